@@ -1,3 +1,13 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "analyzer.h"
+#include "mapped-file.h"
+#include "rec-tokenizer.h"
+#include "rectypes.h"
+
 
 OasisStatisticsBuilder::OasisStatisticsBuilder(OasisStatistics& stats, CSVWriter& csvWriter)
     : oasisStats(stats),
@@ -67,6 +77,7 @@ OasisStatisticsBuilder::BeginRectangle(SoftJin::Ulong layer, SoftJin::Ulong data
 void
 OasisStatisticsBuilder::BeginPolygon(SoftJin::Ulong layer, SoftJin::Ulong datatype, const PointList& ptlist, const Repetition* rep) {
     updateElementStats(oasisStats.polygonCount, rep, oasisStats.srepCounts, oasisStats.srepCountsExpanded);
+    updatePlistStats(layer, datatype, getVertexCount(ptlist));
     currentCellShapeCount++;
 }
 
@@ -74,6 +85,7 @@ OasisStatisticsBuilder::BeginPolygon(SoftJin::Ulong layer, SoftJin::Ulong dataty
 void
 OasisStatisticsBuilder::BeginPath(SoftJin::Ulong layer, SoftJin::Ulong datatype, const PointList& ptlist, const Repetition* rep) {
     updateElementStats(oasisStats.pathCount, rep, oasisStats.srepCounts, oasisStats.srepCountsExpanded);
+    updatePlistStats(layer, datatype, getVertexCount(ptlist));
     currentCellShapeCount++;
 }
 
@@ -189,6 +201,24 @@ OasisStatisticsBuilder::getVertexCount(const PointList& ptlist) const {
     return ptlist.size();
 }
 
+// [POINT_STREAM] plist 길이 분포 {0~2, 3~6, 7~14, 15~62, 63~}와 최대값
+void
+OasisStatisticsBuilder::updatePlistStats(Ulong layer, Ulong datatype, long long vertexCount)
+{
+    static const long long bucketEnds[] = { 2, 6, 14, 62 };
+
+    size_t bucket = 0;
+    while (bucket < 4 && vertexCount > bucketEnds[bucket])
+        bucket++;
+    oasisStats.plists[bucket]++;
+
+    if (vertexCount > oasisStats.maxPlistCount) {
+        oasisStats.maxPlistCount = vertexCount;
+        oasisStats.cellMaxPlistCount = currentCellName;
+        oasisStats.layerMaxPlistCount = std::to_string(layer) + "." + std::to_string(datatype);
+    }
+}
+
 long long
 OasisStatisticsBuilder::getExpandedCount(const Repetition *repetition) const
 {
@@ -196,36 +226,146 @@ OasisStatisticsBuilder::getExpandedCount(const Repetition *repetition) const
             return 1;
         }
 
-        RepetitionType repType = repetition->getType();
-        long long expandedCount = 0;
-
-        switch(repType) {
-        case Rep_ReusePrevious:
-            expandedCount = 1;
-            break;
-        case Rep_Matrix:
-            expandedCount = repetition->getMatrixXdimen() * repetition->getMatrixYdimen();
-            break;
-        case Rep_UniformX:
-        case Rep_UniformY:
-        case Rep_VaryingX:
-        case Rep_VaryingY:
-        case Rep_GridVaryingX:
-        case Rep_GridVaryingY:
-        case Rep_Arbitrary:
-        case Rep_GridArbitrary:
-        case Rep_Diagonal:
-            expandedCount = repetition->getDimen();
-            break;
-        case Rep_TiltedMatrix:
-            expandedCount = repetition->getMatrixNdimen() * repetition->getMatrixMdimen();
-            break;
-        default:
-            expandedCount = 1;
-            break;
+        // [REP_INTERN] 파서가 intern한 repetition이면 cache에 memo된 값을 사용
+        if (repCache && repCache->isInterned(repetition)) {
+            return repCache->getPositionCount(repetition);
         }
+        return Anuvad::Oasis::RepetitionCache::PositionCount(*repetition);
+}
+
+void
+OasisStatisticsBuilder::setRepetitionCache(std::shared_ptr<Anuvad::Oasis::RepetitionCache> cache)
+{
+    repCache = std::move(cache);
+}
+
+// [TEE_BUILDER] OasisBuilder 콜백 -> Begin*()
+void
+OasisStatisticsBuilder::beginCell(CellName* cellName)
+{
+    BeginCell(cellName, 0);
+}
+
+void
+OasisStatisticsBuilder::endCell()
+{
+    EndCell();
+}
+
+void
+OasisStatisticsBuilder::beginPlacement(CellName* cellName, long x, long y,
+                                       const Oreal& mag, const Oreal& angle,
+                                       bool flip, const Repetition* rep)
+{
+    BeginPlacement(cellName, rep);
+}
+
+void
+OasisStatisticsBuilder::beginText(Ulong textlayer, Ulong texttype,
+                                  long x, long y, TextString* text,
+                                  const Repetition* rep)
+{
+    BeginText(textlayer, texttype, rep);
+}
+
+void
+OasisStatisticsBuilder::beginRectangle(Ulong layer, Ulong datatype,
+                                       long x, long y,
+                                       long width, long height,
+                                       const Repetition* rep)
+{
+    BeginRectangle(layer, datatype, rep);
+}
+
+void
+OasisStatisticsBuilder::beginPolygon(Ulong layer, Ulong datatype,
+                                     long x, long y,
+                                     const PointList& ptlist,
+                                     const Repetition* rep)
+{
+    BeginPolygon(layer, datatype, ptlist, rep);
+}
+
+void
+OasisStatisticsBuilder::beginPath(Ulong layer, Ulong datatype,
+                                  long x, long y, long halfwidth,
+                                  long startExtn, long endExtn,
+                                  const PointList& ptlist,
+                                  const Repetition* rep)
+{
+    BeginPath(layer, datatype, ptlist, rep);
+}
+
+void
+OasisStatisticsBuilder::beginTrapezoid(Ulong layer, Ulong datatype,
+                                       long x, long y,
+                                       const Trapezoid& trap,
+                                       const Repetition* rep)
+{
+    BeginTrapezoid(layer, datatype, rep);
+}
+
+void
+OasisStatisticsBuilder::beginCircle(Ulong layer, Ulong datatype,
+                                    long x, long y, long radius,
+                                    const Repetition* rep)
+{
+    BeginCircle(layer, datatype, rep);
+}
+
+void
+OasisStatisticsBuilder::beginXGeometry(Ulong layer, Ulong datatype,
+                                       long x, long y, Ulong attribute,
+                                       const string& data,
+                                       const Repetition* rep)
+{
+    BeginXGeometry(layer, datatype, rep);
+}
+
+void
+OasisStatisticsBuilder::endElement()
+{
+    // [POINT_STREAM] 선언한 numPoints만큼 addPoints()로 받지 못한 경우
+    if (streamLeft != 0) {
+        streamLeft = 0;
+        throw std::runtime_error("point stream has fewer vertices than declared");
+    }
+    EndElement();
+}
+
+// [POINT_STREAM] vertex는 저장하지 않고 numPoints로 통계를 낸 뒤 개수만 확인
+void
+OasisStatisticsBuilder::beginPolygonStream(Ulong layer, Ulong datatype,
+                                           long x, long y, Ulong numPoints,
+                                           const Repetition* rep)
+{
+    updateElementStats(oasisStats.polygonCount, rep, oasisStats.srepCounts, oasisStats.srepCountsExpanded);
+    updatePlistStats(layer, datatype, numPoints);
+    currentCellShapeCount++;
+    streamLeft = numPoints;
+}
+
+void
+OasisStatisticsBuilder::beginPathStream(Ulong layer, Ulong datatype,
+                                        long x, long y, long halfwidth,
+                                        long startExtn, long endExtn,
+                                        Ulong numPoints,
+                                        const Repetition* rep)
+{
+    updateElementStats(oasisStats.pathCount, rep, oasisStats.srepCounts, oasisStats.srepCountsExpanded);
+    updatePlistStats(layer, datatype, numPoints);
+    currentCellShapeCount++;
+    streamLeft = numPoints;
+}
 
-        return expandedCount;
+void
+OasisStatisticsBuilder::addPoints(const Anuvad::Oasis::DeltaSpan& points)
+{
+    if (points.size() > streamLeft) {
+        streamLeft = 0;
+        throw std::runtime_error("point stream has more vertices than declared");
+    }
+    streamLeft -= points.size();
 }
 
 void OasisStatisticsBuilder::addFileProperty(Property *prop)
@@ -272,3 +412,134 @@ void OasisStatisticsBuilder::registerXName(XName *xname)
 {
 
 }
+
+
+/** [SKIP_SCAN]
+ *  CREATE
+ */
+OasisStructureAnalyzer::OasisStructureAnalyzer(OasisStatistics& stats)
+    : oasisStats(stats)
+{
+}
+
+void
+OasisStructureAnalyzer::analyze(const char* filename)
+{
+    using namespace Anuvad::Oasis;
+
+    // cell 하나의 구조 정보. 이름은 CELLNAME 레코드가 파일 끝에 올 수 있으므로 나중에 해석
+    struct CellExtent {
+        CellKey key;
+        long long start;
+        long long end;
+        long long cblockCount;
+        long long elementCount;     // placement + 도형 + text 레코드 수
+    };
+
+    MappedFile mfile(filename);
+    MappedScanner scanner(mfile);
+    OasisRecordTokenizer tokenizer(scanner);
+    const RecordCursor& curs = tokenizer.cursor();
+
+    std::vector<CellExtent> cells;
+    std::unordered_map<unsigned long long, string> cellNames;   // refnum -> name
+    unsigned long long nextRefnum = 0;
+    bool inCell = false;
+
+    while (tokenizer.next()) {
+        // cell 을 끝내는 레코드 : cell 끝은 그 레코드(CBLOCK 안이면 CBLOCK 끝)
+        if (inCell && !curs.inCell) {
+            cells.back().end = curs.blockEnd;
+            inCell = false;
+        }
+
+        switch (curs.recID) {
+        case RID_CELLNAME_IMPLICIT:
+        case RID_CELLNAME: {
+            string name = scanner.readString().str();
+            unsigned long long refnum = (curs.recID == RID_CELLNAME)
+                                            ? scanner.readUInt64() : nextRefnum++;
+            tokenizer.claimRecord();
+            cellNames[refnum] = name;
+            if (curs.recID == RID_CELLNAME)
+                oasisStats.cellNameRec4Count++;
+            else
+                oasisStats.cellNameRec3Count++;
+            break;
+        }
+        case RID_CELL_REF:
+        case RID_CELL_NAMED:
+            if (inCell)
+                cells.back().end = curs.blockEnd;
+            cells.push_back(CellExtent{ curs.ref, (long long) curs.offset,
+                                        (long long) curs.offset, 0, 0 });
+            inCell = true;
+            if (curs.recID == RID_CELL_REF)
+                oasisStats.cellRec13Count++;
+            else
+                oasisStats.cellRec14Count++;
+            break;
+        case RID_XYABSOLUTE:
+            oasisStats.xyabsolute = true;
+            break;
+        case RID_XYRELATIVE:
+            oasisStats.xyrelative = true;
+            break;
+        case RID_CBLOCK:
+            oasisStats.cblock = true;
+            if (inCell)
+                cells.back().cblockCount++;
+            break;
+        default:
+            if (inCell && curs.recID >= RID_PLACEMENT && curs.recID <= RID_CIRCLE)
+                cells.back().elementCount++;
+            break;
+        }
+    }
+    if (inCell)
+        cells.back().end = scanner.currFileOffset();
+
+    // cell size 통계 (empty cell 제외)
+    long long totalSize = 0;
+    long long sizedCells = 0;
+    std::vector<long long> sizes;
+
+    for (const CellExtent& cell : cells) {
+        string name = cell.key.name;
+        if (cell.key.byRefnum) {
+            auto iter = cellNames.find(cell.key.refnum);
+            name = (iter != cellNames.end()) ? iter->second : std::to_string(cell.key.refnum);
+        }
+
+        if (cell.cblockCount > oasisStats.maxCBlockCountAcell) {
+            oasisStats.maxCBlockCountAcell = cell.cblockCount;
+            oasisStats.cellMaxCBlockCountAcell = name;
+        }
+        if (cell.elementCount == 0)
+            continue;
+
+        long long size = cell.end - cell.start;
+        sizes.push_back(size);
+        totalSize += size;
+        sizedCells++;
+
+        if (size > oasisStats.maxCellSize) {
+            oasisStats.maxCellSize = size;
+            oasisStats.cellMaxCellSize = name;
+        }
+        if (sizedCells == 1 || size < oasisStats.minCellSize) {
+            oasisStats.minCellSize = size;
+            oasisStats.cellMinCellSize = name;
+        }
+    }
+    if (sizedCells > 0)
+        oasisStats.avgCellSize = totalSize / sizedCells;
+
+    // 구간 = maxCellSize / 10, 마지막 구간은 maxCellSize 포함
+    oasisStats.cellSizeInterval = oasisStats.maxCellSize / 10;
+    for (long long size : sizes) {
+        long long idx = (oasisStats.cellSizeInterval > 0)
+                            ? size / oasisStats.cellSizeInterval : 0;
+        oasisStats.cellSizes[std::min<long long>(idx, 9)]++;
+    }
+}
@@ -6,8 +6,11 @@
 #ifndef OASIS_ANALYZER_H_INCLUDED
 #define OASIS_ANALYZER_H_INCLUDED
 
+#include <memory>
 #include "misc/utils.h"         // for WarningHandler
 #include "builder.h"
+#include "stream-builder.h"
+#include "rep-intern.h"
 #include "oasis_statistics.h"
 #include "csv_writer.h"
 
@@ -18,7 +21,8 @@ namespace Jeong {
 using SoftJin::WarningHandler;
 
 
-class OasisStatisticsBuilder : public OasisBuilder {
+class OasisStatisticsBuilder
+  : public OasisBuilder, public Anuvad::Oasis::OasisPointStreamBuilder {
 public:
     // Constructor
     OasisStatisticsBuilder(OasisStatistics& stats, CSVWriter& csvWriter);
@@ -40,6 +44,12 @@ public:
     // Custom functions to manage statistics collection and CSV output
     void finalizeStatistics();
 
+    /** [REP_INTERN]
+     *  ADD
+     *   - 파서의 RepetitionCache를 공유하면 intern된 repetition의 확장 개수를 memo에서 읽음
+     */
+    void setRepetitionCache(std::shared_ptr<Anuvad::Oasis::RepetitionCache> cache);
+
 private:
     OasisStatistics& oasisStats;
     vector<CellStatistics> cellStats;
@@ -51,6 +61,11 @@ private:
     long long currentCellCBlockCount;
     long long cellStartPosition;
 
+    // [POINT_STREAM] 아직 addPoints()로 받지 않은 vertex 수
+    Ulong streamLeft = 0;
+
+    std::shared_ptr<Anuvad::Oasis::RepetitionCache> repCache;   // [REP_INTERN] 없으면 매번 계산
+
     void initializeCurrentCell(const std::string& name, long long offset);
 
 /*
@@ -86,10 +101,58 @@ enum RepetitionType {
     void updateRepetitionTypeExpandedFrequency(const Repetition* rep, std::vector<long long>& repetitionCountsExpanded);
 
     long long getVertexCount(const PointList& ptlist) const;
+    void updatePlistStats(Ulong layer, Ulong datatype, long long vertexCount);
     long long getExpandedCount(const Repetition* repetition) const;
 
     // OasisBuilder interface
 public:
+    /** [TEE_BUILDER]
+     *  ADD
+     *   - Anuvad 파서/TeeBuilder/CursorFeeder 에서 바로 받을 수 있도록
+     *     OasisBuilder 콜백을 위의 Begin*() 으로 넘긴다 (oasis-copy -a).
+     *   - 이 인터페이스로는 cell offset 을 알 수 없으므로 cell offset 은 0,
+     *     file size 도 채우지 않는다.
+     *   - CTRAPEZOID 는 TRAPEZOID 로 전달되므로 trapezoidCount 에 합산된다.
+     */
+    void beginCell(CellName* cellName) override;
+    void endCell() override;
+    void beginPlacement(CellName* cellName, long x, long y,
+                        const Oreal& mag, const Oreal& angle, bool flip,
+                        const Repetition* rep) override;
+    void beginText(Ulong textlayer, Ulong texttype, long x, long y,
+                   TextString* text, const Repetition* rep) override;
+    void beginRectangle(Ulong layer, Ulong datatype, long x, long y,
+                        long width, long height,
+                        const Repetition* rep) override;
+    void beginPolygon(Ulong layer, Ulong datatype, long x, long y,
+                      const PointList& ptlist,
+                      const Repetition* rep) override;
+    void beginPath(Ulong layer, Ulong datatype, long x, long y,
+                   long halfwidth, long startExtn, long endExtn,
+                   const PointList& ptlist,
+                   const Repetition* rep) override;
+    void beginTrapezoid(Ulong layer, Ulong datatype, long x, long y,
+                        const Trapezoid& trap,
+                        const Repetition* rep) override;
+    void beginCircle(Ulong layer, Ulong datatype, long x, long y,
+                     long radius, const Repetition* rep) override;
+    void beginXGeometry(Ulong layer, Ulong datatype, long x, long y,
+                        Ulong attribute, const string& data,
+                        const Repetition* rep) override;
+    void endElement() override;
+
+    /** [POINT_STREAM]
+     *  ADD
+     *   - 큰 polygon/path는 vertex를 받지 않고 numPoints로 plist 통계를 낸다.
+     *   - addPoints()로 받은 개수가 numPoints와 다르면 runtime_error.
+     */
+    void beginPolygonStream(Ulong layer, Ulong datatype, long x, long y,
+                            Ulong numPoints, const Repetition* rep) override;
+    void beginPathStream(Ulong layer, Ulong datatype, long x, long y,
+                         long halfwidth, long startExtn, long endExtn,
+                         Ulong numPoints, const Repetition* rep) override;
+    void addPoints(const Anuvad::Oasis::DeltaSpan& points) override;
+
     void addFileProperty(Property *prop) override;
     void addCellProperty(Property *prop) override;
     void addElementProperty(Property *prop) override;
@@ -101,6 +164,23 @@ public:
     void registerXName(XName *xname) override;
 };
 
+/** [SKIP_SCAN]
+ *  CREATE
+ *   - 레코드 구조만으로 산출되는 통계 (도형/repetition/property 디코딩 없음)
+ *   - files/rec-tokenizer.h 의 OasisRecordTokenizer 로 파일을 한 번 훑으면서
+ *     cellname/cell 레코드 종류별 개수, CBLOCK 개수, xy 모드, cell size 분포를 채운다.
+ *   - builder 콜백으로는 레코드 종류와 파일 offset 을 알 수 없으므로 별도 pass 로 둔다.
+ */
+class OasisStructureAnalyzer {
+public:
+    explicit OasisStructureAnalyzer(OasisStatistics& stats);
+
+    void analyze(const char* filename);
+
+private:
+    OasisStatistics& oasisStats;
+};
+
 struct OasisParserOptions {
     bool  strictConformance;    // false => allow minor deviations from spec
     bool  wantValidation;       // false => ignore validation in END
@@ -2,15 +2,21 @@
 #define CSV_WRITER_H
 
 #include <string>
-#include "analyzer.h"
+#include "oasis_statistics.h"
+
+namespace Oasis {
+namespace Jeong {
 
 class CSVWriter {
 public:
     CSVWriter(const std::string& filename);
-    void write(const Statistics& stats);
+    void OasisStatisticsWrite(const OasisStatistics& stats);
 
 private:
     std::string filename;
 };
 
+}  // namespace Jeong
+}  // namespace Oasis
+
 #endif  // CSV_WRITER_H
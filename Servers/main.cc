@@ -105,6 +105,10 @@ main(int argc, char* argv[])
     try {
         Oasis::Jeong::OasisParser parser(infilename, DisplayWarning, parserOptions);
         parser.parseFile(&builder);
+
+        // [SKIP_SCAN] 레코드 구조 통계는 tokenizer pass 로 산출
+        Jeong::OasisStructureAnalyzer structure(oasisStats);
+        structure.analyze(infilename);
     } catch (const std::exception& exc) {
         FatalError("%s", exc.what());
         return 1;
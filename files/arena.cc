@@ -0,0 +1,137 @@
+// oasis/arena.cc -- monotonic arena for per-cell allocations
+//
+// last modified:   2026/10/17
+
+#include <algorithm>
+#include <cstdlib>
+#include "arena.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+
+MonotonicArena::MonotonicArena (size_t initialChunkSize)
+{
+    chunks = Null;
+    cur = limit = Null;
+    initialSize = std::max(initialChunkSize, size_t(256));
+    nextChunkSize = initialSize;
+    dtors = Null;
+    bytesUsed = 0;
+    bytesReserved = 0;
+}
+
+
+MonotonicArena::~MonotonicArena()
+{
+    runDestructors();
+    while (chunks != Null) {
+        Chunk*  next = chunks->next;
+        free(chunks);
+        chunks = next;
+    }
+}
+
+
+// allocateSlow -- allocate when the current chunk has no room
+// A request too big for a regular chunk gets a chunk of its own, linked
+// in behind the current one so that the free space in the current
+// chunk is not abandoned.
+
+void*
+MonotonicArena::allocateSlow (size_t size, size_t align)
+{
+    size_t  need = size + align;        // room for worst-case padding
+    bool  dedicated = (need > MaxChunkSize);
+    size_t  dataSize = dedicated ? need : std::max(nextChunkSize, need);
+
+    // The header is padded so that chunk data starts max-aligned.
+    const size_t  HeaderSize = (sizeof(Chunk) + alignof(std::max_align_t) - 1)
+                               & ~(alignof(std::max_align_t) - 1);
+    Chunk*  chunk = static_cast<Chunk*>(malloc(HeaderSize + dataSize));
+    if (chunk == Null)
+        throw std::bad_alloc();
+    chunk->size = dataSize;
+    bytesReserved += dataSize;
+
+    char*  data = reinterpret_cast<char*>(chunk) + HeaderSize;
+    uintptr_t  p = (reinterpret_cast<uintptr_t>(data) + align - 1)
+                   & ~(uintptr_t(align) - 1);
+    bytesUsed += size;
+
+    if (dedicated  &&  chunks != Null) {
+        chunk->next = chunks->next;
+        chunks->next = chunk;
+    } else {
+        chunk->next = chunks;
+        chunks = chunk;
+        cur = reinterpret_cast<char*>(p + size);
+        limit = data + dataSize;
+        if (! dedicated)
+            nextChunkSize = std::min(nextChunkSize * 2, size_t(MaxChunkSize));
+    }
+    return reinterpret_cast<void*>(p);
+}
+
+
+// reset -- release everything allocated, keeping the largest chunk
+
+void
+MonotonicArena::reset()
+{
+    runDestructors();
+    if (chunks == Null)
+        return;
+
+    Chunk*  keep = chunks;
+    for (Chunk* chunk = chunks->next;  chunk != Null;  chunk = chunk->next) {
+        if (chunk->size > keep->size)
+            keep = chunk;
+    }
+    Chunk*  chunk = chunks;
+    while (chunk != Null) {
+        Chunk*  next = chunk->next;
+        if (chunk != keep)
+            free(chunk);
+        chunk = next;
+    }
+
+    const size_t  HeaderSize = (sizeof(Chunk) + alignof(std::max_align_t) - 1)
+                               & ~(alignof(std::max_align_t) - 1);
+    keep->next = Null;
+    chunks = keep;
+    cur = reinterpret_cast<char*>(keep) + HeaderSize;
+    limit = cur + keep->size;
+    nextChunkSize = std::min(std::max(initialSize, keep->size * 2),
+                             size_t(MaxChunkSize));
+    bytesUsed = 0;
+    bytesReserved = keep->size;
+}
+
+
+void
+MonotonicArena::addDestructor (void (*destroy)(void*), void* object)
+{
+    void*  mem = allocate(sizeof(DtorNode), alignof(DtorNode));
+    DtorNode*  node = static_cast<DtorNode*>(mem);
+    node->next = dtors;
+    node->destroy = destroy;
+    node->object = object;
+    dtors = node;
+}
+
+
+void
+MonotonicArena::runDestructors()
+{
+    // Clear the list first so that a throwing destructor cannot cause
+    // the others to run twice.
+    DtorNode*  node = dtors;
+    dtors = Null;
+    for ( ;  node != Null;  node = node->next)
+        node->destroy(node->object);
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
@@ -0,0 +1,155 @@
+// oasis/arena.h -- monotonic arena for per-cell allocations
+//
+// last modified:   2026/10/17
+//
+// A builder that stores the elements of a cell makes several small heap
+// allocations per element: the element object itself, a copy of its
+// point list, and the positions its repetition expands to.  On
+// polygon-heavy layers malloc() and free() dominate the profile.
+//
+// MonotonicArena hands out memory by bumping a pointer through large
+// chunks and frees nothing until reset() or destruction, when it drops
+// everything at once.  It is meant for data whose lifetime is a cell:
+// the parser keeps one arena per cell (see OasisArenaBuilder in
+// parser.h) and a builder that keeps a cell's data past endCell() keeps
+// the arena with it.
+//
+// An arena is not thread-safe; each parser or worker has its own.
+
+#ifndef OASIS_ARENA_H_INCLUDED
+#define OASIS_ARENA_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "misc/utils.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+
+// MonotonicArena -- bump allocator with bulk release
+//
+// allocate() returns uninitialized memory.  create() constructs an
+// object in the arena; if its type has a non-trivial destructor the
+// arena runs the destructor on reset() or destruction, in reverse
+// order of construction.  Objects must not be deleted individually.
+// copyArray() copies trivially-copyable data into the arena.
+//
+// Chunks grow geometrically from initialChunkSize up to MaxChunkSize.
+// A request larger than that gets a chunk of its own.  reset() keeps
+// the largest chunk so that an arena reused cell after cell stops
+// calling malloc() once it has seen the largest cell.
+//
+// Data members
+//
+// chunks           Chunk*      most recent chunk; chunks are linked
+//                              through Chunk::next
+// cur, limit       char*       free space in the current chunk
+// nextChunkSize    size_t      data size of the next chunk to allocate
+// initialSize      size_t      nextChunkSize after reset()
+// dtors            DtorNode*   destructors to run, most recent first
+// bytesUsed        size_t      bytes handed out since the last reset()
+// bytesReserved    size_t      bytes in all chunks
+
+class MonotonicArena {
+    struct Chunk {
+        Chunk*      next;
+        size_t      size;       // bytes of data following the header
+    };
+    struct DtorNode {
+        DtorNode*   next;
+        void      (*destroy)(void*);
+        void*       object;
+    };
+
+    Chunk*      chunks;
+    char*       cur;
+    char*       limit;
+    size_t      nextChunkSize;
+    size_t      initialSize;
+    DtorNode*   dtors;
+    size_t      bytesUsed;
+    size_t      bytesReserved;
+
+public:
+    static const size_t  DefaultChunkSize = 64*1024;
+    static const size_t  MaxChunkSize = 4*1024*1024;
+
+    explicit    MonotonicArena (size_t initialChunkSize = DefaultChunkSize);
+                ~MonotonicArena();
+
+    void*       allocate (size_t size,
+                          size_t align = alignof(std::max_align_t));
+    void        reset();
+
+    template <typename T>
+    T*          allocArray (size_t n) {
+                    static_assert(std::is_trivially_destructible<T>::value,
+                                  "arena arrays are never destroyed");
+                    return static_cast<T*>(allocate(n * sizeof(T),
+                                                    alignof(T)));
+                }
+
+    template <typename T>
+    T*          copyArray (const T* src, size_t n) {
+                    static_assert(std::is_trivially_copyable<T>::value,
+                                  "copyArray() uses memcpy");
+                    if (n == 0)
+                        return Null;
+                    T*  dst = allocArray<T>(n);
+                    memcpy(dst, src, n * sizeof(T));
+                    return dst;
+                }
+
+    template <typename T, typename... Args>
+    T*          create (Args&&... args) {
+                    void*  mem = allocate(sizeof(T), alignof(T));
+                    T*  obj = new (mem) T(std::forward<Args>(args)...);
+                    if (! std::is_trivially_destructible<T>::value)
+                        addDestructor(&DestroyObject<T>, obj);
+                    return obj;
+                }
+
+    size_t      getBytesUsed() const        { return bytesUsed; }
+    size_t      getBytesReserved() const    { return bytesReserved; }
+
+private:
+    void*       allocateSlow (size_t size, size_t align);
+    void        addDestructor (void (*destroy)(void*), void* object);
+    void        runDestructors();
+
+    template <typename T>
+    static void DestroyObject (void* p)  { static_cast<T*>(p)->~T(); }
+
+private:
+                MonotonicArena (const MonotonicArena&);   // forbidden
+    void        operator= (const MonotonicArena&);        // forbidden
+};
+
+
+inline void*
+MonotonicArena::allocate (size_t size, size_t align)
+{
+    // align is a power of 2.  The fast path is taken by nearly every
+    // call once the first chunk exists.
+    uintptr_t  p = (reinterpret_cast<uintptr_t>(cur) + align - 1)
+                   & ~(uintptr_t(align) - 1);
+    if (cur != Null  &&  size <= size_t(limit - cur)
+            &&  p - reinterpret_cast<uintptr_t>(cur)
+                    <= size_t(limit - cur) - size) {
+        bytesUsed += size;
+        cur = reinterpret_cast<char*>(p + size);
+        return reinterpret_cast<void*>(p);
+    }
+    return allocateSlow(size, align);
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_ARENA_H_INCLUDED
@@ -0,0 +1,93 @@
+// oasis/batch-builder.h -- optional batched element callbacks for builders
+//
+// last modified:   2026/10/17
+//
+// Each element a builder is given costs at least two virtual calls,
+// beginFoo() and endElement(), and most builders then look up some
+// per-layer state for it.  Real files come in long runs of rectangles
+// on one layer and datatype, so the caller can instead hand over a
+// whole run at once.
+//
+// A builder that derives from OasisBatchBuilder instead of directly
+// from OasisBuilder may be given runs of rectangles through
+// beginRectangles().  CursorFeeder (cursor-feed.h) finds out with
+// dynamic_cast, as the parser does for OasisArenaBuilder; OasisParser
+// itself always delivers rectangles singly.  The run is delivered in
+// file order, at the point where its last rectangle was read, and takes
+// the place of the beginRectangle()/endElement() pairs for those
+// rectangles.  All the rectangles in a run are in the current cell and
+// have the same layer and datatype; none has properties.  The run is
+// never empty.
+//
+// The default beginRectangles() makes the per-element calls, so a
+// builder may derive from OasisBatchBuilder and override nothing, and
+// a batch-aware caller may treat every OasisBatchBuilder the same.
+//
+// The Repetition pointers in a run are those the caller would have
+// passed singly and remain valid as long as they would have.  The span
+// itself is the caller's buffer and is valid only during the call.
+
+#ifndef OASIS_BATCH_BUILDER_H_INCLUDED
+#define OASIS_BATCH_BUILDER_H_INCLUDED
+
+#include <cstddef>
+
+#include "misc/utils.h"
+#include "oasis.h"
+#include "builder.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using SoftJin::Ulong;
+
+
+// RectElem -- the per-rectangle arguments of beginRectangle()
+
+struct RectElem {
+    long                x, y;
+    long                width, height;
+    const Repetition*   rep;            // Null if none
+};
+
+
+// ElemSpan -- a read-only array of elements, like CellGraph::NodeSpan
+
+template <typename T>
+class ElemSpan {
+    const T*    first;
+    size_t      count;
+public:
+                ElemSpan (const T* first, size_t count)
+                  : first(first), count(count) { }
+    const T*    begin() const           { return first; }
+    const T*    end() const             { return first + count; }
+    size_t      size() const            { return count; }
+    bool        empty() const           { return (count == 0); }
+    const T&    operator[] (size_t n) const  { return first[n]; }
+};
+
+typedef ElemSpan<RectElem>  RectSpan;
+
+
+class OasisBatchBuilder : public OasisBuilder {
+public:
+    virtual     ~OasisBatchBuilder() { }
+
+    // beginRectangles -- a run of rectangles on one layer and datatype
+    virtual void  beginRectangles (Ulong layer, Ulong datatype,
+                                   const RectSpan& rects) {
+                      for (const RectElem* r = rects.begin();
+                              r != rects.end();  ++r) {
+                          beginRectangle(layer, datatype, r->x, r->y,
+                                         r->width, r->height, r->rep);
+                          endElement();
+                      }
+                  }
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_BATCH_BUILDER_H_INCLUDED
@@ -0,0 +1,650 @@
+// oasis/bbox-index.cc -- bounding boxes of the cells in an OASIS file
+//
+// last modified:   2026/10/17
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "oasis.h"
+#include "rectypes.h"
+#include "bbox-index.h"
+#include "cell-graph.h"
+#include "cursor.h"
+#include "mapped-file.h"
+#include "mapped-scanner.h"
+#include "rec-tokenizer.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::runtime_error;
+using std::vector;
+using SoftJin::llong;
+
+
+namespace {
+
+const Uint  PropNameBit       = 0x04;   // PROPERTY: UUUUVCNS
+const Uint  PropRefnumBit     = 0x02;
+const Uint  PropReuseBit      = 0x08;
+
+const char  BoundingBoxPropName[] = "S_BOUNDING_BOX";
+
+
+long
+AddClamped (long a, long b)
+{
+    long  sum;
+    if (__builtin_add_overflow(a, b, &sum))
+        return (b > 0 ? LONG_MAX : LONG_MIN);
+    return sum;
+}
+
+
+long
+FloorToLong (double v)
+{
+    v = std::floor(v);
+    if (v <= double(LONG_MIN))  return LONG_MIN;
+    if (v >= double(LONG_MAX))  return LONG_MAX;
+    return long(v);
+}
+
+
+long
+CeilToLong (double v)
+{
+    v = std::ceil(v);
+    if (v <= double(LONG_MIN))  return LONG_MIN;
+    if (v >= double(LONG_MAX))  return LONG_MAX;
+    return long(v);
+}
+
+
+// CosSin -- cosine and sine of angle in degrees
+// Multiples of 90 degrees, by far the most common, are exact.
+
+void
+CosSin (double angle, /*out*/ double* c, /*out*/ double* s)
+{
+    double  quarters = angle / 90.0;
+    if (quarters == std::floor(quarters)  &&  std::fabs(quarters) < 1e9) {
+        static const double  Cos[4] = { 1, 0, -1, 0 };
+        static const double  Sin[4] = { 0, 1, 0, -1 };
+        int  k = int(((llong(quarters) % 4) + 4) % 4);
+        *c = Cos[k];
+        *s = Sin[k];
+    } else {
+        double  rad = angle * M_PI / 180.0;
+        *c = std::cos(rad);
+        *s = std::sin(rad);
+    }
+}
+
+
+// ReadPropValue -- Section 31.1
+// Returns false for values that are not numbers: strings and PROPSTRING
+// reference-numbers.
+
+bool
+ReadPropValue (MappedScanner& scanner, /*out*/ double* val)
+{
+    Ulong  type = scanner.readUInt();
+    if (type <= 7) {
+        *val = scanner.readRealBody(type);
+        return true;
+    }
+    switch (type) {
+        case 8:   *val = double(scanner.readUInt64());  return true;
+        case 9:   *val = double(scanner.readSInt64());  return true;
+        case 10:
+        case 11:
+        case 12:  (void) scanner.readString();          return false;
+        case 13:
+        case 14:
+        case 15:  (void) scanner.readUInt64();          return false;
+        default:
+            throw runtime_error(scanner.getMappedFile().getFilename()
+                                + ": invalid property value type "
+                                + std::to_string(type));
+    }
+}
+
+
+// ViewBox -- extent of an element and all its repetitions
+
+BoundingBox
+ViewBox (const ElementView& view)
+{
+    BoundingBox  box;
+    long  x = view.x;
+    long  y = view.y;
+
+    switch (view.kind) {
+        case EK_Rectangle:
+        case EK_Trapezoid:
+            box = BoundingBox(x, y, AddClamped(x, long(view.width)),
+                                    AddClamped(y, long(view.height)));
+            break;
+
+        case EK_CTrapezoid: {
+            // Some types derive one dimension from the other, up to
+            // twice its size.
+            long  side = 2 * long(std::max(view.width, view.height));
+            box = BoundingBox(x, y, AddClamped(x, side), AddClamped(y, side));
+            break;
+        }
+
+        case EK_Circle:
+            box = BoundingBox(x, y, x, y);
+            box.grow(long(view.radius), long(view.radius));
+            break;
+
+        case EK_Polygon:
+        case EK_Path:
+            for (Ulong j = 0;  j < view.numPoints;  ++j)
+                box.addPoint(AddClamped(x, view.points[j].x),
+                             AddClamped(y, view.points[j].y));
+            if (view.kind == EK_Path) {
+                long  pad = long(view.halfwidth)
+                          + std::max(std::labs(view.startExtn),
+                                     std::labs(view.endExtn));
+                box.grow(pad, pad);
+            }
+            break;
+
+        default:                // text and XGEOMETRY have no extent
+            box = BoundingBox(x, y, x, y);
+            break;
+    }
+
+    box.sweep(BoundingBox::OfRepetition(view.rep));
+    return box;
+}
+
+
+// CellExtent -- what the cursor pass learns about a cell without a box
+
+struct ChildPlacement {
+    string      child;
+    long        x, y;
+    double      mag, angle;
+    bool        flip;
+    BoundingBox offsets;
+};
+
+struct CellExtent {
+    string                  name;
+    BoundingBox             local;      // the cell's own elements
+    vector<ChildPlacement>  placements;
+};
+
+}  // unnamed namespace
+
+
+//----------------------------------------------------------------------
+// BoundingBox
+
+
+void
+BoundingBox::addPoint (long x, long y)
+{
+    xmin = std::min(xmin, x);
+    ymin = std::min(ymin, y);
+    xmax = std::max(xmax, x);
+    ymax = std::max(ymax, y);
+}
+
+
+void
+BoundingBox::merge (const BoundingBox& b)
+{
+    if (b.isEmpty())
+        return;
+    addPoint(b.xmin, b.ymin);
+    addPoint(b.xmax, b.ymax);
+}
+
+
+// grow -- move each side outward
+void
+BoundingBox::grow (long dx, long dy)
+{
+    if (isEmpty())
+        return;
+    xmin = AddClamped(xmin, -dx);
+    ymin = AddClamped(ymin, -dy);
+    xmax = AddClamped(xmax, dx);
+    ymax = AddClamped(ymax, dy);
+}
+
+
+// sweep -- extent of the box moved by every offset in offsets
+// offsets is the bounding box of a set of displacements, as from
+// OfRepetition().
+
+void
+BoundingBox::sweep (const BoundingBox& offsets)
+{
+    if (isEmpty()  ||  offsets.isEmpty())
+        return;
+    xmin = AddClamped(xmin, offsets.xmin);
+    ymin = AddClamped(ymin, offsets.ymin);
+    xmax = AddClamped(xmax, offsets.xmax);
+    ymax = AddClamped(ymax, offsets.ymax);
+}
+
+
+// transform -- box of this box placed as a PLACEMENT places a cell
+// The cell is flipped about the x-axis, magnified, rotated
+// counterclockwise by angle degrees and moved to (x,y), in that order.
+
+BoundingBox
+BoundingBox::transform (double mag, double angle, bool flip,
+                        long x, long y) const
+{
+    if (isEmpty())
+        return *this;
+    if (isUnbounded())
+        return Everything();
+
+    double  c, s;
+    CosSin(angle, &c, &s);
+    double  px[2] = { double(xmin), double(xmax) };
+    double  py[2] = { double(ymin), double(ymax) };
+
+    double  lox = HUGE_VAL, loy = HUGE_VAL, hix = -HUGE_VAL, hiy = -HUGE_VAL;
+    for (int i = 0;  i < 2;  ++i) {
+        for (int j = 0;  j < 2;  ++j) {
+            double  u = px[i] * mag;
+            double  v = (flip ? -py[j] : py[j]) * mag;
+            double  tx = u*c - v*s + x;
+            double  ty = u*s + v*c + y;
+            lox = std::min(lox, tx);   hix = std::max(hix, tx);
+            loy = std::min(loy, ty);   hiy = std::max(hiy, ty);
+        }
+    }
+    return BoundingBox(FloorToLong(lox), FloorToLong(loy),
+                       CeilToLong(hix), CeilToLong(hiy));
+}
+
+
+// inverseTransform -- box of this box in the coordinates of a placed cell
+// The inverse of transform() with the same arguments.
+
+BoundingBox
+BoundingBox::inverseTransform (double mag, double angle, bool flip,
+                               long x, long y) const
+{
+    if (isEmpty())
+        return *this;
+    if (isUnbounded()  ||  mag == 0)
+        return Everything();
+
+    double  c, s;
+    CosSin(angle, &c, &s);
+    double  px[2] = { double(xmin) - x, double(xmax) - x };
+    double  py[2] = { double(ymin) - y, double(ymax) - y };
+
+    double  lox = HUGE_VAL, loy = HUGE_VAL, hix = -HUGE_VAL, hiy = -HUGE_VAL;
+    for (int i = 0;  i < 2;  ++i) {
+        for (int j = 0;  j < 2;  ++j) {
+            double  u = (px[i]*c + py[j]*s) / mag;
+            double  v = (py[j]*c - px[i]*s) / mag;
+            if (flip)
+                v = -v;
+            lox = std::min(lox, u);   hix = std::max(hix, u);
+            loy = std::min(loy, v);   hiy = std::max(hiy, v);
+        }
+    }
+    return BoundingBox(FloorToLong(lox), FloorToLong(loy),
+                       CeilToLong(hix), CeilToLong(hiy));
+}
+
+
+// OfRepetition -- bounding box of the offsets of rep
+// Null yields the single offset (0,0).  The regular repetitions are
+// bounded by their corners, so only the explicit offset lists are
+// walked.
+
+/*static*/ BoundingBox
+BoundingBox::OfRepetition (const Repetition* rep)
+{
+    BoundingBox  box(0, 0, 0, 0);
+    if (rep == Null)
+        return box;
+
+    switch (rep->getType()) {
+        case Rep_Matrix:
+            if (rep->getMatrixXdimen() != 0  &&  rep->getMatrixYdimen() != 0)
+                box.addPoint(long(rep->getMatrixXdimen() - 1)
+                                 * rep->getMatrixXspace(),
+                             long(rep->getMatrixYdimen() - 1)
+                                 * rep->getMatrixYspace());
+            break;
+
+        case Rep_UniformX:
+            if (rep->getDimen() != 0)
+                box.addPoint(long(rep->getDimen() - 1)
+                                 * rep->getUniformXspace(), 0);
+            break;
+
+        case Rep_UniformY:
+            if (rep->getDimen() != 0)
+                box.addPoint(0, long(rep->getDimen() - 1)
+                                    * rep->getUniformYspace());
+            break;
+
+        case Rep_VaryingX:
+        case Rep_GridVaryingX:
+            for (Ulong i = 0;  i < rep->getDimen();  ++i)
+                box.addPoint(rep->getVaryingXoffset(i), 0);
+            break;
+
+        case Rep_VaryingY:
+        case Rep_GridVaryingY:
+            for (Ulong i = 0;  i < rep->getDimen();  ++i)
+                box.addPoint(0, rep->getVaryingYoffset(i));
+            break;
+
+        case Rep_TiltedMatrix: {
+            if (rep->getMatrixNdimen() == 0  ||  rep->getMatrixMdimen() == 0)
+                break;
+            long   n = long(rep->getMatrixNdimen() - 1);
+            long   m = long(rep->getMatrixMdimen() - 1);
+            Delta  nd = rep->getMatrixNdelta();
+            Delta  md = rep->getMatrixMdelta();
+            box.addPoint(n*nd.x, n*nd.y);
+            box.addPoint(m*md.x, m*md.y);
+            box.addPoint(n*nd.x + m*md.x, n*nd.y + m*md.y);
+            break;
+        }
+
+        case Rep_Diagonal:
+            if (rep->getDimen() != 0) {
+                Delta  delta = rep->getDiagonalDelta();
+                long   n = long(rep->getDimen() - 1);
+                box.addPoint(n*delta.x, n*delta.y);
+            }
+            break;
+
+        case Rep_Arbitrary:
+        case Rep_GridArbitrary:
+            for (Ulong i = 0;  i < rep->getDimen();  ++i) {
+                Delta  delta = rep->getDelta(i);
+                box.addPoint(delta.x, delta.y);
+            }
+            break;
+
+        default:
+            break;
+    }
+    return box;
+}
+
+
+//----------------------------------------------------------------------
+// CellBBoxIndex
+
+
+CellBBoxIndex::CellBBoxIndex()
+{
+    numFromProperty = 0;
+    numComputed = 0;
+}
+
+
+// build -- find the bounding box of every cell in the file
+// Throws runtime_error if the file cannot be read.
+
+void
+CellBBoxIndex::build (const char* fname)
+{
+    boxes.clear();
+    numFromProperty = numComputed = 0;
+    readProperties(fname);
+    computeMissing(fname);
+}
+
+
+// lookup -- bounding box of the named cell
+// Returns false if the cell is not defined in the file.
+
+bool
+CellBBoxIndex::lookup (const string& cellName,
+                       /*out*/ BoundingBox* box) const
+{
+    std::unordered_map<string, BoundingBox>::const_iterator
+        iter = boxes.find(cellName);
+    if (iter == boxes.end())
+        return false;
+    *box = iter->second;
+    return true;
+}
+
+
+// readProperties -- collect S_BOUNDING_BOX properties of CELLNAME records
+// A CELLNAME record's properties are the PROPERTY and PROPERTY_REPEAT
+// records that follow it, with PAD and CBLOCK records ignored.  The
+// modal property name and value list carry over between records, as
+// the parser keeps them.
+
+void
+CellBBoxIndex::readProperties (const char* fname)
+{
+    struct Candidate {
+        string      cellName;
+        bool        byRefnum;
+        Ullong      refnum;
+        double      values[5];
+    };
+
+    MappedFile            mfile(fname);
+    MappedScanner         scanner(mfile);
+    OasisRecordTokenizer  tokenizer(scanner);
+    const RecordCursor&   curs = tokenizer.cursor();
+
+    std::unordered_map<Ullong, string>  propNames;
+    vector<Candidate>  candidates;
+    Ullong  nextPropRefnum = 0;
+
+    string  cellName;                   // of the current CELLNAME record
+    bool    inCellName = false;
+
+    bool    haveName = false;           // modal property name
+    bool    nameByRefnum = false;
+    Ullong  nameRefnum = 0;
+    string  name;
+    bool    haveValues = false;         // modal value list, if it is
+    bool    valuesUsable = false;       // five numbers
+    double  values[5];
+
+    mfile.advise(MappedFile::Sequential);
+    tokenizer.rewind();
+    while (tokenizer.next()) {
+        switch (curs.recID) {
+            case RID_PAD:
+            case RID_CBLOCK:
+                continue;
+
+            case RID_CELLNAME_IMPLICIT:
+            case RID_CELLNAME:
+                cellName = scanner.readString().str();
+                if (curs.recID == RID_CELLNAME)
+                    (void) scanner.readUInt64();
+                tokenizer.claimRecord();
+                inCellName = true;
+                continue;
+
+            case RID_PROPNAME_IMPLICIT:
+            case RID_PROPNAME: {
+                string  pname = scanner.readString().str();
+                Ullong  refnum = (curs.recID == RID_PROPNAME)
+                                     ? scanner.readUInt64()
+                                     : nextPropRefnum++;
+                tokenizer.claimRecord();
+                propNames[refnum].swap(pname);
+                break;
+            }
+
+            case RID_CELL_REF:
+            case RID_CELL_NAMED:
+                haveName = haveValues = false;
+                break;
+
+            case RID_PROPERTY: {
+                Uint  info = curs.infoByte;
+                if (info & PropNameBit) {
+                    haveName = true;
+                    nameByRefnum = (info & PropRefnumBit);
+                    if (nameByRefnum)
+                        nameRefnum = scanner.readUInt64();
+                    else
+                        name = scanner.readString().str();
+                }
+                if (! (info & PropReuseBit)) {
+                    Ullong  count = info >> 4;
+                    if (count == 15)
+                        count = scanner.readUInt64();
+                    haveValues = true;
+                    valuesUsable = (count == 5);
+                    for (Ullong j = 0;  j < count;  ++j) {
+                        double  val = 0;
+                        bool  isNumber = ReadPropValue(scanner, &val);
+                        if (j < 5)
+                            values[j] = val;
+                        valuesUsable = valuesUsable && isNumber;
+                    }
+                }
+                tokenizer.claimRecord();
+            }
+                /* FALLTHROUGH */
+
+            case RID_PROPERTY_REPEAT:
+                if (inCellName  &&  haveName  &&  haveValues  &&  valuesUsable
+                        &&  (nameByRefnum  ||  name == BoundingBoxPropName)) {
+                    Candidate  cand;
+                    cand.cellName = cellName;
+                    cand.byRefnum = nameByRefnum;
+                    cand.refnum = nameRefnum;
+                    std::copy(values, values + 5, cand.values);
+                    candidates.push_back(cand);
+                }
+                continue;
+
+            default:
+                break;
+        }
+        inCellName = false;
+    }
+
+    // If a cell has more than one box, the first wins.
+    for (size_t j = 0;  j < candidates.size();  ++j) {
+        const Candidate&  cand = candidates[j];
+        if (cand.byRefnum) {
+            std::unordered_map<Ullong, string>::const_iterator
+                iter = propNames.find(cand.refnum);
+            if (iter == propNames.end()  ||  iter->second != BoundingBoxPropName)
+                continue;
+        }
+        if (cand.values[0] != 0  ||  cand.values[3] < 0  ||  cand.values[4] < 0)
+            continue;
+        long  x = FloorToLong(cand.values[1]);
+        long  y = FloorToLong(cand.values[2]);
+        BoundingBox  box(x, y, CeilToLong(x + cand.values[3]),
+                               CeilToLong(y + cand.values[4]));
+        if (boxes.insert(std::make_pair(cand.cellName, box)).second)
+            ++numFromProperty;
+    }
+}
+
+
+// computeMissing -- compute the boxes of cells that have no property
+// The cursor pass records each such cell's local extent and its
+// placements; the boxes are then resolved children first, in the
+// topological order of a CellGraph of those cells.  A placement of a
+// cell that is not defined in the file makes the parent's box
+// unbounded.
+
+void
+CellBBoxIndex::computeMissing (const char* fname)
+{
+    vector<CellExtent>  extents;
+    std::unordered_map<string, Uint>  extentNodes;
+    OasisCursor  cursor(fname);
+    ElementView  views[256];
+
+    while (cursor.nextCell()) {
+        const string&  name = cursor.getCellName();
+        if (name.empty()  ||  boxes.count(name) != 0
+                ||  ! extentNodes.insert(std::make_pair(name,
+                                                        extents.size())).second)
+            continue;           // nextCell() skips the rest
+
+        extents.push_back(CellExtent());
+        CellExtent&  extent = extents.back();
+        extent.name = name;
+        size_t  n;
+        while ((n = cursor.next(views, 256)) != 0) {
+            for (size_t j = 0;  j < n;  ++j) {
+                const ElementView&  view = views[j];
+                if (view.kind != EK_Placement) {
+                    extent.local.merge(ViewBox(view));
+                    continue;
+                }
+                ChildPlacement  place;
+                place.child = view.name.str();
+                place.x = view.x;
+                place.y = view.y;
+                place.mag = view.mag;
+                place.angle = view.angle;
+                place.flip = view.flip;
+                place.offsets = BoundingBox::OfRepetition(view.rep);
+                extent.placements.push_back(place);
+            }
+        }
+    }
+
+    CellGraph  graph;
+    graph.reserveNodes(extents.size());
+    for (Uint node = 0;  node < extents.size();  ++node) {
+        const vector<ChildPlacement>&  places = extents[node].placements;
+        for (size_t j = 0;  j < places.size();  ++j) {
+            std::unordered_map<string, Uint>::const_iterator
+                iter = extentNodes.find(places[j].child);
+            if (iter != extentNodes.end())
+                graph.addEdge(node, iter->second);
+        }
+    }
+    graph.finalize();
+
+    // A cycle, which the spec forbids, contributes nothing: its cells
+    // come last in the order and skip the children not yet resolved.
+    const vector<Uint>&  order = graph.getTopologicalOrder();
+    for (size_t k = 0;  k < order.size();  ++k) {
+        const CellExtent&  ext = extents[order[k]];
+        BoundingBox  box = ext.local;
+        for (size_t j = 0;  j < ext.placements.size();  ++j) {
+            const ChildPlacement&  place = ext.placements[j];
+            BoundingBox  cbox;
+            if (! lookup(place.child, &cbox)) {
+                if (extentNodes.count(place.child) == 0)
+                    cbox = BoundingBox::Everything();
+                else
+                    continue;           // cycle
+            }
+            cbox = cbox.transform(place.mag, place.angle, place.flip,
+                                  place.x, place.y);
+            cbox.sweep(place.offsets);
+            box.merge(cbox);
+        }
+        boxes[ext.name] = box;
+        ++numComputed;
+    }
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
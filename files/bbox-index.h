@@ -0,0 +1,110 @@
+// oasis/bbox-index.h -- bounding boxes of the cells in an OASIS file
+//
+// last modified:   2026/10/17
+//
+// OasisParser::parseWindow() parses only what can intersect a window.
+// To decide which placements to follow it needs the bounding box of
+// each cell, and CellBBoxIndex provides them.
+//
+// Files written with the standard properties carry an S_BOUNDING_BOX
+// property on each CELLNAME record (Appendix 2).  Its value list is
+//
+//     flags  lower-left-x  lower-left-y  width  height
+//
+// Nonzero flags mark a box that is unknown or that depends on cells
+// outside the file, and such boxes are ignored.  The index reads
+// them in a pass over the file with OasisRecordTokenizer; property
+// names given by reference-number are resolved at the end of the pass,
+// since PROPNAME records may come anywhere.
+//
+// Cells without a usable property get a computed box.  A second pass
+// with OasisCursor collects the extent of each such cell's own
+// geometry and its placements, and the boxes are then resolved bottom
+// up through the hierarchy.  Computed boxes are conservative: a
+// rotated placement contributes the box of its rotated box, and text
+// and XGEOMETRY elements only contribute their positions, since OASIS
+// gives them no extent.
+//
+// BoundingBox is a closed rectangle in database units.  The empty box
+// has xmin > xmax.
+
+#ifndef OASIS_BBOX_INDEX_H_INCLUDED
+#define OASIS_BBOX_INDEX_H_INCLUDED
+
+#include <climits>
+#include <string>
+#include <unordered_map>
+
+#include "misc/utils.h"
+#include "oasis.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+using SoftJin::Ullong;
+
+
+struct BoundingBox {
+    long        xmin, ymin, xmax, ymax;
+
+    BoundingBox() : xmin(LONG_MAX), ymin(LONG_MAX),
+                    xmax(LONG_MIN), ymax(LONG_MIN) { }
+    BoundingBox (long x0, long y0, long x1, long y1)
+      : xmin(x0), ymin(y0), xmax(x1), ymax(y1) { }
+
+    static BoundingBox  Everything() {
+                    return BoundingBox(LONG_MIN, LONG_MIN, LONG_MAX, LONG_MAX);
+                }
+
+    bool        isEmpty() const         { return (xmin > xmax  ||  ymin > ymax); }
+    bool        isUnbounded() const {
+                    return (xmin == LONG_MIN  ||  ymin == LONG_MIN
+                            ||  xmax == LONG_MAX  ||  ymax == LONG_MAX);
+                }
+    bool        intersects (const BoundingBox& b) const {
+                    return (! isEmpty()  &&  ! b.isEmpty()
+                            &&  xmin <= b.xmax  &&  b.xmin <= xmax
+                            &&  ymin <= b.ymax  &&  b.ymin <= ymax);
+                }
+
+    void        addPoint (long x, long y);
+    void        merge (const BoundingBox& b);
+    void        grow (long dx, long dy);
+    void        sweep (const BoundingBox& offsets);
+
+    BoundingBox transform (double mag, double angle, bool flip,
+                           long x, long y) const;
+    BoundingBox inverseTransform (double mag, double angle, bool flip,
+                                  long x, long y) const;
+
+    static BoundingBox  OfRepetition (const Repetition* rep);
+};
+
+
+class CellBBoxIndex {
+    std::unordered_map<string, BoundingBox>  boxes;     // by cell name
+    size_t      numFromProperty;
+    size_t      numComputed;
+
+public:
+                CellBBoxIndex();
+
+    void        build (const char* fname);
+    bool        lookup (const string& cellName,
+                        /*out*/ BoundingBox* box) const;
+
+    size_t      size() const                    { return boxes.size(); }
+    size_t      getNumFromProperty() const      { return numFromProperty; }
+    size_t      getNumComputed() const          { return numComputed; }
+
+private:
+    void        readProperties (const char* fname);
+    void        computeMissing (const char* fname);
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_BBOX_INDEX_H_INCLUDED
@@ -0,0 +1,609 @@
+// oasis/call-batch.cc -- record OasisBuilder calls for replay on another thread
+//
+// last modified:   2026/10/17
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
+#include "call-batch.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using SoftJin::Uchar;
+
+
+namespace {
+
+enum CallKind {
+    CK_BeginFile,
+    CK_EndFile,
+    CK_BeginCell,
+    CK_EndCell,
+    CK_Placement,
+    CK_Text,
+    CK_Rectangle,
+    CK_Polygon,
+    CK_Path,
+    CK_Trapezoid,
+    CK_Circle,
+    CK_XElement,
+    CK_XGeometry,
+    CK_EndElement,
+    CK_CellProperty,
+    CK_FileProperty,
+    CK_ElementProperty,
+    CK_CellName,
+    CK_TextString,
+    CK_PropName,
+    CK_PropString,
+    CK_LayerName,
+    CK_XName
+};
+
+
+// CallReader -- decode the fields of recorded calls in order
+
+class CallReader {
+    const char*  ptr;
+public:
+    explicit    CallReader (const char* ptr) : ptr(ptr) { }
+    const char* position() const        { return ptr; }
+
+    template <typename T>
+    T           get() {
+                    T  val;
+                    memcpy(&val, ptr, sizeof(T));
+                    ptr += sizeof(T);
+                    return val;
+                }
+    const char* skip (size_t n) {
+                    const char*  p = ptr;
+                    ptr += n;
+                    return p;
+                }
+    void        getPoints (/*out*/ PointList* ptlist) {
+                    Ulong  npoints = get<Ulong>();
+                    ptlist->resize(npoints);
+                    size_t  n = npoints * sizeof(Delta);
+                    if (n != 0)
+                        memcpy(ptlist->data(), skip(n), n);
+                }
+};
+
+}  // unnamed namespace
+
+
+// Points are copied into the buffer as bytes.
+static_assert(std::is_trivially_copyable<Delta>::value,
+              "Delta must be trivially copyable");
+
+
+CallBatch::CallBatch (size_t capacity)
+  : bytes(capacity == 0 ? 1 : capacity),
+    used(0),
+    numCalls(0)
+{ }
+
+
+// clear -- forget the calls recorded, keeping the buffer for reuse
+// Also forgets the repetitions, so the batch must not be being
+// replayed.
+
+void
+CallBatch::clear()
+{
+    used = 0;
+    numCalls = 0;
+    reals.clear();
+    trapezoids.clear();
+    properties.clear();
+    repCache.clear();
+}
+
+
+char*
+CallBatch::reserve (size_t n)
+{
+    if (used + n > bytes.size())
+        bytes.resize(std::max(2*bytes.size(), used + n));
+    char*  p = &bytes[used];
+    used += n;
+    return p;
+}
+
+
+void
+CallBatch::startCall (int kind)
+{
+    put<Uchar>(kind);
+    ++numCalls;
+}
+
+
+template <typename T>
+void
+CallBatch::put (const T& val)
+{
+    memcpy(reserve(sizeof(T)), &val, sizeof(T));
+}
+
+
+void
+CallBatch::putString (const string& str)
+{
+    put<Ulong>(str.size());
+    if (! str.empty())
+        memcpy(reserve(str.size()), str.data(), str.size());
+}
+
+
+void
+CallBatch::putPoints (const PointList& ptlist)
+{
+    put<Ulong>(ptlist.size());
+    size_t  n = ptlist.size() * sizeof(Delta);
+    if (n != 0)
+        memcpy(reserve(n), ptlist.data(), n);
+}
+
+
+// replay -- make the recorded calls on target, in order
+// ptlist is scratch space for point lists; a caller replaying many
+// batches passes the same one to save allocations.  The arguments are
+// read into locals first because the order in which function arguments
+// are evaluated is unspecified.
+
+void
+CallBatch::replay (OasisBuilder* target, /*inout*/ PointList* ptlist) const
+{
+    CallReader  in(bytes.data());
+    const char*  end = bytes.data() + used;
+    size_t  nextReal = 0;
+    size_t  nextTrap = 0;
+    size_t  nextProp = 0;
+
+    while (in.position() < end) {
+        int  kind = in.get<Uchar>();
+        switch (kind) {
+            case CK_BeginFile: {
+                Ulong  scheme = in.get<Ulong>();
+                Ulong  len = in.get<Ulong>();
+                string  version(in.skip(len), len);
+                target->beginFile(version, reals[nextReal++],
+                                  Validation::Scheme(scheme));
+                break;
+            }
+            case CK_EndFile:
+                target->endFile();
+                break;
+
+            case CK_BeginCell:
+                target->beginCell(in.get<CellName*>());
+                break;
+            case CK_EndCell:
+                target->endCell();
+                break;
+
+            case CK_Placement: {
+                CellName*  cellName = in.get<CellName*>();
+                long  x = in.get<long>();
+                long  y = in.get<long>();
+                bool  flip = in.get<bool>();
+                const Repetition*  rep = in.get<const Repetition*>();
+                const Oreal&  mag = reals[nextReal++];
+                const Oreal&  angle = reals[nextReal++];
+                target->beginPlacement(cellName, x, y, mag, angle, flip, rep);
+                break;
+            }
+
+            case CK_Text: {
+                Ulong  textlayer = in.get<Ulong>();
+                Ulong  texttype = in.get<Ulong>();
+                long  x = in.get<long>();
+                long  y = in.get<long>();
+                TextString*  text = in.get<TextString*>();
+                const Repetition*  rep = in.get<const Repetition*>();
+                target->beginText(textlayer, texttype, x, y, text, rep);
+                break;
+            }
+
+            case CK_Rectangle: {
+                Ulong  layer = in.get<Ulong>();
+                Ulong  datatype = in.get<Ulong>();
+                long  x = in.get<long>();
+                long  y = in.get<long>();
+                long  width = in.get<long>();
+                long  height = in.get<long>();
+                const Repetition*  rep = in.get<const Repetition*>();
+                target->beginRectangle(layer, datatype, x, y,
+                                       width, height, rep);
+                break;
+            }
+
+            case CK_Polygon: {
+                Ulong  layer = in.get<Ulong>();
+                Ulong  datatype = in.get<Ulong>();
+                long  x = in.get<long>();
+                long  y = in.get<long>();
+                const Repetition*  rep = in.get<const Repetition*>();
+                in.getPoints(ptlist);
+                target->beginPolygon(layer, datatype, x, y, *ptlist, rep);
+                break;
+            }
+
+            case CK_Path: {
+                Ulong  layer = in.get<Ulong>();
+                Ulong  datatype = in.get<Ulong>();
+                long  x = in.get<long>();
+                long  y = in.get<long>();
+                long  halfwidth = in.get<long>();
+                long  startExtn = in.get<long>();
+                long  endExtn = in.get<long>();
+                const Repetition*  rep = in.get<const Repetition*>();
+                in.getPoints(ptlist);
+                target->beginPath(layer, datatype, x, y, halfwidth,
+                                  startExtn, endExtn, *ptlist, rep);
+                break;
+            }
+
+            case CK_Trapezoid: {
+                Ulong  layer = in.get<Ulong>();
+                Ulong  datatype = in.get<Ulong>();
+                long  x = in.get<long>();
+                long  y = in.get<long>();
+                const Repetition*  rep = in.get<const Repetition*>();
+                target->beginTrapezoid(layer, datatype, x, y,
+                                       trapezoids[nextTrap++], rep);
+                break;
+            }
+
+            case CK_Circle: {
+                Ulong  layer = in.get<Ulong>();
+                Ulong  datatype = in.get<Ulong>();
+                long  x = in.get<long>();
+                long  y = in.get<long>();
+                long  radius = in.get<long>();
+                const Repetition*  rep = in.get<const Repetition*>();
+                target->beginCircle(layer, datatype, x, y, radius, rep);
+                break;
+            }
+
+            case CK_XElement: {
+                Ulong  attribute = in.get<Ulong>();
+                Ulong  len = in.get<Ulong>();
+                string  data(in.skip(len), len);
+                target->beginXElement(attribute, data);
+                break;
+            }
+
+            case CK_XGeometry: {
+                Ulong  layer = in.get<Ulong>();
+                Ulong  datatype = in.get<Ulong>();
+                long  x = in.get<long>();
+                long  y = in.get<long>();
+                Ulong  attribute = in.get<Ulong>();
+                const Repetition*  rep = in.get<const Repetition*>();
+                Ulong  len = in.get<Ulong>();
+                string  data(in.skip(len), len);
+                target->beginXGeometry(layer, datatype, x, y,
+                                       attribute, data, rep);
+                break;
+            }
+
+            case CK_EndElement:
+                target->endElement();
+                break;
+
+            case CK_CellProperty: {
+                Property  prop(properties[nextProp++]);
+                target->addCellProperty(&prop);
+                break;
+            }
+            case CK_FileProperty: {
+                Property  prop(properties[nextProp++]);
+                target->addFileProperty(&prop);
+                break;
+            }
+            case CK_ElementProperty: {
+                Property  prop(properties[nextProp++]);
+                target->addElementProperty(&prop);
+                break;
+            }
+
+            case CK_CellName:
+                target->registerCellName(in.get<CellName*>());
+                break;
+            case CK_TextString:
+                target->registerTextString(in.get<TextString*>());
+                break;
+            case CK_PropName:
+                target->registerPropName(in.get<PropName*>());
+                break;
+            case CK_PropString:
+                target->registerPropString(in.get<PropString*>());
+                break;
+            case CK_LayerName:
+                target->registerLayerName(in.get<LayerName*>());
+                break;
+            case CK_XName:
+                target->registerXName(in.get<XName*>());
+                break;
+
+            default:
+                assert (false);
+                return;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------
+// OasisBuilder methods
+
+
+void
+CallBatch::beginFile (const string& version,
+                      const Oreal& unit,
+                      Validation::Scheme valScheme)
+{
+    startCall(CK_BeginFile);
+    put<Ulong>(valScheme);
+    putString(version);
+    reals.push_back(unit);
+}
+
+
+void
+CallBatch::endFile()
+{
+    startCall(CK_EndFile);
+}
+
+
+void
+CallBatch::beginCell (CellName* cellName)
+{
+    startCall(CK_BeginCell);
+    put(cellName);
+}
+
+
+void
+CallBatch::endCell()
+{
+    startCall(CK_EndCell);
+}
+
+
+void
+CallBatch::beginPlacement (CellName* cellName,
+                           long x, long y,
+                           const Oreal&  mag,
+                           const Oreal&  angle,
+                           bool flip,
+                           const Repetition*  rep)
+{
+    startCall(CK_Placement);
+    put(cellName);
+    put(x);
+    put(y);
+    put(flip);
+    put(repCache.intern(rep));
+    reals.push_back(mag);
+    reals.push_back(angle);
+}
+
+
+void
+CallBatch::beginText (Ulong textlayer, Ulong texttype,
+                      long x, long y,
+                      TextString* text,
+                      const Repetition* rep)
+{
+    startCall(CK_Text);
+    put(textlayer);
+    put(texttype);
+    put(x);
+    put(y);
+    put(text);
+    put(repCache.intern(rep));
+}
+
+
+void
+CallBatch::beginRectangle (Ulong layer, Ulong datatype,
+                           long x, long y,
+                           long width, long height,
+                           const Repetition*  rep)
+{
+    startCall(CK_Rectangle);
+    put(layer);
+    put(datatype);
+    put(x);
+    put(y);
+    put(width);
+    put(height);
+    put(repCache.intern(rep));
+}
+
+
+void
+CallBatch::beginPolygon (Ulong layer, Ulong datatype,
+                         long x, long y,
+                         const PointList&  ptlist,
+                         const Repetition*  rep)
+{
+    startCall(CK_Polygon);
+    put(layer);
+    put(datatype);
+    put(x);
+    put(y);
+    put(repCache.intern(rep));
+    putPoints(ptlist);
+}
+
+
+void
+CallBatch::beginPath (Ulong layer, Ulong datatype,
+                      long x, long  y,
+                      long halfwidth,
+                      long startExtn, long endExtn,
+                      const PointList&  ptlist,
+                      const Repetition*  rep)
+{
+    startCall(CK_Path);
+    put(layer);
+    put(datatype);
+    put(x);
+    put(y);
+    put(halfwidth);
+    put(startExtn);
+    put(endExtn);
+    put(repCache.intern(rep));
+    putPoints(ptlist);
+}
+
+
+void
+CallBatch::beginTrapezoid (Ulong layer, Ulong datatype,
+                           long x, long  y,
+                           const Trapezoid& trap,
+                           const Repetition*  rep)
+{
+    startCall(CK_Trapezoid);
+    put(layer);
+    put(datatype);
+    put(x);
+    put(y);
+    put(repCache.intern(rep));
+    trapezoids.push_back(trap);
+}
+
+
+void
+CallBatch::beginCircle (Ulong layer, Ulong datatype,
+                        long x, long y,
+                        long radius,
+                        const Repetition*  rep)
+{
+    startCall(CK_Circle);
+    put(layer);
+    put(datatype);
+    put(x);
+    put(y);
+    put(radius);
+    put(repCache.intern(rep));
+}
+
+
+void
+CallBatch::beginXElement (Ulong attribute, const string& data)
+{
+    startCall(CK_XElement);
+    put(attribute);
+    putString(data);
+}
+
+
+void
+CallBatch::beginXGeometry (Ulong layer, Ulong datatype,
+                           long x, long y,
+                           Ulong attribute,
+                           const string& data,
+                           const Repetition*  rep)
+{
+    startCall(CK_XGeometry);
+    put(layer);
+    put(datatype);
+    put(x);
+    put(y);
+    put(attribute);
+    put(repCache.intern(rep));
+    putString(data);
+}
+
+
+void
+CallBatch::endElement()
+{
+    startCall(CK_EndElement);
+}
+
+
+void
+CallBatch::addCellProperty (Property* prop)
+{
+    startCall(CK_CellProperty);
+    properties.push_back(*prop);
+}
+
+
+void
+CallBatch::addFileProperty (Property* prop)
+{
+    startCall(CK_FileProperty);
+    properties.push_back(*prop);
+}
+
+
+void
+CallBatch::addElementProperty (Property* prop)
+{
+    startCall(CK_ElementProperty);
+    properties.push_back(*prop);
+}
+
+
+void
+CallBatch::registerCellName (CellName* cellName)
+{
+    startCall(CK_CellName);
+    put(cellName);
+}
+
+
+void
+CallBatch::registerTextString (TextString* textString)
+{
+    startCall(CK_TextString);
+    put(textString);
+}
+
+
+void
+CallBatch::registerPropName (PropName* propName)
+{
+    startCall(CK_PropName);
+    put(propName);
+}
+
+
+void
+CallBatch::registerPropString (PropString* propString)
+{
+    startCall(CK_PropString);
+    put(propString);
+}
+
+
+void
+CallBatch::registerLayerName (LayerName* layerName)
+{
+    startCall(CK_LayerName);
+    put(layerName);
+}
+
+
+void
+CallBatch::registerXName (XName* xname)
+{
+    startCall(CK_XName);
+    put(xname);
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
@@ -0,0 +1,166 @@
+// oasis/call-batch.h -- record OasisBuilder calls for replay on another thread
+//
+// last modified:   2026/10/17
+//
+// TeeBuilder's threaded mode and PipelineBuilder both hand the parser's
+// calls to a builder running on another thread.  CallBatch is what they
+// hand over.  It is itself an OasisBuilder: each call made on it is
+// recorded, and replay() later makes the same calls, in the same order,
+// on a target.
+//
+// The calls are packed into a byte buffer: a kind byte followed by the
+// arguments in their native representation, with point lists and
+// strings inline.  Oreals, trapezoids and properties, which are not
+// plain data, go into side tables in the order of the calls that use
+// them.
+//
+// Pointer validity.  What the parser passes is valid only for the
+// duration of the call, so the batch holds copies of point lists,
+// strings, trapezoids and properties.  replay() gives each property to
+// the target as a copy of its own, because the builder interface passes
+// it as non-const and a batch may be replayed on several targets.
+// Repetitions may be no better: a parser passes its modal Repetition
+// object, which the next record overwrites.  So each repetition is
+// interned in the batch's own RepetitionCache, and the target gets the
+// cache's pointer.  Like every Repetition a builder is given, that
+// pointer is valid only during the call; a target that keeps the
+// repetition interns it in a cache of its own (rep-intern.h).  Because
+// the cache belongs to the batch, clear() empties it and memory stays
+// bounded by the size of a batch, however long the file.
+//
+// Name pointers (CellName, TextString, ...) are recorded as they are.
+// The parser keeps its names until it is destroyed, so it must outlive
+// the replay.
+//
+// A batch is filled by one thread and replayed by others.  The caller
+// provides the synchronization that makes the recording visible to
+// the replaying threads, and must not record into a batch while it is
+// being replayed.
+
+#ifndef OASIS_CALL_BATCH_H_INCLUDED
+#define OASIS_CALL_BATCH_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include "misc/utils.h"
+#include "oasis.h"
+#include "builder.h"
+#include "rep-intern.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+using std::vector;
+using SoftJin::Ulong;
+
+
+class CallBatch : public OasisBuilder {
+    vector<char>        bytes;
+    size_t              used;           // bytes recorded so far
+    size_t              numCalls;
+    vector<Oreal>       reals;
+    vector<Trapezoid>   trapezoids;
+    vector<Property>    properties;
+    RepetitionCache     repCache;       // owns the repetitions recorded
+
+public:
+    explicit    CallBatch (size_t capacity = 16*1024);
+
+    void        clear();
+    bool        empty() const           { return (numCalls == 0); }
+    size_t      size() const            { return numCalls; }
+    size_t      byteSize() const        { return used; }
+
+    void        replay (OasisBuilder* target,
+                        /*inout*/ PointList* ptlist) const;
+
+    // OasisBuilder virtual methods.  Each records the call.
+
+    virtual void  beginFile (const string& version,
+                             const Oreal& unit,
+                             Validation::Scheme valScheme);
+    virtual void  endFile();
+
+    virtual void  beginCell (CellName* cellName);
+    virtual void  endCell();
+
+    virtual void  beginPlacement (CellName* cellName,
+                                  long x, long y,
+                                  const Oreal&  mag,
+                                  const Oreal&  angle,
+                                  bool flip,
+                                  const Repetition*  rep);
+
+    virtual void  beginText (Ulong textlayer, Ulong texttype,
+                             long x, long y,
+                             TextString* text,
+                             const Repetition* rep);
+
+    virtual void  beginRectangle (Ulong layer, Ulong datatype,
+                                  long x, long y,
+                                  long width, long height,
+                                  const Repetition*  rep);
+
+    virtual void  beginPolygon (Ulong layer, Ulong datatype,
+                                long x, long y,
+                                const PointList&  ptlist,
+                                const Repetition*  rep);
+
+    virtual void  beginPath (Ulong layer, Ulong datatype,
+                             long x, long  y,
+                             long halfwidth,
+                             long startExtn, long endExtn,
+                             const PointList&  ptlist,
+                             const Repetition*  rep);
+
+    virtual void  beginTrapezoid (Ulong layer, Ulong datatype,
+                                  long x, long  y,
+                                  const Trapezoid& trap,
+                                  const Repetition*  rep);
+
+    virtual void  beginCircle (Ulong layer, Ulong datatype,
+                               long x, long y,
+                               long radius,
+                               const Repetition*  rep);
+
+    virtual void  beginXElement (Ulong attribute, const string& data);
+
+    virtual void  beginXGeometry (Ulong layer, Ulong datatype,
+                                  long x, long y,
+                                  Ulong attribute,
+                                  const string& data,
+                                  const Repetition*  rep);
+
+    virtual void  endElement();
+
+    virtual void  addCellProperty (Property* prop);
+    virtual void  addFileProperty (Property* prop);
+    virtual void  addElementProperty (Property* prop);
+
+    virtual void  registerCellName   (CellName*   cellName);
+    virtual void  registerTextString (TextString* textString);
+    virtual void  registerPropName   (PropName*   propName);
+    virtual void  registerPropString (PropString* propString);
+    virtual void  registerLayerName  (LayerName*  layerName);
+    virtual void  registerXName      (XName*      xname);
+
+private:
+    char*       reserve (size_t n);
+    void        startCall (int kind);
+    template <typename T>
+    void        put (const T& val);
+    void        putString (const string& str);
+    void        putPoints (const PointList& ptlist);
+
+private:
+                CallBatch (const CallBatch&);           // forbidden
+    void        operator= (const CallBatch&);           // forbidden
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_CALL_BATCH_H_INCLUDED
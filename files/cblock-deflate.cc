@@ -0,0 +1,321 @@
+// oasis/cblock-deflate.cc -- compress cells into CBLOCKs on background threads
+//
+// last modified:   2026/10/17
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <zlib.h>
+
+#include "rectypes.h"
+#include "varint.h"
+#include "cblock-deflate.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::runtime_error;
+using std::unique_lock;
+using std::mutex;
+
+
+// bodyStart is this until beginBody() is called.
+const size_t  NoBody = ~size_t(0);
+
+
+CellBuffer::CellBuffer() {
+    bodyStart = NoBody;
+}
+
+
+void
+CellBuffer::clear()
+{
+    bytes.clear();
+    cuts.clear();
+    bodyStart = NoBody;
+}
+
+
+// beginBody -- what follows is the cell's contents, to be compressed
+
+void
+CellBuffer::beginBody() {
+    bodyStart = bytes.size();
+}
+
+
+void
+CellBuffer::beginRecord (Ulong recID)
+{
+    if (bodyStart != NoBody) {
+        size_t  blockStart = (cuts.empty() ? bodyStart : cuts.back());
+        if (bytes.size() - blockStart >= CblockSize)
+            cuts.push_back(bytes.size());
+    }
+    writeUInt(recID);
+}
+
+
+void
+CellBuffer::writeBytes (const void* buf, size_t nbytes)
+{
+    const Uchar*  p = static_cast<const Uchar*>(buf);
+    bytes.insert(bytes.end(), p, p + nbytes);
+}
+
+
+void
+CellBuffer::writeUInt (Ullong val)
+{
+    size_t  n = bytes.size();
+    bytes.resize(n + MaxVarintBytes);
+    bytes.resize(n + EncodeUInt(val, &bytes[n]));
+}
+
+
+void
+CellBuffer::writeSInt (llong val)
+{
+    size_t  n = bytes.size();
+    bytes.resize(n + MaxVarintBytes);
+    bytes.resize(n + EncodeSInt(val, &bytes[n]));
+}
+
+
+// writeReal -- Section 7.3: real
+// The same forms as OasisWriter::writeReal(), so that the file does not
+// depend on compressThreads: a rational is written as an integer (type
+// 0 or 1), a reciprocal (2 or 3) or a ratio (4 or 5), and anything
+// else as an IEEE single (type 6) if that holds it exactly, otherwise
+// as a double (type 7).
+
+void
+CellBuffer::writeReal (const Oreal& val)
+{
+    if (val.isRational()) {
+        long   numer = val.getNumerator();
+        Ulong  denom = val.getDenominator();
+        bool   neg = (numer < 0);
+        Ulong  mag = (neg ? -Ulong(numer) : Ulong(numer));
+        if (denom == 1) {
+            writeUInt(neg ? 1 : 0);
+            writeUInt(mag);
+        } else if (mag == 1) {
+            writeUInt(neg ? 3 : 2);
+            writeUInt(denom);
+        } else {
+            writeUInt(neg ? 5 : 4);
+            writeUInt(mag);
+            writeUInt(denom);
+        }
+        return;
+    }
+
+    double  value = val.getValue();
+    float   fvalue = float(value);
+    if (double(fvalue) == value) {
+        Uint  bits;
+        memcpy(&bits, &fvalue, sizeof bits);
+        writeUInt(6);
+        for (int j = 0;  j < 4;  ++j)
+            writeByte(int(bits >> 8*j) & 0xff);
+        return;
+    }
+
+    Ullong  bits;
+    memcpy(&bits, &value, sizeof bits);
+    writeUInt(7);
+    for (int j = 0;  j < 8;  ++j)
+        writeByte(int(bits >> 8*j) & 0xff);
+}
+
+
+void
+CellBuffer::writeString (const string& str)
+{
+    writeUInt(str.size());
+    writeBytes(str.data(), str.size());
+}
+
+
+//----------------------------------------------------------------------
+
+
+CblockDeflater::CblockDeflater (unsigned nthreads)
+{
+    queuedBytes = 0;
+    shuttingDown = false;
+    for (unsigned j = 0;  j < std::max(nthreads, 1u);  ++j)
+        workers.push_back(std::thread(&CblockDeflater::runWorker, this));
+}
+
+
+CblockDeflater::~CblockDeflater()
+{
+    {
+        unique_lock<mutex>  lock(queueMutex);
+        shuttingDown = true;
+    }
+    jobReady.notify_all();
+    for (size_t j = 0;  j < workers.size();  ++j)
+        workers[j].join();
+}
+
+
+// submit -- queue a finished cell
+// Takes the cell's bytes and leaves cell cleared for the next one.
+// If compress is false the bytes are written as they are, but still in
+// their turn.
+
+void
+CblockDeflater::submit (CellBuffer* cell, bool compress)
+{
+    JobPtr  job(new Job);
+    job->data.swap(cell->bytes);
+    job->cuts.swap(cell->cuts);
+    job->numBytes = job->data.size();
+    job->bodyStart = std::min(cell->bodyStart, job->numBytes);
+    job->compress = compress;
+    job->done = ! compress;
+    if (! compress)
+        job->out.swap(job->data);
+    cell->clear();
+
+    {
+        unique_lock<mutex>  lock(queueMutex);
+        jobs.push_back(job);
+        if (compress)
+            unclaimed.push_back(job);
+        queuedBytes += job->numBytes;
+    }
+    if (compress)
+        jobReady.notify_one();
+}
+
+
+// collect -- take the output of the oldest submitted cell
+// Returns false if nothing has been submitted that was not collected,
+// or if wait is false and the oldest cell is not ready.  Throws
+// runtime_error if compressing the cell failed.
+
+bool
+CblockDeflater::collect (/*out*/ vector<Uchar>* out, bool wait)
+{
+    unique_lock<mutex>  lock(queueMutex);
+    if (jobs.empty())
+        return false;
+
+    JobPtr  job = jobs.front();
+    if (! job->done) {
+        if (! wait)
+            return false;
+        jobDone.wait(lock, [&]() { return job->done; });
+    }
+    jobs.pop_front();
+    queuedBytes -= job->numBytes;
+    lock.unlock();
+
+    if (! job->error.empty())
+        throw runtime_error(job->error);
+    out->swap(job->out);
+    return true;
+}
+
+
+size_t
+CblockDeflater::numQueued()
+{
+    unique_lock<mutex>  lock(queueMutex);
+    return jobs.size();
+}
+
+
+size_t
+CblockDeflater::getQueuedBytes()
+{
+    unique_lock<mutex>  lock(queueMutex);
+    return queuedBytes;
+}
+
+
+void
+CblockDeflater::runWorker()
+{
+    unique_lock<mutex>  lock(queueMutex);
+    for (;;) {
+        jobReady.wait(lock, [&]() {
+            return (shuttingDown  ||  ! unclaimed.empty());
+        });
+        if (shuttingDown)
+            return;
+
+        JobPtr  job = unclaimed.front();
+        unclaimed.pop_front();
+        lock.unlock();
+        try {
+            deflateJob(job.get());
+        } catch (const std::exception& exc) {
+            job->error = exc.what();
+        }
+        lock.lock();
+        job->done = true;
+        jobDone.notify_all();
+    }
+}
+
+
+// deflateJob -- the CELL record as it is, then the contents as CBLOCKs
+// Section 35: CBLOCK record
+// `34' comp-type uncomp-byte-count comp-byte-count comp-bytes
+// comp-type 0 is DEFLATE (RFC 1951) without a zlib header.
+
+/*static*/ void
+CblockDeflater::deflateJob (Job* job)
+{
+    const Uchar*  data = job->data.data();
+    vector<Uchar>&  out = job->out;
+    out.assign(data, data + job->bodyStart);
+
+    z_stream  zs;
+    memset(&zs, 0, sizeof zs);
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                     8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        job->error = "CBLOCK compression failed: deflateInit2";
+        return;
+    }
+
+    vector<Uchar>  comp;
+    size_t  start = job->bodyStart;
+    for (size_t j = 0;  j <= job->cuts.size();  ++j) {
+        size_t  end = (j < job->cuts.size() ? job->cuts[j] : job->data.size());
+        if (end == start)
+            continue;
+
+        deflateReset(&zs);
+        comp.resize(deflateBound(&zs, end - start));
+        zs.next_in = const_cast<Uchar*>(data + start);
+        zs.avail_in = end - start;
+        zs.next_out = comp.data();
+        zs.avail_out = comp.size();
+        if (deflate(&zs, Z_FINISH) != Z_STREAM_END) {
+            job->error = "CBLOCK compression failed";
+            break;
+        }
+
+        Uchar   header[4 * MaxVarintBytes];
+        size_t  n = EncodeUInt(RID_CBLOCK, header);
+        n += EncodeUInt(0, header + n);
+        n += EncodeUInt(end - start, header + n);
+        n += EncodeUInt(zs.total_out, header + n);
+        out.insert(out.end(), header, header + n);
+        out.insert(out.end(), comp.data(), comp.data() + zs.total_out);
+        start = end;
+    }
+    deflateEnd(&zs);
+    vector<Uchar>().swap(job->data);
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
@@ -0,0 +1,139 @@
+// oasis/cblock-deflate.h -- compress cells into CBLOCKs on background threads
+//
+// last modified:   2026/10/17
+//
+// When OasisCreator compresses its output, deflate takes most of the
+// time, and doing it inline keeps the whole copy on one core.
+// CblockDeflater is the writing counterpart of CblockPrefetcher.  The
+// creator encodes each cell into a CellBuffer instead of the file and
+// submits it; a pool of worker threads turns the buffers into CBLOCK
+// records; and the creator collects the results in submission order
+// and writes them to the file.  This is what pigz does for gzip.
+//
+// Cells can be compressed independently because each one starts with
+// the modal variables reset (Section 10.1), and a CBLOCK may not
+// straddle the end of a cell anyway.  The file offset of a cell is
+// known only when it is written, so the creator records the offsets for
+// S_CELL_OFFSET as it collects the cells, not as it begins them.
+//
+// A CellBuffer holds the CELL record, which is written as it is,
+// followed by the cell's contents, which are compressed.  The contents
+// are cut into CBLOCKs of about CblockSize uncompressed bytes, always
+// at a record boundary since records may not straddle a CBLOCK.
+//
+// Memory is bounded by the caller, not here.  The creator stops to
+// collect (waiting if need be) whenever more than maxQueuedBytes of
+// submitted cells are outstanding.
+
+#ifndef OASIS_CBLOCK_DEFLATE_H_INCLUDED
+#define OASIS_CBLOCK_DEFLATE_H_INCLUDED
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "misc/utils.h"
+#include "oasis.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+using std::vector;
+using SoftJin::Uchar;
+using SoftJin::Uint;
+using SoftJin::Ulong;
+using SoftJin::Ullong;
+using SoftJin::llong;
+
+
+// Uncompressed size at which a cell's contents are cut into another
+// CBLOCK.  Large enough to compress well, small enough that a reader
+// need not hold much of a huge cell inflated.
+const size_t  CblockSize = 256 * 1024;
+
+
+// CellBuffer -- one cell's records encoded in memory
+// The write methods encode as OasisWriter does.  beginRecord() must be
+// called before each record so that the contents can be cut into
+// CBLOCKs between records.
+
+class CellBuffer {
+    friend class CblockDeflater;
+
+    vector<Uchar>   bytes;
+    size_t          bodyStart;          // where the contents begin
+    vector<size_t>  cuts;               // where a new CBLOCK begins
+
+public:
+                CellBuffer();
+
+    void        clear();
+    void        beginBody();
+    void        beginRecord (Ulong recID);
+    size_t      size() const            { return bytes.size(); }
+
+    void        writeByte (int byte)    { bytes.push_back(Uchar(byte)); }
+    void        writeBytes (const void* buf, size_t nbytes);
+    void        writeUInt (Ullong val);
+    void        writeSInt (llong val);
+    void        writeReal (const Oreal& val);
+    void        writeString (const string& str);
+
+private:
+                CellBuffer (const CellBuffer&);         // forbidden
+    void        operator= (const CellBuffer&);          // forbidden
+};
+
+
+class CblockDeflater {
+    struct Job {
+        vector<Uchar>   data;           // the CellBuffer's bytes
+        size_t          numBytes;       // data.size() when submitted
+        size_t          bodyStart;
+        vector<size_t>  cuts;
+        bool            compress;       // false => write data as it is
+        vector<Uchar>   out;            // what goes into the file
+        bool            done;           // out is ready (or error set)
+        string          error;          // non-empty if compression failed
+    };
+    typedef std::shared_ptr<Job>  JobPtr;
+
+    std::mutex               queueMutex;
+    std::condition_variable  jobReady;      // submit() -> workers
+    std::condition_variable  jobDone;       // workers -> collect()
+
+    std::deque<JobPtr>  jobs;               // submitted cells in order
+    std::deque<JobPtr>  unclaimed;          // jobs no worker has taken
+    size_t              queuedBytes;        // sum of data sizes in jobs
+    bool                shuttingDown;
+
+    vector<std::thread> workers;
+
+public:
+    explicit    CblockDeflater (unsigned nthreads);
+                ~CblockDeflater();
+
+    void        submit (CellBuffer* cell, bool compress);
+    bool        collect (/*out*/ vector<Uchar>* out, bool wait);
+    size_t      numQueued();
+    size_t      getQueuedBytes();
+
+private:
+    void        runWorker();
+    static void deflateJob (Job* job);
+
+private:
+                CblockDeflater (const CblockDeflater&);     // forbidden
+    void        operator= (const CblockDeflater&);          // forbidden
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_CBLOCK_DEFLATE_H_INCLUDED
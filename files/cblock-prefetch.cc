@@ -0,0 +1,241 @@
+// oasis/cblock-prefetch.cc -- inflate upcoming CBLOCKs on background threads
+//
+// last modified:   2026/10/17
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "rectypes.h"
+#include "mapped-scanner.h"
+#include "rec-tokenizer.h"
+#include "cblock-prefetch.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::unique_lock;
+using std::mutex;
+
+
+CblockPrefetcher::CblockPrefetcher (const MappedFile& mfile,
+                                    unsigned nthreads,
+                                    size_t maxQueuedBytes)
+  : mfile(mfile),
+    maxQueuedBytes(maxQueuedBytes)
+{
+    queuedBytes = 0;
+    numTaken = 0;
+    scoutOffset = 0;
+    generation = 0;
+    scoutActive = false;
+    shuttingDown = false;
+
+    scout = std::thread(&CblockPrefetcher::runScout, this);
+    for (unsigned j = 0;  j < std::max(nthreads, 1u);  ++j)
+        workers.push_back(std::thread(&CblockPrefetcher::runWorker, this));
+}
+
+
+CblockPrefetcher::~CblockPrefetcher()
+{
+    {
+        unique_lock<mutex>  lock(queueMutex);
+        shuttingDown = true;
+    }
+    jobReady.notify_all();
+    blockDone.notify_all();
+    spaceFree.notify_all();
+    scoutWanted.notify_all();
+
+    scout.join();
+    for (size_t j = 0;  j < workers.size();  ++j)
+        workers[j].join();
+}
+
+
+// restart -- start looking for CBLOCKs at a new record boundary
+// The consumer calls this whenever it seeks.  Blocks already queued
+// belong to the old position and are dropped.  Workers still inflating
+// them finish harmlessly because each holds its own reference.
+
+void
+CblockPrefetcher::restart (Ullong offset)
+{
+    {
+        unique_lock<mutex>  lock(queueMutex);
+        ++generation;
+        jobs.clear();
+        queuedBytes = 0;
+        scoutOffset = offset;
+        scoutActive = true;
+    }
+    scoutWanted.notify_one();
+    spaceFree.notify_all();
+}
+
+
+// take -- hand over the inflated contents of the CBLOCK at cblockOffset
+// Blocks before cblockOffset are discarded; the consumer has moved past
+// them.  Returns false if the prefetcher does not have (and will not
+// get) that block, or if inflating it failed.  In either case the
+// consumer inflates the block itself and reports any error.
+
+bool
+CblockPrefetcher::take (Ullong cblockOffset, /*out*/ vector<Uchar>* buf)
+{
+    unique_lock<mutex>  lock(queueMutex);
+
+    for (;;) {
+        while (! jobs.empty()  &&  jobs.front()->offset < cblockOffset) {
+            queuedBytes -= jobs.front()->uncompCount;
+            jobs.pop_front();
+            spaceFree.notify_one();
+        }
+        if (! jobs.empty()  ||  ! scoutActive  ||  shuttingDown)
+            break;
+        blockDone.wait(lock);
+    }
+    if (jobs.empty()  ||  jobs.front()->offset != cblockOffset)
+        return false;
+
+    JobPtr  job = jobs.front();
+    blockDone.wait(lock, [&]() { return (job->done  ||  shuttingDown); });
+    jobs.pop_front();
+    queuedBytes -= job->uncompCount;
+    spaceFree.notify_one();
+
+    if (! job->done  ||  ! job->error.empty())
+        return false;
+    buf->swap(job->data);
+    ++numTaken;
+    return true;
+}
+
+
+void
+CblockPrefetcher::runScout()
+{
+    unique_lock<mutex>  lock(queueMutex);
+    for (;;) {
+        scoutWanted.wait(lock, [this]() {
+            return (shuttingDown  ||  scoutActive);
+        });
+        if (shuttingDown)
+            return;
+
+        Ullong  offset = scoutOffset;
+        Ullong  gen = generation;
+        lock.unlock();
+        bool  current = scoutFrom(offset, gen);
+        lock.lock();
+
+        // If restart() was called meanwhile, scoutActive is already
+        // set for the new position; leave it alone.
+        if (current  &&  gen == generation)
+            scoutActive = false;
+        blockDone.notify_all();         // wake a consumer waiting for jobs
+    }
+}
+
+
+// scoutFrom -- walk top-level records from offset, queuing CBLOCKs
+// The tokenizer steps over every other record, so the scout gets past
+// START, the name and table records and uncompressed cells.  It never
+// enters a CBLOCK; cells inside one cannot contain another.  Returns
+// false if it stopped because restart() changed the generation or the
+// prefetcher is shutting down, true if it stopped at the end of the
+// file or at a record it cannot handle.
+
+bool
+CblockPrefetcher::scoutFrom (Ullong offset, Ullong gen)
+{
+    MappedScanner  scanner(mfile);
+    OasisRecordTokenizer  tokenizer(scanner);
+    try {
+        tokenizer.seekTo(offset);
+        while (tokenizer.next()) {
+            const RecordCursor&  curs = tokenizer.cursor();
+            if (curs.recID != RID_CBLOCK)
+                continue;
+
+            JobPtr  job(new Job);
+            Ulong  compType = scanner.readUInt();
+            job->offset = curs.offset;
+            job->uncompCount = scanner.readUInt64();
+            job->compCount = scanner.readUInt64();
+            job->claimed = false;
+            job->done = false;
+            tokenizer.claimRecord();
+
+            Ullong  dataOffset = scanner.currFileOffset();
+            if (compType != 0
+                    ||  ! mfile.contains(dataOffset, job->compCount))
+                return true;
+            job->compData = mfile.getData() + dataOffset;
+
+            unique_lock<mutex>  lock(queueMutex);
+            spaceFree.wait(lock, [&]() {
+                return (shuttingDown  ||  gen != generation
+                        ||  jobs.empty()
+                        ||  queuedBytes <= maxQueuedBytes);
+            });
+            if (shuttingDown  ||  gen != generation)
+                return false;
+            jobs.push_back(job);
+            queuedBytes += job->uncompCount;
+            lock.unlock();
+            jobReady.notify_one();
+            blockDone.notify_all();
+
+            tokenizer.seekTo(dataOffset + job->compCount);
+        }
+    }
+    catch (const std::exception&) {
+        // Malformed input.  Stop scouting; the consumer's own scanner
+        // will meet the same bytes and report the error properly.
+    }
+    return true;
+}
+
+
+void
+CblockPrefetcher::runWorker()
+{
+    unique_lock<mutex>  lock(queueMutex);
+    for (;;) {
+        JobPtr  job;
+        jobReady.wait(lock, [&]() {
+            if (shuttingDown)
+                return true;
+            for (size_t j = 0;  j < jobs.size();  ++j) {
+                if (! jobs[j]->claimed) {
+                    job = jobs[j];
+                    return true;
+                }
+            }
+            return false;
+        });
+        if (shuttingDown)
+            return;
+
+        job->claimed = true;
+        lock.unlock();
+        inflateJob(job.get());
+        lock.lock();
+        job->done = true;
+        blockDone.notify_all();
+    }
+}
+
+
+/*static*/ void
+CblockPrefetcher::inflateJob (Job* job)
+{
+    if (! InflateCblock(job->compData, job->compCount, job->uncompCount,
+                        &job->data))
+        job->error = "CBLOCK decompression failed";
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
@@ -0,0 +1,115 @@
+// oasis/cblock-prefetch.h -- inflate upcoming CBLOCKs on background threads
+//
+// last modified:   2026/10/17
+//
+// In compressed OASIS files almost every byte is inside a CBLOCK, and
+// inflating them inline makes decompression and record decoding take
+// turns on one core.  CblockPrefetcher overlaps the two.  A scout
+// thread walks the top-level records ahead of the consumer, finds the
+// CBLOCK records, and queues them; a pool of worker threads inflates
+// the queued blocks.  The consumer (a MappedScanner) collects the
+// inflated buffers in file order with take().
+//
+// The scout walks the records with an OasisRecordTokenizer
+// (rec-tokenizer.h), which steps over START, the name and table records
+// and uncompressed elements without decoding them.  If it meets a CBLOCK
+// it cannot queue (an unknown compression type or truncated data) or a
+// malformed record it stops, and the consumer inflates the remaining
+// CBLOCKs inline as before.  The prefetcher is purely an accelerator:
+// take() returning false is never an error.  getNumTaken() says how
+// many blocks the consumer got from it.
+//
+// Memory is bounded.  The scout stops queuing once the uncompressed
+// size of the queued blocks exceeds maxQueuedBytes, and resumes as the
+// consumer takes them.
+//
+// Scope.  Only MappedScanner can take from a prefetcher, and the one
+// pass that attaches one is CellOffsetIndex::build() (cell-index.h),
+// which the parser runs for useCellIndex with a thread per core.  The
+// cells that OasisParser then parses -- parseCell(),
+// CreateLayoutDataBase() and the workers of parseFileParallel() -- are
+// read through OasisScanner, which inflates each CBLOCK inline when it
+// reaches it, with or without useMappedInput.  Prefetching those would
+// first need the parser to read records through MappedScanner.
+
+#ifndef OASIS_CBLOCK_PREFETCH_H_INCLUDED
+#define OASIS_CBLOCK_PREFETCH_H_INCLUDED
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "misc/utils.h"
+#include "mapped-file.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+using std::vector;
+using SoftJin::Uchar;
+using SoftJin::Ullong;
+
+
+class CblockPrefetcher {
+    struct Job {
+        Ullong          offset;         // file offset of CBLOCK record
+        const Uchar*    compData;       // compressed bytes in the mapping
+        Ullong          compCount;
+        Ullong          uncompCount;
+        vector<Uchar>   data;           // inflated bytes
+        bool            claimed;        // a worker has taken it
+        bool            done;           // data is ready (or error set)
+        string          error;          // non-empty if inflation failed
+    };
+    typedef std::shared_ptr<Job>  JobPtr;
+
+    const MappedFile&   mfile;
+    size_t              maxQueuedBytes;
+
+    std::mutex               queueMutex;
+    std::condition_variable  jobReady;      // scout -> workers
+    std::condition_variable  blockDone;     // workers -> consumer
+    std::condition_variable  spaceFree;     // consumer -> scout
+    std::condition_variable  scoutWanted;   // restart() -> scout
+
+    std::deque<JobPtr>  jobs;               // queued blocks in file order
+    size_t              queuedBytes;        // sum of uncompCount in jobs
+    Ullong              numTaken;           // blocks handed over by take()
+    Ullong              scoutOffset;        // where the scout resumes
+    Ullong              generation;         // bumped by restart()
+    bool                scoutActive;        // scout is walking records
+    bool                shuttingDown;
+
+    std::thread          scout;
+    vector<std::thread>  workers;
+
+public:
+                CblockPrefetcher (const MappedFile& mfile, unsigned nthreads,
+                                  size_t maxQueuedBytes = 64 << 20);
+                ~CblockPrefetcher();
+
+    void        restart (Ullong offset);
+    bool        take (Ullong cblockOffset, /*out*/ vector<Uchar>* buf);
+    Ullong      getNumTaken() const     { return numTaken; }
+
+private:
+    void        runScout();
+    void        runWorker();
+    bool        scoutFrom (Ullong offset, Ullong gen);
+    static void inflateJob (Job* job);
+
+private:
+                CblockPrefetcher (const CblockPrefetcher&);  // forbidden
+    void        operator= (const CblockPrefetcher&);         // forbidden
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_CBLOCK_PREFETCH_H_INCLUDED
@@ -0,0 +1,277 @@
+// oasis/cell-graph.cc -- compact placement graph of the cells in a file
+//
+// last modified:   2026/10/17
+
+#include <algorithm>
+
+#include "cell-graph.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+
+namespace {
+
+// Merge the pending edges when there are this many, so that a cell
+// that alternates between children cannot make the list grow without
+// bound.
+const size_t  InitialCompactSize = 1 << 20;
+
+}  // unnamed namespace
+
+
+CellGraph::CellGraph()
+{
+    clear();
+}
+
+
+void
+CellGraph::clear()
+{
+    numNodes = 0;
+    pending.clear();
+    compactAt = InitialCompactSize;
+    offsets.assign(1, 0);
+    targets.clear();
+    counts.clear();
+    inDegrees.clear();
+    topoOrder.clear();
+    levels.clear();
+    numLevels = 0;
+    acyclic = true;
+    numPlacements = 0;
+    final = true;
+}
+
+
+// addNode -- add a node and return its number
+
+Uint
+CellGraph::addNode()
+{
+    final = false;
+    return numNodes++;
+}
+
+
+// reserveNodes -- make sure nodes 0 .. n-1 exist
+
+void
+CellGraph::reserveNodes (Uint n)
+{
+    if (n > numNodes) {
+        numNodes = n;
+        final = false;
+    }
+}
+
+
+// addEdge -- record one placement of child in parent
+// Both nodes must exist.
+
+void
+CellGraph::addEdge (Uint parent, Uint child)
+{
+    assert (parent < numNodes  &&  child < numNodes);
+
+    final = false;
+    if (! pending.empty()) {
+        Edge&  last = pending.back();
+        if (last.parent == parent  &&  last.child == child) {
+            ++last.count;
+            return;
+        }
+    }
+    if (pending.size() >= compactAt) {
+        compactPending();
+        if (pending.size() >= compactAt/2)
+            compactAt *= 2;
+    }
+    Edge  edge;
+    edge.parent = parent;
+    edge.child = child;
+    edge.count = 1;
+    pending.push_back(edge);
+}
+
+
+// compactPending -- sort the pending edges and merge duplicates
+
+void
+CellGraph::compactPending()
+{
+    std::sort(pending.begin(), pending.end(),
+              [](const Edge& a, const Edge& b) {
+                  return (a.parent < b.parent
+                          ||  (a.parent == b.parent  &&  a.child < b.child));
+              });
+    size_t  out = 0;
+    for (size_t j = 0;  j < pending.size();  ++j) {
+        if (out > 0  &&  pending[out-1].parent == pending[j].parent
+                &&  pending[out-1].child == pending[j].child)
+            pending[out-1].count += pending[j].count;
+        else
+            pending[out++] = pending[j];
+    }
+    pending.resize(out);
+}
+
+
+// finalize -- merge the pending edges into the CSR arrays
+// and recompute everything derived from them.
+
+void
+CellGraph::finalize()
+{
+    if (final)
+        return;
+
+    // Put the existing edges back into the pending list so that one
+    // sort merges old and new.
+    Uint  oldNodes = offsets.size() - 1;
+    for (Uint n = 0;  n < oldNodes;  ++n) {
+        for (Uint e = offsets[n];  e < offsets[n+1];  ++e) {
+            Edge  edge;
+            edge.parent = n;
+            edge.child = targets[e];
+            edge.count = counts[e];
+            pending.push_back(edge);
+        }
+    }
+    compactPending();
+
+    offsets.assign(numNodes + 1, 0);
+    targets.resize(pending.size());
+    counts.resize(pending.size());
+    inDegrees.assign(numNodes, 0);
+    numPlacements = 0;
+    for (size_t j = 0;  j < pending.size();  ++j) {
+        const Edge&  edge = pending[j];
+        ++offsets[edge.parent + 1];
+        targets[j] = edge.child;
+        counts[j] = edge.count;
+        ++inDegrees[edge.child];
+        numPlacements += edge.count;
+    }
+    for (Uint n = 0;  n < numNodes;  ++n)
+        offsets[n+1] += offsets[n];
+
+    pending.clear();
+    pending.shrink_to_fit();
+    compactAt = InitialCompactSize;
+    final = true;
+    computeOrder();
+}
+
+
+// computeOrder -- topological order and levels
+// Kahn's algorithm run upwards: a node is ready when all its children
+// have been ordered.  Nodes start in node order, so the result depends
+// only on the graph.
+
+void
+CellGraph::computeOrder()
+{
+    // Parents of each node, as a second CSR.
+    vector<Uint>  parentOffsets(numNodes + 1, 0);
+    vector<Uint>  parents(targets.size());
+    for (Uint n = 0;  n < numNodes;  ++n)
+        parentOffsets[n+1] = parentOffsets[n] + inDegrees[n];
+    vector<Uint>  fill(parentOffsets.begin(), parentOffsets.end() - 1);
+    for (Uint n = 0;  n < numNodes;  ++n)
+        for (Uint e = offsets[n];  e < offsets[n+1];  ++e)
+            parents[fill[targets[e]]++] = n;
+
+    vector<Uint>  remaining(numNodes);
+    topoOrder.clear();
+    topoOrder.reserve(numNodes);
+    for (Uint n = 0;  n < numNodes;  ++n) {
+        remaining[n] = offsets[n+1] - offsets[n];
+        if (remaining[n] == 0)
+            topoOrder.push_back(n);
+    }
+    for (size_t j = 0;  j < topoOrder.size();  ++j) {
+        Uint  node = topoOrder[j];
+        for (Uint e = parentOffsets[node];  e < parentOffsets[node+1];  ++e)
+            if (--remaining[parents[e]] == 0)
+                topoOrder.push_back(parents[e]);
+    }
+
+    acyclic = (topoOrder.size() == numNodes);
+    if (! acyclic) {
+        for (Uint n = 0;  n < numNodes;  ++n)
+            if (remaining[n] != 0)
+                topoOrder.push_back(n);
+    }
+
+    // On a cycle a child may not have its level yet; it counts as 0.
+    levels.assign(numNodes, 0);
+    numLevels = (numNodes == 0) ? 0 : 1;
+    for (size_t j = 0;  j < topoOrder.size();  ++j) {
+        Uint  node = topoOrder[j];
+        Uint  level = 0;
+        for (Uint e = offsets[node];  e < offsets[node+1];  ++e)
+            level = std::max(level, levels[targets[e]] + 1);
+        levels[node] = level;
+        numLevels = std::max(numLevels, level + 1);
+    }
+}
+
+
+// getTopCells -- the nodes that nothing places, in node order
+
+void
+CellGraph::getTopCells (/*out*/ vector<Uint>* tops) const
+{
+    assert (final);
+    tops->clear();
+    for (Uint n = 0;  n < numNodes;  ++n)
+        if (inDegrees[n] == 0)
+            tops->push_back(n);
+}
+
+
+// getReachable -- the nodes reachable from roots, children first
+// A post-order walk with an explicit stack, because real hierarchies
+// can be deeper than the call stack allows.  A cycle is cut at the
+// back edge.  Each node appears once.
+
+void
+CellGraph::getReachable (const vector<Uint>& roots,
+                         /*out*/ vector<Uint>* order) const
+{
+    assert (final);
+
+    enum { Unseen, OnStack, Done };
+    vector<char>  state(numNodes, Unseen);
+    vector< std::pair<Uint, Uint> >  stack;     // node, next edge
+
+    order->clear();
+    for (size_t j = 0;  j < roots.size();  ++j) {
+        Uint  root = roots[j];
+        if (root >= numNodes  ||  state[root] != Unseen)
+            continue;
+        state[root] = OnStack;
+        stack.push_back(std::make_pair(root, offsets[root]));
+
+        while (! stack.empty()) {
+            Uint  node = stack.back().first;
+            if (stack.back().second < offsets[node+1]) {
+                Uint  child = targets[stack.back().second++];
+                if (state[child] == Unseen) {
+                    state[child] = OnStack;
+                    stack.push_back(std::make_pair(child, offsets[child]));
+                }
+            } else {
+                state[node] = Done;
+                order->push_back(node);
+                stack.pop_back();
+            }
+        }
+    }
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
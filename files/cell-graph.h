@@ -0,0 +1,154 @@
+// oasis/cell-graph.h -- compact placement graph of the cells in a file
+//
+// last modified:   2026/10/17
+//
+// CellGraph records which cells place which, for ordering and pruning
+// passes over a file's hierarchy.  Cells are nodes numbered densely
+// from 0; the caller maps its own cell keys (CellName pointers, cell
+// index numbers) to node numbers.  An edge parent -> child stands for
+// all the PLACEMENTs of child in parent and carries their number.
+//
+// The graph is built in two phases.  addEdge() appends to a pending
+// list, merging a placement into the previous edge when both are the
+// same pair, as they are for runs of placements of one cell.  That is
+// the cost of a PLACEMENT record: a compare and, now and then, a
+// push_back.  finalize() sorts the pending edges, merges duplicates,
+// and builds the compressed sparse row (CSR) arrays: for node n, the
+// children are targets[offsets[n] .. offsets[n+1]).  It also computes
+// the in-degrees, a topological order and the level of each node.
+//
+// Edges and nodes may be added after finalize(); the next finalize()
+// merges them in.  The queries require a finalized graph.
+//
+// Terms:
+//
+//   top cell       a node that no other node places (in-degree 0)
+//
+//   topological order
+//                  every node comes after all the nodes it places,
+//                  i.e. children first.  If the graph has a cycle,
+//                  which the OASIS spec forbids, the nodes on or above
+//                  it come last, in node order, and isAcyclic() is
+//                  false.
+//
+//   level          0 for a node that places nothing, otherwise one more
+//                  than the highest level among its children.  Nodes
+//                  of one level do not place each other, so each level
+//                  can be processed in parallel once the levels below
+//                  are done.
+
+#ifndef OASIS_CELL_GRAPH_H_INCLUDED
+#define OASIS_CELL_GRAPH_H_INCLUDED
+
+#include <cassert>
+#include <vector>
+
+#include "misc/utils.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::vector;
+using SoftJin::Uint;
+using SoftJin::Ullong;
+
+
+class CellGraph {
+public:
+    // NodeSpan -- the children of a node, in increasing node order
+    class NodeSpan {
+        const Uint*     first;
+        const Uint*     last;
+    public:
+                    NodeSpan (const Uint* first, const Uint* last)
+                      : first(first), last(last) { }
+        const Uint* begin() const       { return first; }
+        const Uint* end() const         { return last; }
+        size_t      size() const        { return (last - first); }
+        bool        empty() const       { return (first == last); }
+        Uint        operator[] (size_t n) const  { return first[n]; }
+    };
+
+private:
+    struct Edge {
+        Uint    parent;
+        Uint    child;
+        Ullong  count;
+    };
+
+    Uint            numNodes;
+    vector<Edge>    pending;            // added since the last finalize()
+    size_t          compactAt;          // pending size that triggers a merge
+    bool            final;
+
+    // CSR arrays, valid when final
+    vector<Uint>    offsets;            // numNodes+1 entries
+    vector<Uint>    targets;            // child of each edge
+    vector<Ullong>  counts;             // placements on each edge
+    vector<Uint>    inDegrees;
+    vector<Uint>    topoOrder;          // children first
+    vector<Uint>    levels;
+    Uint            numLevels;
+    bool            acyclic;
+    Ullong          numPlacements;
+
+public:
+                CellGraph();
+
+    void        clear();
+    Uint        addNode();
+    void        reserveNodes (Uint n);
+    void        addEdge (Uint parent, Uint child);
+    void        finalize();
+
+    bool        isFinal() const         { return final; }
+    Uint        size() const            { return numNodes; }
+
+    // The queries below need a finalized graph.
+
+    size_t      getNumEdges() const     { assert (final);  return targets.size(); }
+    Ullong      getNumPlacements() const { assert (final);  return numPlacements; }
+
+    NodeSpan    children (Uint node) const {
+                    assert (final  &&  node < numNodes);
+                    const Uint*  base = targets.data();
+                    return NodeSpan(base + offsets[node],
+                                    base + offsets[node+1]);
+                }
+    // getPlacementCount -- placements on the k'th edge of children(node)
+    Ullong      getPlacementCount (Uint node, size_t k) const {
+                    assert (final  &&  offsets[node] + k < offsets[node+1]);
+                    return counts[offsets[node] + k];
+                }
+
+    Uint        getInDegree (Uint node) const {
+                    assert (final);  return inDegrees[node];
+                }
+    bool        isTopCell (Uint node) const  { return (getInDegree(node) == 0); }
+    void        getTopCells (/*out*/ vector<Uint>* tops) const;
+
+    const vector<Uint>&  getTopologicalOrder() const {
+                    assert (final);  return topoOrder;
+                }
+    bool        isAcyclic() const       { assert (final);  return acyclic; }
+
+    Uint        getLevel (Uint node) const  { assert (final);  return levels[node]; }
+    Uint        getNumLevels() const    { assert (final);  return numLevels; }
+
+    void        getReachable (const vector<Uint>& roots,
+                              /*out*/ vector<Uint>* order) const;
+
+private:
+    void        compactPending();
+    void        computeOrder();
+
+private:
+                CellGraph (const CellGraph&);           // forbidden
+    void        operator= (const CellGraph&);           // forbidden
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_CELL_GRAPH_H_INCLUDED
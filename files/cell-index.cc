@@ -0,0 +1,582 @@
+// oasis/cell-index.cc -- persistent index of cell offsets in an OASIS file
+//
+// last modified:   2026/10/17
+
+// See mapped-file.cc.
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "oasis.h"
+#include "rectypes.h"
+#include "mapped-scanner.h"
+#include "rec-tokenizer.h"
+#include "cblock-prefetch.h"
+#include "cell-index.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::runtime_error;
+using SoftJin::Uchar;
+
+
+// Layout of the sidecar file.  Everything after the magic is a sequence
+// of OASIS unsigned integers, so that it can be read with DecodeUInt().
+//
+//   magic version
+//   file-size mtime-sec mtime-nsec fingerprint
+//   cell-count
+//   { name-length name-bytes offset end-offset flags record-count
+//     cblock-count cblock-offset* child-count child-index* }*
+//   checksum
+//
+// The checksum is the FNV-1a hash of every byte before it.
+
+static const char   IndexMagic[] = "OASCIDX\n";
+static const size_t IndexMagicLength = sizeof(IndexMagic) - 1;
+static const Ullong IndexVersion = 2;
+
+static const Ullong FingerprintChunk = 64 << 10;
+
+
+static inline Ullong
+HashBytes (Ullong hash, const Uchar* p, size_t n)
+{
+    while (n-- != 0)
+        hash = (hash ^ *p++) * 0x100000001b3ULL;
+    return hash;
+}
+
+static const Ullong  HashInit = 0xcbf29ce484222325ULL;
+
+
+static void
+PutUInt (vector<Uchar>& buf, Ullong val)
+{
+    Uchar  bytes[MaxVarintBytes];
+    buf.insert(buf.end(), bytes, bytes + EncodeUInt(val, bytes));
+}
+
+
+//----------------------------------------------------------------------
+// Structural walk
+
+namespace {
+
+// IndexWalker -- one pass over the records, collecting cell extents
+// Cells and placements may refer to cell names by reference-number, and
+// the CELLNAME records usually come after the cells, so references are
+// collected as they are and resolved at the end.
+
+class IndexWalker {
+    struct RawCell {
+        CellKey          key;
+        Ullong           offset;
+        Ullong           endOffset;
+        bool             inCblock;
+        Ullong           numRecords;
+        vector<Ullong>   cblocks;
+        vector<CellKey>  children;
+    };
+
+    OasisRecordTokenizer  tokenizer;
+    vector<RawCell>     rawCells;
+    std::unordered_map<Ullong, string>  cellNames;  // refnum -> name
+    Ullong              nextCellNameRefnum;
+    bool                inCell;
+
+public:
+    explicit    IndexWalker (MappedScanner& scanner);
+    void        walk();
+    void        collect (/*out*/ vector<CellOffsetIndex::CellEntry>* cells);
+
+private:
+    void        closeCell (Ullong endOffset);
+    void        openCell (const RecordCursor& curs);
+    void        addChild (const CellKey& key);
+    bool        resolve (const CellKey& key, /*out*/ string* name) const;
+};
+
+
+IndexWalker::IndexWalker (MappedScanner& scanner)
+  : tokenizer(scanner)
+{
+    nextCellNameRefnum = 0;
+    inCell = false;
+}
+
+
+void
+IndexWalker::walk()
+{
+    const RecordCursor&  curs = tokenizer.cursor();
+    MappedScanner&  scanner = tokenizer.getScanner();
+
+    tokenizer.rewind();
+    while (tokenizer.next()) {
+        // A record that ends a cell from inside a CBLOCK ends it at the
+        // end of the CBLOCK, since the cell's records fill the block
+        // up to that point.  That is curs.blockEnd.
+
+        switch (curs.recID) {
+            case RID_CELL_REF:
+            case RID_CELL_NAMED:
+                closeCell(curs.blockEnd);
+                openCell(curs);
+                break;
+
+            case RID_CELLNAME_IMPLICIT:
+            case RID_CELLNAME: {
+                closeCell(curs.blockEnd);
+                string  name = scanner.readString().str();
+                Ullong  refnum = (curs.recID == RID_CELLNAME)
+                                     ? scanner.readUInt64()
+                                     : nextCellNameRefnum++;
+                tokenizer.claimRecord();
+                cellNames[refnum] = name;
+                break;
+            }
+
+            case RID_PLACEMENT:
+            case RID_PLACEMENT_TRANSFORM:
+                if (curs.haveRef)
+                    addChild(curs.ref);
+                break;
+
+            case RID_CBLOCK:
+                if (inCell)
+                    rawCells.back().cblocks.push_back(curs.offset);
+                break;
+
+            default:
+                if (! curs.inCell)
+                    closeCell(curs.blockEnd);
+                break;
+        }
+
+        // Counted after the switch so that a record which ends one cell
+        // is not counted in it, and a CELL record counts in its own.
+        if (inCell)
+            ++rawCells.back().numRecords;
+    }
+    closeCell(scanner.currFileOffset());
+}
+
+
+void
+IndexWalker::closeCell (Ullong endOffset)
+{
+    if (inCell) {
+        rawCells.back().endOffset = endOffset;
+        inCell = false;
+    }
+}
+
+
+void
+IndexWalker::openCell (const RecordCursor& curs)
+{
+    rawCells.push_back(RawCell());
+    RawCell&  rc = rawCells.back();
+    rc.key = curs.ref;
+    rc.offset = curs.offset;
+    rc.endOffset = curs.offset;
+    rc.inCblock = curs.inCblock;
+    rc.numRecords = 0;
+    if (curs.inCblock)
+        rc.cblocks.push_back(curs.offset);
+    inCell = true;
+}
+
+
+// addChild -- note a placement in the current cell
+// Runs of placements of the same cell are common, so a child equal to
+// the previous one is not added again; collect() removes the rest of
+// the duplicates.
+
+void
+IndexWalker::addChild (const CellKey& key)
+{
+    if (! inCell)
+        return;
+    vector<CellKey>&  children = rawCells.back().children;
+    if (children.empty()  ||  ! key.sameAs(children.back()))
+        children.push_back(key);
+}
+
+
+bool
+IndexWalker::resolve (const CellKey& key, /*out*/ string* name) const
+{
+    if (! key.byRefnum) {
+        *name = key.name;
+        return true;
+    }
+    std::unordered_map<Ullong, string>::const_iterator
+        iter = cellNames.find(key.refnum);
+    if (iter == cellNames.end())
+        return false;
+    *name = iter->second;
+    return true;
+}
+
+
+// collect -- resolve names and turn the raw cells into index entries
+// Cells whose reference-number has no CELLNAME are dropped, as are
+// placements of cells not defined in the file.  If a name is defined
+// twice (which the parser rejects) the first definition wins.
+
+void
+IndexWalker::collect (/*out*/ vector<CellOffsetIndex::CellEntry>* cells)
+{
+    std::unordered_map<string, Uint>  indexOf;
+    vector<const RawCell*>  kept;
+
+    cells->clear();
+    for (size_t j = 0;  j < rawCells.size();  ++j) {
+        string  name;
+        if (! resolve(rawCells[j].key, &name)  ||  indexOf.count(name))
+            continue;
+        indexOf[name] = cells->size();
+        kept.push_back(&rawCells[j]);
+
+        cells->push_back(CellOffsetIndex::CellEntry());
+        CellOffsetIndex::CellEntry&  entry = cells->back();
+        entry.name = name;
+        entry.offset = rawCells[j].offset;
+        entry.endOffset = rawCells[j].endOffset;
+        entry.inCblock = rawCells[j].inCblock;
+        entry.numRecords = rawCells[j].numRecords;
+        entry.cblocks = rawCells[j].cblocks;
+    }
+
+    for (size_t j = 0;  j < kept.size();  ++j) {
+        vector<Uint>&  children = (*cells)[j].children;
+        for (size_t k = 0;  k < kept[j]->children.size();  ++k) {
+            string  name;
+            std::unordered_map<string, Uint>::const_iterator  iter;
+            if (resolve(kept[j]->children[k], &name)
+                    &&  (iter = indexOf.find(name)) != indexOf.end())
+                children.push_back(iter->second);
+        }
+        std::sort(children.begin(), children.end());
+        children.erase(std::unique(children.begin(), children.end()),
+                       children.end());
+    }
+}
+
+}  // unnamed namespace
+
+
+//----------------------------------------------------------------------
+// CellOffsetIndex
+
+
+CellOffsetIndex::CellOffsetIndex()
+{
+    clear();
+}
+
+
+void
+CellOffsetIndex::clear()
+{
+    fileKey.fileSize = 0;
+    fileKey.mtimeSec = 0;
+    fileKey.mtimeNsec = 0;
+    fileKey.fingerprint = 0;
+    cells.clear();
+    cellsByName.clear();
+    numPrefetched = 0;
+}
+
+
+/*static*/ string
+CellOffsetIndex::IndexFilename (const string& oasisFilename)
+{
+    return (oasisFilename + ".idx");
+}
+
+
+// GetFileKey -- identify the current contents of an OASIS file
+// The fingerprint hashes the size and the first and last 64 KB: the
+// START record and the name tables, which change whenever the cells do.
+
+/*static*/ bool
+CellOffsetIndex::GetFileKey (const string& oasisFilename,
+                             /*out*/ FileKey* key)
+{
+    int  fd = open(oasisFilename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat  st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return false;
+    }
+    key->fileSize = st.st_size;
+    key->mtimeSec = st.st_mtim.tv_sec;
+    key->mtimeNsec = st.st_mtim.tv_nsec;
+
+    Ullong  hash = HashBytes(HashInit, reinterpret_cast<const Uchar*>(
+                                           &key->fileSize),
+                             sizeof key->fileSize);
+    vector<Uchar>  buf(FingerprintChunk);
+    Ullong  tailStart = (key->fileSize > FingerprintChunk)
+                            ? key->fileSize - FingerprintChunk : 0;
+    Ullong  starts[2] = { 0, tailStart };
+    for (int j = 0;  j < 2;  ++j) {
+        ssize_t  n = pread(fd, &buf[0], buf.size(), starts[j]);
+        if (n < 0) {
+            close(fd);
+            return false;
+        }
+        hash = HashBytes(hash, &buf[0], n);
+    }
+    close(fd);
+
+    key->fingerprint = hash;
+    return true;
+}
+
+
+// load -- read the sidecar for oasisFilename
+// Returns false, leaving the index empty, if there is no sidecar, if it
+// is corrupt, or if it was made for a different version of the file.
+
+bool
+CellOffsetIndex::load (const string& oasisFilename)
+{
+    clear();
+
+    FileKey  currKey;
+    if (! GetFileKey(oasisFilename, &currKey))
+        return false;
+
+    FILE*  fp = fopen(IndexFilename(oasisFilename).c_str(), "rb");
+    if (fp == Null)
+        return false;
+    vector<Uchar>  data;
+    Uchar  buf[8192];
+    size_t  n;
+    while ((n = fread(buf, 1, sizeof buf, fp)) > 0)
+        data.insert(data.end(), buf, buf + n);
+    bool  readError = ferror(fp);
+    fclose(fp);
+    if (readError  ||  data.size() < IndexMagicLength
+            ||  memcmp(&data[0], IndexMagic, IndexMagicLength) != 0)
+        return false;
+
+    const Uchar*  p = &data[0] + IndexMagicLength;
+    const Uchar*  end = &data[0] + data.size();
+    Ullong  version, size, sec, nsec, fingerprint, ncells;
+
+    if (! DecodeUInt(&p, end, &version)  ||  version != IndexVersion
+            ||  ! DecodeUInt(&p, end, &size)
+            ||  ! DecodeUInt(&p, end, &sec)
+            ||  ! DecodeUInt(&p, end, &nsec)
+            ||  ! DecodeUInt(&p, end, &fingerprint)
+            ||  ! DecodeUInt(&p, end, &ncells)
+            ||  ncells > Ullong(end - p))
+        return false;
+
+    fileKey.fileSize = size;
+    fileKey.mtimeSec = llong(sec);
+    fileKey.mtimeNsec = long(nsec);
+    fileKey.fingerprint = fingerprint;
+    if (! (fileKey == currKey)) {
+        clear();
+        return false;
+    }
+
+    // Every count is checked against the bytes remaining before it is
+    // used to size anything, so a damaged file cannot make us allocate
+    // more than it could possibly describe.
+
+    cells.resize(ncells);
+    bool  ok = true;
+    for (Ullong j = 0;  ok  &&  j < ncells;  ++j) {
+        CellEntry&  entry = cells[j];
+        Ullong  len, flags, count, val;
+        ok = DecodeUInt(&p, end, &len)  &&  len <= Ullong(end - p);
+        if (! ok)
+            break;
+        entry.name.assign(reinterpret_cast<const char*>(p), len);
+        p += len;
+
+        ok = DecodeUInt(&p, end, &entry.offset)
+             &&  DecodeUInt(&p, end, &entry.endOffset)
+             &&  DecodeUInt(&p, end, &flags)
+             &&  DecodeUInt(&p, end, &entry.numRecords)
+             &&  DecodeUInt(&p, end, &count)  &&  count <= Ullong(end - p);
+        entry.inCblock = (flags & 1);
+        for (Ullong k = 0;  ok  &&  k < count;  ++k) {
+            ok = DecodeUInt(&p, end, &val);
+            entry.cblocks.push_back(val);
+        }
+
+        ok = ok  &&  DecodeUInt(&p, end, &count)
+                 &&  count <= Ullong(end - p);
+        for (Ullong k = 0;  ok  &&  k < count;  ++k) {
+            ok = DecodeUInt(&p, end, &val)  &&  val < ncells;
+            entry.children.push_back(Uint(val));
+        }
+    }
+
+    Ullong  checksum;
+    const Uchar*  bodyEnd = p;
+    if (! ok  ||  ! DecodeUInt(&p, end, &checksum)  ||  p != end
+            ||  checksum != HashBytes(HashInit, &data[0],
+                                      bodyEnd - &data[0])) {
+        clear();
+        return false;
+    }
+
+    rebuildNameMap();
+    return true;
+}
+
+
+// build -- make the index by walking the records of mfile
+// With nthreads > 0, CBLOCKs are inflated ahead of the walk by that
+// many threads, and getNumPrefetched() then says how many of them the
+// walk used.  Throws runtime_error if the file is malformed.
+
+void
+CellOffsetIndex::build (const MappedFile& mfile, unsigned nthreads)
+{
+    clear();
+    if (! GetFileKey(mfile.getFilename(), &fileKey))
+        throw runtime_error("cannot stat file '" + mfile.getFilename()
+                            + "': " + strerror(errno));
+
+    MappedScanner  scanner(mfile);
+    std::unique_ptr<CblockPrefetcher>  prefetcher;
+    if (nthreads > 0) {
+        prefetcher.reset(new CblockPrefetcher(mfile, nthreads));
+        scanner.setPrefetcher(prefetcher.get());
+    }
+
+    IndexWalker  walker(scanner);
+    walker.walk();
+    scanner.setPrefetcher(Null);
+    if (prefetcher.get() != Null)
+        numPrefetched = prefetcher->getNumTaken();
+    walker.collect(&cells);
+    rebuildNameMap();
+}
+
+
+// save -- write the sidecar for oasisFilename
+// The index is written to a temporary file and renamed into place, so
+// a concurrent reader sees either the old index or the complete new
+// one.  Returns false if it cannot be written, e.g. because the
+// directory is read-only; that is not an error for the caller.
+
+bool
+CellOffsetIndex::save (const string& oasisFilename) const
+{
+    vector<Uchar>  data(IndexMagic, IndexMagic + IndexMagicLength);
+    PutUInt(data, IndexVersion);
+    PutUInt(data, fileKey.fileSize);
+    PutUInt(data, Ullong(fileKey.mtimeSec));
+    PutUInt(data, Ullong(fileKey.mtimeNsec));
+    PutUInt(data, fileKey.fingerprint);
+    PutUInt(data, cells.size());
+
+    for (size_t j = 0;  j < cells.size();  ++j) {
+        const CellEntry&  entry = cells[j];
+        PutUInt(data, entry.name.size());
+        data.insert(data.end(), entry.name.begin(), entry.name.end());
+        PutUInt(data, entry.offset);
+        PutUInt(data, entry.endOffset);
+        PutUInt(data, entry.inCblock ? 1 : 0);
+        PutUInt(data, entry.numRecords);
+        PutUInt(data, entry.cblocks.size());
+        for (size_t k = 0;  k < entry.cblocks.size();  ++k)
+            PutUInt(data, entry.cblocks[k]);
+        PutUInt(data, entry.children.size());
+        for (size_t k = 0;  k < entry.children.size();  ++k)
+            PutUInt(data, entry.children[k]);
+    }
+    PutUInt(data, HashBytes(HashInit, &data[0], data.size()));
+
+    string  idxname = IndexFilename(oasisFilename);
+    char  suffix[32];
+    snprintf(suffix, sizeof suffix, ".tmp%ld", long(getpid()));
+    string  tmpname = idxname + suffix;
+
+    FILE*  fp = fopen(tmpname.c_str(), "wb");
+    if (fp == Null)
+        return false;
+    bool  ok = (fwrite(&data[0], 1, data.size(), fp) == data.size());
+    ok = (fclose(fp) == 0)  &&  ok;
+    ok = ok  &&  rename(tmpname.c_str(), idxname.c_str()) == 0;
+    if (! ok)
+        (void) remove(tmpname.c_str());
+    return ok;
+}
+
+
+void
+CellOffsetIndex::rebuildNameMap()
+{
+    cellsByName.clear();
+    for (size_t j = 0;  j < cells.size();  ++j)
+        cellsByName.insert(std::make_pair(cells[j].name, Uint(j)));
+}
+
+
+const CellOffsetIndex::CellEntry*
+CellOffsetIndex::findCell (const string& name) const
+{
+    int  n = findCellIndex(name);
+    return (n < 0 ? Null : &cells[n]);
+}
+
+
+// findCellIndex -- index of the named cell in the table, or -1
+
+int
+CellOffsetIndex::findCellIndex (const string& name) const
+{
+    std::unordered_map<string, Uint>::const_iterator
+        iter = cellsByName.find(name);
+    return (iter == cellsByName.end() ? -1 : int(iter->second));
+}
+
+
+// findCellAt -- the cell whose CELL record is at file offset offset
+// Returns Null if there is none, or if the CELL record is compressed.
+// The cells are in file order, so their offsets are sorted.
+
+const CellOffsetIndex::CellEntry*
+CellOffsetIndex::findCellAt (Ullong offset) const
+{
+    vector<CellEntry>::const_iterator
+        iter = std::lower_bound(cells.begin(), cells.end(), offset,
+                                [](const CellEntry& e, Ullong off) {
+                                    return (e.offset < off);
+                                });
+    for ( ;  iter != cells.end()  &&  iter->offset == offset;  ++iter) {
+        if (! iter->inCblock)
+            return &*iter;
+    }
+    return Null;
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
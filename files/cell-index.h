@@ -0,0 +1,121 @@
+// oasis/cell-index.h -- persistent index of cell offsets in an OASIS file
+//
+// last modified:   2026/10/17
+//
+// To extract one cell the parser must know where its CELL record is.
+// When the file's CELLNAME records carry S_CELL_OFFSET properties that
+// is free; otherwise the parser reads the whole file to find the CELL
+// records, and does so again on every run.  For a multi-GB file that
+// pass dominates the cost of extracting a small cell.
+//
+// CellOffsetIndex records the result of that pass in a sidecar file
+// next to the OASIS file (<file>.idx).  The index is built by a quick
+// structural walk that skips over element records without decoding
+// them, and holds for each cell
+//
+//   - its name
+//   - the file offsets of its CELL record and of the end of the cell
+//   - the number of records in it
+//   - the offsets of the CBLOCK records that hold its records
+//   - the cells it places, as indexes into the cell table
+//
+// The sidecar is keyed by the OASIS file's size, modification time and
+// a hash of its first and last 64 KB.  load() rejects an index whose
+// key does not match, so a stale index is rebuilt rather than used.
+// The index is an accelerator only: if it cannot be read or written
+// the caller falls back to its own scan.
+//
+// Cells whose CELL record is itself inside a CBLOCK have no file offset
+// the parser can seek to.  They are indexed (with inCblock set) for the
+// sake of the hierarchy, but their offset is that of the CBLOCK.
+
+#ifndef OASIS_CELL_INDEX_H_INCLUDED
+#define OASIS_CELL_INDEX_H_INCLUDED
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "misc/utils.h"
+#include "mapped-file.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+using std::vector;
+using SoftJin::Uint;
+using SoftJin::Ullong;
+using SoftJin::llong;
+
+
+class CellOffsetIndex {
+public:
+    struct CellEntry {
+        string          name;
+        Ullong          offset;         // CELL record (or its CBLOCK)
+        Ullong          endOffset;      // just past the cell's last record
+        bool            inCblock;       // CELL record is compressed
+        Ullong          numRecords;     // records in the cell, CELL included
+        vector<Ullong>  cblocks;        // CBLOCKs holding the cell's records
+        vector<Uint>    children;       // indexes of cells placed, sorted
+    };
+
+    // Identity of the indexed OASIS file.
+    struct FileKey {
+        Ullong          fileSize;
+        llong           mtimeSec;
+        long            mtimeNsec;
+        Ullong          fingerprint;
+
+        bool operator== (const FileKey& k) const {
+            return (fileSize == k.fileSize  &&  mtimeSec == k.mtimeSec
+                    &&  mtimeNsec == k.mtimeNsec
+                    &&  fingerprint == k.fingerprint);
+        }
+    };
+
+    typedef vector<CellEntry>::const_iterator  const_iterator;
+
+private:
+    FileKey             fileKey;
+    vector<CellEntry>   cells;          // in file order
+    std::unordered_map<string, Uint>  cellsByName;
+    Ullong              numPrefetched;  // CBLOCKs build() did not inflate
+
+public:
+                CellOffsetIndex();
+
+    static string  IndexFilename (const string& oasisFilename);
+    static bool    GetFileKey (const string& oasisFilename,
+                               /*out*/ FileKey* key);
+
+    bool        load (const string& oasisFilename);
+    void        build (const MappedFile& mfile, unsigned nthreads = 0);
+    bool        save (const string& oasisFilename) const;
+
+    size_t      size() const            { return cells.size(); }
+    const_iterator  begin() const       { return cells.begin(); }
+    const_iterator  end() const         { return cells.end(); }
+    const CellEntry&  getCell (Uint n) const  { return cells[n]; }
+    const CellEntry*  findCell (const string& name) const;
+    int         findCellIndex (const string& name) const;
+    const CellEntry*  findCellAt (Ullong offset) const;
+
+    Ullong      getIndexedFileSize() const  { return fileKey.fileSize; }
+    Ullong      getNumPrefetched() const    { return numPrefetched; }
+
+private:
+    void        clear();
+    void        rebuildNameMap();
+
+private:
+                CellOffsetIndex (const CellOffsetIndex&);   // forbidden
+    void        operator= (const CellOffsetIndex&);         // forbidden
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_CELL_INDEX_H_INCLUDED
@@ -26,6 +26,11 @@ OasisCreator::OasisCreator (const char* fname,
     repReuse.makeReuse();
     cellOffsetPropName = Null;
     deletePropName = false;
+
+    // [PARALLEL_CBLOCK]
+    bufferingCell = false;
+    if (options.compressThreads != 0  &&  ! options.immediateNames)
+        deflater.reset(new CblockDeflater(options.compressThreads));
 }
 
 
@@ -95,6 +100,13 @@ OasisCreator::beginFile (const string&  version,
 /*virtual*/ void
 OasisCreator::endFile()
 {
+    // [PARALLEL_CBLOCK]  All cells must be in the file before the name
+    // tables, which need their offsets.
+    if (bufferingCell)
+        submitCell();
+    if (deflater.get() != Null)
+        commitCells(true);
+
     writeNameTables();
 
     // Section 14:  END record
@@ -141,10 +153,48 @@ OasisCreator::writeTableInfo (const NameTable* ntab)
 /*virtual*/ void
 OasisCreator::beginCell (CellName* cellName)
 {
-    // Save the cell's offset for use when writing the cellName's
-    // S_CELL_OFFSET property.
-    cellOffsets[cellName] = writer.currFileOffset();
+    // [PARALLEL_CBLOCK]  Hand the previous cell to the deflater.  If
+    // this one is to be compressed in the background, it goes into
+    // cellBuffer and its offset is saved when it is written.  Otherwise
+    // the cells still in the deflater must be written first.
+
+    if (bufferingCell)
+        submitCell();
+    bufferingCell = (deflater.get() != Null  &&  mustCompress);
+    if (bufferingCell)
+        pendingCells.push_back(cellName);
+    else {
+        if (deflater.get() != Null)
+            commitCells(true);
+
+        // Save the cell's offset for use when writing the cellName's
+        // S_CELL_OFFSET property.
+        cellOffsets[cellName] = writer.currFileOffset();
+    }
+
+    writeCellRecord(cellName);
+
+
+    // Begin compression if requested in the constructor and reset all
+    // modal variables to the uninitialized or default state.  A buffered
+    // cell is compressed later, so there is no block to begin, and
+    // endCell() finds none to end.
+
+    if (bufferingCell)
+        cellBuffer.beginBody();
+    else
+        beginBlock();
+    modvars.reset();            // 10.1
+}
 
+
+/** [RAW_CELL]
+ *  CREATE
+ *   - The CELL record, split out of beginCell() for copyRawCell().
+ */
+void
+OasisCreator::writeCellRecord (CellName* cellName)
+{
     // If the cellName has been registered, use the refnum form of the
     // CELL record.  Otherwise use the name form and mark the table as
     // being non-strict.
@@ -189,12 +239,63 @@ OasisCreator::beginCell (CellName* cellName)
     }
 
     /** **********************************************************************/
+}
 
-    // Begin compression if requested in the constructor and reset all
-    // modal variables to the uninitialized or default state.
 
-    beginBlock();
-    modvars.reset();            // 10.1
+// SameRefnums -- true if each name has the same refnum in table as in refs
+
+template <typename TableT, typename NameT>
+static bool
+SameRefnums (TableT* table, const vector< NameRef<NameT> >& refs)
+{
+    for (size_t j = 0;  j < refs.size();  ++j) {
+        Ulong  refnum;
+        if (! table->getRefnum(refs[j].name, &refnum)
+                ||  refnum != refs[j].refnum)
+            return false;
+    }
+    return true;
+}
+
+
+/** [RAW_CELL]
+ *  CREATE
+ *   - Copy a cell's stored contents after our own CELL record.  The
+ *     contents must be compressed if ours would be, and each
+ *     reference-number in them must denote the same name in our tables
+ *     as in the input; otherwise the parser parses the cell and we
+ *     encode it with our own numbers.  Names used as strings make the
+ *     tables non-strict, as they would in beginPlacement() etc.
+ */
+/*virtual*/ bool
+OasisCreator::copyRawCell (CellName* cellName, const RawCell& raw)
+{
+    if (raw.compressed != mustCompress)
+        return false;
+
+    RefNameTable*  cellTable = options._hasCellNames ? _currCellNameTable.get()
+                                                     : cellNameTable.get();
+    if (! SameRefnums(cellTable, raw.cellRefs)
+            ||  ! SameRefnums(textStringTable.get(), raw.textRefs)
+            ||  ! SameRefnums(propNameTable.get(), raw.propNameRefs)
+            ||  ! SameRefnums(propStringTable.get(), raw.propStringRefs))
+        return false;
+
+    if (raw.cellNameStrings)  cellTable->notStrict();
+    if (raw.textStrings)      textStringTable->notStrict();
+    if (raw.propNameStrings)  propNameTable->notStrict();
+
+    // [PARALLEL_CBLOCK]  The cells before this one go first.
+    if (bufferingCell)
+        submitCell();
+    if (deflater.get() != Null)
+        commitCells(true);
+
+    cellOffsets[cellName] = writer.currFileOffset();
+    writeCellRecord(cellName);
+    writer.writeBytes(raw.data, raw.size);
+    modvars.reset();            // whatever the contents left is unknown
+    return true;
 }
 
 /** [INPUT_CELLNAMES]
@@ -318,6 +419,167 @@ OasisCreator::beginPlacement (CellName*  cellName,
     if (infoByte & RepBit)  writeRepetition(rep);
 }
 
+/** [ELEMENT_BATCH]
+ *  CREATE
+ *   - A run of rectangles from the parser.  The run shares one layer and
+ *     datatype, so only the first record carries them; the rest find
+ *     them in the modal variables.  The calls are not virtual and there
+ *     is no endElement() between them.
+ */
+/*virtual*/ void
+OasisCreator::beginRectangles (Ulong layer, Ulong datatype,
+                               const RectSpan& rects)
+{
+    for (const RectElem* r = rects.begin();  r != rects.end();  ++r)
+        OasisCreator::beginRectangle(layer, datatype, r->x, r->y,
+                                     r->width, r->height, r->rep);
+}
+
+
+/** [PARALLEL_CBLOCK]
+ *  CREATE
+ *   - The abbreviations write to cellBuffer while a cell is being
+ *     buffered for the deflater, and to the file otherwise.
+ */
+void
+OasisCreator::writeSInt (long val)
+{
+    if (bufferingCell)
+        cellBuffer.writeSInt(val);
+    else
+        writer.writeSInt(val);
+}
+
+
+void
+OasisCreator::writeUInt (Ulong val)
+{
+    if (bufferingCell)
+        cellBuffer.writeUInt(val);
+    else
+        writer.writeUInt(val);
+}
+
+
+void
+OasisCreator::writeSInt64 (llong val)
+{
+    if (bufferingCell)
+        cellBuffer.writeSInt(val);
+    else
+        writer.writeSInt64(val);
+}
+
+
+void
+OasisCreator::writeUInt64 (Ullong val)
+{
+    if (bufferingCell)
+        cellBuffer.writeUInt(val);
+    else
+        writer.writeUInt64(val);
+}
+
+
+void
+OasisCreator::writeReal (const Oreal& val)
+{
+    if (bufferingCell)
+        cellBuffer.writeReal(val);
+    else
+        writer.writeReal(val);
+}
+
+
+void
+OasisCreator::writeString (const string& val)
+{
+    if (bufferingCell)
+        cellBuffer.writeString(val);
+    else
+        writer.writeString(val);
+}
+
+
+void
+OasisCreator::beginRecord (RecordID recID)
+{
+    if (bufferingCell)
+        cellBuffer.beginRecord(recID);
+    else
+        writer.writeUInt(recID);
+}
+
+
+void
+OasisCreator::writeInfoByte (int infoByte)
+{
+    if (bufferingCell)
+        cellBuffer.writeByte(infoByte);
+    else
+        writer.writeByte(infoByte);
+}
+
+
+void
+OasisCreator::writeBytes (const void* buf, size_t nbytes)
+{
+    if (bufferingCell)
+        cellBuffer.writeBytes(buf, nbytes);
+    else
+        writer.writeBytes(buf, nbytes);
+}
+
+
+/** [SHAPE_ENCODE]
+ *  CREATE
+ *   - Write the point-list in whichever of the six types is shortest
+ *     (shape-encode.h) instead of always in one type.  The list is
+ *     encoded into ptlistBuffer and written in one piece.
+ */
+void
+OasisCreator::writePointList (const PointList& ptlist, bool isPolygon)
+{
+    PointListCode  code;
+    if (! ChoosePointListCode(ptlist, isPolygon, &code))
+        throw std::overflow_error("point-list has an edge too long to encode");
+    ptlistBuffer.clear();
+    EncodePointList(ptlist, code, &ptlistBuffer);
+    writeBytes(ptlistBuffer.data(), ptlistBuffer.size());
+}
+
+
+/** [PARALLEL_CBLOCK]
+ *  CREATE
+ *   - submitCell() hands the buffered cell to the deflater and writes
+ *     whatever cells are ready.  commitCells() writes the finished cells
+ *     in order and saves their offsets.  With all it waits for every
+ *     cell; otherwise it waits only while the deflater holds more than
+ *     MaxQueuedCellBytes, which bounds the memory used.
+ */
+const size_t  MaxQueuedCellBytes = 64 << 20;
+
+void
+OasisCreator::submitCell()
+{
+    deflater->submit(&cellBuffer, true);
+    bufferingCell = false;
+    commitCells(false);
+}
+
+
+void
+OasisCreator::commitCells (bool all)
+{
+    while (deflater->collect(&commitBuffer, all
+                   ||  deflater->getQueuedBytes() > MaxQueuedCellBytes)) {
+        cellOffsets[pendingCells.front()] = writer.currFileOffset();
+        pendingCells.pop_front();
+        writer.writeBytes(commitBuffer.data(), commitBuffer.size());
+    }
+}
+
+
 /** [INPUT_CELLNAMES]
  *  UPDATE
  *   - currCellNameTalbe
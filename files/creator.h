@@ -19,12 +19,17 @@
 #include "misc/utils.h"
 
 #include "builder.h"
+#include "batch-builder.h"
+#include "cblock-deflate.h"
+#include "raw-cell.h"
 #include "modal-vars.h"
 #include "names.h"
 #include "oasis.h"
 #include "rectypes.h"
+#include "shape-encode.h"
 #include "writer.h"
 
+#include <deque>
 #include <iostream>
 #include <map>
 
@@ -33,6 +38,8 @@ namespace Oasis {
 
 using std::auto_ptr;
 using std::string;
+using std::vector;
+using SoftJin::Uchar;
 using SoftJin::Uint;
 using SoftJin::Ulong;
 using SoftJin::HashMap;
@@ -60,6 +67,16 @@ using SoftJin::HashPointer;
 //      spec.  That is because setting it to true will make OasisParser
 //      parse the file twice, once for the name records and once for the
 //      rest.
+//
+// compressThreads      unsigned
+//
+//      If this is not 0 and the output is compressed, each cell is
+//      encoded into memory and compressed by this many threads in the
+//      background (cblock-deflate.h), instead of being compressed as it
+//      is written.  The file is equivalent but not byte-identical: the
+//      CBLOCKs are cut differently.  Ignored if immediateNames is true,
+//      because name records written between cells would have to wait
+//      for the cells.
 
 /**
  * [CBLOCK_ON_OFF]
@@ -67,12 +84,16 @@ using SoftJin::HashPointer;
  * [STRICT_ON_OFF]
  * ADD
  *  - hasCellNames, strict
+ * [PARALLEL_CBLOCK]
+ * ADD
+ *  - compressThreads
  */
 struct OasisCreatorOptions {
     bool    immediateNames;
     bool    mustCompressed;
     bool    _hasCellNames;
     bool    _strict;
+    unsigned  compressThreads;
 
     OasisCreatorOptions (bool immediateNames,
                          bool mustCompressed,
@@ -83,6 +104,7 @@ struct OasisCreatorOptions {
         this->mustCompressed = mustCompressed;
         this->_hasCellNames  = isCellNames;
         this->_strict        = isStrict;
+        this->compressThreads = 0;
     }
 };
 
@@ -107,6 +129,12 @@ struct OasisCreatorOptions {
 //    is not required.  See the comment before registerCellName() in
 //    creator.cc.  Names must not be registered more than once.
 //
+// beginRectangles() (batch-builder.h) is equivalent to calling
+// beginRectangle() for each rectangle in the run.
+//
+// copyRawCell() (raw-cell.h) takes the place of beginCell() ... endCell()
+// for a cell it accepts.
+//
 // setXYrelative() may only be called just before beginning an element.
 //
 // setCompression() may be called anytime.
@@ -169,7 +197,31 @@ struct OasisCreatorOptions {
 //      Contains the starting file offset of each cell written.
 //      The key is the CellName* for the cell.  beginCell() stores the
 //      offset here and writeCellName() uses it to to set the value of
-//      the property S_CELL_OFFSET.
+//      the property S_CELL_OFFSET.  When cells are compressed in the
+//      background, the offset is stored by commitCells() instead, when
+//      the cell is finally written.
+//
+// deflater             auto_ptr<CblockDeflater>
+//
+//      The background compressor if options.compressThreads is in
+//      effect, otherwise Null.
+//
+// cellBuffer           CellBuffer
+// bufferingCell        bool
+//
+//      While bufferingCell is true the abbreviations write to cellBuffer
+//      instead of writer.  It is true from beginCell() until the cell is
+//      handed to the deflater, which happens at the next beginCell() or
+//      at endFile().
+//
+// pendingCells         deque<CellName*>
+//
+//      The cells handed to the deflater but not yet written, in order.
+//
+// ptlistBuffer         vector<Uchar>
+//
+//      Scratch space in which writePointList() encodes a point-list
+//      before writing it, reused for every list.
 //
 // cellNameTable        auto_ptr<CellNameTable>
 // textStringTable      auto_ptr<TextStringTable>
@@ -185,7 +237,7 @@ struct OasisCreatorOptions {
 //      the classes in creator.cc and avoid cluttering this header file.
 
 
-class OasisCreator : public OasisBuilder {
+class OasisCreator : public OasisBatchBuilder, public OasisRawCellBuilder {
 
     class NameTable;
     class RefNameTable;
@@ -211,6 +263,15 @@ private:
     CellOffsetMap        cellOffsets;   // file offset of each cell written
     OasisCreatorOptions  options;       // options passed to constructor
 
+    // [PARALLEL_CBLOCK]  Background compression of cells
+    auto_ptr<CblockDeflater>  deflater;
+    CellBuffer           cellBuffer;
+    bool                 bufferingCell;
+    std::deque<CellName*>  pendingCells;
+    vector<Uchar>        commitBuffer;  // reused by commitCells()
+
+    vector<Uchar>        ptlistBuffer;  // reused by writePointList()
+
     // Name tables for the six types of names
     auto_ptr<CellNameTable>    cellNameTable;
     auto_ptr<TextStringTable>  textStringTable;
@@ -258,6 +319,9 @@ public:
                                   long width, long height,
                                   const Repetition*  rep);
 
+    virtual void  beginRectangles (Ulong layer, Ulong datatype,
+                                   const RectSpan& rects);
+
     virtual void  beginPolygon (Ulong layer, Ulong datatype,
                                 long x, long y,
                                 const PointList&  ptlist,
@@ -302,6 +366,9 @@ public:
     virtual void  registerLayerName  (LayerName*  layerName);
     virtual void  registerXName      (XName*      xname);
 
+    // OasisRawCellBuilder virtual method.
+    virtual bool  copyRawCell (CellName* cellName, const RawCell& raw);
+
 public:
     // Other public methods
     void        setXYrelative (bool flag);
@@ -317,9 +384,17 @@ private:
     void        writeString (const string& val);
     void        beginRecord (RecordID recID);
     void        writeInfoByte (int infoByte);
+    void        writeBytes (const void* buf, size_t nbytes);
     void        beginBlock();
     void        endBlock();
 
+    // Cells
+    void        writeCellRecord (CellName* cellName);
+
+    // Background compression
+    void        submitCell();
+    void        commitCells (bool all);
+
     // Name tables
     void        writeTableInfo (const NameTable* ntab);
     void        writeNameTables();
@@ -0,0 +1,312 @@
+// oasis/cursor-feed.cc -- drive an OasisBuilder from an OasisCursor
+//
+// last modified:   2026/10/17
+
+#include <stdexcept>
+
+#include "cursor-feed.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::runtime_error;
+
+
+namespace {
+
+// Views fetched from the cursor at a time.
+const size_t  ViewBatchSize = 256;
+
+
+// CtrapForms -- Section 27: each CTRAPEZOID type as a TRAPEZOID
+// deltaA and deltaB are multiples of the trapezoid's short dimension:
+// the height for horizontal types, the width for vertical ones.  Types
+// 16-19 and 25 have height equal to width, 20-21 width twice the
+// height, and 22-23 height twice the width.
+
+struct CtrapForm {
+    bool        vertical;
+    int         a, b;
+};
+
+const CtrapForm  CtrapForms[26] = {
+    { false,  0, -1 },  { false,  0,  1 },  { false,  1,  0 },
+    { false, -1,  0 },  { false,  1, -1 },  { false, -1,  1 },
+    { false,  1,  1 },  { false, -1, -1 },                      //  0-7
+    { true,   0,  1 },  { true,   0, -1 },  { true,  -1,  0 },
+    { true,   1,  0 },  { true,  -1,  1 },  { true,   1, -1 },
+    { true,  -1, -1 },  { true,   1,  1 },                      //  8-15
+    { false,  0, -1 },  { false,  0,  1 },  { false,  1,  0 },
+    { false, -1,  0 },                                          // 16-19
+    { false,  1, -1 },  { false, -1,  1 },                      // 20-21
+    { true,  -1,  1 },  { true,   1, -1 },                      // 22-23
+    { false,  0,  0 },  { false,  0,  0 }                       // 24-25
+};
+
+
+Trapezoid
+CTrapezoidAsTrapezoid (Ulong ctrapType, Ulong width, Ulong height)
+{
+    if (ctrapType > 25)
+        throw runtime_error("invalid ctrapezoid-type "
+                            + std::to_string(ctrapType));
+    switch (ctrapType) {
+        case 16:  case 17:  case 18:  case 19:  case 25:
+            height = width;
+            break;
+        case 20:  case 21:
+            width = 2*height;
+            break;
+        case 22:  case 23:
+            height = 2*width;
+            break;
+    }
+    const CtrapForm&  form = CtrapForms[ctrapType];
+    long  unit = form.vertical ? long(width) : long(height);
+    return Trapezoid(form.vertical ? Trapezoid::Vertical
+                                   : Trapezoid::Horizontal,
+                     width, height, form.a * unit, form.b * unit);
+}
+
+}  // unnamed namespace
+
+
+CursorFeeder::CursorFeeder (OasisCursor& cursor, OasisBuilder* builder)
+  : cursor(cursor),
+    builder(builder),
+    views(ViewBatchSize)
+{
+    batchBuilder = dynamic_cast<OasisBatchBuilder*>(builder);
+    streamBuilder = dynamic_cast<OasisPointStreamBuilder*>(builder);
+    if (streamBuilder != Null)
+        cursor.setPointStreamThreshold(PointStreamThreshold);
+    wantText = true;
+    wantExtensions = true;
+}
+
+
+// feedFile -- give the builder the whole file, from beginFile() to
+// endFile()
+// valScheme is passed to beginFile(); the cursor does not read the
+// END record.
+
+void
+CursorFeeder::feedFile (Validation::Scheme valScheme)
+{
+    cursor.rewind();
+    builder->beginFile(cursor.getVersion(), Oreal(cursor.getUnit()),
+                       valScheme);
+    while (cursor.nextCell())
+        feedCell();
+    builder->endFile();
+}
+
+
+//----------------------------------------------------------------------
+// Private methods
+
+
+// feedCell -- give the builder the cell the cursor is in
+
+void
+CursorFeeder::feedCell()
+{
+    const CellKey&  key = cursor.getCellKey();
+    builder->beginCell(getCellName(cursor.getCellName(), key.byRefnum,
+                                   key.refnum));
+    size_t  n;
+    while ((n = cursor.next(&views[0], views.size())) != 0) {
+        for (size_t j = 0;  j < n;  ++j)
+            feedElement(views[j]);
+    }
+    flushRun();
+    builder->endCell();
+}
+
+
+void
+CursorFeeder::feedElement (const ElementView& view)
+{
+    if (batchBuilder != Null) {
+        if (view.kind == EK_Rectangle) {
+            addToRun(view);
+            return;
+        }
+        flushRun();
+    }
+
+    switch (view.kind) {
+        case EK_Placement:
+            builder->beginPlacement(
+                getCellName(view.name.str(), view.byRefnum, view.refnum),
+                view.x, view.y, Oreal(view.mag), Oreal(view.angle),
+                view.flip, view.rep);
+            break;
+
+        case EK_Text:
+            if (! wantText)
+                return;
+            builder->beginText(view.layer, view.datatype, view.x, view.y,
+                               getTextString(view), view.rep);
+            break;
+
+        case EK_Rectangle:
+            builder->beginRectangle(view.layer, view.datatype,
+                                    view.x, view.y, view.width, view.height,
+                                    view.rep);
+            break;
+
+        case EK_Polygon:
+            if (view.points == Null  &&  streamBuilder != Null) {
+                streamBuilder->beginPolygonStream(view.layer, view.datatype,
+                                                  view.x, view.y,
+                                                  view.numPoints, view.rep);
+                StreamPointList(streamBuilder, view.pointList, true);
+                break;
+            }
+            makePointList(view, true);
+            builder->beginPolygon(view.layer, view.datatype, view.x, view.y,
+                                  ptlist, view.rep);
+            break;
+
+        case EK_Path:
+            if (view.points == Null  &&  streamBuilder != Null) {
+                streamBuilder->beginPathStream(view.layer, view.datatype,
+                                               view.x, view.y, view.halfwidth,
+                                               view.startExtn, view.endExtn,
+                                               view.numPoints, view.rep);
+                StreamPointList(streamBuilder, view.pointList, false);
+                break;
+            }
+            makePointList(view, false);
+            builder->beginPath(view.layer, view.datatype, view.x, view.y,
+                               view.halfwidth, view.startExtn, view.endExtn,
+                               ptlist, view.rep);
+            break;
+
+        case EK_Trapezoid: {
+            Trapezoid  trap(view.vertical ? Trapezoid::Vertical
+                                          : Trapezoid::Horizontal,
+                            view.width, view.height,
+                            view.deltaA, view.deltaB);
+            builder->beginTrapezoid(view.layer, view.datatype,
+                                    view.x, view.y, trap, view.rep);
+            break;
+        }
+
+        case EK_CTrapezoid:
+            builder->beginTrapezoid(view.layer, view.datatype, view.x, view.y,
+                                    CTrapezoidAsTrapezoid(view.ctrapType,
+                                                          view.width,
+                                                          view.height),
+                                    view.rep);
+            break;
+
+        case EK_Circle:
+            builder->beginCircle(view.layer, view.datatype, view.x, view.y,
+                                 view.radius, view.rep);
+            break;
+
+        case EK_XGeometry:
+            if (! wantExtensions)
+                return;
+            builder->beginXGeometry(view.layer, view.datatype,
+                                    view.x, view.y, view.attribute,
+                                    view.data.str(), view.rep);
+            break;
+    }
+    builder->endElement();
+}
+
+
+// addToRun -- add a rectangle to the run for batchBuilder
+
+void
+CursorFeeder::addToRun (const ElementView& view)
+{
+    if (! rectRun.empty()
+            &&  (view.layer != runLayer  ||  view.datatype != runDatatype))
+        flushRun();
+    runLayer = view.layer;
+    runDatatype = view.datatype;
+
+    RectElem  elem;
+    elem.x = view.x;
+    elem.y = view.y;
+    elem.width = view.width;
+    elem.height = view.height;
+    elem.rep = view.rep;
+    rectRun.push_back(elem);
+    if (rectRun.size() >= MaxRectRun)
+        flushRun();
+}
+
+
+// flushRun -- give batchBuilder the rectangles in the run, if any
+
+void
+CursorFeeder::flushRun()
+{
+    if (rectRun.empty())
+        return;
+    batchBuilder->beginRectangles(runLayer, runDatatype,
+                                  RectSpan(rectRun.data(), rectRun.size()));
+    rectRun.clear();
+}
+
+
+// getCellName -- the CellName object for name, made on first use
+// name is empty if the cursor could not resolve refnum.
+
+CellName*
+CursorFeeder::getCellName (const string& name, bool byRefnum, Ullong refnum)
+{
+    if (name.empty()  &&  byRefnum)
+        throw runtime_error("cell reference-number "
+                            + std::to_string(refnum)
+                            + " has no CELLNAME record");
+
+    std::unique_ptr<CellName>&  cellName = cellNames[name];
+    if (cellName.get() == Null) {
+        cellName.reset(new CellName(name));
+        builder->registerCellName(cellName.get());
+    }
+    return cellName.get();
+}
+
+
+// getTextString -- the TextString object for a TEXT view, made on
+// first use
+
+TextString*
+CursorFeeder::getTextString (const ElementView& view)
+{
+    if (view.name.size == 0  &&  view.byRefnum)
+        throw runtime_error("text-string reference-number "
+                            + std::to_string(view.refnum)
+                            + " has no TEXTSTRING record");
+
+    std::unique_ptr<TextString>&  text = textStrings[view.name.str()];
+    if (text.get() == Null) {
+        text.reset(new TextString(view.name.str()));
+        builder->registerTextString(text.get());
+    }
+    return text.get();
+}
+
+
+// makePointList -- put the vertices of a POLYGON or PATH view in ptlist
+// decoding them if the cursor left the list undecoded.
+
+void
+CursorFeeder::makePointList (const ElementView& view, bool isPolygon)
+{
+    if (view.points == Null)
+        MappedScanner::DecodePointList(view.pointList, isPolygon, &ptlist);
+    else
+        ptlist.assign(view.points, view.points + view.numPoints);
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
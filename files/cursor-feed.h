@@ -0,0 +1,122 @@
+// oasis/cursor-feed.h -- drive an OasisBuilder from an OasisCursor
+//
+// last modified:   2026/10/17
+//
+// OasisCursor does what OasisParser cannot: it filters elements by layer
+// before decoding them, and it can leave long point-lists undecoded.
+// CursorFeeder puts those abilities behind the usual push interface.  It
+// pulls the views of every cell from a cursor and makes the
+// corresponding OasisBuilder calls, so that any builder, OasisCreator
+// in particular, can be fed from a cursor:
+//
+//     OasisCursor   cursor(infile);
+//     cursor.setLayerFilter(filter);
+//     OasisCreator  creator(outfile, options);
+//     CursorFeeder  feeder(cursor, &creator);
+//     feeder.feedFile(Validation::CRC32);
+//
+// The cursor must have been constructed with resolveNames true.  Cells
+// come in file order.  The CellName and TextString objects passed to
+// the builder are made by the feeder, registered with the builder when
+// first used, and live as long as the feeder.  Repetitions are the
+// cursor's interned ones.
+//
+// What the cursor does not return is not passed on: properties,
+// XNAME, XELEMENT, and the name records other than CELLNAME and
+// TEXTSTRING.  The version and unit come from the START record.  The
+// unit, magnifications and angles reach the builder as the doubles the
+// cursor reads, so a rational or reciprocal in the input is written
+// back as a double.  ignoreText() and ignoreExtensions() drop TEXT and
+// XGEOMETRY elements, like the wantText and wantExtensions options of
+// the parser.
+//
+// If the builder is an OasisBatchBuilder (batch-builder.h), consecutive
+// rectangles on one layer and datatype go to it as runs through
+// beginRectangles().  A run ends at the first other element, at a
+// change of layer or datatype, at the end of the cell, or when it has
+// MaxRectRun rectangles.  The cursor skips properties, so no rectangle
+// it returns has any.
+//
+// If the builder is an OasisPointStreamBuilder (stream-builder.h), the
+// constructor sets the cursor's point-stream threshold to
+// PointStreamThreshold, and each polygon or path whose list the cursor
+// leaves undecoded goes to the builder through beginPolygonStream() or
+// beginPathStream() and addPoints(), followed by endElement().  For
+// other builders such lists, should the caller have set a threshold
+// anyway, are decoded into a PointList as usual.
+//
+// Errors, including references to cell or text-string
+// reference-numbers that no name record defines, throw runtime_error.
+
+#ifndef OASIS_CURSOR_FEED_H_INCLUDED
+#define OASIS_CURSOR_FEED_H_INCLUDED
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "misc/utils.h"
+#include "oasis.h"
+#include "builder.h"
+#include "batch-builder.h"
+#include "stream-builder.h"
+#include "cursor.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+using std::vector;
+using SoftJin::Ulong;
+using SoftJin::Ullong;
+
+
+class CursorFeeder {
+    // Enough to amortize the call, few enough to stay in L1.
+    static const size_t  MaxRectRun = 256;
+
+    OasisCursor&        cursor;
+    OasisBuilder*       builder;
+    OasisBatchBuilder*  batchBuilder;   // builder, if it takes runs
+    OasisPointStreamBuilder*  streamBuilder;    // builder, if it streams
+    bool                wantText;
+    bool                wantExtensions;
+
+    std::unordered_map< string, std::unique_ptr<CellName> >    cellNames;
+    std::unordered_map< string, std::unique_ptr<TextString> >  textStrings;
+
+    vector<ElementView> views;          // one batch from the cursor
+    PointList           ptlist;         // for beginPolygon() and beginPath()
+    vector<RectElem>    rectRun;        // not yet given to batchBuilder
+    Ulong               runLayer;       // of the rectangles in rectRun
+    Ulong               runDatatype;
+
+public:
+                CursorFeeder (OasisCursor& cursor, OasisBuilder* builder);
+
+    void        ignoreText()            { wantText = false; }
+    void        ignoreExtensions()      { wantExtensions = false; }
+
+    void        feedFile (Validation::Scheme valScheme);
+
+private:
+    void        feedCell();
+    void        feedElement (const ElementView& view);
+    void        addToRun (const ElementView& view);
+    void        flushRun();
+    CellName*   getCellName (const string& name, bool byRefnum,
+                             Ullong refnum);
+    TextString* getTextString (const ElementView& view);
+    void        makePointList (const ElementView& view, bool isPolygon);
+
+private:
+                CursorFeeder (const CursorFeeder&);     // forbidden
+    void        operator= (const CursorFeeder&);        // forbidden
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_CURSOR_FEED_H_INCLUDED
@@ -0,0 +1,972 @@
+// oasis/cursor.cc -- pull-style reading of the elements of an OASIS file
+//
+// last modified:   2026/10/17
+
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "oasis.h"
+#include "rectypes.h"
+#include "cursor.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::runtime_error;
+
+
+namespace {
+
+const Uint  PlaceXBit         = 0x20;   // PLACEMENT: CNXYRAAF, CNXYRMAF
+const Uint  PlaceYBit         = 0x10;
+const Uint  PlaceRepBit       = 0x08;
+const Uint  PlaceMagBit       = 0x04;   // PLACEMENT_TRANSFORM only
+const Uint  PlaceAngleBit     = 0x02;
+const Uint  PlaceAngleMask    = 0x06;   // PLACEMENT only
+const Uint  PlaceFlipBit      = 0x01;
+
+const Uint  ElemXBit          = 0x10;   // TEXT and all geometry records
+const Uint  ElemYBit          = 0x08;
+const Uint  ElemRepBit        = 0x04;
+const Uint  ElemDatatypeBit   = 0x02;   // TEXT: texttype
+const Uint  ElemLayerBit      = 0x01;   // TEXT: textlayer
+
+const Uint  TextStringBit     = 0x40;   // TEXT: 0CNXYRTL
+const Uint  TextRefnumBit     = 0x20;
+
+const Uint  RectSquareBit     = 0x80;   // RECTANGLE: SWHXYRDL
+const Uint  WidthBit          = 0x40;   // also PATH, TRAPEZOID, CTRAPEZOID
+const Uint  HeightBit         = 0x20;   // RECTANGLE, (C)TRAPEZOID
+const Uint  PointListBit      = 0x20;   // POLYGON, PATH
+const Uint  PathExtensionBit  = 0x80;
+const Uint  TrapVerticalBit   = 0x80;
+const Uint  CtrapTypeBit      = 0x80;
+const Uint  RadiusBit         = 0x20;
+
+
+// ReadInterval -- Section 19: the intervals in LAYERNAME records
+// Types 0-4 are 0..inf, 0..b, b..b, b..inf and a..b.
+
+void
+ReadInterval (MappedScanner& scanner, /*out*/ Ulong* lo, /*out*/ Ulong* hi)
+{
+    Ulong  type = scanner.readUInt();
+    *lo = 0;
+    *hi = ULONG_MAX;
+    switch (type) {
+        case 0:                                                 break;
+        case 1:  *hi = scanner.readUInt();                      break;
+        case 2:  *lo = *hi = scanner.readUInt();                break;
+        case 3:  *lo = scanner.readUInt();                      break;
+        case 4:  *lo = scanner.readUInt();
+                 *hi = scanner.readUInt();                      break;
+        default:
+            throw runtime_error(scanner.getMappedFile().getFilename()
+                                + ": invalid interval type "
+                                + std::to_string(type));
+    }
+}
+
+}  // unnamed namespace
+
+
+// Modal::reset -- Section 10: the state at the start of a cell
+// All modal variables are undefined except the positions, which are 0,
+// and the xy-mode, which is absolute.
+
+void
+OasisCursor::Modal::reset()
+{
+    xyRelative = false;
+    placementX = placementY = 0;
+    geometryX = geometryY = 0;
+    textX = textY = 0;
+    haveLayer = haveDatatype = false;
+    haveTextlayer = haveTexttype = false;
+    haveWidth = haveHeight = false;
+    haveHalfwidth = false;
+    haveStartExtn = haveEndExtn = false;
+    haveCtrapType = false;
+    haveRadius = false;
+    polygonPoints.have = polygonPoints.pending = false;
+    pathPoints.have = pathPoints.pending = false;
+    haveTextString = false;
+    repetition = Null;
+    repPending = false;
+}
+
+
+OasisCursor::OasisCursor (const char* fname, bool resolveNames)
+  : mfile(fname),
+    scanner(mfile),
+    tokenizer(scanner),
+    repCache(std::make_shared<RepetitionCache>()),
+    batchArena(16*1024)
+{
+    cellOpen = false;
+    atBoundary = false;
+    numFiltered = 0;
+    streamThreshold = 0;
+    unit = 0;
+    modal.reset();
+
+    if (resolveNames) {
+        readNames();
+        tokenizer.rewind();
+    }
+}
+
+
+// rewind -- go back to before the first cell
+
+void
+OasisCursor::rewind()
+{
+    tokenizer.rewind();
+    modal.reset();
+    cellOpen = false;
+    atBoundary = false;
+    cellName.clear();
+}
+
+
+// setLayerFilter -- return only elements that filter selects
+// The filter's layer names are bound here with the file's LAYERNAME
+// records.
+
+void
+OasisCursor::setLayerFilter (const LayerFilter& filter)
+{
+    layerFilter = filter;
+    if (! layerFilter.hasNames())
+        return;
+    for (size_t j = 0;  j < layerNames.size();  ++j) {
+        const LayerNameEntry&  entry = layerNames[j];
+        layerFilter.bindLayerName(entry.name, entry.isText,
+                                  entry.layerLo, entry.layerHi,
+                                  entry.dtypeLo, entry.dtypeHi);
+    }
+}
+
+
+// nextCell -- advance to the next cell in the file
+// Whatever remains of the current cell is skipped.  Returns false when
+// there are no more cells.
+
+bool
+OasisCursor::nextCell()
+{
+    if (cellOpen)
+        skipCell();
+
+    const RecordCursor&  curs = tokenizer.cursor();
+    for (;;) {
+        if (atBoundary)
+            atBoundary = false;
+        else if (! tokenizer.next())
+            return false;
+
+        switch (curs.recID) {
+            case RID_CELL_REF:
+            case RID_CELL_NAMED:
+                beginCell();
+                return true;
+            case RID_END:
+                return false;
+            default:
+                break;          // the tokenizer steps over it
+        }
+    }
+}
+
+
+// skipCell -- abandon the rest of the current cell
+// The records are stepped over without being decoded.  The next
+// nextCell() returns the following cell.
+
+void
+OasisCursor::skipCell()
+{
+    while (cellOpen) {
+        if (! tokenizer.next()) {
+            cellOpen = false;
+            break;
+        }
+        if (endsCell(tokenizer.cursor())) {
+            atBoundary = true;
+            cellOpen = false;
+        }
+    }
+}
+
+
+// seekCell -- position the cursor at the start of the named cell
+// Returns false if there is no such cell, or if the constructor was
+// told not to resolve names.  After a successful return the cursor is
+// in the cell, as after nextCell(), and the following nextCell() goes
+// on from there in file order.
+
+bool
+OasisCursor::seekCell (const string& name)
+{
+    std::unordered_map<string, CellStart>::const_iterator
+        iter = cellStarts.find(name);
+    if (iter == cellStarts.end())
+        return false;
+
+    // A cell inside a CBLOCK is reached by inflating the CBLOCK and
+    // stepping through the records before it.  Those records belong
+    // to other cells and are not decoded.
+
+    const CellStart&  start = iter->second;
+    const RecordCursor&  curs = tokenizer.cursor();
+    tokenizer.seekTo(start.offset);
+    cellOpen = false;
+    atBoundary = false;
+    for (;;) {
+        if (! tokenizer.next())
+            abortCursor("cell '" + name + "' not found at its offset");
+        if (curs.inCblock != start.inCblock)
+            continue;
+        if (curs.inCblock  &&  curs.blockOffset < start.blockOffset)
+            continue;
+        if (curs.recID != RID_CELL_REF  &&  curs.recID != RID_CELL_NAMED)
+            abortCursor("cell '" + name + "' not found at its offset");
+        break;
+    }
+    beginCell();
+    return true;
+}
+
+
+// next -- get the next element of the current cell
+// Returns false at the end of the cell.  The view and what it points to
+// are valid until the next call to next() or to a positioning method.
+
+bool
+OasisCursor::next (/*out*/ ElementView* view)
+{
+    return (next(view, 1) == 1);
+}
+
+
+// next -- get up to maxViews elements of the current cell
+// Returns the number of views filled in; 0 at the end of the cell.
+// The point lists and strings of all the views are kept in one arena,
+// which the next call recycles.
+
+size_t
+OasisCursor::next (/*out*/ ElementView* views, size_t maxViews)
+{
+    batchArena.reset();
+    size_t  n = 0;
+    while (n < maxViews  &&  readElement(&views[n]))
+        ++n;
+    return n;
+}
+
+
+//----------------------------------------------------------------------
+// Private methods
+
+
+// readNames -- collect name records, cell positions and START
+// The names of reference-numbers may be defined anywhere in the file,
+// so CELL records that use reference-numbers are resolved after the
+// pass.  If a name is defined twice, the first cell wins.
+
+void
+OasisCursor::readNames()
+{
+    const RecordCursor&  curs = tokenizer.cursor();
+    vector< std::pair<CellKey, CellStart> >  starts;
+    Ullong  nextCellRefnum = 0;
+    Ullong  nextTextRefnum = 0;
+
+    tokenizer.rewind();
+    while (tokenizer.next()) {
+        switch (curs.recID) {
+            case RID_START:
+                // `1' version-string unit offset-flag [table-offsets]
+                version = scanner.readString().str();
+                unit = scanner.readReal();
+                if (scanner.readUInt() == 0) {
+                    for (int j = 0;  j < 12;  ++j)
+                        scanner.skipUInt();
+                }
+                tokenizer.claimRecord();
+                break;
+
+            case RID_CELL_REF:
+            case RID_CELL_NAMED: {
+                CellStart  start;
+                start.offset = curs.offset;
+                start.blockOffset = curs.blockOffset;
+                start.inCblock = curs.inCblock;
+                starts.push_back(std::make_pair(curs.ref, start));
+                break;
+            }
+
+            case RID_CELLNAME_IMPLICIT:
+            case RID_CELLNAME: {
+                string  name = scanner.readString().str();
+                Ullong  refnum = (curs.recID == RID_CELLNAME)
+                                     ? scanner.readUInt64()
+                                     : nextCellRefnum++;
+                tokenizer.claimRecord();
+                cellNames[refnum].swap(name);
+                break;
+            }
+
+            case RID_TEXTSTRING_IMPLICIT:
+            case RID_TEXTSTRING: {
+                string  text = scanner.readString().str();
+                Ullong  refnum = (curs.recID == RID_TEXTSTRING)
+                                     ? scanner.readUInt64()
+                                     : nextTextRefnum++;
+                tokenizer.claimRecord();
+                textStrings[refnum].swap(text);
+                break;
+            }
+
+            case RID_LAYERNAME_GEOMETRY:
+            case RID_LAYERNAME_TEXT: {
+                LayerNameEntry  entry;
+                entry.name = scanner.readString().str();
+                entry.isText = (curs.recID == RID_LAYERNAME_TEXT);
+                ReadInterval(scanner, &entry.layerLo, &entry.layerHi);
+                ReadInterval(scanner, &entry.dtypeLo, &entry.dtypeHi);
+                tokenizer.claimRecord();
+                layerNames.push_back(entry);
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    for (size_t j = 0;  j < starts.size();  ++j) {
+        const CellKey&  key = starts[j].first;
+        if (! key.byRefnum) {
+            cellStarts.insert(std::make_pair(key.name, starts[j].second));
+            continue;
+        }
+        std::unordered_map<Ullong, string>::const_iterator
+            iter = cellNames.find(key.refnum);
+        if (iter != cellNames.end())
+            cellStarts.insert(std::make_pair(iter->second, starts[j].second));
+    }
+}
+
+
+// beginCell -- called with the tokenizer at a CELL record
+
+void
+OasisCursor::beginCell()
+{
+    const RecordCursor&  curs = tokenizer.cursor();
+    modal.reset();
+    cellKey = curs.ref;
+    StringView  name = keepName(cellKey, cellNames);
+    cellName.assign(name.data, name.size);
+    cellOpen = true;
+}
+
+
+// endsCell -- true if the record at curs is not part of the open cell
+
+bool
+OasisCursor::endsCell (const RecordCursor& curs) const
+{
+    return (! curs.inCell
+            ||  curs.recID == RID_CELL_REF  ||  curs.recID == RID_CELL_NAMED);
+}
+
+
+// readElement -- read records up to and including the next element
+// Returns false, and leaves the tokenizer at the record that ends the
+// cell, if the cell has no more elements.
+
+bool
+OasisCursor::readElement (/*out*/ ElementView* view)
+{
+    if (! cellOpen)
+        return false;
+
+    const RecordCursor&  curs = tokenizer.cursor();
+    for (;;) {
+        if (! tokenizer.next()) {
+            cellOpen = false;
+            return false;
+        }
+        if (endsCell(curs)) {
+            atBoundary = true;
+            cellOpen = false;
+            return false;
+        }
+
+        switch (curs.recID) {
+            case RID_XYABSOLUTE:
+                modal.xyRelative = false;
+                break;
+
+            case RID_XYRELATIVE:
+                modal.xyRelative = true;
+                break;
+
+            case RID_PLACEMENT:
+            case RID_PLACEMENT_TRANSFORM:
+                readPlacement(view);
+                tokenizer.claimRecord();
+                return true;
+
+            case RID_TEXT: {
+                bool  wanted = readText(view);
+                tokenizer.claimRecord();
+                if (wanted)
+                    return true;
+                break;
+            }
+
+            case RID_RECTANGLE:
+            case RID_POLYGON:
+            case RID_PATH:
+            case RID_TRAPEZOID:
+            case RID_TRAPEZOID_A:
+            case RID_TRAPEZOID_B:
+            case RID_CTRAPEZOID:
+            case RID_CIRCLE: {
+                bool  wanted = readGeometry(view);
+                tokenizer.claimRecord();
+                if (wanted)
+                    return true;
+                break;
+            }
+
+            case RID_XGEOMETRY: {
+                bool  wanted = readXGeometry(view);
+                tokenizer.claimRecord();
+                if (wanted)
+                    return true;
+                break;
+            }
+
+            default:
+                // PAD, PROPERTY, PROPERTY_REPEAT, XELEMENT, and CBLOCK,
+                // which the tokenizer inflates when it moves on.
+                break;
+        }
+    }
+}
+
+
+// readPlacement -- Section 22
+// `17' placement-info-byte [reference-number | cellname-string]
+//      [x] [y] [repetition]
+// `18' placement-info-byte [reference-number | cellname-string]
+//      [magnification] [angle] [x] [y] [repetition]
+//
+// The tokenizer has already read the cell reference and keeps the
+// modal placement-cell; its value is in curs.ref.
+
+void
+OasisCursor::readPlacement (/*out*/ ElementView* view)
+{
+    const RecordCursor&  curs = tokenizer.cursor();
+    Uint  info = curs.infoByte;
+
+    clearView(EK_Placement, view);
+    if (! curs.haveRef)
+        abortCursor("PLACEMENT with undefined modal variable placement-cell");
+    view->byRefnum = curs.ref.byRefnum;
+    view->refnum = curs.ref.refnum;
+    view->name = keepName(curs.ref, cellNames);
+
+    if (curs.recID == RID_PLACEMENT_TRANSFORM) {
+        if (info & PlaceMagBit)
+            view->mag = scanner.readReal();
+        if (info & PlaceAngleBit)
+            view->angle = scanner.readReal();
+    } else
+        view->angle = ((info & PlaceAngleMask) >> 1) * 90;
+    view->flip = (info & PlaceFlipBit);
+
+    // PLACEMENT uses different bits for x, y and repetition than the
+    // other elements.
+    Uint  posInfo = ((info & PlaceXBit) ? ElemXBit : 0)
+                  | ((info & PlaceYBit) ? ElemYBit : 0)
+                  | ((info & PlaceRepBit) ? ElemRepBit : 0);
+    readPosition(posInfo, &modal.placementX, &modal.placementY, true, view);
+}
+
+
+// readText -- Section 23
+// `19' text-info-byte [reference-number | text-string]
+//      [textlayer] [texttype] [x] [y] [repetition]
+
+bool
+OasisCursor::readText (/*out*/ ElementView* view)
+{
+    Uint  info = tokenizer.cursor().infoByte;
+
+    clearView(EK_Text, view);
+    if (info & TextStringBit) {
+        readKey(info & TextRefnumBit, &modal.textString);
+        modal.haveTextString = true;
+    }
+    if (info & ElemLayerBit) {
+        modal.textlayer = scanner.readUInt();
+        modal.haveTextlayer = true;
+    }
+    if (info & ElemDatatypeBit) {
+        modal.texttype = scanner.readUInt();
+        modal.haveTexttype = true;
+    }
+    if (! modal.haveTextString)
+        abortCursor("TEXT with undefined modal variable text-string");
+    if (! modal.haveTextlayer  ||  ! modal.haveTexttype)
+        abortCursor("TEXT with undefined modal variable textlayer"
+                    " or texttype");
+
+    bool  wanted = layerFilter.allowsText(modal.textlayer, modal.texttype);
+    if (wanted) {
+        view->layer = modal.textlayer;
+        view->datatype = modal.texttype;
+        view->byRefnum = modal.textString.byRefnum;
+        view->refnum = modal.textString.refnum;
+        view->name = keepName(modal.textString, textStrings);
+    } else
+        ++numFiltered;
+    readPosition(info, &modal.textX, &modal.textY, wanted, view);
+    return wanted;
+}
+
+
+// readGeometry -- Sections 24-29
+// All geometry records begin with info-byte, layer and datatype and end
+// with x, y and repetition.  Returns false if the layer filter rejects
+// the element; the record has then only updated the modal variables.
+
+bool
+OasisCursor::readGeometry (/*out*/ ElementView* view)
+{
+    const RecordCursor&  curs = tokenizer.cursor();
+    Uint  info = curs.infoByte;
+
+    if (info & ElemLayerBit) {
+        modal.layer = scanner.readUInt();
+        modal.haveLayer = true;
+    }
+    if (info & ElemDatatypeBit) {
+        modal.datatype = scanner.readUInt();
+        modal.haveDatatype = true;
+    }
+    if (! modal.haveLayer  ||  ! modal.haveDatatype)
+        abortCursor("geometry with undefined modal variable layer"
+                    " or datatype");
+    bool  wanted = layerFilter.allowsGeometry(modal.layer, modal.datatype);
+
+    switch (curs.recID) {
+        case RID_RECTANGLE:
+            // `20' rectangle-info-byte [layer] [datatype] [width] [height]
+            //      [x] [y] [repetition]
+            clearView(EK_Rectangle, view);
+            if (info & WidthBit) {
+                modal.width = scanner.readUInt();
+                modal.haveWidth = true;
+            }
+            if (info & RectSquareBit) {
+                if (info & HeightBit)
+                    abortCursor("RECTANGLE has both S and H bits set");
+                modal.height = modal.width;
+                modal.haveHeight = modal.haveWidth;
+            } else if (info & HeightBit) {
+                modal.height = scanner.readUInt();
+                modal.haveHeight = true;
+            }
+            if (! modal.haveWidth  ||  ! modal.haveHeight)
+                abortCursor("RECTANGLE with undefined modal variable"
+                            " geometry-w or geometry-h");
+            view->width = modal.width;
+            view->height = modal.height;
+            break;
+
+        case RID_POLYGON:
+            // `21' polygon-info-byte [layer] [datatype] [point-list]
+            //      [x] [y] [repetition]
+            clearView(EK_Polygon, view);
+            readPointList(&modal.polygonPoints, info & PointListBit,
+                          true, wanted, view);
+            break;
+
+        case RID_PATH: {
+            // `22' path-info-byte [layer] [datatype] [half-width]
+            //      [extension-scheme [start-extension] [end-extension]]
+            //      [point-list] [x] [y] [repetition]
+            clearView(EK_Path, view);
+            if (info & WidthBit) {
+                modal.halfwidth = scanner.readUInt();
+                modal.haveHalfwidth = true;
+            }
+            if (! modal.haveHalfwidth)
+                abortCursor("PATH with undefined modal variable halfwidth");
+
+            if (info & PathExtensionBit) {
+                // extension-scheme ::= 0000SSEE
+                Ulong  scheme = scanner.readUInt();
+                Uint   kinds[2] = { Uint((scheme >> 2) & 3), Uint(scheme & 3) };
+                long*  extns[2] = { &modal.startExtn, &modal.endExtn };
+                bool*  haves[2] = { &modal.haveStartExtn, &modal.haveEndExtn };
+                for (int j = 0;  j < 2;  ++j) {
+                    switch (kinds[j]) {
+                        case 0:  break;
+                        case 1:  *extns[j] = 0;  break;
+                        case 2:  *extns[j] = modal.halfwidth;  break;
+                        case 3:  *extns[j] = scanner.readSInt();  break;
+                    }
+                    if (kinds[j] != 0)
+                        *haves[j] = true;
+                }
+            }
+            if (! modal.haveStartExtn  ||  ! modal.haveEndExtn)
+                abortCursor("PATH with undefined modal variable"
+                            " path-start-extension or path-end-extension");
+
+            view->halfwidth = modal.halfwidth;
+            view->startExtn = modal.startExtn;
+            view->endExtn = modal.endExtn;
+            readPointList(&modal.pathPoints, info & PointListBit,
+                          false, wanted, view);
+            break;
+        }
+
+        case RID_TRAPEZOID:
+        case RID_TRAPEZOID_A:
+        case RID_TRAPEZOID_B:
+            // `23' trap-info-byte [layer] [datatype] [width] [height]
+            //      delta-a delta-b [x] [y] [repetition]
+            // `24' and `25' have only delta-a and only delta-b.
+            clearView(EK_Trapezoid, view);
+            if (info & WidthBit) {
+                modal.width = scanner.readUInt();
+                modal.haveWidth = true;
+            }
+            if (info & HeightBit) {
+                modal.height = scanner.readUInt();
+                modal.haveHeight = true;
+            }
+            if (! modal.haveWidth  ||  ! modal.haveHeight)
+                abortCursor("TRAPEZOID with undefined modal variable"
+                            " geometry-w or geometry-h");
+            view->width = modal.width;
+            view->height = modal.height;
+            view->vertical = (info & TrapVerticalBit);
+            if (curs.recID != RID_TRAPEZOID_B)
+                view->deltaA = scanner.readSInt();
+            if (curs.recID != RID_TRAPEZOID_A)
+                view->deltaB = scanner.readSInt();
+            break;
+
+        case RID_CTRAPEZOID:
+            // `26' ctrapezoid-info-byte [layer] [datatype] [ctrapezoid-type]
+            //      [width] [height] [x] [y] [repetition]
+            // Some types use only one of width and height, so a missing
+            // one is left 0 rather than treated as an error.
+            clearView(EK_CTrapezoid, view);
+            if (info & CtrapTypeBit) {
+                modal.ctrapType = scanner.readUInt();
+                modal.haveCtrapType = true;
+            }
+            if (info & WidthBit) {
+                modal.width = scanner.readUInt();
+                modal.haveWidth = true;
+            }
+            if (info & HeightBit) {
+                modal.height = scanner.readUInt();
+                modal.haveHeight = true;
+            }
+            if (! modal.haveCtrapType)
+                abortCursor("CTRAPEZOID with undefined modal variable"
+                            " ctrapezoid-type");
+            view->ctrapType = modal.ctrapType;
+            view->width = (modal.haveWidth ? modal.width : 0);
+            view->height = (modal.haveHeight ? modal.height : 0);
+            break;
+
+        case RID_CIRCLE:
+            // `27' circle-info-byte [layer] [datatype] [radius]
+            //      [x] [y] [repetition]
+            clearView(EK_Circle, view);
+            if (info & RadiusBit) {
+                modal.radius = scanner.readUInt();
+                modal.haveRadius = true;
+            }
+            if (! modal.haveRadius)
+                abortCursor("CIRCLE with undefined modal variable radius");
+            view->radius = modal.radius;
+            break;
+    }
+
+    view->layer = modal.layer;
+    view->datatype = modal.datatype;
+    if (! wanted)
+        ++numFiltered;
+    readPosition(info, &modal.geometryX, &modal.geometryY, wanted, view);
+    return wanted;
+}
+
+
+// readXGeometry -- Section 33
+// `33' xgeometry-info-byte attribute [layer] [datatype] xgeometry-string
+//      [x] [y] [repetition]
+
+bool
+OasisCursor::readXGeometry (/*out*/ ElementView* view)
+{
+    Uint  info = tokenizer.cursor().infoByte;
+
+    clearView(EK_XGeometry, view);
+    view->attribute = scanner.readUInt();
+    if (info & ElemLayerBit) {
+        modal.layer = scanner.readUInt();
+        modal.haveLayer = true;
+    }
+    if (info & ElemDatatypeBit) {
+        modal.datatype = scanner.readUInt();
+        modal.haveDatatype = true;
+    }
+    if (! modal.haveLayer  ||  ! modal.haveDatatype)
+        abortCursor("XGEOMETRY with undefined modal variable layer"
+                    " or datatype");
+    bool  wanted = layerFilter.allowsGeometry(modal.layer, modal.datatype);
+    view->layer = modal.layer;
+    view->datatype = modal.datatype;
+    StringView  data = scanner.readString();
+    if (wanted)
+        view->data = keepString(data);
+    else
+        ++numFiltered;
+    readPosition(info, &modal.geometryX, &modal.geometryY, wanted, view);
+    return wanted;
+}
+
+
+// readPosition -- read the x, y and repetition that end element records
+// In xy-relative mode the coordinates in the record are added to the
+// modal position; in either mode the modal position becomes the
+// element's.  The repetition of an element that is not wanted is only
+// stepped over.
+
+void
+OasisCursor::readPosition (Uint info, long* modalX, long* modalY,
+                           bool wanted, /*out*/ ElementView* view)
+{
+    if (info & ElemXBit) {
+        long  x = scanner.readSInt();
+        *modalX = (modal.xyRelative ? *modalX + x : x);
+    }
+    if (info & ElemYBit) {
+        long  y = scanner.readSInt();
+        *modalY = (modal.xyRelative ? *modalY + y : y);
+    }
+    view->x = *modalX;
+    view->y = *modalY;
+    if (! wanted) {
+        if (info & ElemRepBit)
+            skipRepetition();
+        return;
+    }
+    view->rep = (info & ElemRepBit) ? readRepetition() : Null;
+}
+
+
+// readRepetition -- Section 7.6
+// Returns the interned repetition and makes it the modal repetition.
+// A modal repetition left undecoded by skipRepetition() is decoded
+// when it is reused.
+
+const Repetition*
+OasisCursor::readRepetition()
+{
+    RepetitionView  rview = scanner.readRepetitionView();
+    Repetition  rep;
+    try {
+        if (rview.type != Rep_ReusePrevious) {
+            MappedScanner::DecodeRepetition(rview, &rep);
+            modal.repetition = repCache->intern(&rep);
+            modal.repPending = false;
+        } else if (modal.repPending) {
+            MappedScanner::DecodeRepetition(modal.repView, &rep);
+            modal.repetition = repCache->intern(&rep);
+            modal.repPending = false;
+        }
+    } catch (const runtime_error& exc) {
+        abortCursor(exc.what());
+    }
+    if (modal.repetition == Null)
+        abortCursor("repetition type 0 with undefined modal variable"
+                    " repetition");
+    return modal.repetition;
+}
+
+
+// skipRepetition -- step over the repetition of an element not wanted
+// The bytes are kept as the modal repetition, because the CBLOCK
+// buffer they are in may be gone when an element reuses them.
+
+void
+OasisCursor::skipRepetition()
+{
+    RepetitionView  rview = scanner.readRepetitionView();
+    if (rview.type == Rep_ReusePrevious)
+        return;
+    modal.repBytes.assign(rview.data, rview.end);
+    modal.repView.type = rview.type;
+    modal.repView.data = modal.repBytes.data();
+    modal.repView.end = modal.repBytes.data() + modal.repBytes.size();
+    modal.repPending = true;
+    modal.repetition = Null;
+}
+
+
+// readPointList -- read or reuse a point-list and copy it to the arena
+// present says whether the record has a point-list; otherwise the modal
+// point-list is used.  For an element that is not wanted the list is
+// kept undecoded, as for repetitions, and so is a list to be streamed.
+// The view of a streamed list gets its own copy of the bytes, because
+// the modal copy may be replaced before the next call to next().
+
+void
+OasisCursor::readPointList (ModalPointList* modalList, bool present,
+                            bool isPolygon, bool wanted,
+                            /*out*/ ElementView* view)
+{
+    if (present) {
+        PointListView  plv = scanner.readPointListView();
+        bool  stream = (streamThreshold != 0
+                        &&  PointListDecoder::NumVertices(plv, isPolygon)
+                                >= streamThreshold);
+        if (wanted  &&  ! stream) {
+            MappedScanner::DecodePointList(plv, isPolygon, &modalList->points);
+            modalList->pending = false;
+        } else {
+            modalList->bytes.assign(plv.data, plv.end);
+            modalList->raw = plv;
+            modalList->raw.data = modalList->bytes.data();
+            modalList->raw.end = modalList->bytes.data()
+                                 + modalList->bytes.size();
+            modalList->pending = true;
+        }
+        modalList->have = true;
+    }
+    if (! modalList->have)
+        abortCursor(isPolygon ? "POLYGON with undefined modal variable"
+                                " polygon-point-list"
+                              : "PATH with undefined modal variable"
+                                " path-point-list");
+    if (! wanted)
+        return;
+
+    if (modalList->pending  &&  streamThreshold != 0) {
+        const PointListView&  raw = modalList->raw;
+        Ulong  numPoints = PointListDecoder::NumVertices(raw, isPolygon);
+        if (numPoints >= streamThreshold) {
+            view->points = Null;
+            view->numPoints = numPoints;
+            view->pointList = raw;
+            view->pointList.data = batchArena.copyArray(raw.data,
+                                                        raw.byteSize());
+            view->pointList.end = view->pointList.data + raw.byteSize();
+            return;
+        }
+    }
+    if (modalList->pending) {
+        MappedScanner::DecodePointList(modalList->raw, isPolygon,
+                                       &modalList->points);
+        modalList->pending = false;
+    }
+    const PointList&  points = modalList->points;
+    view->numPoints = points.size();
+    view->points = batchArena.copyArray(&points[0], points.size());
+}
+
+
+// readKey -- read a reference-number or a string into key
+
+void
+OasisCursor::readKey (bool byRefnum, /*out*/ CellKey* key)
+{
+    key->byRefnum = byRefnum;
+    if (byRefnum) {
+        key->refnum = scanner.readUInt64();
+        key->name.clear();
+    } else {
+        key->refnum = 0;
+        StringView  sv = scanner.readString();
+        key->name.assign(sv.data, sv.size);
+    }
+}
+
+
+// keepString -- copy sv to the batch arena
+// The bytes a StringView points to may be in a CBLOCK buffer that is
+// overwritten when the scanner enters the next CBLOCK.
+
+StringView
+OasisCursor::keepString (const StringView& sv)
+{
+    if (sv.size == 0)
+        return StringView();
+    char*  data = batchArena.allocArray<char>(sv.size);
+    memcpy(data, sv.data, sv.size);
+    return StringView(data, sv.size);
+}
+
+
+// keepName -- the name key gives, copied to the batch arena
+// Empty if key is a reference-number that names does not define.
+
+StringView
+OasisCursor::keepName (const CellKey& key,
+                       const std::unordered_map<Ullong, string>& names)
+{
+    if (! key.byRefnum)
+        return keepString(StringView(key.name.data(), key.name.size()));
+
+    std::unordered_map<Ullong, string>::const_iterator
+        iter = names.find(key.refnum);
+    if (iter == names.end())
+        return StringView();
+    return keepString(StringView(iter->second.data(), iter->second.size()));
+}
+
+
+void
+OasisCursor::clearView (ElementKind kind, /*out*/ ElementView* view)
+{
+    const RecordCursor&  curs = tokenizer.cursor();
+    *view = ElementView();
+    view->kind = kind;
+    view->recID = curs.recID;
+    view->offset = curs.offset;
+    view->mag = 1.0;
+}
+
+
+void
+OasisCursor::abortCursor (const string& msg)
+{
+    const RecordCursor&  curs = tokenizer.cursor();
+    string  where = curs.inCblock
+                        ? "in CBLOCK at offset " + std::to_string(curs.offset)
+                              + " (+" + std::to_string(curs.blockOffset) + ")"
+                        : "at offset " + std::to_string(curs.offset);
+    throw runtime_error(mfile.getFilename() + ": " + where + ": " + msg);
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
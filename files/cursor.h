@@ -0,0 +1,294 @@
+// oasis/cursor.h -- pull-style reading of the elements of an OASIS file
+//
+// last modified:   2026/10/17
+//
+// OasisParser pushes: it calls one virtual OasisBuilder method per
+// element, and the caller cannot stop it, batch what it gets, or run
+// it in step with anything else.  OasisCursor lets the caller pull
+// instead.  It walks the file cell by cell and returns the elements of
+// the current cell as ElementViews, one at a time or in batches:
+//
+//     OasisCursor  cursor(fname);
+//     ElementView  views[256];
+//     while (cursor.nextCell()) {
+//         size_t  n;
+//         while ((n = cursor.next(views, 256)) != 0)
+//             for (size_t j = 0;  j < n;  ++j)
+//                 ... views[j] ...
+//     }
+//
+// skipCell() abandons the rest of the current cell without decoding
+// it; seekCell() positions the cursor at the named cell.
+//
+// Each view has the element's modal state resolved: layer, datatype,
+// position, sizes and repetition are the values that apply to the
+// element, whether the record gave them explicitly or not, and
+// positions are absolute even in xy-relative mode.  Point lists,
+// strings and views are valid until the next call to next() or to a
+// positioning method.  Repetitions are interned in the cursor's
+// RepetitionCache (rep-intern.h) and live as long as the cursor.
+//
+// getVersion() and getUnit() give the fields of the START record.
+// Properties are skipped, as are records outside cells.  Reference-
+// numbers of cells and text strings are resolved if resolveNames is
+// true (the default).  The names come from a pass over the whole file
+// with OasisRecordTokenizer, made by the constructor, which also notes
+// where each cell begins for seekCell().  Without it the views carry
+// only the reference-numbers and seekCell() always fails.
+//
+// setLayerFilter() restricts the views to elements on some layers (see
+// layer-filter.h).  Elements that fail the filter are not returned;
+// their point-lists and repetitions are stepped over without being
+// decoded, and are decoded only if a later element reuses them.  Layer
+// names in the filter are bound with the LAYERNAME records found by
+// the constructor's pass, so they need resolveNames.
+//
+// setPointStreamThreshold() keeps point-lists of at least that many
+// vertices undecoded: the view has points Null and the encoded list in
+// pointList, which the caller expands a chunk at a time with
+// PointListDecoder or StreamPointList() (stream-builder.h).  Only the
+// encoded bytes, a few per vertex, are copied.
+//
+// Errors in the file make the methods throw runtime_error.
+
+#ifndef OASIS_CURSOR_H_INCLUDED
+#define OASIS_CURSOR_H_INCLUDED
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "misc/utils.h"
+#include "oasis.h"
+#include "arena.h"
+#include "layer-filter.h"
+#include "mapped-file.h"
+#include "mapped-scanner.h"
+#include "rec-tokenizer.h"
+#include "rep-intern.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+using std::vector;
+using SoftJin::Uchar;
+using SoftJin::Uint;
+using SoftJin::Ulong;
+using SoftJin::Ullong;
+
+
+enum ElementKind {
+    EK_Placement,
+    EK_Text,
+    EK_Rectangle,
+    EK_Polygon,
+    EK_Path,
+    EK_Trapezoid,               // record types 23, 24 and 25
+    EK_CTrapezoid,
+    EK_Circle,
+    EK_XGeometry
+};
+
+
+// ElementView -- one element with its modal state resolved
+//
+// Which fields are meaningful depends on kind.
+//
+// all          recID, offset, x, y, rep
+// geometry     layer, datatype
+// TEXT         layer, datatype (textlayer and texttype), name (the
+//              text string), byRefnum, refnum
+// PLACEMENT    name (the cell), byRefnum, refnum, mag, angle, flip
+// RECTANGLE    width, height
+// POLYGON      points, numPoints; points[0] is (0,0), and the closing
+//              edge is implied.  If the list is streamed (see
+//              setPointStreamThreshold()), points is Null and pointList
+//              holds the list undecoded.
+// PATH         points or pointList, numPoints, halfwidth, startExtn,
+//              endExtn
+// TRAPEZOID    width, height, deltaA, deltaB, vertical
+// CTRAPEZOID   width, height, ctrapType
+// CIRCLE       radius
+// XGEOMETRY    layer, datatype, attribute, data
+//
+// name is empty if it is given by a reference-number that could not be
+// resolved.  rep is Null for elements without repetition.
+
+struct ElementView {
+    ElementKind         kind;
+    Ulong               recID;
+    Ullong              offset;         // record, or CBLOCK containing it
+    Ulong               layer;
+    Ulong               datatype;
+    long                x;
+    long                y;
+    const Repetition*   rep;
+
+    Ulong               width;
+    Ulong               height;
+    long                deltaA;
+    long                deltaB;
+    bool                vertical;
+    Ulong               ctrapType;
+    Ulong               radius;
+
+    const Delta*        points;
+    Ulong               numPoints;
+    PointListView       pointList;      // if streamed; see above
+    Ulong               halfwidth;
+    long                startExtn;
+    long                endExtn;
+
+    StringView          name;
+    bool                byRefnum;
+    Ullong              refnum;
+    double              mag;
+    double              angle;          // degrees
+    bool                flip;
+
+    Ulong               attribute;
+    StringView          data;
+};
+
+
+class OasisCursor {
+    // A filtered element's point-list is kept undecoded in bytes, with
+    // raw describing it, until an element that is wanted reuses it.
+    struct ModalPointList {
+        bool            have;
+        bool            pending;
+        PointList       points;
+        PointListView   raw;
+        vector<Uchar>   bytes;
+    };
+
+    // Modal variables (Section 10).  The have* flags say whether a
+    // variable is defined.
+    struct Modal {
+        bool            xyRelative;
+        long            placementX, placementY;
+        long            geometryX, geometryY;
+        long            textX, textY;
+        bool            haveLayer, haveDatatype;
+        Ulong           layer, datatype;
+        bool            haveTextlayer, haveTexttype;
+        Ulong           textlayer, texttype;
+        bool            haveWidth, haveHeight;
+        Ulong           width, height;
+        bool            haveHalfwidth;
+        Ulong           halfwidth;
+        bool            haveStartExtn, haveEndExtn;
+        long            startExtn, endExtn;
+        bool            haveCtrapType;
+        Ulong           ctrapType;
+        bool            haveRadius;
+        Ulong           radius;
+        ModalPointList  polygonPoints, pathPoints;
+        // The modal placement-cell is kept by the tokenizer.
+        bool            haveTextString;
+        CellKey         textString;     // refnum or string, like a cell
+        const Repetition*  repetition;
+        bool            repPending;     // repetition is in repBytes
+        RepetitionView  repView;
+        vector<Uchar>   repBytes;
+
+        void    reset();
+    };
+
+    struct CellStart {
+        Ullong          offset;         // CELL record, or its CBLOCK
+        Ullong          blockOffset;    // within the CBLOCK
+        bool            inCblock;
+    };
+
+    struct LayerNameEntry {             // a LAYERNAME record
+        string          name;
+        bool            isText;
+        Ulong           layerLo, layerHi;
+        Ulong           dtypeLo, dtypeHi;
+    };
+
+    MappedFile                  mfile;
+    MappedScanner               scanner;
+    OasisRecordTokenizer        tokenizer;
+    Modal                       modal;
+    std::shared_ptr<RepetitionCache>  repCache;
+    MonotonicArena              batchArena;     // points and strings of
+                                                // the views handed out
+
+    std::unordered_map<Ullong, string>  cellNames;    // refnum -> name
+    std::unordered_map<Ullong, string>  textStrings;  // refnum -> string
+    std::unordered_map<string, CellStart>  cellStarts;
+    vector<LayerNameEntry>      layerNames;
+    string                      version;        // from START
+    double                      unit;
+    LayerFilter                 layerFilter;
+    Ullong                      numFiltered;
+    Ulong                       streamThreshold;  // 0 if never
+
+    bool                        cellOpen;       // between CELL and its end
+    bool                        atBoundary;     // tokenizer is at the record
+                                                // that ended the last cell
+    CellKey                     cellKey;
+    string                      cellName;       // empty if unresolved
+
+public:
+    explicit    OasisCursor (const char* fname, bool resolveNames = true);
+
+    bool        nextCell();
+    bool        seekCell (const string& name);
+    void        skipCell();
+    void        rewind();
+    void        setLayerFilter (const LayerFilter& filter);
+    void        setPointStreamThreshold (Ulong minPoints) {
+                    streamThreshold = minPoints;
+                }
+
+    bool        next (/*out*/ ElementView* view);
+    size_t      next (/*out*/ ElementView* views, size_t maxViews);
+
+    bool        inCell() const                  { return cellOpen; }
+    const string&   getCellName() const         { return cellName; }
+    const CellKey&  getCellKey() const          { return cellKey; }
+    const string&   getVersion() const          { return version; }
+    double      getUnit() const                 { return unit; }
+    Ullong      getFilteredCount() const        { return numFiltered; }
+    std::shared_ptr<RepetitionCache>  getRepetitionCache() const {
+                    return repCache;
+                }
+
+private:
+    void        readNames();
+    void        beginCell();
+    bool        readElement (/*out*/ ElementView* view);
+    void        readPlacement (/*out*/ ElementView* view);
+    bool        readText (/*out*/ ElementView* view);
+    bool        readGeometry (/*out*/ ElementView* view);
+    bool        readXGeometry (/*out*/ ElementView* view);
+    void        readPosition (Uint info, long* modalX, long* modalY,
+                              bool wanted, /*out*/ ElementView* view);
+    const Repetition*  readRepetition();
+    void        skipRepetition();
+    void        readPointList (ModalPointList* modal, bool present,
+                               bool isPolygon, bool wanted,
+                               /*out*/ ElementView* view);
+    void        readKey (bool byRefnum, /*out*/ CellKey* key);
+    StringView  keepString (const StringView& sv);
+    StringView  keepName (const CellKey& key,
+                          const std::unordered_map<Ullong, string>& names);
+    bool        endsCell (const RecordCursor& curs) const;
+    void        clearView (ElementKind kind, /*out*/ ElementView* view);
+    void        abortCursor (const string& msg);
+
+private:
+                OasisCursor (const OasisCursor&);       // forbidden
+    void        operator= (const OasisCursor&);         // forbidden
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_CURSOR_H_INCLUDED
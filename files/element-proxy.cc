@@ -0,0 +1,173 @@
+// oasis/element-proxy.cc -- base for builder proxies that hold elements
+//
+// last modified:   2026/10/17
+
+#include "element-proxy.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+
+ElementProxy::ElementProxy (OasisBuilder* target)
+  : target(target)
+{
+    lastHeld = false;
+    passing = false;
+}
+
+
+ElementProxy::~ElementProxy() { }
+
+
+// beginHeld -- the element about to arrive is held
+
+void
+ElementProxy::beginHeld()
+{
+    settle();
+    passing = false;
+    lastHeld = true;
+}
+
+
+// beginForwarded -- the element about to arrive is forwarded at once
+
+void
+ElementProxy::beginForwarded()
+{
+    settle();
+    passing = true;
+}
+
+
+// settle -- the element held last, if any, will get no properties
+
+void
+ElementProxy::settle()
+{
+    if (lastHeld) {
+        lastHeld = false;
+        settleLast();
+    }
+}
+
+
+void
+ElementProxy::settleLast() { }
+
+
+//----------------------------------------------------------------------
+// Structure, names and properties
+
+
+void
+ElementProxy::beginFile (const string& version, const Oreal& unit,
+                         Validation::Scheme valScheme)
+{
+    target->beginFile(version, unit, valScheme);
+}
+
+
+void
+ElementProxy::endFile()
+{
+    settle();
+    flushHeld();
+    passing = false;
+    target->endFile();
+}
+
+
+void
+ElementProxy::beginCell (CellName* cellName)
+{
+    settle();
+    flushHeld();
+    passing = false;
+    target->beginCell(cellName);
+}
+
+
+void
+ElementProxy::endCell()
+{
+    settle();
+    flushHeld();
+    passing = false;
+    target->endCell();
+}
+
+
+void
+ElementProxy::endElement()
+{
+    if (passing)
+        target->endElement();
+    passing = false;
+    settle();
+}
+
+
+void
+ElementProxy::addCellProperty (Property* prop)
+{
+    target->addCellProperty(prop);
+}
+
+
+void
+ElementProxy::addFileProperty (Property* prop)
+{
+    target->addFileProperty(prop);
+}
+
+
+// addElementProperty
+// The element the property belongs to is taken back from those held
+// and forwarded at once, so that its properties follow it.
+
+void
+ElementProxy::addElementProperty (Property* prop)
+{
+    if (lastHeld) {
+        lastHeld = false;
+        passing = true;
+        releaseLast();
+    }
+    target->addElementProperty(prop);
+}
+
+
+void
+ElementProxy::registerCellName (CellName* cellName) {
+    target->registerCellName(cellName);
+}
+
+void
+ElementProxy::registerTextString (TextString* textString) {
+    target->registerTextString(textString);
+}
+
+void
+ElementProxy::registerPropName (PropName* propName) {
+    target->registerPropName(propName);
+}
+
+void
+ElementProxy::registerPropString (PropString* propString) {
+    target->registerPropString(propString);
+}
+
+void
+ElementProxy::registerLayerName (LayerName* layerName) {
+    target->registerLayerName(layerName);
+}
+
+void
+ElementProxy::registerXName (XName* xname) {
+    target->registerXName(xname);
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
@@ -0,0 +1,111 @@
+// oasis/element-proxy.h -- base for builder proxies that hold elements
+//
+// last modified:   2026/10/17
+//
+// RepetitionSynthesizer (rep-synth.h) and ModalOrderBuilder
+// (modal-order.h) sit in front of an OasisCreator and hold the elements
+// of a cell so that they can write them out in another form or another
+// order.  ElementProxy is what the two share: forwarding everything
+// that is not an element, and the bookkeeping of which elements are
+// held and which went through.
+//
+// Writing the held elements later changes the order of the elements in
+// a cell.  That is allowed: OASIS gives no meaning to the order of
+// elements within a cell.  Everything that is not an element goes
+// through unchanged, after the cell's held elements when it ends the
+// cell.  A property attaches to the element before it, so an element
+// that gets properties is taken back from those held and forwarded at
+// once, followed by its properties.
+//
+// endElement() is optional after an element: JLayoutBuilder does not
+// call it.  So the end of a held element is also seen when the next
+// element, the end of the cell or the end of the file arrives.  The
+// proxy calls endElement() after every element it writes.
+//
+// Repetitions that the proxy passes on after the call that brought
+// them, or that it makes itself, are interned in its own
+// RepetitionCache.
+//
+// A derived class calls beginHeld() before it holds an element and
+// beginForwarded() before it forwards one at once, and provides
+//
+//     flushHeld()      write every element held, each followed by
+//                      endElement()
+//     releaseLast()    forward the element held last at once, without
+//                      endElement(), and stop holding it
+//     settleLast()     the element held last will get no properties;
+//                      the default does nothing
+
+#ifndef OASIS_ELEMENT_PROXY_H_INCLUDED
+#define OASIS_ELEMENT_PROXY_H_INCLUDED
+
+#include <string>
+
+#include "misc/utils.h"
+#include "oasis.h"
+#include "builder.h"
+#include "rep-intern.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+
+
+class ElementProxy : public OasisBuilder {
+protected:
+    OasisBuilder*       target;
+    RepetitionCache     repCache;       // owns the repetitions passed on
+
+private:
+    bool                lastHeld;       // the last element may get properties
+    bool                passing;        // the last element went through
+
+public:
+    explicit    ElementProxy (OasisBuilder* target);
+    virtual     ~ElementProxy();
+
+    // OasisBuilder virtual methods for everything but the elements.
+
+    virtual void  beginFile (const string& version,
+                             const Oreal& unit,
+                             Validation::Scheme valScheme);
+    virtual void  endFile();
+
+    virtual void  beginCell (CellName* cellName);
+    virtual void  endCell();
+
+    virtual void  endElement();
+
+    virtual void  addCellProperty (Property* prop);
+    virtual void  addFileProperty (Property* prop);
+    virtual void  addElementProperty (Property* prop);
+
+    virtual void  registerCellName   (CellName*   cellName);
+    virtual void  registerTextString (TextString* textString);
+    virtual void  registerPropName   (PropName*   propName);
+    virtual void  registerPropString (PropString* propString);
+    virtual void  registerLayerName  (LayerName*  layerName);
+    virtual void  registerXName      (XName*      xname);
+
+protected:
+    void        beginHeld();
+    void        beginForwarded();
+
+    virtual void  flushHeld() = 0;
+    virtual void  releaseLast() = 0;
+    virtual void  settleLast();
+
+private:
+    void        settle();
+
+private:
+                ElementProxy (const ElementProxy&);     // forbidden
+    void        operator= (const ElementProxy&);        // forbidden
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_ELEMENT_PROXY_H_INCLUDED
@@ -0,0 +1,205 @@
+// oasis/layer-filter.cc -- selection of elements by layer and datatype
+//
+// last modified:   2026/10/17
+
+#include <cerrno>
+#include <cstdlib>
+#include <algorithm>
+
+#include "layer-filter.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+
+namespace {
+
+// ParseRange -- parse "N" or "N-M" at *pp
+// Advances *pp past the range.  Returns false if there is no number.
+
+bool
+ParseRange (const char** pp, /*out*/ Ulong* lo, /*out*/ Ulong* hi)
+{
+    const char*  p = *pp;
+    char*  end;
+
+    if (*p < '0'  ||  *p > '9')
+        return false;
+    errno = 0;
+    *lo = strtoul(p, &end, 10);
+    if (errno != 0)
+        return false;
+    *hi = *lo;
+    p = end;
+    if (*p == '-') {
+        ++p;
+        if (*p < '0'  ||  *p > '9')
+            return false;
+        *hi = strtoul(p, &end, 10);
+        if (errno != 0  ||  *hi < *lo)
+            return false;
+        p = end;
+    }
+    *pp = p;
+    return true;
+}
+
+}  // unnamed namespace
+
+
+LayerFilter::LayerFilter()
+{
+    forget();
+}
+
+
+// allow -- select layers layerLo..layerHi with datatypes dtypeLo..dtypeHi
+// The bounds are inclusive.  The rule applies to geometry and to text.
+
+void
+LayerFilter::allow (Ulong layerLo, Ulong layerHi, Ulong dtypeLo, Ulong dtypeHi)
+{
+    Rule  rule;
+    rule.layerLo = layerLo;
+    rule.layerHi = layerHi;
+    rule.dtypeLo = dtypeLo;
+    rule.dtypeHi = dtypeHi;
+    rule.forGeometry = true;
+    rule.forText = true;
+    rules.push_back(rule);
+    forget();
+}
+
+
+// allowName -- select the layers the file's LAYERNAME records give this name
+// The name selects nothing until bindLayerName() is called for it.
+
+void
+LayerFilter::allowName (const string& layerName)
+{
+    if (std::find(names.begin(), names.end(), layerName) == names.end())
+        names.push_back(layerName);
+    forget();
+}
+
+
+// addSpec -- add a rule written as a command-line argument
+// The forms are
+//
+//     L   L-L   L/D   L/D-D   L-L/D   L-L/D-D
+//
+// with decimal layer and datatype numbers.  Anything else is taken to
+// be a layer name.  Returns false if spec is empty or starts like a
+// number but is not a valid range.
+
+bool
+LayerFilter::addSpec (const string& spec)
+{
+    if (spec.empty())
+        return false;
+    if (spec[0] < '0'  ||  spec[0] > '9') {
+        allowName(spec);
+        return true;
+    }
+
+    const char*  p = spec.c_str();
+    Ulong  layerLo, layerHi;
+    Ulong  dtypeLo = 0, dtypeHi = ULONG_MAX;
+    if (! ParseRange(&p, &layerLo, &layerHi))
+        return false;
+    if (*p == '/') {
+        ++p;
+        if (! ParseRange(&p, &dtypeLo, &dtypeHi))
+            return false;
+    }
+    if (*p != '\0')
+        return false;
+    allow(layerLo, layerHi, dtypeLo, dtypeHi);
+    return true;
+}
+
+
+// bindLayerName -- tell the filter what a LAYERNAME record says
+// If layerName was passed to allowName(), its intervals are selected
+// for geometry (isText false) or text (isText true).  Otherwise the
+// call does nothing.
+
+void
+LayerFilter::bindLayerName (const string& layerName, bool isText,
+                            Ulong layerLo, Ulong layerHi,
+                            Ulong dtypeLo, Ulong dtypeHi)
+{
+    if (std::find(names.begin(), names.end(), layerName) == names.end())
+        return;
+
+    Rule  rule;
+    rule.layerLo = layerLo;
+    rule.layerHi = layerHi;
+    rule.dtypeLo = dtypeLo;
+    rule.dtypeHi = dtypeHi;
+    rule.forGeometry = ! isText;
+    rule.forText = isText;
+    rules.push_back(rule);
+    forget();
+}
+
+
+bool
+LayerFilter::allowsGeometry (Ulong layer, Ulong datatype) const
+{
+    if (! isActive())
+        return true;
+    if (! haveLastGeometry  ||  layer != lastGeometryLayer
+            ||  datatype != lastGeometryDtype) {
+        lastGeometryResult = matches(false, layer, datatype);
+        lastGeometryLayer = layer;
+        lastGeometryDtype = datatype;
+        haveLastGeometry = true;
+    }
+    return lastGeometryResult;
+}
+
+
+bool
+LayerFilter::allowsText (Ulong textlayer, Ulong texttype) const
+{
+    if (! isActive())
+        return true;
+    if (! haveLastText  ||  textlayer != lastTextLayer
+            ||  texttype != lastTextDtype) {
+        lastTextResult = matches(true, textlayer, texttype);
+        lastTextLayer = textlayer;
+        lastTextDtype = texttype;
+        haveLastText = true;
+    }
+    return lastTextResult;
+}
+
+
+bool
+LayerFilter::matches (bool text, Ulong layer, Ulong datatype) const
+{
+    for (vector<Rule>::const_iterator iter = rules.begin();
+            iter != rules.end();  ++iter) {
+        if ((text ? iter->forText : iter->forGeometry)
+                &&  layer >= iter->layerLo  &&  layer <= iter->layerHi
+                &&  datatype >= iter->dtypeLo  &&  datatype <= iter->dtypeHi)
+            return true;
+    }
+    return false;
+}
+
+
+// forget -- invalidate the memo after the rules change
+void
+LayerFilter::forget()
+{
+    haveLastGeometry = haveLastText = false;
+    lastGeometryLayer = lastGeometryDtype = 0;
+    lastTextLayer = lastTextDtype = 0;
+    lastGeometryResult = lastTextResult = false;
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
@@ -0,0 +1,90 @@
+// oasis/layer-filter.h -- selection of elements by layer and datatype
+//
+// last modified:   2026/10/17
+//
+// A LayerFilter says which layer/datatype pairs a reader wants.  It
+// holds two kinds of rule:
+//
+//   - ranges of layers and datatypes, added with allow() or addSpec();
+//     these select both geometry and text
+//
+//   - layer names, added with allowName() or addSpec().  A name means
+//     whatever the file's LAYERNAME records say it means: the reader
+//     calls bindLayerName() for each LAYERNAME record, and the name
+//     then selects the intervals of that record.  Names from
+//     geometry LAYERNAME records (type 11) select geometry; those from
+//     text records (type 12) select text.
+//
+// A filter without rules selects everything, so that a default-
+// constructed LayerFilter in OasisParserOptions costs nothing.
+//
+// The point of filtering early is to avoid work.  A reader tests the
+// filter as soon as an element's modal layer and datatype are known,
+// and for elements that fail it only steps over the point-list and
+// repetition, keeping their bytes in case a later element reuses them
+// through the modal variables.  See OasisCursor (cursor.h).
+
+#ifndef OASIS_LAYER_FILTER_H_INCLUDED
+#define OASIS_LAYER_FILTER_H_INCLUDED
+
+#include <climits>
+#include <string>
+#include <vector>
+
+#include "misc/utils.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+using std::vector;
+using SoftJin::Ulong;
+
+
+class LayerFilter {
+    struct Rule {
+        Ulong   layerLo, layerHi;
+        Ulong   dtypeLo, dtypeHi;
+        bool    forGeometry;
+        bool    forText;
+    };
+
+    vector<Rule>    rules;
+    vector<string>  names;      // from allowName(), bound or not
+
+    // One-entry memo per kind.  Consecutive elements are usually on
+    // the same layer.
+    mutable bool    haveLastGeometry, haveLastText;
+    mutable Ulong   lastGeometryLayer, lastGeometryDtype;
+    mutable Ulong   lastTextLayer, lastTextDtype;
+    mutable bool    lastGeometryResult, lastTextResult;
+
+public:
+                LayerFilter();
+
+    void        allow (Ulong layerLo, Ulong layerHi,
+                       Ulong dtypeLo = 0, Ulong dtypeHi = ULONG_MAX);
+    void        allowName (const string& layerName);
+    bool        addSpec (const string& spec);
+    void        bindLayerName (const string& layerName, bool isText,
+                               Ulong layerLo, Ulong layerHi,
+                               Ulong dtypeLo, Ulong dtypeHi);
+
+    bool        isActive() const {
+                    return (! rules.empty()  ||  ! names.empty());
+                }
+    bool        hasNames() const        { return (! names.empty()); }
+
+    bool        allowsGeometry (Ulong layer, Ulong datatype) const;
+    bool        allowsText (Ulong textlayer, Ulong texttype) const;
+
+private:
+    bool        matches (bool text, Ulong layer, Ulong datatype) const;
+    void        forget();
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_LAYER_FILTER_H_INCLUDED
@@ -1,6 +1,7 @@
 #include "layoutbuilder.h"
 #include <iostream>
 #include <iomanip>
+#include <cstring>
 
 
 namespace Oasis {
@@ -33,107 +34,25 @@ void JLayout::unpackRepetition(long x, long y, const Repetition* rep, std::vecto
         return;
     }
 
-    // 반복 타입에 따른 배치 좌표 처리
-    switch (rep->getType()) {
-    case Rep_Matrix: {
-        Ulong xdimen = rep->getMatrixXdimen();
-        Ulong ydimen = rep->getMatrixYdimen();
-        long  xspace = rep->getMatrixXspace();
-        long  yspace = rep->getMatrixYspace();
-
-        for (Ulong i = 0; i < xdimen; ++i) {
-            for (Ulong j = 0; j < ydimen; ++j) {
-                long newX = x + i * xspace;
-                long newY = y + j * yspace;
-                positions.push_back({newX, newY});
-            }
-        }
-        break;
-    }
-    case Rep_UniformX: {
-        Ulong dimen = rep->getDimen();
-        long xspace = rep->getUniformXspace();
-
-        for (Ulong i = 0; i < dimen; ++i) {
-            long newX = x + i * xspace;
-            positions.push_back({newX, y});
-        }
-        break;
-    }
-    case Rep_UniformY: {
-        Ulong dimen = rep->getDimen();
-        long yspace = rep->getUniformYspace();
-
-        for (Ulong i = 0; i < dimen; ++i) {
-            long newY = y + i * yspace;
-            positions.push_back({x, newY});
-        }
-        break;
-    }
-    case Rep_TiltedMatrix: {
-        Ulong ndimen = rep->getMatrixNdimen();
-        Ulong mdimen = rep->getMatrixMdimen();
-        Delta  ndisp = rep->getMatrixNdelta();
-        Delta  mdisp = rep->getMatrixMdelta();
-
-        for (Ulong i = 0; i < ndimen; ++i) {
-            for (Ulong j = 0; j < mdimen; ++j) {
-                long newX = x + i * ndisp.x + j * mdisp.x;
-                long newY = y + i * ndisp.y + j * mdisp.y;
-                positions.push_back({newX, newY});
-            }
-        }
-        break;
-    }
-    case Rep_Diagonal: {
-        Ulong dimen = rep->getDimen();
-        Delta delta = rep->getDiagonalDelta();
-
-        for (Ulong i = 0; i < dimen; ++i) {
-            long newX = x + i * delta.x;
-            long newY = y + i * delta.y;
-            positions.push_back({newX, newY});
-        }
-        break;
-    }
-    case Rep_Arbitrary:
-    case Rep_GridArbitrary: {
-        Ulong dimen = rep->getDimen();
-
-        for (Ulong i = 0; i < dimen; ++i) {
-            Delta delta = rep->getDelta(i);
-            long newX = x + delta.x;
-            long newY = y + delta.y;
-            positions.push_back({newX, newY});
-        }
-        break;
+    // 펼치는 순서는 RepetitionCache::ExpandOffsets()와 같음
+    std::vector<Delta> offsets;
+    RepetitionCache::ExpandOffsets(*rep, &offsets);
+    for (const auto& delta : offsets) {
+        positions.push_back({x + delta.x, y + delta.y});
     }
-    // Varying 및 GridVarying 처리
-    case Rep_VaryingX :
-    case Rep_GridVaryingX : {
-        Ulong dimen = rep->getDimen();
+}
 
-        for (Ulong i = 0; i < dimen; ++i){
-            long newX = x + rep->getVaryingXoffset(i);
-            positions.push_back({newX, y});
-        }
-        break;
-    }
-    case Rep_VaryingY :
-    case Rep_GridVaryingY : {
-        Ulong dimen = rep->getDimen();
+// repetition을 intern하고 cache에 memo된 offset을 참조 (도형마다 펼치지 않음)
+PositionSpan JLayout::repeatPositions(long x, long y, const Repetition* rep, RepetitionCache& repCache) {
+    PositionSpan span;
+    span.x = x;
+    span.y = y;
+    span.rep = repCache.intern(rep);
 
-        for (Ulong i = 0; i < dimen; ++i){
-            long newY = y + rep->getVaryingYoffset(i);
-            positions.push_back({x, newY});
-        }
-        break;
-    }
-    default:
-        // 기본 단일 배치
-        positions.push_back({x, y});
-        break;
-    }
+    const std::vector<Delta>& offsets = repCache.getOffsets(span.rep);
+    span.offsets = offsets.data();
+    span.count = offsets.size();
+    return span;
 }
 
 // JRectangle Implementation
@@ -157,7 +76,7 @@ void JRectangle::generateBinary(OasisBuilder& creator, Ulong layer, Ulong dataty
     }
 }
 
-std::vector<std::pair<long, long> > JRectangle::getRepeatedPositions() const
+PositionSpan JRectangle::getRepeatedPositions() const
 {
     return repeatedPositions;
 }
@@ -184,7 +103,7 @@ void JSquare::generateBinary(OasisBuilder& creator, Ulong layer, Ulong datatype)
     }
 }
 
-std::vector<std::pair<long, long> > JSquare::getRepeatedPositions() const
+PositionSpan JSquare::getRepeatedPositions() const
 {
     return repeatedPositions;
 }
@@ -213,12 +132,18 @@ BBox JPolygon::getBBox() const {
 
 
 void JPolygon::generateBinary(OasisBuilder& creator, Ulong layer, Ulong datatype) const {
+    PointList scratch;
+    generateBinary(creator, layer, datatype, scratch);
+}
+
+void JPolygon::generateBinary(OasisBuilder& creator, Ulong layer, Ulong datatype, PointList& scratch) const {
+    const PointList& ptlist = points.toPointList(scratch);
     for (const auto& pos : repeatedPositions) {
-        creator.beginPolygon(layer, datatype, pos.first, pos.second, points, nullptr);
+        creator.beginPolygon(layer, datatype, pos.first, pos.second, ptlist, nullptr);
     }
 }
 
-std::vector<std::pair<long, long> > JPolygon::getRepeatedPositions() const
+PositionSpan JPolygon::getRepeatedPositions() const
 {
     return repeatedPositions;
 }
@@ -240,12 +165,18 @@ BBox JPath::getBBox() const {
 }
 
 void JPath::generateBinary(OasisBuilder& creator, Ulong layer, Ulong datatype) const {
+    PointList scratch;
+    generateBinary(creator, layer, datatype, scratch);
+}
+
+void JPath::generateBinary(OasisBuilder& creator, Ulong layer, Ulong datatype, PointList& scratch) const {
+    const PointList& ptlist = points.toPointList(scratch);
     for (const auto& pos : repeatedPositions) {
-        creator.beginPath(layer, datatype, pos.first, pos.second, halfwidth, startExtn, endExtn, points, nullptr);
+        creator.beginPath(layer, datatype, pos.first, pos.second, halfwidth, startExtn, endExtn, ptlist, nullptr);
     }
 }
 
-std::vector<std::pair<long, long> > JPath::getRepeatedPositions() const
+PositionSpan JPath::getRepeatedPositions() const
 {
     return repeatedPositions;
 }
@@ -271,7 +202,7 @@ void JTrapezoid::generateBinary(OasisBuilder& creator, Ulong layer, Ulong dataty
     }
 }
 
-std::vector<std::pair<long, long> > JTrapezoid::getRepeatedPositions() const
+PositionSpan JTrapezoid::getRepeatedPositions() const
 {
     return repeatedPositions;
 }
@@ -294,7 +225,7 @@ void JCircle::generateBinary(OasisBuilder& creator, Ulong layer, Ulong datatype)
     }
 }
 
-std::vector<std::pair<long, long> > JCircle::getRepeatedPositions() const
+PositionSpan JCircle::getRepeatedPositions() const
 {
     return repeatedPositions;
 }
@@ -321,7 +252,7 @@ void JText::generateBinary(OasisBuilder& creator, Ulong layer, Ulong datatype) c
     }
 }
 
-std::vector<std::pair<long, long> > JText::getRepeatedPositions() const
+PositionSpan JText::getRepeatedPositions() const
 {
     return repeatedPositions;
 }
@@ -329,9 +260,8 @@ std::vector<std::pair<long, long> > JText::getRepeatedPositions() const
 
 // JPlacement Implementation
 
-JPlacement::JPlacement(CellName* cellName, long x, long y, const Oreal& mag, const Oreal& angle, bool flip, const Repetition* rep)
-    : cellName(cellName), x(x), y(y), mag(mag), angle(angle), flip(flip), rep(rep) {
-    JLayout::unpackRepetition(x, y, rep, repeatedPositions);
+JPlacement::JPlacement(CellName* cellName, long x, long y, const Oreal& mag, const Oreal& angle, bool flip, const PositionSpan& positions)
+    : cellName(cellName), x(x), y(y), mag(mag), angle(angle), flip(flip), repeatedPositions(positions) {
 }
 
 void JPlacement::generateBinary(OasisBuilder& creator) const {
@@ -340,7 +270,7 @@ void JPlacement::generateBinary(OasisBuilder& creator) const {
     }
 }
 
-std::vector<std::pair<long, long> > JPlacement::getRepeatedPositions() const
+PositionSpan JPlacement::getRepeatedPositions() const
 {
     return repeatedPositions;
 }
@@ -382,15 +312,31 @@ bool JPlacement::getFlip() const
 
 // JCell Implementation
 
-JCell::JCell(CellName* name)
-    : name(name) {}
+JCell::JCell(CellName* name, MonotonicArena* parserArena)
+    : name(name), arena(parserArena) {
+    // 파서가 arena를 주지 않으면 셀이 직접 소유
+    if (!arena) {
+        ownArena.reset(new MonotonicArena);
+        arena = ownArena.get();
+    }
+}
+
+void JCell::adoptArena(std::unique_ptr<MonotonicArena> parserArena) {
+    if (parserArena.get() == arena && !ownArena) {
+        ownArena = std::move(parserArena);
+    }
+}
+
+void JCell::addShape(const Layer& layerKey, JShape* shape) {
+    shapesByLayer[layerKey].push_back(shape);
+}
 
-void JCell::addShape(const Layer& layerKey, std::unique_ptr<JShape> shape) {
-    shapesByLayer[layerKey].push_back(std::move(shape));
+std::vector<JShape*>& JCell::getShapeList(const Layer& layerKey) {
+    return shapesByLayer[layerKey];
 }
 
-void JCell::addPlacement(std::unique_ptr<JPlacement> placement) {
-    placements.push_back(std::move(placement));
+void JCell::addPlacement(JPlacement* placement) {
+    placements.push_back(placement);
 }
 
 void JCell::addParent(JCell* parent) {
@@ -412,6 +358,9 @@ void JCell::generateBinary(OasisBuilder& creator) const {
         placement->generateBinary(creator);
     }
 
+    // Polygon/Path 출력 시 PointList 복원에 재사용
+    PointList scratch;
+
     // Generate shapes and print BBox information
     for (const auto& pair : shapesByLayer) {
         Ulong layer     = pair.first.layer;
@@ -421,25 +370,25 @@ void JCell::generateBinary(OasisBuilder& creator) const {
 
             switch (shape->getShapeType()) {
             case JLayout::Rectangle:
-                static_cast<JRectangle*>(shape.get())->generateBinary(creator, layer, datatype);
+                static_cast<JRectangle*>(shape)->generateBinary(creator, layer, datatype);
                 break;
             case JLayout::Square:
-                static_cast<JSquare*>(shape.get())->generateBinary(creator, layer, datatype);
+                static_cast<JSquare*>(shape)->generateBinary(creator, layer, datatype);
                 break;
             case JLayout::Polygon:
-                static_cast<JPolygon*>(shape.get())->generateBinary(creator, layer, datatype);
+                static_cast<JPolygon*>(shape)->generateBinary(creator, layer, datatype, scratch);
                 break;
             case JLayout::Path:
-                static_cast<JPath*>(shape.get())->generateBinary(creator, layer, datatype);
+                static_cast<JPath*>(shape)->generateBinary(creator, layer, datatype, scratch);
                 break;
             case JLayout::Trapezoid:
-                static_cast<JTrapezoid*>(shape.get())->generateBinary(creator, layer, datatype);
+                static_cast<JTrapezoid*>(shape)->generateBinary(creator, layer, datatype);
                 break;
             case JLayout::Circle:
-                static_cast<JCircle*>(shape.get())->generateBinary(creator, layer, datatype);
+                static_cast<JCircle*>(shape)->generateBinary(creator, layer, datatype);
                 break;
             case JLayout::Text:
-                static_cast<JText*>(shape.get())->generateBinary(creator, layer, datatype);
+                static_cast<JText*>(shape)->generateBinary(creator, layer, datatype);
                 break;
             default:
                 throw std::runtime_error("Unknown shape type");
@@ -449,13 +398,17 @@ void JCell::generateBinary(OasisBuilder& creator) const {
 }
 
 
-const std::vector<std::unique_ptr<JPlacement>>& JCell::getPlacements() const {
+const std::vector<JPlacement*>& JCell::getPlacements() const {
     return placements;
 }
 
 // JLayoutBuilder Implementation
 JLayoutBuilder::JLayoutBuilder(OasisBuilder& creator)
-    : creator(creator) {}
+    : creator(creator), repCache(std::make_shared<RepetitionCache>()) {}
+
+void JLayoutBuilder::setRepetitionCache(std::shared_ptr<RepetitionCache> cache) {
+    repCache = std::move(cache);
+}
 
 void JLayoutBuilder::beginFile(const std::string& version, const Oreal& unit, Validation::Scheme valScheme) {
     fileVersion = version;
@@ -466,14 +419,32 @@ void JLayoutBuilder::beginFile(const std::string& version, const Oreal& unit, Va
 }
 
 void JLayoutBuilder::beginCell(CellName* cellName) {
-    currentCell = new JCell(cellName);
+    currentCell = new JCell(cellName, parserArena);
     cells[cellName->getName()] = std::unique_ptr<JCell>(currentCell);
+    if (parserArena) {
+        arenaCell = currentCell;
+    }
 }
 
 void JLayoutBuilder::endCell() {
     currentCell = nullptr;
 }
 
+// 파서의 셀 arena: 셀 데이터를 여기에 할당
+void JLayoutBuilder::beginCellArena(MonotonicArena* arena) {
+    parserArena = arena;
+    arenaCell = nullptr;
+}
+
+// 셀 데이터는 endFile()까지 필요하므로 arena를 셀이 인수 (복사 없음)
+void JLayoutBuilder::endCellArena(std::unique_ptr<MonotonicArena>& arena) {
+    if (arenaCell) {
+        arenaCell->adoptArena(std::move(arena));
+    }
+    parserArena = nullptr;
+    arenaCell = nullptr;
+}
+
 void JLayoutBuilder::endFile()
 {
     generateBinary();
@@ -483,17 +454,88 @@ void JLayoutBuilder::endFile()
 void JLayoutBuilder::beginRectangle(Ulong layer, Ulong datatype, long x, long y, long width, long height, const Repetition* rep) {
     if (currentCell) {
         Layer layerKey{layer, datatype};
+        MonotonicArena& arena = currentCell->getArena();
+        PositionSpan positions = JLayout::repeatPositions(x, y, rep, *repCache);
         if (width == height){
-            currentCell->addShape(layerKey, std::unique_ptr<JShape>(new JSquare(x, y, width, rep)));
+            currentCell->addShape(layerKey, arena.create<JSquare>(x, y, width, positions));
+        }
+        currentCell->addShape(layerKey, arena.create<JRectangle>(x, y, width, height, positions));
+    }
+}
+
+// [ELEMENT_BATCH] layer 목록 검색은 묶음마다 한 번
+void JLayoutBuilder::beginRectangles(Ulong layer, Ulong datatype, const RectSpan& rects) {
+    if (!currentCell) {
+        return;
+    }
+    Layer layerKey{layer, datatype};
+    MonotonicArena& arena = currentCell->getArena();
+    std::vector<JShape*>& shapes = currentCell->getShapeList(layerKey);
+    shapes.reserve(shapes.size() + rects.size());
+    for (const RectElem& r : rects) {
+        PositionSpan positions = JLayout::repeatPositions(r.x, r.y, r.rep, *repCache);
+        // beginRectangle()과 같은 도형을 만든다.
+        if (r.width == r.height) {
+            shapes.push_back(arena.create<JSquare>(r.x, r.y, r.width, positions));
         }
-        currentCell->addShape(layerKey, std::unique_ptr<JShape>(new JRectangle(x, y, width, height, rep)));
+        shapes.push_back(arena.create<JRectangle>(r.x, r.y, r.width, r.height, positions));
     }
 }
 
 void JLayoutBuilder::beginPolygon(Ulong layer, Ulong datatype, long x, long y, const PointList& points, const Repetition* rep) {
     if (currentCell) {
         Layer layerKey{layer, datatype};
-        currentCell->addShape(layerKey, std::unique_ptr<JShape>(new JPolygon(x, y, points, rep)));
+        MonotonicArena& arena = currentCell->getArena();
+        currentCell->addShape(layerKey, arena.create<JPolygon>(x, y, points, JLayout::repeatPositions(x, y, rep, *repCache), arena));
+    }
+}
+
+// [POINT_STREAM] PointList를 거치지 않고 arena 배열에 vertex를 받는다
+void JLayoutBuilder::beginPolygonStream(Ulong layer, Ulong datatype, long x, long y, Ulong numPoints, const Repetition* rep) {
+    streamDest = nullptr;
+    streamLeft = numPoints;
+    if (currentCell) {
+        Layer layerKey{layer, datatype};
+        MonotonicArena& arena = currentCell->getArena();
+        streamDest = arena.allocArray<Delta>(numPoints);
+        PointSpan points(streamDest, numPoints);
+        currentCell->addShape(layerKey, arena.create<JPolygon>(x, y, points, JLayout::repeatPositions(x, y, rep, *repCache)));
+    }
+}
+
+void JLayoutBuilder::beginPathStream(Ulong layer, Ulong datatype, long x, long y, long halfwidth, long startExtn, long endExtn, Ulong numPoints, const Repetition* rep) {
+    streamDest = nullptr;
+    streamLeft = numPoints;
+    if (currentCell) {
+        Layer layerKey{layer, datatype};
+        MonotonicArena& arena = currentCell->getArena();
+        streamDest = arena.allocArray<Delta>(numPoints);
+        PointSpan points(streamDest, numPoints);
+        currentCell->addShape(layerKey, arena.create<JPath>(x, y, halfwidth, startExtn, endExtn, points, JLayout::repeatPositions(x, y, rep, *repCache)));
+    }
+}
+
+void JLayoutBuilder::addPoints(const DeltaSpan& points) {
+    // 선언한 numPoints를 넘으면 arena 배열 밖에 쓰게 되므로 오류
+    size_t n = points.size();
+    if (n > streamLeft) {
+        streamLeft = 0;
+        throw std::runtime_error("point stream has more vertices than "
+                                 "declared");
+    }
+    if (streamDest) {
+        memcpy(streamDest, points.begin(), n * sizeof(Delta));
+        streamDest += n;
+    }
+    streamLeft -= n;
+}
+
+// [POINT_STREAM] 스트림이 numPoints보다 짧으면 배열 끝이 초기화되지 않은 채 남는다
+void JLayoutBuilder::endElement() {
+    if (streamLeft != 0) {
+        streamLeft = 0;
+        throw std::runtime_error("point stream has fewer vertices than "
+                                 "declared");
     }
 }
 
@@ -502,36 +544,40 @@ void JLayoutBuilder::beginPlacement(CellName* cellName, long x, long y, const Or
         return;
     }
 
-    std::unique_ptr<JPlacement> placement(new JPlacement(cellName, x, y, mag, angle, flip, rep));
-    currentCell->addPlacement(std::move(placement));
+    MonotonicArena& arena = currentCell->getArena();
+    currentCell->addPlacement(arena.create<JPlacement>(cellName, x, y, mag, angle, flip, JLayout::repeatPositions(x, y, rep, *repCache)));
     updateCellHierarchy(currentCell->getName(), cellName);
 }
 
 void JLayoutBuilder::beginText(Ulong textlayer, Ulong texttype, long x, long y, TextString* text, const Repetition* rep) {
     if (currentCell) {
         Layer layerKey{textlayer, texttype};
-        currentCell->addShape(layerKey, std::make_unique<JText>(x, y, text, rep));
+        MonotonicArena& arena = currentCell->getArena();
+        currentCell->addShape(layerKey, arena.create<JText>(x, y, text, JLayout::repeatPositions(x, y, rep, *repCache)));
     }
 }
 
 void JLayoutBuilder::beginPath(Ulong layer, Ulong datatype, long x, long y, long halfwidth, long startExtn, long endExtn, const PointList& points, const Repetition* rep) {
     if (currentCell) {
         Layer layerKey{layer, datatype};
-        currentCell->addShape(layerKey, std::make_unique<JPath>(x, y, halfwidth, startExtn, endExtn, points, rep));
+        MonotonicArena& arena = currentCell->getArena();
+        currentCell->addShape(layerKey, arena.create<JPath>(x, y, halfwidth, startExtn, endExtn, points, JLayout::repeatPositions(x, y, rep, *repCache), arena));
     }
 }
 
 void JLayoutBuilder::beginTrapezoid(Ulong layer, Ulong datatype, long x, long y, const Oasis::Trapezoid& trap, const Repetition* rep) {
     if (currentCell) {
         Layer layerKey{layer, datatype};
-        currentCell->addShape(layerKey, std::make_unique<JTrapezoid>(x, y, trap, rep));
+        MonotonicArena& arena = currentCell->getArena();
+        currentCell->addShape(layerKey, arena.create<JTrapezoid>(x, y, trap, JLayout::repeatPositions(x, y, rep, *repCache)));
     }
 }
 
 void JLayoutBuilder::beginCircle(Ulong layer, Ulong datatype, long x, long y, long radius, const Repetition* rep) {
     if (currentCell) {
         Layer layerKey{layer, datatype};
-        currentCell->addShape(layerKey, std::make_unique<JCircle>(x, y, radius, rep));
+        MonotonicArena& arena = currentCell->getArena();
+        currentCell->addShape(layerKey, arena.create<JCircle>(x, y, radius, JLayout::repeatPositions(x, y, rep, *repCache)));
     }
 }
 
@@ -608,7 +654,7 @@ JLayout::BBox JLayoutBuilder::calculateCellBBox(const JCell* cell, std::unordere
     for (const auto& layerShapes : cell->getShapesByLayer()) {
         for (const auto& shape : layerShapes.second) {
             JLayout::BBox shapeBBox = shape->getBBox();  // 각 도형의 BBox
-            std::vector<std::pair<long, long>> repeatedPositions = shape->getRepeatedPositions();
+            JLayout::PositionSpan repeatedPositions = shape->getRepeatedPositions();
 
             if (repeatedPositions.size() > 1) { // 다수의 위치 처리
                 for (const auto& pos : repeatedPositions) {
@@ -638,7 +684,7 @@ JLayout::BBox JLayoutBuilder::calculateCellBBox(const JCell* cell, std::unordere
             bool flip = placement->getFlip();
 
             // 반복된 위치들에 대해 BBox 계산
-            std::vector<std::pair<long, long>> repeatedPositions = placement->getRepeatedPositions();
+            JLayout::PositionSpan repeatedPositions = placement->getRepeatedPositions();
 
             for (const auto& pos : repeatedPositions) {
                 // 반복된 위치마다 변환을 적용하고 BBox 계산
@@ -9,11 +9,16 @@
 #include "port/hash-table.h"
 #include "misc/utils.h"
 #include "builder.h"
+#include "batch-builder.h"
+#include "stream-builder.h"
 #include "modal-vars.h"
 #include "names.h"
 #include "oasis.h"
 #include "rectypes.h"
 #include "writer.h"
+#include "arena.h"
+#include "parser.h"
+#include "rep-intern.h"
 
 #include <math.h> // 각도 변환을 위해 필요
 
@@ -121,9 +126,65 @@ public:
 };
 
 
+/** [REP_INTERN]
+ *  UPDATE
+ *   - PositionSpan: 기준 위치 (x, y)와 RepetitionCache에 memo된 offset 배열.
+ *     같은 repetition을 쓰는 도형들이 offset 배열을 공유하고, 절대 위치는
+ *     순회할 때 계산한다.  rep는 intern된 포인터 (없으면 nullptr).
+ */
+struct PositionSpan {
+    long x = 0, y = 0;
+    const Repetition* rep = nullptr;
+    const Delta* offsets = nullptr;
+    size_t count = 0;
+
+    class const_iterator {
+    public:
+        const_iterator(const Delta* p, long x, long y) : p(p), x(x), y(y) {}
+        std::pair<long, long> operator*() const { return {x + p->x, y + p->y}; }
+        const_iterator& operator++() { ++p; return *this; }
+        bool operator!=(const const_iterator& other) const { return p != other.p; }
+    private:
+        const Delta* p;
+        long x, y;
+    };
+
+    const_iterator begin() const { return const_iterator(offsets, x, y); }
+    const_iterator end() const { return const_iterator(offsets + count, x, y); }
+    size_t size() const { return count; }
+};
+
+// PointSpan: 셀 arena에 복사된 point list (소유권 없음)
+struct PointSpan {
+    const Delta* data = nullptr;
+    size_t count = 0;
+
+    PointSpan() = default;
+    PointSpan(const PointList& points, MonotonicArena& arena)
+        : data(arena.copyArray(points.data(), points.size())), count(points.size()) {}
+    // [POINT_STREAM] 이미 arena에 있는 배열 (addPoints()로 채워짐)
+    PointSpan(const Delta* data, size_t count) : data(data), count(count) {}
+
+    const Delta* begin() const { return data; }
+    const Delta* end() const { return data + count; }
+    size_t size() const { return count; }
+
+    // 출력 시 creator에 넘길 PointList로 복원 (scratch를 재사용하여 malloc 회피)
+    const PointList& toPointList(PointList& scratch) const {
+        scratch.assign(begin(), end());
+        return scratch;
+    }
+};
+
 // Repetition 처리 함수
 void unpackRepetition(long x, long y, const Repetition* rep, std::vector<std::pair<long, long>>& positions);
 
+/** [REP_INTERN]
+ *  ADD
+ *   - repetition을 intern하고 memo된 offset으로 PositionSpan 생성
+ */
+PositionSpan repeatPositions(long x, long y, const Repetition* rep, RepetitionCache& repCache);
+
 }  // namespace JLayout
 
 
@@ -135,7 +196,7 @@ class JShape {
 public:
     virtual JLayout::BBox getBBox() const = 0;
     virtual void generateBinary(OasisBuilder& builder, Ulong layer, Ulong datatype) const = 0;
-    virtual std::vector<std::pair<long, long>> getRepeatedPositions() const = 0;
+    virtual JLayout::PositionSpan getRepeatedPositions() const = 0;
     virtual ~JShape() = default;
 
     JLayout::Type getShapeType() const { return shapeType; }
@@ -148,149 +209,133 @@ protected:
 
 class JRectangle : public JShape {
 public:
-    JRectangle(long x, long y, long width, long height, const Repetition* rep)
-        : JShape(JLayout::Rectangle), x(x), y(y), width(width), height(height), rep(rep) {
-        // Repetition 처리하여 repeatedPositions에 저장
-        JLayout::unpackRepetition(x, y, rep, repeatedPositions);
-    }
+    JRectangle(long x, long y, long width, long height, const JLayout::PositionSpan& positions)
+        : JShape(JLayout::Rectangle), x(x), y(y), width(width), height(height), repeatedPositions(positions) {}
 
     JLayout::BBox getBBox() const override;
     void generateBinary(OasisBuilder& builder, Ulong layer, Ulong datatype) const override;
 
-    std::vector<std::pair<long, long> > getRepeatedPositions() const override;
+    JLayout::PositionSpan getRepeatedPositions() const override;
 
 private:
     long x, y, width, height;
-    const Repetition* rep;
-    std::vector<std::pair<long, long>> repeatedPositions;  // 반복된 위치들
+    JLayout::PositionSpan repeatedPositions;  // 반복된 위치들 (offset은 RepetitionCache 소유)
 };
 
 class JSquare : public JShape {
 public:
-    JSquare(long x, long y, long width, const Repetition* rep)
-        : JShape(JLayout::Square), x(x), y(y), width(width), rep(rep) {
-        JLayout::unpackRepetition(x, y, rep, repeatedPositions);
-    }
+    JSquare(long x, long y, long width, const JLayout::PositionSpan& positions)
+        : JShape(JLayout::Square), x(x), y(y), width(width), repeatedPositions(positions) {}
 
     JLayout::BBox getBBox() const override;
     void generateBinary(OasisBuilder& builder, Ulong layer, Ulong datatype) const override;
 
-    std::vector<std::pair<long, long> > getRepeatedPositions() const override;
+    JLayout::PositionSpan getRepeatedPositions() const override;
 
 private:
     long x, y, width;
-    const Repetition* rep;
-    std::vector<std::pair<long, long>> repeatedPositions;  // 반복된 위치들
+    JLayout::PositionSpan repeatedPositions;  // 반복된 위치들 (offset은 RepetitionCache 소유)
 };
 
 class JPolygon : public JShape {
 public:
-    JPolygon(long x, long y, const PointList& points, const Repetition* rep)
-        : JShape(JLayout::Polygon), x(x), y(y), points(points), rep(rep) {
-        JLayout::unpackRepetition(x, y, rep, repeatedPositions);
-    }
+    JPolygon(long x, long y, const PointList& points, const JLayout::PositionSpan& positions, MonotonicArena& arena)
+        : JShape(JLayout::Polygon), x(x), y(y), points(points, arena), repeatedPositions(positions) {}
+    JPolygon(long x, long y, const JLayout::PointSpan& points, const JLayout::PositionSpan& positions)
+        : JShape(JLayout::Polygon), x(x), y(y), points(points), repeatedPositions(positions) {}
 
     JLayout::BBox getBBox() const override;
     void generateBinary(OasisBuilder& builder, Ulong layer, Ulong datatype) const override;
+    void generateBinary(OasisBuilder& builder, Ulong layer, Ulong datatype, PointList& scratch) const;
 
-    std::vector<std::pair<long, long> > getRepeatedPositions() const override;
+    JLayout::PositionSpan getRepeatedPositions() const override;
 
 private:
     long x, y;
-    PointList points;
-    const Repetition* rep;
-    std::vector<std::pair<long, long>> repeatedPositions;  // 반복된 위치들
+    JLayout::PointSpan points;  // 셀 arena에 복사된 point list
+    JLayout::PositionSpan repeatedPositions;  // 반복된 위치들 (offset은 RepetitionCache 소유)
 };
 
 // Path 도형 정의
 class JPath : public JShape {
 public:
-    JPath(long x, long y, long halfwidth, long startExtn, long endExtn, const PointList& points, const Repetition* rep)
-        : JShape(JLayout::Path), x(x), y(y), halfwidth(halfwidth), startExtn(startExtn), endExtn(endExtn), points(points), rep(rep) {
-        JLayout::unpackRepetition(x, y, rep, repeatedPositions);
-    }
+    JPath(long x, long y, long halfwidth, long startExtn, long endExtn, const PointList& points, const JLayout::PositionSpan& positions, MonotonicArena& arena)
+        : JShape(JLayout::Path), x(x), y(y), halfwidth(halfwidth), startExtn(startExtn), endExtn(endExtn), points(points, arena), repeatedPositions(positions) {}
+    JPath(long x, long y, long halfwidth, long startExtn, long endExtn, const JLayout::PointSpan& points, const JLayout::PositionSpan& positions)
+        : JShape(JLayout::Path), x(x), y(y), halfwidth(halfwidth), startExtn(startExtn), endExtn(endExtn), points(points), repeatedPositions(positions) {}
 
     JLayout::BBox getBBox() const override;
     void generateBinary(OasisBuilder& builder, Ulong layer, Ulong datatype) const override;
+    void generateBinary(OasisBuilder& builder, Ulong layer, Ulong datatype, PointList& scratch) const;
 
-    std::vector<std::pair<long, long> > getRepeatedPositions() const override;
+    JLayout::PositionSpan getRepeatedPositions() const override;
 
 private:
     long x, y;
     long halfwidth, startExtn, endExtn;
-    PointList points;
-    const Repetition* rep;
-    std::vector<std::pair<long, long>> repeatedPositions;  // 반복된 위치들
+    JLayout::PointSpan points;  // 셀 arena에 복사된 point list
+    JLayout::PositionSpan repeatedPositions;  // 반복된 위치들 (offset은 RepetitionCache 소유)
 };
 
 // Trapezoid 도형 정의
 class JTrapezoid : public JShape {
 public:
     // 트랩레조이드의 좌표와 기하학적 속성을 멤버로 정의
-    JTrapezoid(long x, long y, const class Trapezoid& trapezoid, const Repetition* rep)
-        : JShape(JLayout::Trapezoid), x(x), y(y), trapezoid(trapezoid), rep(rep) {
-        JLayout::unpackRepetition(x, y, rep, repeatedPositions);
-    }
+    JTrapezoid(long x, long y, const class Trapezoid& trapezoid, const JLayout::PositionSpan& positions)
+        : JShape(JLayout::Trapezoid), x(x), y(y), trapezoid(trapezoid), repeatedPositions(positions) {}
 
     JLayout::BBox getBBox() const override;
     void generateBinary(OasisBuilder& builder, Ulong layer, Ulong datatype) const override;
 
-    std::vector<std::pair<long, long> > getRepeatedPositions() const override;
+    JLayout::PositionSpan getRepeatedPositions() const override;
 
 private:
     long x, y;
     class Trapezoid trapezoid;  // Trapezoid는 구조체로 정의된 도형의 속성 (예: 두 변의 길이, 높이)
-    const Repetition* rep;
-    std::vector<std::pair<long, long>> repeatedPositions;  // 반복된 위치들
+    JLayout::PositionSpan repeatedPositions;  // 반복된 위치들 (offset은 RepetitionCache 소유)
 };
 
 
 // Circle 도형 정의
 class JCircle : public JShape {
 public:
-    JCircle(long x, long y, long radius, const Repetition* rep)
-        : JShape(JLayout::Circle), x(x), y(y), radius(radius), rep(rep) {
-        JLayout::unpackRepetition(x, y, rep, repeatedPositions);
-    }
+    JCircle(long x, long y, long radius, const JLayout::PositionSpan& positions)
+        : JShape(JLayout::Circle), x(x), y(y), radius(radius), repeatedPositions(positions) {}
 
     JLayout::BBox getBBox() const override;
     void generateBinary(OasisBuilder& builder, Ulong layer, Ulong datatype) const override;
 
-    std::vector<std::pair<long, long> > getRepeatedPositions() const override;
+    JLayout::PositionSpan getRepeatedPositions() const override;
 
 private:
     long x, y, radius;
-    const Repetition* rep;
-    std::vector<std::pair<long, long>> repeatedPositions;  // 반복된 위치들
+    JLayout::PositionSpan repeatedPositions;  // 반복된 위치들 (offset은 RepetitionCache 소유)
 };
 
 // Text 도형 정의
 class JText : public JShape {
 public:
-    JText(long x, long y, TextString* text, const Repetition* rep)
-        : JShape(JLayout::Text), x(x), y(y), text(text), rep(rep) {
-        JLayout::unpackRepetition(x, y, rep, repeatedPositions);
-    }
+    JText(long x, long y, TextString* text, const JLayout::PositionSpan& positions)
+        : JShape(JLayout::Text), x(x), y(y), text(text), repeatedPositions(positions) {}
 
     JLayout::BBox getBBox() const override;
     void generateBinary(OasisBuilder& builder, Ulong layer, Ulong datatype) const override;
 
-    std::vector<std::pair<long, long> > getRepeatedPositions() const override;
+    JLayout::PositionSpan getRepeatedPositions() const override;
 
 private:
     long x, y;
     TextString* text;
-    const Repetition* rep;
-    std::vector<std::pair<long, long>> repeatedPositions;  // 반복된 위치들
+    JLayout::PositionSpan repeatedPositions;  // 반복된 위치들 (offset은 RepetitionCache 소유)
 };
 
 // Placement 정의
 class JPlacement {
 public:
-    JPlacement(CellName* cellName, long x, long y, const Oreal& mag, const Oreal& angle, bool flip, const Repetition* rep);
+    JPlacement(CellName* cellName, long x, long y, const Oreal& mag, const Oreal& angle, bool flip, const JLayout::PositionSpan& positions);
     void generateBinary(OasisBuilder& builder) const;
 
-    std::vector<std::pair<long, long>> getRepeatedPositions() const;
+    JLayout::PositionSpan getRepeatedPositions() const;
 
     CellName* getName() const;
 
@@ -305,19 +350,35 @@ private:
     long x, y;
     Oreal mag, angle;
     bool flip;
-    const Repetition* rep;
-    std::vector<std::pair<long, long>> repeatedPositions;  // 반복된 위치 저장
+    JLayout::PositionSpan repeatedPositions;  // 반복된 위치 (offset은 RepetitionCache 소유)
 };
 
 
 
 // Cell 정의
+/** [CELL_ARENA]
+ *  UPDATE
+ *   - 도형과 placement는 셀의 arena에 생성되고 arena가 소멸될 때 함께 소멸됨.
+ *     arena는 파서가 넘겨준 것(adoptArena로 인수)이거나, 파서가 arena를
+ *     주지 않는 경우(parseFile) 셀이 직접 만든 것.
+ */
 class JCell {
 public:
-    explicit JCell(CellName* name);
-
-    void addShape(const JLayout::Layer& layerKey, std::unique_ptr<JShape> shape);
-    void addPlacement(std::unique_ptr<JPlacement> placement);
+    explicit JCell(CellName* name, MonotonicArena* parserArena = nullptr);
+
+    // 셀 데이터를 할당할 arena
+    MonotonicArena& getArena() { return *arena; }
+    // 파서의 셀 arena를 인수하여 endCell 이후에도 데이터를 유지
+    void adoptArena(std::unique_ptr<MonotonicArena> parserArena);
+
+    void addShape(const JLayout::Layer& layerKey, JShape* shape);
+    /** [ELEMENT_BATCH]
+     *  ADD
+     *   - layer의 도형 목록.  같은 layer의 도형을 여러 개 추가할 때
+     *     shapesByLayer 검색을 한 번만 하기 위해 사용.
+     */
+    std::vector<JShape*>& getShapeList(const JLayout::Layer& layerKey);
+    void addPlacement(JPlacement* placement);
     void addParent(JCell* parent);
     void addChild(JCell* child);
     CellName* getName() const;
@@ -326,11 +387,11 @@ public:
     JCell* parent = nullptr;
 
     // shapesByLayer의 getter 함수 (const 참조로 반환)
-    const std::unordered_map<JLayout::Layer, std::vector<std::unique_ptr<JShape>>, JLayout::Layer::HashFunction>& getShapesByLayer() const {
+    const std::unordered_map<JLayout::Layer, std::vector<JShape*>, JLayout::Layer::HashFunction>& getShapesByLayer() const {
         return shapesByLayer;
     }
     // placements 벡터에 대한 const 참조 반환
-    const std::vector<std::unique_ptr<JPlacement>>& getPlacements() const;
+    const std::vector<JPlacement*>& getPlacements() const;
 
 
     // BBox 캐시를 설정하는 함수
@@ -345,8 +406,10 @@ public:
 
 private:
     CellName* name;
-    std::unordered_map<JLayout::Layer, std::vector<std::unique_ptr<JShape>>, JLayout::Layer::HashFunction> shapesByLayer;
-    std::vector<std::unique_ptr<JPlacement>> placements;
+    std::unique_ptr<MonotonicArena> ownArena;  // 셀이 소유한 arena (파서 arena를 인수한 경우 포함)
+    MonotonicArena* arena;                     // 현재 할당에 사용하는 arena
+    std::unordered_map<JLayout::Layer, std::vector<JShape*>, JLayout::Layer::HashFunction> shapesByLayer;  // arena 소유
+    std::vector<JPlacement*> placements;       // arena 소유
     std::unordered_set<JCell*> children;
 
     // BBox 캐시 변수
@@ -355,7 +418,7 @@ private:
 
 
 // LayoutBuilder 정의
-class JLayoutBuilder : public OasisBuilder {
+class JLayoutBuilder : public OasisBatchBuilder, public OasisArenaBuilder, public OasisPointStreamBuilder {
 public:
     explicit JLayoutBuilder(OasisBuilder& builder);
 
@@ -366,6 +429,11 @@ public:
 
     void beginPlacement(CellName* cellName, long x, long y, const Oreal& mag, const Oreal& angle, bool flip, const Repetition* rep) override;
     void beginRectangle(Ulong layer, Ulong datatype, long x, long y, long width, long height, const Repetition* rep) override;
+    /** [ELEMENT_BATCH]
+     *  ADD
+     *   - 같은 layer/datatype의 rectangle 묶음.  beginRectangle()을 반복한 것과 같다.
+     */
+    void beginRectangles(Ulong layer, Ulong datatype, const RectSpan& rects) override;
     void beginPolygon(Ulong layer, Ulong datatype, long x, long y, const PointList& points, const Repetition* rep) override;
     void beginText(Ulong textlayer, Ulong texttype, long x, long y, TextString* text, const Repetition* rep) override;
     void beginPath(Ulong layer, Ulong datatype, long x, long y, long halfwidth, long startExtn, long endExtn, const PointList& points, const Repetition* rep) override;
@@ -393,6 +461,14 @@ public:
     // 레이아웃 정보를 터미널 출력하는 함수
     void printLayoutInfo() const;
 
+    /** [REP_INTERN]
+     *  ADD
+     *   - 파서의 RepetitionCache를 공유 (OasisParser::getRepetitionCache()).
+     *     공유하면 파서가 intern한 포인터를 해시 없이 찾는다.
+     *     공유하지 않으면 builder 자신의 cache에 내용 해시로 intern한다.
+     */
+    void setRepetitionCache(std::shared_ptr<RepetitionCache> cache);
+
 private:
     OasisBuilder& creator;
     std::string fileVersion;
@@ -402,6 +478,44 @@ private:
     std::unordered_map<std::string, std::unique_ptr<JCell>> cells;
     JCell* currentCell = nullptr;
 
+    /** [CELL_ARENA]
+     *  ADD
+     *   - parserArena : beginCellArena()로 받은 파서의 셀 arena
+     *   - arenaCell   : parserArena에 데이터를 할당한 셀 (endCellArena에서 인수)
+     */
+    MonotonicArena* parserArena = nullptr;
+    JCell* arenaCell = nullptr;
+
+    // [REP_INTERN] 도형/placement의 repetition을 intern하고 offset을 memo
+    std::shared_ptr<RepetitionCache> repCache;
+
+    /** [POINT_STREAM]
+     *  ADD
+     *   - streamDest : 스트리밍 중인 polygon/path의 arena 배열에서 다음에 채울 위치
+     *   - streamLeft : 아직 받지 않은 vertex 수.  셀 밖이라 저장하지 않을
+     *     때도 세며, endElement()에서 0이 아니면 오류.
+     */
+    Delta* streamDest = nullptr;
+    size_t streamLeft = 0;
+
+    // OasisArenaBuilder interface
+public:
+    void beginCellArena(MonotonicArena* arena) override;
+    void endCellArena(std::unique_ptr<MonotonicArena>& arena) override;
+
+    /** [POINT_STREAM]
+     *  ADD
+     *   - 큰 point list를 PointList 없이 셀 arena에 바로 받는다.
+     *     begin*Stream()에서 numPoints 크기의 배열을 잡고 도형을 만들며,
+     *     addPoints()는 그 배열을 순서대로 채운다.
+     */
+    // OasisPointStreamBuilder interface
+public:
+    void beginPolygonStream(Ulong layer, Ulong datatype, long x, long y, Ulong numPoints, const Repetition* rep) override;
+    void beginPathStream(Ulong layer, Ulong datatype, long x, long y, long halfwidth, long startExtn, long endExtn, Ulong numPoints, const Repetition* rep) override;
+    void addPoints(const DeltaSpan& points) override;
+    void endElement() override;
+
     // OasisBuilder interface
 public:
 
@@ -0,0 +1,132 @@
+// oasis/mapped-file.cc -- read-only memory mapping of an OASIS file
+//
+// last modified:   2026/10/17
+
+// Ask for 64-bit off_t on 32-bit hosts so that fstat() reports the
+// size of files larger than 2 GB.  This must precede every #include.
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped-file.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::runtime_error;
+
+
+MappedFile::MappedFile (const char* fname)
+  : filename(fname)
+{
+    base = Null;
+    fileSize = 0;
+
+    if ((fd = open(fname, O_RDONLY)) < 0)
+        throw runtime_error("cannot open file '" + filename + "': "
+                            + strerror(errno));
+
+    struct stat  st;
+    if (fstat(fd, &st) < 0) {
+        int  err = errno;
+        close(fd);
+        throw runtime_error("cannot stat file '" + filename + "': "
+                            + strerror(err));
+    }
+    fileSize = st.st_size;
+
+    // A 32-bit process cannot map a file of 4 GB or more in one piece.
+    // Refuse rather than silently map a truncated prefix.
+
+    if (fileSize > std::numeric_limits<size_t>::max()) {
+        close(fd);
+        throw runtime_error("file '" + filename + "' is too large to map"
+                            " on this host; parse it without mapped input");
+    }
+
+    // mmap() rejects zero-length mappings.  An empty file is not a
+    // valid OASIS file, but let verifyMagic() report that.
+
+    if (fileSize == 0)
+        return;
+
+    void*  addr = mmap(Null, static_cast<size_t>(fileSize), PROT_READ,
+                       MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        int  err = errno;
+        close(fd);
+        throw runtime_error("cannot map file '" + filename + "': "
+                            + strerror(err));
+    }
+    base = static_cast<const Uchar*>(addr);
+}
+
+
+MappedFile::~MappedFile()
+{
+    if (base != Null)
+        munmap(const_cast<Uchar*>(base), static_cast<size_t>(fileSize));
+    close(fd);
+}
+
+
+void
+MappedFile::advise (Access access)
+{
+    int  advice;
+    switch (access) {
+        case Sequential:  advice = MADV_SEQUENTIAL;  break;
+        case Random:      advice = MADV_RANDOM;      break;
+        default:          advice = MADV_NORMAL;      break;
+    }
+    adviseRange(0, fileSize, advice);
+}
+
+
+void
+MappedFile::willNeed (Ullong offset, Ullong length)
+{
+    adviseRange(offset, length, MADV_WILLNEED);
+}
+
+
+void
+MappedFile::dontNeed (Ullong offset, Ullong length)
+{
+    adviseRange(offset, length, MADV_DONTNEED);
+}
+
+
+// adviseRange -- pass a hint for [offset, offset+length) to madvise()
+// madvise() wants a page-aligned start address, so we round the offset
+// down to a page boundary and extend the length to match.  The range
+// is clipped to the file.
+
+void
+MappedFile::adviseRange (Ullong offset, Ullong length, int advice)
+{
+    if (base == Null  ||  offset >= fileSize)
+        return;
+    if (length > fileSize - offset)
+        length = fileSize - offset;
+
+    static const Ullong  pageSize = sysconf(_SC_PAGESIZE);
+    Ullong  start = offset - offset % pageSize;
+    length += offset - start;
+
+    (void) madvise(const_cast<Uchar*>(base + start),
+                   static_cast<size_t>(length), advice);
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
@@ -0,0 +1,90 @@
+// oasis/mapped-file.h -- read-only memory mapping of an OASIS file
+//
+// last modified:   2026/10/17
+//
+// MappedFile maps an entire input file into the address space so that
+// the scanners can decode records in place instead of copying them
+// through a stdio-style buffer.  File sizes and offsets are 64-bit
+// throughout; files larger than 4 GB are supported on 64-bit hosts.
+
+#ifndef OASIS_MAPPED_FILE_H_INCLUDED
+#define OASIS_MAPPED_FILE_H_INCLUDED
+
+#include <string>
+#include "misc/utils.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+using SoftJin::Uchar;
+using SoftJin::Ullong;
+
+
+// MappedFile -- whole-file, read-only mapping
+//
+// The constructor opens and maps the file and throws runtime_error if
+// either step fails.  The mapping lives until the object is destroyed;
+// every pointer or view derived from getData() is invalid after that.
+//
+// advise() tells the kernel how the pages of the mapping will be
+// touched.  A pass that reads the mapping front to back, as
+// FileValidator does, wants Sequential (aggressive read-ahead, pages
+// dropped soon after use); one that jumps between cells wants Random.
+// willNeed() asks for a byte range to be read into the page cache.  It
+// helps read() on the same file as well, which is how the parser uses
+// it; the other hints affect only accesses through the mapping.
+//
+// dontNeed() lets a long sequential pass release pages it has finished
+// with so that a tens-of-GB parse does not evict everything else from
+// the page cache.  All three hints are advisory; failures are ignored.
+//
+// Data members
+//
+// fd           int             descriptor of the mapped file
+// base         const Uchar*    start of the mapping; Null for empty files
+// fileSize     Ullong          size of the file in bytes
+// filename     string          for error messages
+
+class MappedFile {
+    int           fd;
+    const Uchar*  base;
+    Ullong        fileSize;
+    string        filename;
+
+public:
+    enum Access {
+        Normal,         // no particular pattern
+        Sequential,     // one front-to-back pass
+        Random          // seekTo() between cells
+    };
+
+    explicit    MappedFile (const char* fname);
+                ~MappedFile();
+
+    const Uchar*   getData() const      { return base; }
+    Ullong         getSize() const      { return fileSize; }
+    const string&  getFilename() const  { return filename; }
+
+    bool        contains (Ullong offset, Ullong length) const {
+                    return (offset <= fileSize
+                            &&  length <= fileSize - offset);
+                }
+
+    void        advise (Access access);
+    void        willNeed (Ullong offset, Ullong length);
+    void        dontNeed (Ullong offset, Ullong length);
+
+private:
+    void        adviseRange (Ullong offset, Ullong length, int advice);
+
+private:
+                MappedFile (const MappedFile&);         // forbidden
+    void        operator= (const MappedFile&);          // forbidden
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_MAPPED_FILE_H_INCLUDED
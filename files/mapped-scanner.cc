@@ -0,0 +1,899 @@
+// oasis/mapped-scanner.cc -- zero-copy tokenizing of a mapped OASIS file
+//
+// last modified:   2026/10/17
+
+#include <cstdarg>
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <zlib.h>
+
+#include "mapped-scanner.h"
+#include "cblock-prefetch.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::runtime_error;
+
+
+// Direction tables for 2-deltas, 3-deltas and form-1 g-deltas
+// (Section 7.5).  The index is the direction code in the low bits.
+
+static const int  DirX[8] = { 1, 0, -1,  0, 1, -1, -1,  1 };
+static const int  DirY[8] = { 0, 1,  0, -1, 1,  1, -1, -1 };
+
+
+static inline Delta
+MakeOctangularDelta (Uint dir, Ullong magnitude)
+{
+    llong  mag = magnitude;
+    return Delta(DirX[dir] * mag, DirY[dir] * mag);
+}
+
+
+// DecodeGDelta -- decode a g-delta from raw bytes
+// Form 1 is a single integer whose bit 0 is 0; bits 1-3 hold the
+// direction and the rest the magnitude.  Form 2 has bit 0 set; bit 1
+// is the sign of x and the rest its magnitude, followed by y as a
+// signed-integer.
+
+static bool
+DecodeGDelta (const Uchar** pp, const Uchar* end, /*out*/ Delta* delta)
+{
+    const Uchar*  p = *pp;
+    Ullong  val;
+    if (! DecodeUIntFast(&p, end, &val))
+        return false;
+    if ((val & 1) == 0) {
+        *delta = MakeOctangularDelta((val >> 1) & 7, val >> 4);
+    } else {
+        llong  x = val >> 2;
+        llong  y;
+        if (! DecodeSIntFast(&p, end, &y))
+            return false;
+        delta->x = (val & 2) ? -x : x;
+        delta->y = y;
+    }
+    *pp = p;
+    return true;
+}
+
+
+MappedScanner::MappedScanner (const MappedFile& mfile)
+  : mfile(mfile)
+{
+    fileBase = mfile.getData();
+    fileEnd = fileBase + mfile.getSize();
+    cp = fileBase;
+    endp = fileEnd;
+    inCblock = false;
+    cblockOffset = 0;
+    resumep = Null;
+    prefetcher = Null;
+}
+
+
+// setPrefetcher -- inflate CBLOCKs ahead of the scanner
+// The prefetcher must use the same MappedFile and outlive the scanner
+// (or be detached with setPrefetcher(Null)).  It starts scouting at
+// the scanner's current position; every seekTo() restarts it.
+
+void
+MappedScanner::setPrefetcher (CblockPrefetcher* pf)
+{
+    prefetcher = pf;
+    if (prefetcher != Null)
+        prefetcher->restart(currFileOffset());
+}
+
+
+void
+MappedScanner::abortScanner (const char* fmt, ...)
+{
+    char  msg[256];
+    va_list  ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof msg, fmt, ap);
+    va_end(ap);
+
+    char  where[128];
+    if (inCblock)
+        snprintf(where, sizeof where, "in CBLOCK at offset %llu (+%llu)",
+                 cblockOffset, currBlockOffset());
+    else
+        snprintf(where, sizeof where, "at offset %llu", currFileOffset());
+
+    throw runtime_error(mfile.getFilename() + ": " + where + ": " + msg);
+}
+
+
+Ullong
+MappedScanner::currFileOffset() const
+{
+    return (inCblock ? cblockOffset : Ullong(cp - fileBase));
+}
+
+
+Ullong
+MappedScanner::currBlockOffset() const
+{
+    return (inCblock ? Ullong(cp - &cblockBuffer[0]) : 0);
+}
+
+
+Ullong
+MappedScanner::cblockEndOffset() const
+{
+    return (inCblock ? Ullong(resumep - fileBase) : currFileOffset());
+}
+
+
+bool
+MappedScanner::atEnd()
+{
+    if (cp == endp  &&  inCblock)
+        leaveCblock();
+    return (cp == endp);
+}
+
+
+void
+MappedScanner::seekTo (Ullong offset)
+{
+    if (offset > mfile.getSize())
+        abortScanner("seek to offset %llu beyond end of file", offset);
+    inCblock = false;
+    cp = fileBase + offset;
+    endp = fileEnd;
+    if (prefetcher != Null)
+        prefetcher->restart(offset);
+}
+
+
+// underflow -- called when the current input range is exhausted
+// Records may not straddle the end of a CBLOCK, but the CBLOCK itself
+// ends at a record boundary and reading continues in the mapping.
+
+void
+MappedScanner::underflow()
+{
+    if (inCblock)
+        leaveCblock();
+    if (cp == endp)
+        abortScanner("unexpected end of file");
+}
+
+
+void
+MappedScanner::leaveCblock()
+{
+    inCblock = false;
+    cp = resumep;
+    endp = fileEnd;
+}
+
+
+// need -- ensure nbytes contiguous bytes are available
+// Returns a pointer to them and advances past them.
+
+const Uchar*
+MappedScanner::need (size_t nbytes)
+{
+    if (cp == endp  &&  nbytes != 0)
+        underflow();
+    if (size_t(endp - cp) < nbytes)
+        abortScanner(inCblock ? "record extends beyond end of CBLOCK"
+                              : "unexpected end of file");
+    const Uchar*  p = cp;
+    cp += nbytes;
+    return p;
+}
+
+
+Ullong
+MappedScanner::readUInt64()
+{
+    if (cp == endp)
+        underflow();
+    Ullong  val;
+    if (! DecodeUIntFast(&cp, endp, &val)) {
+        // Distinguish a truncated integer from one that overflows.
+        const Uchar*  p = cp;
+        while (p != endp  &&  (*p & 0x80))
+            ++p;
+        if (p == endp)
+            abortScanner(inCblock ? "record extends beyond end of CBLOCK"
+                                  : "unexpected end of file");
+        abortScanner("unsigned-integer too large for 64 bits");
+    }
+    return val;
+}
+
+
+Ulong
+MappedScanner::readUInt()
+{
+    Ullong  val = readUInt64();
+    if (val > Ullong(Ulong(-1)))
+        abortScanner("unsigned-integer %llu too large", val);
+    return val;
+}
+
+
+llong
+MappedScanner::readSInt64()
+{
+    return UIntToSInt(readUInt64());
+}
+
+
+long
+MappedScanner::readSInt()
+{
+    llong  val = readSInt64();
+    if (val != llong(long(val)))
+        abortScanner("signed-integer %lld out of range", val);
+    return val;
+}
+
+
+// readReal -- Section 7.3
+// Types 0-5 are ratios of unsigned-integers; 6 and 7 are IEEE float
+// and double in little-endian order.  We assemble the IEEE bytes
+// explicitly so that the code does not depend on host byte order.
+
+double
+MappedScanner::readReal()
+{
+    return readRealBody(readUInt());
+}
+
+
+// readRealBody -- read the part of a real that follows its type
+// Property values use the real's type as the value type, so the
+// property code reads the type itself and calls this.
+
+double
+MappedScanner::readRealBody (Ulong type)
+{
+    switch (type) {
+        case 0:  return  double(readUInt64());
+        case 1:  return -double(readUInt64());
+        case 2:  return  1.0 / double(readUInt64());
+        case 3:  return -1.0 / double(readUInt64());
+        case 4:
+        case 5: {
+            double  num = double(readUInt64());
+            double  den = double(readUInt64());
+            if (den == 0.0)
+                abortScanner("real has zero denominator");
+            return ((type == 4) ? num/den : -num/den);
+        }
+        case 6: {
+            const Uchar*  p = need(4);
+            Uint  bits = Uint(p[0]) | Uint(p[1]) << 8
+                         | Uint(p[2]) << 16 | Uint(p[3]) << 24;
+            float  fval;
+            memcpy(&fval, &bits, sizeof fval);
+            return fval;
+        }
+        case 7: {
+            const Uchar*  p = need(8);
+            Ullong  bits = 0;
+            for (int j = 7;  j >= 0;  --j)
+                bits = (bits << 8) | p[j];
+            double  dval;
+            memcpy(&dval, &bits, sizeof dval);
+            return dval;
+        }
+        default:
+            abortScanner("invalid real type %lu", type);
+    }
+    return 0.0;         // not reached
+}
+
+
+StringView
+MappedScanner::readString()
+{
+    Ullong  len = readUInt64();
+    const Uchar*  p = need(len);
+    return StringView(reinterpret_cast<const char*>(p), len);
+}
+
+
+void
+MappedScanner::readBytes (Uchar* buf, size_t nbytes)
+{
+    memcpy(buf, need(nbytes), nbytes);
+}
+
+
+Delta
+MappedScanner::readOneDelta (bool horizontal)
+{
+    llong  val = readSInt64();
+    return (horizontal ? Delta(val, 0) : Delta(0, val));
+}
+
+
+Delta
+MappedScanner::readTwoDelta()
+{
+    Ullong  val = readUInt64();
+    return MakeOctangularDelta(val & 3, val >> 2);
+}
+
+
+Delta
+MappedScanner::readThreeDelta()
+{
+    Ullong  val = readUInt64();
+    return MakeOctangularDelta(val & 7, val >> 3);
+}
+
+
+Delta
+MappedScanner::readGDelta()
+{
+    if (cp == endp)
+        underflow();
+    Delta  delta;
+    if (! DecodeGDelta(&cp, endp, &delta))
+        abortScanner("invalid or truncated g-delta");
+    return delta;
+}
+
+
+// readPointListView -- Section 7.7
+// Validates the type, reads the count, and finds the end of the
+// encoded deltas without decoding them.  Each delta is one integer
+// except a form-2 g-delta, which is two.
+
+PointListView
+MappedScanner::readPointListView()
+{
+    PointListView  view;
+    view.type = readUInt();
+    if (view.type > 5)
+        abortScanner("invalid point-list type %u", view.type);
+    view.count = readUInt();
+
+    if (cp == endp  &&  view.count != 0)
+        underflow();
+    view.data = cp;
+
+    const Uchar*  p = cp;
+    bool  gdelta = (view.type >= 4);
+    if (! gdelta) {
+        // One integer per delta: count the integers a block at a time.
+        if (! SkipUIntRun(&p, endp, view.count))
+            abortScanner("point-list extends beyond end of %s",
+                         inCblock ? "CBLOCK" : "file");
+        view.end = cp = p;
+        return view;
+    }
+    for (Ulong j = 0;  j < view.count;  ++j) {
+        if (p == endp)
+            abortScanner("point-list extends beyond end of %s",
+                         inCblock ? "CBLOCK" : "file");
+        bool  twoInts = (*p & 1);
+        for (int k = twoInts ? 2 : 1;  k > 0;  --k) {
+            while (p != endp  &&  (*p & 0x80))
+                ++p;
+            if (p == endp)
+                abortScanner("point-list extends beyond end of %s",
+                             inCblock ? "CBLOCK" : "file");
+            ++p;
+        }
+    }
+    view.end = cp = p;
+    return view;
+}
+
+
+// skipUInt -- step over an unsigned or signed integer
+// Only the continuation bits are examined, so this does not care how
+// large the integer is.
+
+void
+MappedScanner::skipUInt()
+{
+    if (cp == endp)
+        underflow();
+    const Uchar*  p = cp;
+    while (p != endp  &&  (*p & 0x80))
+        ++p;
+    if (p == endp)
+        abortScanner(inCblock ? "record extends beyond end of CBLOCK"
+                              : "unexpected end of file");
+    cp = p + 1;
+}
+
+
+// skipGDelta -- step over a g-delta
+// Bit 0 of the first byte distinguishes form 1 (one integer) from
+// form 2 (two integers).
+
+void
+MappedScanner::skipGDelta()
+{
+    if (cp == endp)
+        underflow();
+    bool  twoInts = (*cp & 1);
+    skipUInt();
+    if (twoInts)
+        skipUInt();
+}
+
+
+// skipRepetition -- Section 7.6
+// The dimension fields store the count minus 2, so the varying and
+// arbitrary types are followed by dimen+1 spaces or displacements.
+
+void
+MappedScanner::skipRepetition()
+{
+    skipRepetitionBody(readUInt());
+}
+
+
+// readRepetitionView -- find the extent of a repetition without decoding it
+// Used for elements that are read only for their effect on the modal
+// variables: the bytes can be kept and decoded if a later element
+// reuses the repetition.
+
+RepetitionView
+MappedScanner::readRepetitionView()
+{
+    RepetitionView  view;
+    view.type = readUInt();
+    if (cp == endp  &&  view.type != Rep_ReusePrevious)
+        underflow();
+    view.data = cp;
+    skipRepetitionBody(view.type);
+    view.end = cp;
+    return view;
+}
+
+
+void
+MappedScanner::skipRepetitionBody (Ulong type)
+{
+    switch (type) {
+        case Rep_ReusePrevious:
+            break;
+
+        case Rep_Matrix:                // xdimen ydimen xspace yspace
+            for (int j = 0;  j < 4;  ++j)
+                skipUInt();
+            break;
+
+        case Rep_UniformX:              // dimen space
+        case Rep_UniformY:
+            skipUInt();
+            skipUInt();
+            break;
+
+        case Rep_VaryingX:              // dimen space*
+        case Rep_VaryingY:
+        case Rep_GridVaryingX:          // dimen grid space*
+        case Rep_GridVaryingY: {
+            Ullong  dimen = readUInt64();
+            if (type == Rep_GridVaryingX  ||  type == Rep_GridVaryingY)
+                skipUInt();
+            for (Ullong j = 0;  j <= dimen;  ++j)
+                skipUInt();
+            break;
+        }
+
+        case Rep_TiltedMatrix:          // ndimen mdimen ndelta mdelta
+            skipUInt();
+            skipUInt();
+            skipGDelta();
+            skipGDelta();
+            break;
+
+        case Rep_Diagonal:              // dimen delta
+            skipUInt();
+            skipGDelta();
+            break;
+
+        case Rep_Arbitrary:             // dimen delta*
+        case Rep_GridArbitrary: {       // dimen grid delta*
+            Ullong  dimen = readUInt64();
+            if (type == Rep_GridArbitrary)
+                skipUInt();
+            for (Ullong j = 0;  j <= dimen;  ++j)
+                skipGDelta();
+            break;
+        }
+
+        default:
+            abortScanner("invalid repetition type %lu", type);
+    }
+}
+
+
+// skipInterval -- Section 19: the intervals in LAYERNAME records
+// Type 0 has no bounds, types 1-3 one bound and type 4 two.
+
+void
+MappedScanner::skipInterval()
+{
+    Ulong  type = readUInt();
+    if (type > 4)
+        abortScanner("invalid interval type %lu", type);
+    if (type >= 1)
+        skipUInt();
+    if (type == 4)
+        skipUInt();
+}
+
+
+// skipPropValue -- Section 31.1
+// Types 0-7 are reals (the value type is the real type), 8 and 9 are
+// integers, 10-12 strings and 13-15 PROPSTRING reference-numbers.
+
+void
+MappedScanner::skipPropValue()
+{
+    Ulong  type = readUInt();
+    if (type <= 7)
+        (void) readRealBody(type);
+    else if (type >= 10  &&  type <= 12)
+        (void) readString();
+    else if (type <= 15)
+        skipUInt();             // integer or PROPSTRING reference-number
+    else
+        abortScanner("invalid property value type %lu", type);
+}
+
+
+// DecodePointList -- expand a PointListView into vertices
+// See PointListDecoder below for the layout of the list.
+
+/*static*/ void
+MappedScanner::DecodePointList (const PointListView& view, bool isPolygon,
+                                /*out*/ PointList* ptlist)
+{
+    PointListDecoder  decoder(view, isPolygon);
+    ptlist->clear();
+    ptlist->resize(decoder.numVertices());
+    decoder.next(&(*ptlist)[0], ptlist->size());
+}
+
+
+// PointListDecoder
+// The list begins with the implicit first vertex (0,0).  For polygons
+// the 1-delta forms (types 0 and 1) imply one more vertex that makes
+// the last two edges axis-parallel; the closing edge itself is never
+// stored.  Type 5 stores each delta relative to the previous one.
+
+PointListDecoder::PointListDecoder (const PointListView& view,
+                                    bool isPolygon)
+  : view(view),
+    isPolygon(isPolygon)
+{
+    p = view.data;
+    originDone = false;
+    numDecoded = 0;
+    remaining = NumVertices(view, isPolygon);
+    x = y = 0;
+    dx = dy = 0;
+}
+
+
+/*static*/ Ulong
+PointListDecoder::NumVertices (const PointListView& view, bool isPolygon)
+{
+    bool  implied = (isPolygon  &&  view.type <= 1  &&  view.count != 0);
+    return (view.count + 1 + (implied ? 1 : 0));
+}
+
+
+size_t
+PointListDecoder::next (/*out*/ Delta* vertices, size_t maxVertices)
+{
+    size_t  n = 0;
+    if (! originDone  &&  maxVertices != 0) {
+        vertices[n++] = Delta(0, 0);
+        originDone = true;
+        --remaining;
+    }
+
+    // Types 0-3 have one integer per delta.  They are decoded a chunk
+    // at a time with DecodeUIntRun() into vals.
+    const size_t  ChunkSize = 64;
+    Ullong  vals[ChunkSize];
+
+    while (n < maxVertices  &&  numDecoded < view.count) {
+        if (view.type >= 4) {
+            Delta  delta;
+            if (! DecodeGDelta(&p, view.end, &delta))
+                throw runtime_error("invalid point-list encoding");
+            if (view.type == 5) {
+                dx += delta.x;
+                dy += delta.y;
+                delta = Delta(dx, dy);
+            }
+            x += delta.x;
+            y += delta.y;
+            vertices[n++] = Delta(x, y);
+            ++numDecoded;
+            --remaining;
+            continue;
+        }
+
+        size_t  nvals = std::min<Ulong>(view.count - numDecoded,
+                                        std::min(ChunkSize, maxVertices - n));
+        if (! DecodeUIntRun(&p, view.end, vals, nvals))
+            throw runtime_error("invalid point-list encoding");
+        for (size_t k = 0;  k < nvals;  ++k, ++numDecoded) {
+            Ullong  val = vals[k];
+            switch (view.type) {
+                case 0:
+                case 1: {
+                    bool  horiz = ((numDecoded % 2 == 0) == (view.type == 0));
+                    (horiz ? x : y) += UIntToSInt(val);
+                    break;
+                }
+                case 2: {
+                    Delta  delta = MakeOctangularDelta(val & 3, val >> 2);
+                    x += delta.x;
+                    y += delta.y;
+                    break;
+                }
+                default: {
+                    Delta  delta = MakeOctangularDelta(val & 7, val >> 3);
+                    x += delta.x;
+                    y += delta.y;
+                    break;
+                }
+            }
+            vertices[n++] = Delta(x, y);
+        }
+        remaining -= nvals;
+    }
+
+    // The implied vertex closes a 1-delta polygon.
+    if (n < maxVertices  &&  remaining == 1  &&  numDecoded == view.count
+            &&  view.count != 0) {
+        bool  lastHoriz = (((view.count - 1) % 2 == 0) == (view.type == 0));
+        vertices[n++] = lastHoriz ? Delta(x, 0) : Delta(0, y);
+        remaining = 0;
+    }
+    return n;
+}
+
+
+// DecodeRepetition -- build a Repetition from a RepetitionView
+// Varying offsets and arbitrary deltas are stored cumulatively, with
+// the implicit (0,0) first, as Repetition holds them.  The view must
+// not be of type 0, which has nothing to decode.
+
+/*static*/ void
+MappedScanner::DecodeRepetition (const RepetitionView& view,
+                                 /*out*/ Repetition* rep)
+{
+    const Uchar*  p = view.data;
+    Ullong  v[4];
+    bool    ok = true;
+
+    // The leading unsigned-integers: dimensions, spaces and grid.
+    int  nfixed;
+    switch (view.type) {
+        case Rep_Matrix:            // xdimen ydimen xspace yspace
+            nfixed = 4;
+            break;
+        case Rep_UniformX:          // dimen space
+        case Rep_UniformY:
+        case Rep_GridVaryingX:      // dimen grid
+        case Rep_GridVaryingY:
+        case Rep_GridArbitrary:
+        case Rep_TiltedMatrix:      // ndimen mdimen
+            nfixed = 2;
+            break;
+        case Rep_VaryingX:          // dimen
+        case Rep_VaryingY:
+        case Rep_Diagonal:
+        case Rep_Arbitrary:
+            nfixed = 1;
+            break;
+        default:
+            throw runtime_error("invalid repetition type "
+                                + std::to_string(view.type));
+    }
+    for (int j = 0;  j < nfixed  &&  ok;  ++j)
+        ok = DecodeUInt(&p, view.end, &v[j]);
+    if (! ok)
+        throw runtime_error("invalid repetition encoding");
+
+    switch (view.type) {
+        case Rep_Matrix:
+            rep->makeMatrix(v[0] + 2, v[1] + 2, v[2], v[3]);
+            break;
+
+        case Rep_UniformX:
+            rep->makeUniformX(v[0] + 2, v[1]);
+            break;
+
+        case Rep_UniformY:
+            rep->makeUniformY(v[0] + 2, v[1]);
+            break;
+
+        case Rep_VaryingX:
+        case Rep_VaryingY:
+        case Rep_GridVaryingX:
+        case Rep_GridVaryingY: {
+            Ulong  dimen = v[0] + 2;
+            Ulong  grid = (view.type == Rep_GridVaryingX
+                           ||  view.type == Rep_GridVaryingY) ? v[1] : 1;
+            switch (view.type) {
+                case Rep_VaryingX:      rep->makeVaryingX(dimen);            break;
+                case Rep_GridVaryingX:  rep->makeGridVaryingX(dimen, grid);  break;
+                case Rep_VaryingY:      rep->makeVaryingY(dimen);            break;
+                default:                rep->makeGridVaryingY(dimen, grid);  break;
+            }
+            llong  offset = 0;
+            rep->addOffset(0);
+            const size_t  ChunkSize = 64;
+            Ullong  spaces[ChunkSize];
+            for (Ulong j = 1;  j < dimen  &&  ok;  j += ChunkSize) {
+                size_t  n = std::min<Ulong>(ChunkSize, dimen - j);
+                ok = DecodeUIntRun(&p, view.end, spaces, n);
+                for (size_t k = 0;  k < n  &&  ok;  ++k) {
+                    offset += llong(spaces[k]) * llong(grid);
+                    rep->addOffset(offset);
+                }
+            }
+            break;
+        }
+
+        case Rep_TiltedMatrix: {
+            Delta  ndelta, mdelta;
+            ok = DecodeGDelta(&p, view.end, &ndelta)
+                 &&  DecodeGDelta(&p, view.end, &mdelta);
+            rep->makeTiltedMatrix(v[0] + 2, v[1] + 2, ndelta, mdelta);
+            break;
+        }
+
+        case Rep_Diagonal: {
+            Delta  delta;
+            ok = DecodeGDelta(&p, view.end, &delta);
+            rep->makeDiagonal(v[0] + 2, delta);
+            break;
+        }
+
+        default: {                      // Rep_Arbitrary, Rep_GridArbitrary
+            Ulong  dimen = v[0] + 2;
+            Ulong  grid = 1;
+            if (view.type == Rep_GridArbitrary) {
+                grid = v[1];
+                rep->makeGridArbitrary(dimen, grid);
+            } else
+                rep->makeArbitrary(dimen);
+            Delta  pos(0, 0);
+            rep->addDelta(pos);
+            for (Ulong j = 1;  j < dimen  &&  ok;  ++j) {
+                Delta  delta;
+                ok = DecodeGDelta(&p, view.end, &delta);
+                pos.x += delta.x * long(grid);
+                pos.y += delta.y * long(grid);
+                rep->addDelta(pos);
+            }
+            break;
+        }
+    }
+    if (! ok)
+        throw runtime_error("invalid repetition encoding");
+}
+
+
+// enterCblock -- Section 35: CBLOCK record
+// `34' comp-type uncomp-byte-count comp-byte-count comp-bytes
+//
+// The caller has already read the record-ID.  comp-type 0 is raw
+// DEFLATE (RFC 1951) without a zlib header.
+
+void
+MappedScanner::enterCblock()
+{
+    if (inCblock)
+        abortScanner("CBLOCK nested inside CBLOCK");
+
+    Ullong  recOffset = currFileOffset() - 1;
+    Ulong   compType = readUInt();
+    Ullong  uncompCount = readUInt64();
+    Ullong  compCount = readUInt64();
+    if (compType != 0)
+        abortScanner("unsupported CBLOCK compression type %lu", compType);
+    if (compCount > Ullong(endp - cp))
+        abortScanner("CBLOCK compressed data extends beyond end of file");
+
+    const Uchar*  compData = cp;
+    bool  haveData = (prefetcher != Null
+                      &&  prefetcher->take(recOffset, &cblockBuffer)
+                      &&  cblockBuffer.size() == uncompCount);
+    if (! haveData
+            &&  ! InflateCblock(compData, compCount, uncompCount,
+                                &cblockBuffer))
+        abortScanner("CBLOCK decompression failed: data is corrupt or"
+                     " does not inflate to %llu bytes", uncompCount);
+
+    inCblock = true;
+    cblockOffset = recOffset;
+    resumep = compData + compCount;
+    cp = uncompCount ? &cblockBuffer[0] : Null;
+    endp = cp + uncompCount;
+}
+
+
+// skipCblock -- step over a CBLOCK without inflating it
+// Like enterCblock(), this is called after the record-ID has been
+// read.  Structural passes that only want the top-level records use it.
+
+void
+MappedScanner::skipCblock()
+{
+    if (inCblock)
+        abortScanner("CBLOCK nested inside CBLOCK");
+
+    (void) readUInt();                  // comp-type
+    skipUInt();                         // uncomp-byte-count
+    Ullong  compCount = readUInt64();
+    if (compCount > Ullong(endp - cp))
+        abortScanner("CBLOCK compressed data extends beyond end of file");
+    cp += compCount;
+}
+
+
+bool
+InflateCblock (const Uchar* compData, Ullong compCount,
+               Ullong uncompCount, /*out*/ vector<Uchar>* buf)
+{
+    buf->resize(uncompCount);
+
+    z_stream  zs;
+    memset(&zs, 0, sizeof zs);
+    if (inflateInit2(&zs, -MAX_WBITS) != Z_OK)
+        return false;
+
+    // avail_in and avail_out are 32-bit, so feed blocks of 4 GB or
+    // more in pieces.
+
+    const Uint  MaxChunk = 1u << 30;
+    const Uchar*  in = compData;
+    Ullong  inLeft = compCount;
+    Uchar*  out = uncompCount ? &(*buf)[0] : Null;
+    Ullong  outLeft = uncompCount;
+    int  zerr = Z_OK;
+
+    while (zerr == Z_OK) {
+        if (zs.avail_in == 0  &&  inLeft != 0) {
+            zs.avail_in = std::min<Ullong>(inLeft, MaxChunk);
+            zs.next_in = const_cast<Uchar*>(in);
+            in += zs.avail_in;
+            inLeft -= zs.avail_in;
+        }
+        if (zs.avail_out == 0  &&  outLeft != 0) {
+            zs.avail_out = std::min<Ullong>(outLeft, MaxChunk);
+            zs.next_out = out;
+            out += zs.avail_out;
+            outLeft -= zs.avail_out;
+        }
+        zerr = inflate(&zs, (inLeft == 0) ? Z_FINISH : Z_NO_FLUSH);
+        if (zerr == Z_BUF_ERROR  &&  (inLeft != 0  ||  outLeft != 0))
+            zerr = Z_OK;                // just needs the next chunk
+    }
+    Ullong  produced = zs.total_out;
+    inflateEnd(&zs);
+
+    return (zerr == Z_STREAM_END  &&  produced == uncompCount);
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
@@ -0,0 +1,245 @@
+// oasis/mapped-scanner.h -- zero-copy tokenizing of a mapped OASIS file
+//
+// last modified:   2026/10/17
+//
+// MappedScanner is the counterpart of OasisScanner for input that has
+// been mapped with MappedFile.  It decodes the OASIS primitive types
+// (integers, reals, strings, deltas, point lists) directly from the
+// mapping.  Nothing is copied unless the caller asks for it: strings
+// come back as StringViews and point lists as PointListViews that
+// point into the mapped bytes.
+//
+// Compressed data is the exception.  After the caller has read the
+// record-ID of a CBLOCK record it calls enterCblock(), which inflates
+// the block into a buffer owned by the scanner.  Subsequent reads come
+// from that buffer until it is exhausted; the scanner then resumes
+// reading from the mapping just after the compressed bytes.  Views
+// created while inside a CBLOCK point into the buffer and remain valid
+// only until the next call to enterCblock() or seekTo().
+
+#ifndef OASIS_MAPPED_SCANNER_H_INCLUDED
+#define OASIS_MAPPED_SCANNER_H_INCLUDED
+
+#include <string>
+#include <vector>
+#include "misc/utils.h"
+#include "oasis.h"
+#include "mapped-file.h"
+#include "varint.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+using std::vector;
+using SoftJin::Uchar;
+using SoftJin::Uint;
+using SoftJin::Ulong;
+using SoftJin::Ullong;
+using SoftJin::llong;
+
+
+// StringView -- the bytes of an a-, b- or n-string, in place
+
+struct StringView {
+    const char*  data;
+    size_t       size;
+
+    StringView() : data(Null), size(0) { }
+    StringView (const char* d, size_t n) : data(d), size(n) { }
+
+    string      str() const     { return string(data, size); }
+    bool        empty() const   { return (size == 0); }
+    bool        equals (const string& s) const {
+                    return (s.size() == size
+                            &&  s.compare(0, size, data, size) == 0);
+                }
+};
+
+
+// PointListView -- an undecoded point-list
+// data..end are the encoded deltas, i.e. the bytes after the type and
+// vertex count.  count is the number of deltas in the encoding, not
+// the number of vertices in the decoded list.
+
+struct PointListView {
+    const Uchar*  data;
+    const Uchar*  end;
+    Uint          type;         // point-list type 0-5
+    Ulong         count;        // number of encoded deltas
+
+    PointListView() : data(Null), end(Null), type(0), count(0) { }
+    size_t      byteSize() const  { return (end - data); }
+};
+
+
+// RepetitionView -- an undecoded repetition
+// data..end are the bytes after the repetition type; empty for type 0,
+// which reuses the previous repetition.
+
+struct RepetitionView {
+    const Uchar*  data;
+    const Uchar*  end;
+    Ulong         type;         // repetition type 0-11
+
+    RepetitionView() : data(Null), end(Null), type(0) { }
+    size_t      byteSize() const  { return (end - data); }
+};
+
+
+// PointListDecoder -- expand a PointListView a chunk at a time
+// It yields the vertices that MappedScanner::DecodePointList() would
+// put in a PointList, in the same order, but only as many per call to
+// next() as the caller has room for, so a list of a million vertices
+// can be processed in a buffer of a few thousand.  numVertices() is
+// known before anything is decoded.  next() returns 0 when the list is
+// exhausted, and throws runtime_error if the encoding is invalid.  The
+// view's bytes must stay valid while the decoder is in use.
+
+class PointListDecoder {
+    PointListView   view;
+    bool            isPolygon;
+    const Uchar*    p;
+    bool            originDone;     // (0,0) has been returned
+    Ulong           numDecoded;     // deltas
+    Ulong           remaining;      // vertices still to be returned
+    llong           x, y;           // last vertex
+    llong           dx, dy;         // previous delta, for type 5
+
+public:
+                PointListDecoder (const PointListView& view, bool isPolygon);
+
+    static Ulong NumVertices (const PointListView& view, bool isPolygon);
+    Ulong       numVertices() const {
+                    return NumVertices(view, isPolygon);
+                }
+    bool        done() const            { return (remaining == 0); }
+    size_t      next (/*out*/ Delta* vertices, size_t maxVertices);
+};
+
+
+// DecodeUInt() and DecodeSInt(), the primitives the scanner and the
+// view decoders share, are in varint.h with their faster variants.
+
+
+// InflateCblock -- inflate the raw DEFLATE data of a CBLOCK
+// Resizes *buf to uncompCount and fills it.  Returns false if the data
+// is corrupt or does not inflate to exactly uncompCount bytes.
+
+bool    InflateCblock (const Uchar* compData, Ullong compCount,
+                       Ullong uncompCount, /*out*/ vector<Uchar>* buf);
+
+
+class CblockPrefetcher;
+
+
+// MappedScanner
+//
+// Data members
+//
+// mfile            the mapping being scanned
+// fileBase         start of the mapping
+// fileEnd          one past the last mapped byte
+// cp               next byte to read
+// endp             end of the current input range: fileEnd outside a
+//                  CBLOCK, the end of the inflated data inside one
+// inCblock         true while reading from cblockBuffer
+// cblockOffset     file offset of the CBLOCK record being read
+// resumep          where to continue in the mapping after the CBLOCK
+// cblockBuffer     inflated contents of the current CBLOCK
+// prefetcher       if not Null, inflates CBLOCKs ahead of the scanner;
+//                  see setPrefetcher()
+
+class MappedScanner {
+    const MappedFile&  mfile;
+    const Uchar*       fileBase;
+    const Uchar*       fileEnd;
+    const Uchar*       cp;
+    const Uchar*       endp;
+
+    bool               inCblock;
+    Ullong             cblockOffset;
+    const Uchar*       resumep;
+    vector<Uchar>      cblockBuffer;
+    CblockPrefetcher*  prefetcher;
+
+public:
+    explicit    MappedScanner (const MappedFile& mfile);
+
+    const MappedFile&  getMappedFile() const  { return mfile; }
+
+    // Position.  Inside a CBLOCK, currFileOffset() returns the offset
+    // of the CBLOCK record, currBlockOffset() the offset within the
+    // inflated data, and cblockEndOffset() the file offset just past
+    // the compressed bytes.
+
+    Ullong      currFileOffset() const;
+    Ullong      currBlockOffset() const;
+    bool        inCompressedBlock() const   { return inCblock; }
+    Ullong      cblockEndOffset() const;
+    bool        atEnd();
+    void        seekTo (Ullong offset);
+
+    // Primitive types (Section 7 of the spec)
+
+    Uint        readByte();
+    Ulong       readUInt();
+    Ullong      readUInt64();
+    long        readSInt();
+    llong       readSInt64();
+    double      readReal();
+    double      readRealBody (Ulong type);
+    StringView  readString();
+    void        readBytes (Uchar* buf, size_t nbytes);
+
+    Delta       readOneDelta (bool horizontal);
+    Delta       readTwoDelta();
+    Delta       readThreeDelta();
+    Delta       readGDelta();
+    PointListView  readPointListView();
+    RepetitionView readRepetitionView();
+
+    // Skipping fields without decoding them
+    void        skipUInt();
+    void        skipGDelta();
+    void        skipRepetition();
+    void        skipInterval();
+    void        skipPropValue();
+
+    // CBLOCK
+    void        enterCblock();
+    void        skipCblock();
+    void        setPrefetcher (CblockPrefetcher* pf);
+
+    // Decoding of views, independent of any scanner.
+    static void DecodePointList (const PointListView& view, bool isPolygon,
+                                 /*out*/ PointList* ptlist);
+    static void DecodeRepetition (const RepetitionView& view,
+                                  /*out*/ Repetition* rep);
+
+private:
+    void        underflow();
+    void        skipRepetitionBody (Ulong type);
+    void        leaveCblock();
+    const Uchar*  need (size_t nbytes);
+    void        abortScanner (const char* fmt, ...);
+
+private:
+                MappedScanner (const MappedScanner&);   // forbidden
+    void        operator= (const MappedScanner&);       // forbidden
+};
+
+
+inline Uint
+MappedScanner::readByte()
+{
+    if (cp == endp)
+        underflow();
+    return *cp++;
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_MAPPED_SCANNER_H_INCLUDED
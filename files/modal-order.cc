@@ -0,0 +1,595 @@
+// oasis/modal-order.cc -- builder proxy that reorders elements for the
+//                         modal variables
+//
+// last modified:   2026/10/17
+
+#include <algorithm>
+#include <climits>
+
+#include "varint.h"
+#include "shape-encode.h"
+#include "modal-order.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+
+namespace {
+
+const Ulong  UnknownUInt = ULONG_MAX;
+const long   UnknownSInt = LONG_MIN;
+
+
+// SIntField, UIntField -- bytes for a field whose modal variable holds
+// *modal, which becomes val
+
+inline size_t
+SIntField (long val, /*inout*/ long* modal)
+{
+    if (val == *modal)
+        return 0;
+    *modal = val;
+    return SIntSize(val);
+}
+
+
+inline size_t
+UIntField (Ulong val, /*inout*/ Ulong* modal)
+{
+    if (val == *modal)
+        return 0;
+    *modal = val;
+    return UIntSize(val);
+}
+
+
+// PointListSize -- bytes for ptlist in the type ChoosePointListCode()
+// picks, or as plain deltas if no type can hold it
+
+size_t
+PointListSize (const PointList& ptlist, bool isPolygon)
+{
+    PointListCode  code;
+    if (ChoosePointListCode(ptlist, isPolygon, &code))
+        return code.bytes;
+
+    size_t  size = 2;
+    long  px = 0, py = 0;
+    for (PointList::const_iterator iter = ptlist.begin();
+            iter != ptlist.end();  ++iter) {
+        size += SIntSize(iter->x - px) + SIntSize(iter->y - py);
+        px = iter->x;
+        py = iter->y;
+    }
+    return size;
+}
+
+
+// ExtnFieldsSize -- bytes for the extension fields of a path
+// Each end takes the scheme that ChooseExtnScheme() picks.  The scheme
+// byte is left out if both ends reuse the modal variables, and only
+// scheme 3 has an explicit value.  Either way the modal variables
+// become startExtn and endExtn.
+
+size_t
+ExtnFieldsSize (long startExtn, long endExtn, long halfwidth,
+                /*inout*/ long* modalStart, /*inout*/ long* modalEnd)
+{
+    Uint  startScheme = ChooseExtnScheme(startExtn, halfwidth,
+                            (*modalStart == UnknownSInt ? Null : modalStart));
+    Uint  endScheme = ChooseExtnScheme(endExtn, halfwidth,
+                            (*modalEnd == UnknownSInt ? Null : modalEnd));
+    *modalStart = startExtn;
+    *modalEnd = endExtn;
+
+    if (startScheme == 0  &&  endScheme == 0)
+        return 0;
+    size_t  size = 1;
+    if (startScheme == 3)
+        size += SIntSize(startExtn);
+    if (endScheme == 3)
+        size += SIntSize(endExtn);
+    return size;
+}
+
+
+// ComparePoints -- shorter lists first, then lexicographically
+
+int
+ComparePoints (const PointList& a, const PointList& b)
+{
+    if (a.size() != b.size())
+        return (a.size() < b.size() ? -1 : 1);
+    PointList::const_iterator  ia = a.begin(), ib = b.begin();
+    for ( ;  ia != a.end();  ++ia, ++ib) {
+        if (ia->x != ib->x)
+            return (ia->x < ib->x ? -1 : 1);
+        if (ia->y != ib->y)
+            return (ia->y < ib->y ? -1 : 1);
+    }
+    return 0;
+}
+
+
+}  // unnamed namespace
+
+
+// reset -- the modal variables at the start of a cell (Section 10.1)
+// The positions are 0; everything else is undefined.
+
+void
+ModalOrderBuilder::ModalState::reset()
+{
+    layer = datatype = textlayer = texttype = ctrapType = UnknownUInt;
+    width = height = halfwidth = radius = UnknownSInt;
+    startExtn = endExtn = UnknownSInt;
+    placementX = placementY = geometryX = geometryY = textX = textY = 0;
+    ptlist = Null;
+    cellName = Null;
+    text = Null;
+    rep = Null;
+}
+
+
+ModalOrderBuilder::ModalOrderBuilder (OasisBuilder* target)
+  : ElementProxy(target)
+{
+    heldPoints = 0;
+    stateBefore.reset();
+    stateAfter.reset();
+    bytesBefore = bytesAfter = 0;
+}
+
+
+ModalOrderBuilder::~ModalOrderBuilder() { }
+
+
+// holdElement -- add an element to those held
+// Returns the element with everything but what the arguments give
+// cleared, for the caller to fill.
+
+ModalOrderBuilder::Element&
+ModalOrderBuilder::holdElement (ElementKind kind, Ulong layer, Ulong datatype,
+                                long x, long y, const Repetition* rep)
+{
+    beginHeld();
+    if (held.size() >= MaxHeldElements  ||  heldPoints >= MaxHeldPoints)
+        flushHeld();
+
+    held.push_back(Element());
+    Element&  elem = held.back();
+    elem.kind = kind;
+    elem.layer = layer;
+    elem.datatype = datatype;
+    elem.x = x;
+    elem.y = y;
+    elem.width = elem.height = 0;
+    elem.startExtn = elem.endExtn = 0;
+    elem.attribute = 0;
+    elem.extra = 0;
+    elem.cellName = Null;
+    elem.text = Null;
+    elem.mag = Oreal(1);
+    elem.angle = Oreal(0);
+    elem.flip = false;
+    elem.rep = repCache.intern(rep);
+    elem.nameRank = elem.repRank = 0;
+    return elem;
+}
+
+
+// dropLast -- forget the last element held, and what it stored
+
+void
+ModalOrderBuilder::dropLast()
+{
+    switch (held.back().kind) {
+        case PolygonElem:
+        case PathElem:
+            heldPoints -= ptlists.back().size();
+            ptlists.pop_back();
+            break;
+        case TrapezoidElem:
+            traps.pop_back();
+            break;
+        case XGeometryElem:
+            xdata.pop_back();
+            break;
+        default:
+            break;
+    }
+    held.pop_back();
+}
+
+
+// rank -- order of first appearance of ptr among the elements held
+// Null ranks first.
+
+Ulong
+ModalOrderBuilder::rank (const void* ptr)
+{
+    if (ptr == Null)
+        return 0;
+    return ranks.insert(std::make_pair(ptr, Ulong(ranks.size() + 1)))
+                .first->second;
+}
+
+
+// flushHeld -- write the held elements in modal order
+
+void
+ModalOrderBuilder::flushHeld()
+{
+    if (held.empty())
+        return;
+
+    ranks.clear();
+    for (size_t j = 0;  j < held.size();  ++j) {
+        Element&  elem = held[j];
+        bytesBefore += estimate(elem, &stateBefore);
+        elem.nameRank = (elem.kind == PlacementElem) ? rank(elem.cellName)
+                                                     : rank(elem.text);
+        elem.repRank = rank(elem.rep);
+    }
+
+    order.resize(held.size());
+    for (size_t j = 0;  j < order.size();  ++j)
+        order[j] = j;
+    std::stable_sort(order.begin(), order.end(),
+        [this](size_t a, size_t b) { return before(held[a], held[b]); });
+
+    for (size_t j = 0;  j < order.size();  ++j) {
+        const Element&  elem = held[order[j]];
+        bytesAfter += estimate(elem, &stateAfter);
+        emit(elem);
+        target->endElement();
+    }
+
+    // The point lists go; the next part starts without one.
+    stateBefore.ptlist = stateAfter.ptlist = Null;
+    held.clear();
+    ptlists.clear();
+    traps.clear();
+    xdata.clear();
+    heldPoints = 0;
+}
+
+
+// before -- the modal order described in modal-order.h
+
+bool
+ModalOrderBuilder::before (const Element& a, const Element& b) const
+{
+    // Placements, then texts, then geometry.
+    int  ca = (a.kind == PlacementElem ? 0 : a.kind == TextElem ? 1 : 2);
+    int  cb = (b.kind == PlacementElem ? 0 : b.kind == TextElem ? 1 : 2);
+    if (ca != cb)
+        return (ca < cb);
+
+    if (ca == 0) {
+        if (a.nameRank != b.nameRank)
+            return (a.nameRank < b.nameRank);
+        double  amag = a.mag.getValue(),  bmag = b.mag.getValue();
+        if (amag != bmag)
+            return (amag < bmag);
+        double  aangle = a.angle.getValue(),  bangle = b.angle.getValue();
+        if (aangle != bangle)
+            return (aangle < bangle);
+        if (a.flip != b.flip)
+            return b.flip;
+    } else {
+        if (a.layer != b.layer)
+            return (a.layer < b.layer);
+        if (a.datatype != b.datatype)
+            return (a.datatype < b.datatype);
+        if (a.kind != b.kind)
+            return (a.kind < b.kind);
+        if (a.nameRank != b.nameRank)
+            return (a.nameRank < b.nameRank);
+        if (a.width != b.width)
+            return (a.width < b.width);
+        if (a.height != b.height)
+            return (a.height < b.height);
+        if (a.startExtn != b.startExtn)
+            return (a.startExtn < b.startExtn);
+        if (a.endExtn != b.endExtn)
+            return (a.endExtn < b.endExtn);
+        if (a.attribute != b.attribute)
+            return (a.attribute < b.attribute);
+        if (a.kind == PolygonElem  ||  a.kind == PathElem) {
+            int  cmp = ComparePoints(ptlists[a.extra], ptlists[b.extra]);
+            if (cmp != 0)
+                return (cmp < 0);
+        }
+    }
+
+    if (a.repRank != b.repRank)
+        return (a.repRank < b.repRank);
+    if (a.y != b.y)
+        return (a.y < b.y);
+    return (a.x < b.x);
+}
+
+
+// estimate -- bytes of elem's record that depend on the modal state
+// Also updates state as writing the record would.  The record-ID and
+// info-byte are counted; the fields that are always written are not.
+
+size_t
+ModalOrderBuilder::estimate (const Element& elem, ModalState* state) const
+{
+    size_t  size = 2;
+    const PointList*  ptlist = Null;
+    if (elem.kind == PolygonElem  ||  elem.kind == PathElem)
+        ptlist = &ptlists[elem.extra];
+
+    switch (elem.kind) {
+        case PlacementElem:
+            if (elem.cellName != state->cellName)
+                size += 2;
+            state->cellName = elem.cellName;
+            size += SIntField(elem.x, &state->placementX);
+            size += SIntField(elem.y, &state->placementY);
+            break;
+
+        case TextElem:
+            if (elem.text != state->text)
+                size += 2;
+            state->text = elem.text;
+            size += UIntField(elem.layer, &state->textlayer);
+            size += UIntField(elem.datatype, &state->texttype);
+            size += SIntField(elem.x, &state->textX);
+            size += SIntField(elem.y, &state->textY);
+            break;
+
+        default:
+            size += UIntField(elem.layer, &state->layer);
+            size += UIntField(elem.datatype, &state->datatype);
+            size += SIntField(elem.x, &state->geometryX);
+            size += SIntField(elem.y, &state->geometryY);
+            break;
+    }
+
+    switch (elem.kind) {
+        case RectangleElem:
+            size += SIntField(elem.width, &state->width);
+            size += SIntField(elem.height, &state->height);
+            break;
+
+        // A CTRAPEZOID has a modal type and may derive one dimension
+        // from the other.
+        case TrapezoidElem: {
+            Uint  ctrapType;
+            bool  needWidth = true, needHeight = true;
+            if (FindCTrapezoidType(traps[elem.extra], &ctrapType)) {
+                size += UIntField(ctrapType, &state->ctrapType);
+                CTrapezoidFields(ctrapType, &needWidth, &needHeight);
+            }
+            if (needWidth)
+                size += SIntField(elem.width, &state->width);
+            if (needHeight)
+                size += SIntField(elem.height, &state->height);
+            break;
+        }
+
+        case PathElem:
+            size += SIntField(elem.width, &state->halfwidth);
+            size += ExtnFieldsSize(elem.startExtn, elem.endExtn, elem.width,
+                                   &state->startExtn, &state->endExtn);
+            // fall through
+
+        case PolygonElem:
+            if (state->ptlist == Null
+                    ||  ComparePoints(*ptlist, *state->ptlist) != 0)
+                size += PointListSize(*ptlist, elem.kind == PolygonElem);
+            state->ptlist = ptlist;
+            break;
+
+        case CircleElem:
+            size += SIntField(elem.width, &state->radius);
+            break;
+
+        default:
+            break;
+    }
+
+    if (elem.rep != Null) {
+        size += (elem.rep == state->rep)
+                    ? 1 : RepetitionCache::EncodedSize(*elem.rep);
+        state->rep = elem.rep;
+    }
+    return size;
+}
+
+
+// emit -- pass elem to the target, without endElement()
+
+void
+ModalOrderBuilder::emit (const Element& elem)
+{
+    switch (elem.kind) {
+        case PlacementElem:
+            target->beginPlacement(elem.cellName, elem.x, elem.y,
+                                   elem.mag, elem.angle, elem.flip, elem.rep);
+            break;
+        case TextElem:
+            target->beginText(elem.layer, elem.datatype, elem.x, elem.y,
+                              elem.text, elem.rep);
+            break;
+        case RectangleElem:
+            target->beginRectangle(elem.layer, elem.datatype, elem.x, elem.y,
+                                   elem.width, elem.height, elem.rep);
+            break;
+        case PolygonElem:
+            target->beginPolygon(elem.layer, elem.datatype, elem.x, elem.y,
+                                 ptlists[elem.extra], elem.rep);
+            break;
+        case PathElem:
+            target->beginPath(elem.layer, elem.datatype, elem.x, elem.y,
+                              elem.width, elem.startExtn, elem.endExtn,
+                              ptlists[elem.extra], elem.rep);
+            break;
+        case TrapezoidElem:
+            target->beginTrapezoid(elem.layer, elem.datatype, elem.x, elem.y,
+                                   traps[elem.extra], elem.rep);
+            break;
+        case CircleElem:
+            target->beginCircle(elem.layer, elem.datatype, elem.x, elem.y,
+                                elem.width, elem.rep);
+            break;
+        case XGeometryElem:
+            target->beginXGeometry(elem.layer, elem.datatype, elem.x, elem.y,
+                                   elem.attribute, xdata[elem.extra],
+                                   elem.rep);
+            break;
+    }
+}
+
+
+// releaseLast -- the element the property belongs to is taken back
+// from those held and forwarded at once, so that its properties follow
+// it.
+
+void
+ModalOrderBuilder::releaseLast()
+{
+    emit(held.back());
+    dropLast();
+}
+
+
+void
+ModalOrderBuilder::beginCell (CellName* cellName)
+{
+    ElementProxy::beginCell(cellName);
+    stateBefore.reset();
+    stateAfter.reset();
+}
+
+
+//----------------------------------------------------------------------
+// Elements are held until the cell ends.
+
+
+void
+ModalOrderBuilder::beginPlacement (CellName* cellName,
+                                   long x, long y,
+                                   const Oreal&  mag,
+                                   const Oreal&  angle,
+                                   bool flip,
+                                   const Repetition*  rep)
+{
+    Element&  elem = holdElement(PlacementElem, 0, 0, x, y, rep);
+    elem.cellName = cellName;
+    elem.mag = mag;
+    elem.angle = angle;
+    elem.flip = flip;
+}
+
+
+void
+ModalOrderBuilder::beginText (Ulong textlayer, Ulong texttype,
+                              long x, long y,
+                              TextString* text,
+                              const Repetition* rep)
+{
+    Element&  elem = holdElement(TextElem, textlayer, texttype, x, y, rep);
+    elem.text = text;
+}
+
+
+void
+ModalOrderBuilder::beginRectangle (Ulong layer, Ulong datatype,
+                                   long x, long y,
+                                   long width, long height,
+                                   const Repetition*  rep)
+{
+    Element&  elem = holdElement(RectangleElem, layer, datatype, x, y, rep);
+    elem.width = width;
+    elem.height = height;
+}
+
+
+void
+ModalOrderBuilder::beginPolygon (Ulong layer, Ulong datatype,
+                                 long x, long y,
+                                 const PointList&  ptlist,
+                                 const Repetition*  rep)
+{
+    Element&  elem = holdElement(PolygonElem, layer, datatype, x, y, rep);
+    elem.extra = ptlists.size();
+    ptlists.push_back(ptlist);
+    heldPoints += ptlist.size();
+}
+
+
+void
+ModalOrderBuilder::beginPath (Ulong layer, Ulong datatype,
+                              long x, long  y,
+                              long halfwidth,
+                              long startExtn, long endExtn,
+                              const PointList&  ptlist,
+                              const Repetition*  rep)
+{
+    Element&  elem = holdElement(PathElem, layer, datatype, x, y, rep);
+    elem.width = halfwidth;
+    elem.startExtn = startExtn;
+    elem.endExtn = endExtn;
+    elem.extra = ptlists.size();
+    ptlists.push_back(ptlist);
+    heldPoints += ptlist.size();
+}
+
+
+void
+ModalOrderBuilder::beginTrapezoid (Ulong layer, Ulong datatype,
+                                   long x, long  y,
+                                   const Trapezoid& trap,
+                                   const Repetition*  rep)
+{
+    Element&  elem = holdElement(TrapezoidElem, layer, datatype, x, y, rep);
+    elem.width = long(trap.getWidth());
+    elem.height = long(trap.getHeight());
+    elem.extra = traps.size();
+    traps.push_back(trap);
+}
+
+
+void
+ModalOrderBuilder::beginCircle (Ulong layer, Ulong datatype,
+                                long x, long y,
+                                long radius,
+                                const Repetition*  rep)
+{
+    Element&  elem = holdElement(CircleElem, layer, datatype, x, y, rep);
+    elem.width = radius;
+}
+
+
+void
+ModalOrderBuilder::beginXGeometry (Ulong layer, Ulong datatype,
+                                   long x, long y,
+                                   Ulong attribute,
+                                   const string& data,
+                                   const Repetition*  rep)
+{
+    Element&  elem = holdElement(XGeometryElem, layer, datatype, x, y, rep);
+    elem.attribute = attribute;
+    elem.extra = xdata.size();
+    xdata.push_back(data);
+}
+
+
+// beginXElement
+// XELEMENT records have no modal fields; they go through at once.
+
+void
+ModalOrderBuilder::beginXElement (Ulong attribute, const string& data)
+{
+    beginForwarded();
+    target->beginXElement(attribute, data);
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
@@ -0,0 +1,205 @@
+// oasis/modal-order.h -- builder proxy that reorders elements for the
+//                        modal variables
+//
+// last modified:   2026/10/17
+//
+// OasisCreator omits a field of an element record when the field's
+// modal variable already has the value (Section 10): the layer and
+// datatype, the width and height, the point list, the placed cell, the
+// repetition (written as reuse-previous) and so on.  That saves bytes
+// only when consecutive elements share those values, and what arrives
+// from JCell::generateBinary() is in the order of an unordered_map.
+//
+// ModalOrderBuilder sits in front of the OasisCreator and forwards the
+// elements of each cell in a better order.  It holds them until the
+// cell ends and then passes them on sorted by
+//
+//   - placements, texts, then geometry
+//   - for placements: the cell placed, magnification, angle and flip
+//   - for texts: textlayer, texttype and the text string
+//   - for geometry: layer, datatype, kind, then the fields the kind
+//     keeps in modal variables (width and height, point list,
+//     halfwidth and extensions, radius)
+//   - then the repetition, then y and x
+//
+// Names and repetitions are ordered by their first appearance in the
+// cell, so the output does not depend on where things are in memory.
+//
+// Only the order changes; every element keeps its fields.  What the
+// proxy does with elements that get properties and with everything
+// that is not an element is described in element-proxy.h.
+//
+// The proxy holds at most MaxHeldElements elements and MaxHeldPoints
+// points.  A cell with more is sorted and written in parts of that
+// size.
+//
+// getBytesBefore() and getBytesAfter() estimate what the element
+// records held would take in the order in which they arrived and in
+// the order in which they went out.  The estimate counts the fields
+// that the modal variables could supply; the rest is the same in both
+// orders.  It ignores the elements forwarded at once.  Point-lists,
+// trapezoids and path extensions are counted in the encoding that the
+// shape-encode.h functions choose: the cheapest point-list type, a
+// CTRAPEZOID where one fits, and the cheapest extension schemes.
+//
+// The repetitions of the held elements are interned, so equal
+// repetitions are one object and sort together.
+
+#ifndef OASIS_MODAL_ORDER_H_INCLUDED
+#define OASIS_MODAL_ORDER_H_INCLUDED
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "misc/utils.h"
+#include "oasis.h"
+#include "builder.h"
+#include "element-proxy.h"
+#include "rep-intern.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+using std::vector;
+using SoftJin::Ulong;
+using SoftJin::Ullong;
+
+
+class ModalOrderBuilder : public ElementProxy {
+public:
+    static const size_t  MaxHeldElements = 1 << 16;
+    static const size_t  MaxHeldPoints   = 1 << 20;
+
+private:
+    enum ElementKind {
+        PlacementElem, TextElem, RectangleElem, PolygonElem, PathElem,
+        TrapezoidElem, CircleElem, XGeometryElem
+    };
+
+    struct Element {
+        ElementKind     kind;
+        Ulong           layer, datatype;        // textlayer, texttype
+        long            x, y;
+        long            width, height;          // halfwidth, radius
+        long            startExtn, endExtn;
+        Ulong           attribute;              // XGEOMETRY
+        size_t          extra;                  // in ptlists, traps, data
+        CellName*       cellName;
+        TextString*     text;
+        Oreal           mag, angle;
+        bool            flip;
+        const Repetition*  rep;                 // interned
+        Ulong           nameRank, repRank;      // set when sorted
+    };
+
+    // ModalState -- what the modal variables would hold, for estimates
+    struct ModalState {
+        Ulong           layer, datatype, textlayer, texttype;
+        long            width, height, halfwidth, radius;
+        long            startExtn, endExtn;
+        Ulong           ctrapType;
+        long            placementX, placementY, geometryX, geometryY;
+        long            textX, textY;
+        const PointList*   ptlist;
+        const void*     cellName;
+        const void*     text;
+        const Repetition*  rep;
+
+        void    reset();
+    };
+
+    vector<Element>     held;           // in order of arrival
+    vector<PointList>   ptlists;        // of held polygons and paths
+    vector<Trapezoid>   traps;          // of held trapezoids
+    vector<string>      xdata;          // of held XGEOMETRYs
+    size_t              heldPoints;
+
+    vector<size_t>      order;          // scratch
+    std::unordered_map<const void*, Ulong>  ranks;      // scratch
+
+    ModalState          stateBefore, stateAfter;
+    Ullong              bytesBefore, bytesAfter;
+
+public:
+    explicit    ModalOrderBuilder (OasisBuilder* target);
+    virtual     ~ModalOrderBuilder();
+
+    Ullong      getBytesBefore() const  { return bytesBefore; }
+    Ullong      getBytesAfter() const   { return bytesAfter; }
+
+    // OasisBuilder virtual methods for the elements, and beginCell()
+    // to reset the estimates.  ElementProxy provides the rest.
+
+    virtual void  beginCell (CellName* cellName);
+
+    virtual void  beginPlacement (CellName* cellName,
+                                  long x, long y,
+                                  const Oreal&  mag,
+                                  const Oreal&  angle,
+                                  bool flip,
+                                  const Repetition*  rep);
+
+    virtual void  beginText (Ulong textlayer, Ulong texttype,
+                             long x, long y,
+                             TextString* text,
+                             const Repetition* rep);
+
+    virtual void  beginRectangle (Ulong layer, Ulong datatype,
+                                  long x, long y,
+                                  long width, long height,
+                                  const Repetition*  rep);
+
+    virtual void  beginPolygon (Ulong layer, Ulong datatype,
+                                long x, long y,
+                                const PointList&  ptlist,
+                                const Repetition*  rep);
+
+    virtual void  beginPath (Ulong layer, Ulong datatype,
+                             long x, long  y,
+                             long halfwidth,
+                             long startExtn, long endExtn,
+                             const PointList&  ptlist,
+                             const Repetition*  rep);
+
+    virtual void  beginTrapezoid (Ulong layer, Ulong datatype,
+                                  long x, long  y,
+                                  const Trapezoid& trap,
+                                  const Repetition*  rep);
+
+    virtual void  beginCircle (Ulong layer, Ulong datatype,
+                               long x, long y,
+                               long radius,
+                               const Repetition*  rep);
+
+    virtual void  beginXElement (Ulong attribute, const string& data);
+
+    virtual void  beginXGeometry (Ulong layer, Ulong datatype,
+                                  long x, long y,
+                                  Ulong attribute,
+                                  const string& data,
+                                  const Repetition*  rep);
+
+private:
+    virtual void  flushHeld();
+    virtual void  releaseLast();
+
+    Element&    holdElement (ElementKind kind, Ulong layer, Ulong datatype,
+                             long x, long y, const Repetition* rep);
+    void        dropLast();
+    bool        before (const Element& a, const Element& b) const;
+    Ulong       rank (const void* ptr);
+    size_t      estimate (const Element& elem, ModalState* state) const;
+    void        emit (const Element& elem);
+
+private:
+                ModalOrderBuilder (const ModalOrderBuilder&);   // forbidden
+    void        operator= (const ModalOrderBuilder&);           // forbidden
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_MODAL_ORDER_H_INCLUDED
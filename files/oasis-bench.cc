@@ -0,0 +1,1393 @@
+// oasis/oasis-bench.cc -- benchmarks for the parse, build and write paths
+//
+// last modified:   2026/10/17
+//
+// usage:  oasis-bench [-n runs] [-k names] [-o json-file]
+//                     [-B baseline-json] [-T percent] [input-oasis-file]
+//
+// oasis-bench times two kinds of benchmark:
+//
+//   kernel     one hot routine on synthetic data: repetition expansion,
+//              BBox transformation, integer encoding and decoding (the
+//              reference decoder and the run decoder that varint.h
+//              picks for this processor, after checking it against the
+//              others), real decoding, the choice and encoding of
+//              point-list types, the point-list and repetition
+//              writers of OasisCreator, repetition synthesis and modal
+//              reordering in front of it, and CBLOCK deflation and
+//              inflation.  These need no input.
+//
+//   e2e        a whole pass over the input file: parseFile() into a
+//              builder that only counts, oasis-copy (parseFile() into
+//              OasisCreator), the oasis-layout cell BBox computation,
+//              and what oasis-analysis does: parseFile() into
+//              OasisStatisticsBuilder followed by the record pass of
+//              OasisStructureAnalyzer.  That record pass, a walk with
+//              OasisRecordTokenizer, is also timed on its own, as are
+//              CellOffsetIndex::build() with CBLOCK prefetching, which
+//              fails if a file with CBLOCKs gets none prefetched, and
+//              OasisCursor, with and without streaming of large
+//              point-lists.
+//              These run only if an input file is given.
+//
+// Each benchmark runs in a child process so that its peak RSS, taken
+// from wait4(), is its own and not the high-water mark of everything
+// before it.  The child runs the benchmark -n times after one warm-up
+// run and reports the median time.
+//
+// The results go out as JSON, one benchmark per line:
+//
+//     {"name": "varint-decode", "kind": "kernel", "seconds": 0.0123,
+//      "bytes": 4718592, "records": 1048576, "mb_per_s": 383.6,
+//      "records_per_s": 85248455.3, "peak_rss_kb": 14336}
+//
+// mb_per_s is 0 for benchmarks that do not consume bytes.  With -B the
+// results are compared with an earlier JSON file from oasis-bench.  A
+// benchmark regresses if its throughput falls, or its peak RSS grows,
+// by more than -T percent.  The comparison is printed on stderr and the
+// exit status is 2 if anything regressed, so that a script can stop a
+// change before it reaches the farm.
+
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "misc/utils.h"
+#include "builder.h"
+#include "creator.h"
+#include "parser.h"
+#include "layoutbuilder.h"
+#include "mapped-file.h"
+#include "mapped-scanner.h"
+#include "varint.h"
+#include "rec-tokenizer.h"
+#include "cell-index.h"
+#include "cursor.h"
+#include "stream-builder.h"
+#include "pipeline-builder.h"
+#include "rep-synth.h"
+#include "modal-order.h"
+#include "shape-encode.h"
+#include "analyzer.h"
+
+
+using namespace std;
+using namespace Anuvad::SoftJin;
+using namespace Anuvad::Oasis;
+
+// layoutbuilder.h declares its classes in the top-level Oasis namespace,
+// and Servers/analyzer.h in Oasis::Jeong.
+namespace JLayout = ::Oasis::JLayout;
+using ::Oasis::JLayoutBuilder;
+using ::Oasis::Jeong::OasisStatistics;
+using ::Oasis::Jeong::OasisStatisticsBuilder;
+using ::Oasis::Jeong::OasisStructureAnalyzer;
+using ::Oasis::Jeong::CSVWriter;
+
+
+const char  UsageMessage[] =
+"usage:  %s [-n runs] [-k names] [-o json-file] [-B baseline-json]\n"
+"            [-T percent] [input-oasis-file]\n"
+"Options:\n"
+"    -n runs      Time each benchmark this many times after a warm-up\n"
+"                 run and report the median.  Default 5.\n"
+"\n"
+"    -k names     Run only the benchmarks whose names contain one of\n"
+"                 these comma-separated strings.\n"
+"\n"
+"    -o json-file Write the results here instead of standard output.\n"
+"\n"
+"    -B baseline-json\n"
+"        Compare with the results of an earlier run.  The exit status\n"
+"        is 2 if any benchmark regressed.\n"
+"\n"
+"    -T percent   Regression threshold for -B.  Default 10.\n"
+"\n"
+"Without input-oasis-file only the kernel benchmarks run.\n";
+
+
+static void
+UsageError() {
+    fprintf(stderr, UsageMessage, GetProgramName());
+    exit(1);
+}
+
+
+static void
+DisplayWarning (const char* msg) {
+    Error("%s", msg);
+}
+
+
+
+//----------------------------------------------------------------------
+// Benchmark table
+
+
+// BenchResult -- what one run of a benchmark did
+// bytes is the input consumed, or 0 if that means nothing for the
+// benchmark.  records counts whatever unit the benchmark works in:
+// records, elements, values or calls.
+
+struct BenchResult {
+    double      seconds;
+    Ullong      bytes;
+    Ullong      records;
+};
+
+
+struct BenchContext {
+    const char*  infilename;            // Null if none given
+    string       tempDir;
+};
+
+
+typedef void  (*BenchFunc) (const BenchContext& ctx, /*out*/ BenchResult* res);
+
+struct Benchmark {
+    const char*  name;
+    const char*  kind;                  // "kernel" or "e2e"
+    bool         needsInput;
+    BenchFunc    func;
+};
+
+
+// Stopwatch -- wall-clock time since construction
+class Stopwatch {
+    std::chrono::steady_clock::time_point  start;
+public:
+                Stopwatch() : start(std::chrono::steady_clock::now()) { }
+    double      elapsed() const {
+                    return std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start).count();
+                }
+};
+
+
+// Sink -- keeps the compiler from discarding computed values
+static volatile Ullong  Sink;
+
+
+static string
+TempFile (const BenchContext& ctx, const char* stem)
+{
+    return ctx.tempDir + "/oasis-bench-" + to_string(getpid()) + "-" + stem;
+}
+
+
+static Ullong
+FileSize (const string& fname)
+{
+    struct stat  st;
+    if (stat(fname.c_str(), &st) != 0)
+        throw runtime_error("cannot stat '" + fname + "': " + strerror(errno));
+    return Ullong(st.st_size);
+}
+
+
+// AppendUInt, AppendSInt -- append the encoding of val to buf
+
+static void
+AppendUInt (Ullong val, /*inout*/ vector<Uchar>* buf)
+{
+    Uchar  bytes[MaxVarintBytes];
+    buf->insert(buf->end(), bytes, bytes + EncodeUInt(val, bytes));
+}
+
+
+static void
+AppendSInt (llong val, /*inout*/ vector<Uchar>* buf)
+{
+    Uchar  bytes[MaxVarintBytes];
+    buf->insert(buf->end(), bytes, bytes + EncodeSInt(val, bytes));
+}
+
+
+// MakeVarints -- n integers whose encodings are 1 to 5 bytes long
+// The mix is weighted towards short values, as in real files.
+
+static void
+MakeVarints (size_t n, /*out*/ vector<Uchar>* buf)
+{
+    static const int  shifts[] = { 6, 6, 6, 13, 13, 20, 27, 34 };
+    Ullong  state = 12345;
+    buf->clear();
+    for (size_t j = 0;  j < n;  ++j) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        Ullong  val = (state >> 24) & ((1ULL << shifts[j % 8]) - 1);
+        if (j % 2 == 0)
+            AppendUInt(val, buf);
+        else
+            AppendSInt((state & 1) ? -llong(val) : llong(val), buf);
+    }
+}
+
+
+//----------------------------------------------------------------------
+// Kernel benchmarks
+
+
+// rep-unpack -- JLayout::unpackRepetition() over every repetition type
+// that has a fixed shape, plus an arbitrary one.
+
+static void
+BenchRepUnpack (const BenchContext&, /*out*/ BenchResult* res)
+{
+    vector<Repetition>  reps(4);
+    reps[0].makeMatrix(32, 32, 100, 200);
+    reps[1].makeUniformX(256, 50);
+    reps[2].makeDiagonal(128, Delta(30, 40));
+    reps[3].makeArbitrary(256);
+    for (long j = 0;  j < 256;  ++j)
+        reps[3].addDelta(Delta(j * 7, (j * 13) % 1000));
+
+    const int  rounds = 20000;
+    std::vector<std::pair<long, long> >  positions;
+    Ullong  count = 0;
+
+    Stopwatch  watch;
+    for (int r = 0;  r < rounds;  ++r) {
+        const Repetition&  rep = reps[r % reps.size()];
+        positions.clear();
+        JLayout::unpackRepetition(r, -r, &rep, positions);
+        count += positions.size();
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = 0;
+    res->records = count;
+    Sink = count;
+}
+
+
+// bbox-transform -- JLayout::BBox::transform() at the four Manhattan
+// angles, with and without flip.
+
+static void
+BenchBBoxTransform (const BenchContext&, /*out*/ BenchResult* res)
+{
+    JLayout::Matrix2D  matrices[4];
+    for (int j = 0;  j < 4;  ++j)
+        matrices[j] = JLayout::rotationMatrix(j * M_PI / 2);
+
+    const Ullong  count = 10000000;
+    JLayout::BBox  box(-1000, -2000, 3000, 4000);
+    Ullong  acc = 0;
+
+    Stopwatch  watch;
+    for (Ullong j = 0;  j < count;  ++j) {
+        JLayout::BBox  out = box.transform(matrices[j & 3], 1.0, (j & 4),
+                                           long(j & 0xffff), 0);
+        acc += Ullong(out.x_max - out.x_min);
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = 0;
+    res->records = count;
+    Sink = acc;
+}
+
+
+// varint-decode -- DecodeUInt() and DecodeSInt() over a buffer of
+// mixed-length integers
+
+static void
+BenchVarintDecode (const BenchContext&, /*out*/ BenchResult* res)
+{
+    const size_t  count = 4 * 1024 * 1024;
+    vector<Uchar>  buf;
+    MakeVarints(count, &buf);
+
+    const Uchar*  end = buf.data() + buf.size();
+    Ullong  acc = 0;
+
+    Stopwatch  watch;
+    const Uchar*  p = buf.data();
+    for (size_t j = 0;  j < count;  ++j) {
+        if (j % 2 == 0) {
+            Ullong  uval;
+            if (! DecodeUInt(&p, end, &uval))
+                throw runtime_error("varint-decode: bad encoding");
+            acc += uval;
+        } else {
+            llong  sval;
+            if (! DecodeSInt(&p, end, &sval))
+                throw runtime_error("varint-decode: bad encoding");
+            acc += Ullong(sval);
+        }
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = buf.size();
+    res->records = count;
+    Sink = acc;
+}
+
+
+// DecodeRunReference -- DecodeUIntRun() done with DecodeUInt()
+
+static bool
+DecodeRunReference (const Uchar** pp, const Uchar* end, Ullong* vals, size_t n)
+{
+    const Uchar*  p = *pp;
+    for (size_t j = 0;  j < n;  ++j) {
+        if (! DecodeUInt(&p, end, &vals[j]))
+            return false;
+    }
+    *pp = p;
+    return true;
+}
+
+
+// CheckVarintRuns -- compare every VarintImpl with DecodeUInt()
+// Each implementation decodes and skips runs of every length from
+// every offset of buf, which should include truncated and overlong
+// integers, and must agree with DecodeUInt() on the values, the end
+// position and whether the run is valid.
+
+static void
+CheckVarintRuns (const vector<Uchar>& buf)
+{
+    const size_t  MaxRun = 40;
+    const Uchar*  begin = buf.data();
+    const Uchar*  end = begin + buf.size();
+    Ullong  expect[MaxRun], got[MaxRun];
+
+    VarintImpl  saved = GetVarintImpl();
+    for (int impl = 0;  impl < Varint_NumImpls;  ++impl) {
+        if (! SetVarintImpl(VarintImpl(impl)))
+            continue;
+        for (const Uchar* start = begin;  start != end;  ++start) {
+            for (size_t n = 0;  n <= MaxRun;  ++n) {
+                const Uchar*  ep = start;
+                bool  eok = DecodeRunReference(&ep, end, expect, n);
+                const Uchar*  gp = start;
+                bool  gok = DecodeUIntRun(&gp, end, got, n);
+                const Uchar*  sp = start;
+                bool  sok = SkipUIntRun(&sp, end, n);
+                if (gok != eok  ||  gp != ep
+                        ||  (eok  &&  ! std::equal(expect, expect + n, got))
+                        ||  (eok  &&  (! sok  ||  sp != ep)))
+                    throw runtime_error(string("varint-run: ")
+                                        + VarintImplName(VarintImpl(impl))
+                                        + " disagrees with DecodeUInt() at offset "
+                                        + to_string(start - begin));
+            }
+        }
+    }
+    SetVarintImpl(saved);
+}
+
+
+// varint-run -- DecodeUIntRun() over the varint-decode buffer with
+// the implementation chosen for this processor, after checking all
+// the implementations against each other on it and on random bytes
+
+static void
+BenchVarintRun (const BenchContext&, /*out*/ BenchResult* res)
+{
+    const size_t  count = 4 * 1024 * 1024;
+    vector<Uchar>  buf;
+    MakeVarints(count, &buf);
+
+    vector<Uchar>  junk(buf.begin(), buf.begin() + 2048);
+    Ullong  state = 54321;
+    for (size_t j = 0;  j < 2048;  ++j) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        Uint  byte = state >> 56;
+        // Mostly continuation bytes, so that long integers are common.
+        junk.push_back(Uchar((j % 3 == 0) ? byte : (byte | 0x80)));
+    }
+    CheckVarintRuns(junk);
+
+    const size_t  ChunkSize = 256;
+    vector<Ullong>  vals(ChunkSize);
+    const Uchar*  end = buf.data() + buf.size();
+    Ullong  acc = 0;
+
+    Stopwatch  watch;
+    const Uchar*  p = buf.data();
+    for (size_t j = 0;  j < count;  j += ChunkSize) {
+        size_t  n = std::min(ChunkSize, count - j);
+        if (! DecodeUIntRun(&p, end, vals.data(), n))
+            throw runtime_error("varint-run: bad encoding");
+        acc += vals[0] + vals[n - 1];
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = buf.size();
+    res->records = count;
+    Sink = acc;
+}
+
+
+// varint-encode -- EncodeUInt() and EncodeSInt() of the values that
+// MakeVarints() encodes
+
+static void
+BenchVarintEncode (const BenchContext&, /*out*/ BenchResult* res)
+{
+    static const int  shifts[] = { 6, 6, 6, 13, 13, 20, 27, 34 };
+    const size_t  count = 4 * 1024 * 1024;
+    vector<Uchar>  buf(count * MaxVarintBytes);
+
+    Stopwatch  watch;
+    Ullong  state = 12345;
+    Uchar*  p = buf.data();
+    for (size_t j = 0;  j < count;  ++j) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        Ullong  val = (state >> 24) & ((1ULL << shifts[j % 8]) - 1);
+        if (j % 2 == 0)
+            p += EncodeUInt(val, p);
+        else
+            p += EncodeSInt((state & 1) ? -llong(val) : llong(val), p);
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = p - buf.data();
+    res->records = count;
+    Sink = buf[count];
+}
+
+
+// real-decode -- MappedScanner::readReal() over all eight real types
+// The scanner reads only mapped files, so the reals go into a
+// temporary file first.
+
+static void
+BenchRealDecode (const BenchContext& ctx, /*out*/ BenchResult* res)
+{
+    const size_t  count = 2 * 1024 * 1024;
+    vector<Uchar>  buf;
+    for (size_t j = 0;  j < count;  ++j) {
+        Ulong  type = j % 8;
+        EncodeUInt(type, &buf);
+        switch (type) {
+            case 0:  case 1:  case 2:  case 3:
+                EncodeUInt(j % 1000 + 1, &buf);
+                break;
+            case 4:  case 5:
+                EncodeUInt(j % 1000 + 1, &buf);
+                EncodeUInt(j % 7 + 1, &buf);
+                break;
+            case 6: {
+                float  f = float(j) / 3;
+                Uchar  bytes[4];
+                memcpy(bytes, &f, 4);           // little-endian hosts only
+                buf.insert(buf.end(), bytes, bytes + 4);
+                break;
+            }
+            case 7: {
+                double  d = double(j) / 3;
+                Uchar  bytes[8];
+                memcpy(bytes, &d, 8);
+                buf.insert(buf.end(), bytes, bytes + 8);
+                break;
+            }
+        }
+    }
+
+    string  fname = TempFile(ctx, "reals");
+    FILE*  fp = fopen(fname.c_str(), "wb");
+    if (fp == Null
+            ||  fwrite(buf.data(), 1, buf.size(), fp) != buf.size()
+            ||  fclose(fp) != 0)
+        throw runtime_error("cannot write '" + fname + "'");
+
+    double  acc = 0;
+    Stopwatch  watch;
+    {
+        MappedFile  mfile(fname.c_str());
+        MappedScanner  scanner(mfile);
+        for (size_t j = 0;  j < count;  ++j)
+            acc += scanner.readReal();
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = buf.size();
+    res->records = count;
+    Sink = Ullong(acc);
+    unlink(fname.c_str());
+}
+
+
+// ptlist-encode -- ChoosePointListCode() and EncodePointList() over
+// polygons that are 1-delta, Manhattan, octangular and all-angle in
+// turn; bytes is what they encode to
+
+static void
+BenchPtlistEncode (const BenchContext&, /*out*/ BenchResult* res)
+{
+    const int  NumShapes = 4;
+    const int  count = 1000000;
+    PointList  shapes[NumShapes];
+    for (int s = 0;  s < NumShapes;  ++s) {
+        long  x = 0, y = 0;
+        shapes[s].push_back(Delta(0, 0));
+        for (long j = 1;  j < 23;  ++j) {
+            long  d = 10 + (j * 37) % 500;
+            switch (s) {
+                case 0:  (j % 2 ? x : y) += (j % 4 < 2) ? d : -d;       break;
+                case 1:  (j % 3 ? x : y) += d;                          break;
+                case 2:  x += d;  y += (j % 2) ? d : 0;                 break;
+                default: x += d;  y += (j * j * 11) % 997 - 498;        break;
+            }
+            shapes[s].push_back(Delta(x, y));
+        }
+        if (s != 3)
+            shapes[s].push_back(Delta(0, y));   // close with two axis edges
+    }
+
+    vector<Uchar>  buf;
+    Ullong  nbytes = 0;
+    Stopwatch  watch;
+    for (int j = 0;  j < count;  ++j) {
+        const PointList&  ptlist = shapes[j % NumShapes];
+        PointListCode  code;
+        if (! ChoosePointListCode(ptlist, true, &code))
+            throw runtime_error("ptlist-encode: edge too long");
+        buf.clear();
+        EncodePointList(ptlist, code, &buf);
+        nbytes += buf.size();
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = nbytes;
+    res->records = count;
+    Sink = buf[0];
+}
+
+
+// creator-pointlist -- OasisCreator::writePointList() through
+// beginPolygon() and beginPath(), which write little else
+// writePointList() is private, so it is timed through the calls that
+// use it.  The file is uncompressed so that deflate does not dominate.
+
+static void
+BenchCreatorPointList (const BenchContext& ctx, /*out*/ BenchResult* res)
+{
+    const int  count = 200000;
+    PointList  manhattan, anyAngle;
+    manhattan.push_back(Delta(0, 0));
+    anyAngle.push_back(Delta(0, 0));
+    for (long j = 1;  j < 32;  ++j) {
+        manhattan.push_back(Delta(((j + 1) / 2) * 100, (j / 2) * 70));
+        anyAngle.push_back(Delta(j * 37, (j * j * 11) % 997));
+    }
+    manhattan.push_back(Delta(0, 16 * 70));
+
+    string  fname = TempFile(ctx, "ptlist.oas");
+    CellName  cellName("PTLIST");
+    Stopwatch  watch;
+    {
+        OasisCreatorOptions  options(false, false, false, true);
+        OasisCreator  creator(fname.c_str(), options);
+        creator.beginFile("1.0", Oreal(1000), Validation::None);
+        creator.beginCell(&cellName);
+        for (int j = 0;  j < count;  ++j) {
+            if (j % 2 == 0)
+                creator.beginPolygon(j % 4, 0, j, j, manhattan, Null);
+            else
+                creator.beginPath(j % 4, 0, j, j, 10, 0, 0, anyAngle, Null);
+        }
+        creator.endCell();
+        creator.endFile();
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = FileSize(fname);
+    res->records = count;
+    unlink(fname.c_str());
+}
+
+
+// creator-repetition -- OasisCreator::writeRepetition() through
+// beginRectangle() with a repetition of a different type each time,
+// so that reuse-previous never applies
+
+static void
+BenchCreatorRepetition (const BenchContext& ctx, /*out*/ BenchResult* res)
+{
+    const int  count = 400000;
+    vector<Repetition>  reps(8);
+    reps[0].makeMatrix(4, 8, 100, 200);
+    reps[1].makeUniformX(16, 50);
+    reps[2].makeUniformY(16, 70);
+    reps[3].makeVaryingX(8);
+    for (long j = 0;  j < 8;  ++j)
+        reps[3].addOffset(j * j * 10);
+    reps[4].makeGridVaryingY(8, 5);
+    for (long j = 0;  j < 8;  ++j)
+        reps[4].addOffset(j * 25);
+    reps[5].makeTiltedMatrix(4, 4, Delta(100, 10), Delta(-10, 100));
+    reps[6].makeDiagonal(8, Delta(30, 30));
+    reps[7].makeArbitrary(16);
+    for (long j = 0;  j < 16;  ++j)
+        reps[7].addDelta(Delta(j * 31, (j * 17) % 200));
+
+    string  fname = TempFile(ctx, "rep.oas");
+    CellName  cellName("REP");
+    Stopwatch  watch;
+    {
+        OasisCreatorOptions  options(false, false, false, true);
+        OasisCreator  creator(fname.c_str(), options);
+        creator.beginFile("1.0", Oreal(1000), Validation::None);
+        creator.beginCell(&cellName);
+        for (int j = 0;  j < count;  ++j)
+            creator.beginRectangle(1, 0, j, j, 10, 20, &reps[j % reps.size()]);
+        creator.endCell();
+        creator.endFile();
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = FileSize(fname);
+    res->records = count;
+    unlink(fname.c_str());
+}
+
+
+// creator-repsynth -- a flat cell of rectangle rows, as many flows write
+// it, through RepetitionSynthesizer into OasisCreator; records counts
+// the records written
+
+static void
+BenchCreatorRepSynth (const BenchContext& ctx, /*out*/ BenchResult* res)
+{
+    const long  rows = 512, columns = 512;
+
+    string  fname = TempFile(ctx, "repsynth.oas");
+    CellName  cellName("FLAT");
+    Stopwatch  watch;
+    {
+        OasisCreatorOptions  options(false, false, false, true);
+        OasisCreator  creator(fname.c_str(), options);
+        RepetitionSynthesizer  synth(&creator);
+        synth.beginFile("1.0", Oreal(1000), Validation::None);
+        synth.beginCell(&cellName);
+        for (long r = 0;  r < rows;  ++r) {
+            // Every eighth row is ragged, for the arbitrary repetitions.
+            long  jog = (r % 8 == 7) ? 3 : 0;
+            for (long j = 0;  j < columns;  ++j)
+                synth.beginRectangle(1 + r % 2, 0, j*50 + (j % 5)*jog, r*80,
+                                     20, 40, Null);
+        }
+        synth.endCell();
+        synth.endFile();
+        res->records = synth.getRecordsOut();
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = FileSize(fname);
+    unlink(fname.c_str());
+}
+
+
+// creator-modal-order -- rectangles of mixed layers and sizes in hashed
+// order, as JCell::generateBinary() writes them, through
+// ModalOrderBuilder into OasisCreator; records counts the rectangles
+
+static void
+BenchCreatorModalOrder (const BenchContext& ctx, /*out*/ BenchResult* res)
+{
+    const long  count = 256 * 1024;
+
+    string  fname = TempFile(ctx, "modal-order.oas");
+    CellName  cellName("MIXED");
+    Stopwatch  watch;
+    {
+        OasisCreatorOptions  options(false, false, false, true);
+        OasisCreator  creator(fname.c_str(), options);
+        ModalOrderBuilder  modalOrder(&creator);
+        modalOrder.beginFile("1.0", Oreal(1000), Validation::None);
+        modalOrder.beginCell(&cellName);
+        Ullong  state = 12345;
+        for (long j = 0;  j < count;  ++j) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            Ulong  bits = Ulong(state >> 33);
+            modalOrder.beginRectangle(bits % 8, 0, long(bits >> 3) % 100000,
+                                      long(bits >> 11) % 100000,
+                                      10 + (bits >> 20) % 4 * 10, 40, Null);
+        }
+        modalOrder.endCell();
+        modalOrder.endFile();
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = FileSize(fname);
+    res->records = count;
+    unlink(fname.c_str());
+}
+
+
+// CblockSample -- bytes to compress for the CBLOCK benchmarks
+// The start of the input file if there is one, otherwise the varint
+// buffer, which is about as compressible as cell contents.
+
+static void
+CblockSample (const BenchContext& ctx, /*out*/ vector<Uchar>* buf)
+{
+    const Ullong  maxBytes = 64 * 1024 * 1024;
+    if (ctx.infilename != Null) {
+        MappedFile  mfile(ctx.infilename);
+        Ullong  n = std::min(mfile.getSize(), maxBytes);
+        buf->assign(mfile.getData(), mfile.getData() + n);
+    } else
+        MakeVarints(8 * 1024 * 1024, buf);
+}
+
+
+// DeflateBlocks -- compress buf in CBLOCK-sized pieces as OasisCreator
+// does, with raw DEFLATE
+
+const size_t  CblockSize = 256 * 1024;
+
+static void
+DeflateBlocks (const vector<Uchar>& buf,
+               /*out*/ vector<vector<Uchar> >* blocks)
+{
+    blocks->clear();
+    for (size_t off = 0;  off < buf.size();  off += CblockSize) {
+        size_t  n = std::min(CblockSize, buf.size() - off);
+        z_stream  zs;
+        memset(&zs, 0, sizeof zs);
+        if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                         8, Z_DEFAULT_STRATEGY) != Z_OK)
+            throw runtime_error("deflateInit2 failed");
+        blocks->push_back(vector<Uchar>(deflateBound(&zs, n)));
+        vector<Uchar>&  out = blocks->back();
+        zs.next_in = const_cast<Uchar*>(buf.data() + off);
+        zs.avail_in = n;
+        zs.next_out = out.data();
+        zs.avail_out = out.size();
+        int  zerr = deflate(&zs, Z_FINISH);
+        out.resize(zs.total_out);
+        deflateEnd(&zs);
+        if (zerr != Z_STREAM_END)
+            throw runtime_error("deflate failed");
+    }
+}
+
+
+static void
+BenchCblockDeflate (const BenchContext& ctx, /*out*/ BenchResult* res)
+{
+    vector<Uchar>  buf;
+    vector<vector<Uchar> >  blocks;
+    CblockSample(ctx, &buf);
+
+    Stopwatch  watch;
+    DeflateBlocks(buf, &blocks);
+    res->seconds = watch.elapsed();
+    res->bytes = buf.size();
+    res->records = blocks.size();
+}
+
+
+static void
+BenchCblockInflate (const BenchContext& ctx, /*out*/ BenchResult* res)
+{
+    vector<Uchar>  buf;
+    vector<vector<Uchar> >  blocks;
+    CblockSample(ctx, &buf);
+    DeflateBlocks(buf, &blocks);
+
+    vector<Uchar>  out;
+    Stopwatch  watch;
+    for (size_t j = 0;  j < blocks.size();  ++j) {
+        Ullong  n = std::min(Ullong(CblockSize), Ullong(buf.size() - j*CblockSize));
+        if (! InflateCblock(blocks[j].data(), blocks[j].size(), n, &out))
+            throw runtime_error("cblock-inflate: corrupt block");
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = buf.size();
+    res->records = blocks.size();
+}
+
+
+//----------------------------------------------------------------------
+// End-to-end benchmarks
+
+
+// CountingBuilder -- counts the elements the parser delivers
+
+class CountingBuilder : public OasisBuilder {
+public:
+    Ullong      count;
+
+                CountingBuilder() : count(0) { }
+
+    virtual void  beginPlacement (CellName*, long, long, const Oreal&,
+                                  const Oreal&, bool, const Repetition*) {
+                      ++count;
+                  }
+    virtual void  beginText (Ulong, Ulong, long, long, TextString*,
+                             const Repetition*) {
+                      ++count;
+                  }
+    virtual void  beginRectangle (Ulong, Ulong, long, long, long, long,
+                                  const Repetition*) {
+                      ++count;
+                  }
+    virtual void  beginPolygon (Ulong, Ulong, long, long, const PointList&,
+                                const Repetition*) {
+                      ++count;
+                  }
+    virtual void  beginPath (Ulong, Ulong, long, long, long, long, long,
+                             const PointList&, const Repetition*) {
+                      ++count;
+                  }
+    virtual void  beginTrapezoid (Ulong, Ulong, long, long, const Trapezoid&,
+                                  const Repetition*) {
+                      ++count;
+                  }
+    virtual void  beginCircle (Ulong, Ulong, long, long, long,
+                               const Repetition*) {
+                      ++count;
+                  }
+    virtual void  beginXGeometry (Ulong, Ulong, long, long, Ulong,
+                                  const string&, const Repetition*) {
+                      ++count;
+                  }
+};
+
+
+// parse-null -- parseFile() into a builder that does nothing but count
+
+static void
+BenchParseNull (const BenchContext& ctx, /*out*/ BenchResult* res)
+{
+    OasisParserOptions  options;
+    CountingBuilder  builder;
+
+    Stopwatch  watch;
+    {
+        OasisParser  parser(ctx.infilename, DisplayWarning, options);
+        parser.parseFile(&builder);
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = FileSize(ctx.infilename);
+    res->records = builder.count;
+}
+
+
+// copy -- what oasis-copy does with default options
+
+static void
+BenchCopy (const BenchContext& ctx, /*out*/ BenchResult* res)
+{
+    OasisParserOptions  parserOptions;
+    OasisCreatorOptions  creatorOptions(false, true, false, true);
+    string  fname = TempFile(ctx, "copy.oas");
+
+    Stopwatch  watch;
+    {
+        OasisParser  parser(ctx.infilename, DisplayWarning, parserOptions);
+        OasisCreator  creator(fname.c_str(), creatorOptions);
+        parser.parseFile(&creator);
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = FileSize(ctx.infilename);
+    res->records = 0;
+    unlink(fname.c_str());
+}
+
+
+// copy-pipeline -- copy with the creator on a second thread (oasis-copy -p);
+// records counts the batches handed over
+
+static void
+BenchCopyPipeline (const BenchContext& ctx, /*out*/ BenchResult* res)
+{
+    OasisParserOptions  parserOptions;
+    OasisCreatorOptions  creatorOptions(false, true, false, true);
+    string  fname = TempFile(ctx, "copy-pipeline.oas");
+
+    Stopwatch  watch;
+    {
+        OasisParser  parser(ctx.infilename, DisplayWarning, parserOptions);
+        OasisCreator  creator(fname.c_str(), creatorOptions);
+        PipelineBuilder  pipe(&creator);
+        parser.parseFile(&pipe);
+        res->records = pipe.getNumBatches();
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = FileSize(ctx.infilename);
+    unlink(fname.c_str());
+}
+
+
+// layout-bbox -- what oasis-layout does before its menu: build the
+// JLayout database and compute every cell's BBox
+
+static void
+BenchLayoutBBox (const BenchContext& ctx, /*out*/ BenchResult* res)
+{
+    OasisParserOptions  options;
+    CountingBuilder  target;
+
+    Stopwatch  watch;
+    {
+        OasisParser  parser(ctx.infilename, DisplayWarning, options);
+        JLayoutBuilder  layoutBuilder(target);
+        layoutBuilder.setRepetitionCache(parser.getRepetitionCache());
+        parser.parseFile(&layoutBuilder);
+        layoutBuilder.calculateAllCellBBoxes();
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = FileSize(ctx.infilename);
+    res->records = 0;
+}
+
+
+// analyzer -- what oasis-analysis does short of writing the CSV file:
+// parseFile() into OasisStatisticsBuilder, then the record pass of
+// OasisStructureAnalyzer.  records counts the elements and placements.
+
+static void
+BenchAnalyzer (const BenchContext& ctx, /*out*/ BenchResult* res)
+{
+    OasisParserOptions  options;
+    OasisStatistics  statistics(ctx.infilename);
+    CSVWriter  writer(TempFile(ctx, "analyzer.csv"));
+
+    Stopwatch  watch;
+    {
+        OasisParser  parser(ctx.infilename, DisplayWarning, options);
+        OasisStatisticsBuilder  builder(statistics, writer);
+        builder.setRepetitionCache(parser.getRepetitionCache());
+        parser.parseFile(&builder);
+        OasisStructureAnalyzer(statistics).analyze(ctx.infilename);
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = FileSize(ctx.infilename);
+    res->records = statistics.shapeCount + statistics.refCount
+                   + statistics.textCount;
+}
+
+
+// tokenize -- the record pass of OasisStructureAnalyzer alone: every
+// record visited, none decoded beyond its ID and info-byte
+
+static void
+BenchTokenize (const BenchContext& ctx, /*out*/ BenchResult* res)
+{
+    Stopwatch  watch;
+    MappedFile  mfile(ctx.infilename);
+    MappedScanner  scanner(mfile);
+    OasisRecordTokenizer  tokenizer(scanner);
+    while (tokenizer.next())
+        ;
+    res->seconds = watch.elapsed();
+    res->bytes = mfile.getSize();
+    res->records = tokenizer.getRecordCount();
+}
+
+
+// cell-index -- CellOffsetIndex::build() with a prefetch thread per
+// core, as the parser runs it for useCellIndex.  Afterwards it checks
+// that a file whose cells are in CBLOCKs gets some of them from the
+// prefetcher; otherwise the prefetcher is doing nothing.
+
+static void
+BenchCellIndex (const BenchContext& ctx, /*out*/ BenchResult* res)
+{
+    unsigned  nthreads = std::max(std::thread::hardware_concurrency(), 1u);
+    MappedFile  mfile(ctx.infilename);
+    CellOffsetIndex  index;
+
+    Stopwatch  watch;
+    index.build(mfile, nthreads);
+    res->seconds = watch.elapsed();
+    res->bytes = mfile.getSize();
+    res->records = index.size();
+
+    bool  haveCblocks = false;
+    for (CellOffsetIndex::const_iterator iter = index.begin();
+            iter != index.end();  ++iter)
+        haveCblocks = haveCblocks  ||  ! iter->cblocks.empty();
+    if (haveCblocks  &&  index.getNumPrefetched() == 0)
+        throw runtime_error("cell-index: no CBLOCK was prefetched");
+}
+
+
+// cursor -- every element through OasisCursor, in batches
+
+static void
+BenchCursor (const BenchContext& ctx, /*out*/ BenchResult* res)
+{
+    Ullong  count = 0;
+    Stopwatch  watch;
+    {
+        OasisCursor  cursor(ctx.infilename);
+        ElementView  views[256];
+        while (cursor.nextCell()) {
+            size_t  n;
+            while ((n = cursor.next(views, 256)) != 0)
+                count += n;
+        }
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = FileSize(ctx.infilename);
+    res->records = count;
+}
+
+
+// cursor-stream -- cursor, with point-lists of PointStreamThreshold or
+// more vertices expanded a chunk at a time.  Compare its peak RSS with
+// that of cursor on files with giant polygons.
+
+static void
+BenchCursorStream (const BenchContext& ctx, /*out*/ BenchResult* res)
+{
+    const size_t  ChunkSize = 1024;
+    Delta  chunk[ChunkSize];
+    Ullong  count = 0, vertices = 0;
+    Stopwatch  watch;
+    {
+        OasisCursor  cursor(ctx.infilename);
+        cursor.setPointStreamThreshold(PointStreamThreshold);
+        ElementView  views[256];
+        while (cursor.nextCell()) {
+            size_t  n;
+            while ((n = cursor.next(views, 256)) != 0) {
+                count += n;
+                for (size_t j = 0;  j < n;  ++j) {
+                    const ElementView&  view = views[j];
+                    if (view.points != Null  ||  view.numPoints == 0) {
+                        vertices += view.numPoints;
+                        continue;
+                    }
+                    PointListDecoder  decoder(view.pointList,
+                                              view.kind == EK_Polygon);
+                    size_t  m;
+                    while ((m = decoder.next(chunk, ChunkSize)) != 0)
+                        vertices += m;
+                }
+            }
+        }
+    }
+    res->seconds = watch.elapsed();
+    res->bytes = FileSize(ctx.infilename);
+    res->records = count;
+    Sink = vertices;
+}
+
+
+const Benchmark  Benchmarks[] = {
+    { "rep-unpack",         "kernel", false, BenchRepUnpack },
+    { "bbox-transform",     "kernel", false, BenchBBoxTransform },
+    { "varint-decode",      "kernel", false, BenchVarintDecode },
+    { "varint-run",         "kernel", false, BenchVarintRun },
+    { "varint-encode",      "kernel", false, BenchVarintEncode },
+    { "real-decode",        "kernel", false, BenchRealDecode },
+    { "ptlist-encode",      "kernel", false, BenchPtlistEncode },
+    { "creator-pointlist",  "kernel", false, BenchCreatorPointList },
+    { "creator-repetition", "kernel", false, BenchCreatorRepetition },
+    { "creator-repsynth",   "kernel", false, BenchCreatorRepSynth },
+    { "creator-modal-order", "kernel", false, BenchCreatorModalOrder },
+    { "cblock-deflate",     "kernel", false, BenchCblockDeflate },
+    { "cblock-inflate",     "kernel", false, BenchCblockInflate },
+    { "parse-null",         "e2e",    true,  BenchParseNull },
+    { "copy",               "e2e",    true,  BenchCopy },
+    { "copy-pipeline",      "e2e",    true,  BenchCopyPipeline },
+    { "layout-bbox",        "e2e",    true,  BenchLayoutBBox },
+    { "analyzer",           "e2e",    true,  BenchAnalyzer },
+    { "tokenize",           "e2e",    true,  BenchTokenize },
+    { "cell-index",         "e2e",    true,  BenchCellIndex },
+    { "cursor",             "e2e",    true,  BenchCursor },
+    { "cursor-stream",      "e2e",    true,  BenchCursorStream },
+};
+
+const size_t  NumBenchmarks = sizeof(Benchmarks) / sizeof(Benchmarks[0]);
+
+
+
+//----------------------------------------------------------------------
+// Running and reporting
+
+
+// Measurement -- a benchmark's result as reported
+
+struct Measurement {
+    string      name;
+    string      kind;
+    BenchResult result;                 // median run
+    long        peakRssKB;
+
+    double      mbPerSec() const {
+                    return (result.seconds > 0)
+                               ? result.bytes / result.seconds / 1e6 : 0;
+                }
+    double      recordsPerSec() const {
+                    return (result.seconds > 0)
+                               ? result.records / result.seconds : 0;
+                }
+};
+
+
+// RunChild -- body of the child process for one benchmark
+// Writes the median BenchResult to fd and exits.
+
+static void
+RunChild (const Benchmark& bench, const BenchContext& ctx, int runs, int fd)
+{
+    int  status = 0;
+    try {
+        vector<BenchResult>  results(runs);
+        BenchResult  warmup;
+        bench.func(ctx, &warmup);
+        for (int j = 0;  j < runs;  ++j)
+            bench.func(ctx, &results[j]);
+        std::sort(results.begin(), results.end(),
+                  [](const BenchResult& a, const BenchResult& b) {
+                      return a.seconds < b.seconds;
+                  });
+        const BenchResult&  median = results[runs/2];
+        if (write(fd, &median, sizeof median) != ssize_t(sizeof median))
+            status = 1;
+    }
+    catch (const std::exception& exc) {
+        Error("%s: %s", bench.name, exc.what());
+        status = 1;
+    }
+    _exit(status);
+}
+
+
+// RunBenchmark -- run bench in a child process
+// Returns false if the child failed.
+
+static bool
+RunBenchmark (const Benchmark& bench, const BenchContext& ctx, int runs,
+              /*out*/ Measurement* meas)
+{
+    int  fds[2];
+    if (pipe(fds) != 0)
+        FatalError("cannot create pipe: %s", strerror(errno));
+    fflush(Null);
+
+    pid_t  pid = fork();
+    if (pid < 0)
+        FatalError("cannot fork: %s", strerror(errno));
+    if (pid == 0) {
+        close(fds[0]);
+        RunChild(bench, ctx, runs, fds[1]);
+    }
+
+    close(fds[1]);
+    BenchResult  res;
+    ssize_t  nread = read(fds[0], &res, sizeof res);
+    close(fds[0]);
+
+    int  status;
+    struct rusage  usage;
+    if (wait4(pid, &status, 0, &usage) < 0)
+        FatalError("wait4 failed: %s", strerror(errno));
+    if (! WIFEXITED(status)  ||  WEXITSTATUS(status) != 0
+            ||  nread != ssize_t(sizeof res))
+        return false;
+
+    meas->name = bench.name;
+    meas->kind = bench.kind;
+    meas->result = res;
+    meas->peakRssKB = usage.ru_maxrss;  // kilobytes on Linux
+    return true;
+}
+
+
+static void
+WriteJSON (FILE* fp, const vector<Measurement>& meas, const BenchContext& ctx)
+{
+    fprintf(fp, "{\"version\": 1, \"input\": \"%s\", \"benchmarks\": [\n",
+            ctx.infilename ? ctx.infilename : "");
+    for (size_t j = 0;  j < meas.size();  ++j) {
+        const Measurement&  m = meas[j];
+        fprintf(fp, "  {\"name\": \"%s\", \"kind\": \"%s\", "
+                    "\"seconds\": %.6f, \"bytes\": %llu, \"records\": %llu, "
+                    "\"mb_per_s\": %.3f, \"records_per_s\": %.1f, "
+                    "\"peak_rss_kb\": %ld}%s\n",
+                m.name.c_str(), m.kind.c_str(), m.result.seconds,
+                m.result.bytes, m.result.records,
+                m.mbPerSec(), m.recordsPerSec(), m.peakRssKB,
+                (j + 1 < meas.size()) ? "," : "");
+    }
+    fprintf(fp, "]}\n");
+}
+
+
+// FindNumber -- value of "key": in line, or -1 if absent
+static double
+FindNumber (const string& line, const char* key)
+{
+    string  pat = string("\"") + key + "\": ";
+    size_t  pos = line.find(pat);
+    if (pos == string::npos)
+        return -1;
+    return strtod(line.c_str() + pos + pat.size(), Null);
+}
+
+
+// ReadBaseline -- read a file written by WriteJSON()
+// Relies on WriteJSON() putting each benchmark on a line of its own.
+
+static void
+ReadBaseline (const char* fname, /*out*/ vector<Measurement>* meas)
+{
+    FILE*  fp = fopen(fname, "r");
+    if (fp == Null)
+        FatalError("cannot open '%s': %s", fname, strerror(errno));
+
+    char  buf[1024];
+    while (fgets(buf, sizeof buf, fp) != Null) {
+        string  line(buf);
+        const string  namePat = "\"name\": \"";
+        size_t  pos = line.find(namePat);
+        if (pos == string::npos)
+            continue;
+        pos += namePat.size();
+        Measurement  m;
+        m.name = line.substr(pos, line.find('"', pos) - pos);
+        m.result.seconds = FindNumber(line, "seconds");
+        m.result.bytes   = Ullong(FindNumber(line, "bytes"));
+        m.result.records = Ullong(FindNumber(line, "records"));
+        m.peakRssKB      = long(FindNumber(line, "peak_rss_kb"));
+        meas->push_back(m);
+    }
+    fclose(fp);
+}
+
+
+// Compare -- print how meas compares with baseline
+// Throughput is records/s, or MB/s for benchmarks that count bytes.
+// Returns the number of regressions.
+
+static int
+Compare (const vector<Measurement>& meas, const vector<Measurement>& baseline,
+         double threshold)
+{
+    int  regressions = 0;
+    fprintf(stderr, "%-20s %14s %14s %8s %10s %10s\n", "benchmark",
+            "baseline", "current", "change", "base-RSS", "RSS");
+    for (size_t j = 0;  j < meas.size();  ++j) {
+        const Measurement&  cur = meas[j];
+        const Measurement*  base = Null;
+        for (size_t k = 0;  k < baseline.size();  ++k)
+            if (baseline[k].name == cur.name)
+                base = &baseline[k];
+        if (base == Null) {
+            fprintf(stderr, "%-20s %14s\n", cur.name.c_str(), "(new)");
+            continue;
+        }
+
+        bool  useBytes = (cur.result.bytes != 0);
+        double  was = useBytes ? base->mbPerSec() : base->recordsPerSec();
+        double  now = useBytes ? cur.mbPerSec() : cur.recordsPerSec();
+        double  change = (was > 0) ? (now - was) / was * 100 : 0;
+        bool  slower = (change < -threshold);
+        bool  bigger = (base->peakRssKB > 0
+                        &&  cur.peakRssKB > base->peakRssKB
+                                            * (1 + threshold/100));
+        fprintf(stderr, "%-20s %11.1f %s %11.1f %s %+7.1f%% %10ld %10ld%s\n",
+                cur.name.c_str(), was, useBytes ? "MB/s" : "r/s ",
+                now, useBytes ? "MB/s" : "r/s ", change,
+                base->peakRssKB, cur.peakRssKB,
+                slower ? "  REGRESSED" : bigger ? "  RSS GREW" : "");
+        if (slower  ||  bigger)
+            ++regressions;
+    }
+    return regressions;
+}
+
+
+// Selected -- true if name contains one of the comma-separated patterns
+static bool
+Selected (const char* name, const char* patterns)
+{
+    if (patterns == Null)
+        return true;
+    string  pats(patterns);
+    size_t  pos = 0;
+    while (pos <= pats.size()) {
+        size_t  comma = pats.find(',', pos);
+        if (comma == string::npos)
+            comma = pats.size();
+        string  pat = pats.substr(pos, comma - pos);
+        if (! pat.empty()  &&  strstr(name, pat.c_str()) != Null)
+            return true;
+        pos = comma + 1;
+    }
+    return false;
+}
+
+
+int
+main (int argc, char* argv[])
+{
+    SetProgramName(argv[0]);
+
+    int  runs = 5;
+    const char*  patterns = Null;
+    const char*  outfilename = Null;
+    const char*  baselineName = Null;
+    double  threshold = 10;
+
+    int  opt;
+    opterr = 0;
+    while ((opt = getopt(argc, argv, "B:k:n:o:T:")) != EOF) {
+        switch (opt) {
+            case 'B':  baselineName = optarg;           break;
+            case 'k':  patterns = optarg;               break;
+            case 'n':  runs = atoi(optarg);             break;
+            case 'o':  outfilename = optarg;            break;
+            case 'T':  threshold = atof(optarg);        break;
+            default:   UsageError();
+        }
+    }
+    if (optind < argc-1  ||  runs < 1  ||  threshold < 0)
+        UsageError();
+
+    BenchContext  ctx;
+    ctx.infilename = (optind < argc) ? argv[optind] : Null;
+    const char*  tmpdir = getenv("TMPDIR");
+    ctx.tempDir = (tmpdir != Null  &&  *tmpdir != '\0') ? tmpdir : "/tmp";
+
+    vector<Measurement>  meas;
+    int  failures = 0;
+    for (size_t j = 0;  j < NumBenchmarks;  ++j) {
+        const Benchmark&  bench = Benchmarks[j];
+        if (! Selected(bench.name, patterns))
+            continue;
+        if (bench.needsInput  &&  ctx.infilename == Null)
+            continue;
+        Measurement  m;
+        if (RunBenchmark(bench, ctx, runs, &m))
+            meas.push_back(m);
+        else {
+            Error("benchmark %s failed", bench.name);
+            ++failures;
+        }
+    }
+
+    FILE*  fp = stdout;
+    if (outfilename != Null  &&  (fp = fopen(outfilename, "w")) == Null)
+        FatalError("cannot open '%s': %s", outfilename, strerror(errno));
+    WriteJSON(fp, meas, ctx);
+    if (fclose(fp) == EOF)
+        FatalError("cannot close '%s': %s",
+                   outfilename ? outfilename : "standard output",
+                   strerror(errno));
+
+    int  regressions = 0;
+    if (baselineName != Null) {
+        vector<Measurement>  baseline;
+        ReadBaseline(baselineName, &baseline);
+        regressions = Compare(meas, baseline, threshold);
+    }
+    if (failures != 0)
+        return 1;
+    return (regressions != 0) ? 2 : 0;
+}
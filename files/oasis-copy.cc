@@ -11,6 +11,12 @@
  6. [STRICT_ON_OFF::OASISCOPY]  
  7. [STRICT_ON_OFF::CREATOR] 
  8. [CELLS_HIERARCHY::PARSER]  
+ 9. [TEE_BUILDER]
+10. [PIPELINE_BUILDER]
+11. [PARALLEL_CBLOCK]
+12. [REP_SYNTH]
+13. [MODAL_ORDER]
+14. [LAYER_FILTER]
 
 
  usage:  oasis-copy [-c cellname] [-lntvxizh] input-oasis-file output-oasis-file
@@ -22,26 +28,59 @@
 #include <cstdlib>
 #include <cstring>
 #include <exception>
+#include <memory>
 #include <unistd.h>
 #include <iostream>
 
 #include "misc/utils.h"
 #include "creator.h"
 #include "parser.h"
+#include "validator.h"
+#include "layoutbuilder.h"
+#include "analyzer.h"
+#include "tee-builder.h"
+#include "pipeline-builder.h"
+#include "rep-synth.h"
+#include "modal-order.h"
+#include "cursor-feed.h"
 
 
 using namespace std;
 using namespace Anuvad::SoftJin;
 using namespace Anuvad::Oasis;
 
+// layoutbuilder.h declares its classes in the top-level Oasis namespace,
+// and Servers/analyzer.h in Oasis::Jeong.
+using ::Oasis::JLayoutBuilder;
+using ::Oasis::Jeong::OasisStatistics;
+using ::Oasis::Jeong::OasisStatisticsBuilder;
+using ::Oasis::Jeong::OasisStructureAnalyzer;
+using ::Oasis::Jeong::CSVWriter;
+
 
 const char  UsageMessage[] =
-"usage:  %s [-c cellname] [-ilntvx] input-oasis-file output-oasis-file\n"
+"usage:  %s [-c cellname] [-w x0,y0,x1,y1] [-L layers] [-Z threads]\n"
+"            [-a csvfile] [-BbijklmnOpRrtvx]\n"
+"            input-oasis-file output-oasis-file\n"
 "Options:\n"
+"    -a csvfile\n"
+"        Also gather statistics on the input while copying it, as\n"
+"        oasis-analysis does, and write them to csvfile.  Not with -c.\n"
+"        Cell offsets and the file size are not gathered.\n"
+"\n"
+"    -B  Also compute the bounding box of every cell while copying,\n"
+"        and print the layout information.  Not with -c.\n"
+"\n"
+"    -b  Check the validation signature in the END record on other\n"
+"        threads while parsing.  Costs little more than -v.\n"
+"\n"
 "    -c cellname\n"
 "        Select cell.  Create binary stream for only the specified cell.\n"
 "        The default is to create the entire file.\n"
 "\n"
+"    -j  With -a or -B, give the copy and each of the other consumers\n"
+"        its own thread, so that a slow one does not hold up the rest.\n"
+"\n"
 "    -i  Write name records immediately to the file.\n"
 "        Use this option if you need to ensure compatibility with\n"
 "        tools that require names to appear before their references.\n"
@@ -49,14 +88,53 @@ const char  UsageMessage[] =
 "\n"
 "    -l  Ignore LAYERNAME records.\n"
 "\n"
+"    -L layers\n"
+"        Copy only elements on these layers.  layers is L, L-L, L/D,\n"
+"        L-L/D-D and so on, or a name from the LAYERNAME records.\n"
+"        May be repeated.  Not with -b or -c.  The input is read\n"
+"        with a cursor that does not pass on properties, XELEMENT\n"
+"        records, or name records other than cell and text names,\n"
+"        so the copy has none of them.\n"
+"\n"
+"    -k  Keep an index of cell offsets in <infile>.idx and use it with\n"
+"        -c, so that later runs need not read the whole input file.\n"
+"\n"
+"    -m  Also map the input file into memory.  The parser still reads\n"
+"        it, but prefetches each cell's pages and, with -c, copies\n"
+"        cells it can without decoding them.  Faster for very large\n"
+"        files, especially with -c.\n"
+"\n"
 "    -n  Do not insist on strict conformance to the OASIS specification.\n"
 "        The default is to abort for (almost) any deviation.\n"
 "\n"
+"    -O  Reorder the elements of each cell so that consecutive ones\n"
+"        share layers, sizes and repetitions, which the writer can\n"
+"        then omit.  Prints the estimated saving.\n"
+"\n"
+"    -p  Run the builders on a second thread, fed by the parser\n"
+"        through a ring of decoded elements, so that decoding and\n"
+"        writing overlap.\n"
+"\n"
+"    -R  Fold identical elements without repetitions into records\n"
+"        with repetitions, e.g. rows of rectangles into one matrix.\n"
+"        Elements are written in a different order within each cell.\n"
+"\n"
+"    -r  With -c, report how much of the input was parsed and skipped.\n"
+"\n"
 "    -t  Ignore TEXT and TEXTSTRING records.\n"
 "\n"
 "    -v  Ignore the validation scheme and signature in the END record.\n"
 "\n"
+"    -w x0,y0,x1,y1\n"
+"        With -c, copy only what can be seen through this window of the\n"
+"        first cell named, in database units.  Cells and elements that\n"
+"        cannot meet the window are skipped.\n"
+"\n"
 "    -x  Ignore XNAME, XELEMENT, and XGEOMETRY records.\n"
+"\n"
+"    -Z threads\n"
+"        Compress the output cells on this many background threads\n"
+"        instead of inline.  Not with -i or -z.\n"
 "\n";
 
 
@@ -73,6 +151,14 @@ DisplayWarning (const char* msg) {
 }
 
 
+/** [TEE_BUILDER]
+ *  ADD
+ *   - -B에서 JLayoutBuilder의 출력 대상.  복사는 OasisCreator가 하므로
+ *     JLayoutBuilder가 endFile()에서 생성하는 binary는 버린다.
+ */
+class DiscardBuilder : public OasisBuilder { };
+
+
 
 int
 main (int argc, char* argv[])
@@ -90,11 +176,29 @@ main (int argc, char* argv[])
      */
     OasisCreatorOptions creatorOptions(false, true, false, true);
     bool isCellNames = false;
+    bool wantReport = false;    // [PRUNED_EXTRACT]
+    bool haveWindow = false;    // [WINDOW_PARSE]
+    bool wantStats = false;     // [TEE_BUILDER]
+    const char*  statsFilename = Null;
+    bool wantBBoxes = false;
+    bool wantThreads = false;
+    bool wantPipeline = false;  // [PIPELINE_BUILDER]
+    bool wantRepetitions = false;   // [REP_SYNTH]
+    bool wantModalOrder = false;    // [MODAL_ORDER]
+    bool haveLayerFilter = false;   // [LAYER_FILTER]
+    LayerFilter  layerFilter;
+    BoundingBox  window;
 
     int  opt;
     opterr = 0;
-    while ((opt = getopt(argc, argv, "c:lntvxizs")) != EOF) {
+    while ((opt = getopt(argc, argv, "a:Bbc:jklL:mnOpRrtvw:xizsZ:")) != EOF) {
         switch (opt) {
+            case 'a':                                   // [TEE_BUILDER]
+                wantStats = true;
+                statsFilename = optarg;
+                break;
+            case 'B':  wantBBoxes                      = true;    break;
+            case 'b':  parserOptions.validateInBackground = true; break;
             case 'c': 
             {
                 enteredCellNames.emplace_back(optarg); // 첫 번째 셀 이름 추가
@@ -103,14 +207,38 @@ main (int argc, char* argv[])
                 }
                 break;
             }
+            case 'j':  wantThreads                     = true;    break;
+            case 'k':  parserOptions.useCellIndex      = true;    break;
             case 'l':  parserOptions.wantLayerName     = false;   break;
+            case 'L':                                   // [LAYER_FILTER]
+                if (! layerFilter.addSpec(optarg))
+                    UsageError();
+                haveLayerFilter = true;
+                break;
+            case 'm':  parserOptions.useMappedInput    = true;    break;
             case 'n':  parserOptions.strictConformance = false;   break;
+            case 'O':  wantModalOrder                  = true;    break;
+            case 'p':  wantPipeline                    = true;    break;
+            case 'R':  wantRepetitions                 = true;    break;
+            case 'r':  wantReport                      = true;    break;
             case 't':  parserOptions.wantText          = false;   break;
             case 'v':  parserOptions.wantValidation    = false;   break;
+            case 'w':                                   // [WINDOW_PARSE]
+                if (sscanf(optarg, "%ld,%ld,%ld,%ld", &window.xmin,
+                           &window.ymin, &window.xmax, &window.ymax) != 4
+                        ||  window.isEmpty())
+                    UsageError();
+                haveWindow = true;
+                break;
             case 'x':  parserOptions.wantExtensions    = false;   break;
             case 'i':  creatorOptions.immediateNames   = true;    break;
             case 'z':  creatorOptions.mustCompressed   = false;   break;
             case 's':  creatorOptions.strict           = false;   break;
+            case 'Z':                                   // [PARALLEL_CBLOCK]
+                creatorOptions.compressThreads = strtoul(optarg, Null, 10);
+                if (creatorOptions.compressThreads == 0)
+                    UsageError();
+                break;
             default:   UsageError();
         }
     }
@@ -119,6 +247,17 @@ main (int argc, char* argv[])
 
     if (optind != argc-2)   // 수정 : 입력 및 출력 파일 모두 필요
         UsageError();
+    if (haveWindow  &&  !isCellNames)
+        UsageError();
+    if ((wantStats || wantBBoxes)  &&  isCellNames)
+        UsageError();
+    if (haveLayerFilter
+            &&  (isCellNames  ||  parserOptions.validateInBackground))
+        UsageError();
+    if (creatorOptions.compressThreads != 0     // [PARALLEL_CBLOCK]
+            &&  (creatorOptions.immediateNames
+                 ||  !creatorOptions.mustCompressed))
+        UsageError();
 
     const char*  infilename  = argv[optind];
     const char*  outfilename = argv[optind + 1];
@@ -127,12 +266,145 @@ main (int argc, char* argv[])
         OasisParser   parser(infilename, DisplayWarning, parserOptions);
         OasisCreator  creator(outfilename, creatorOptions);
 
-        if (!isCellNames) {  // 셀 이름이 지정되지 않은 경우
-            parser.parseFile(&creator);
-        } else if (!parser.JCreateLayoutDataBase(enteredCellNames, &creator)) {
+        /** [REP_SYNTH]
+         *  ADD
+         *   - -R: RepetitionSynthesizer가 creator 앞에서 같은 element를
+         *     repetition으로 묶는다.  이후의 output은 creator 대신 이것을
+         *     대상으로 한다.
+         *
+         *  [MODAL_ORDER]
+         *  ADD
+         *   - -O: ModalOrderBuilder가 creator 바로 앞에서 cell의 element를
+         *     modal variable 순서로 정렬한다.  -R과 함께면
+         *     synth -> order -> creator.
+         */
+        ModalOrderBuilder  modalOrder(&creator);
+        OasisBuilder*  output = &creator;
+        if (wantModalOrder)
+            output = &modalOrder;
+        RepetitionSynthesizer  synth(output);
+        if (wantRepetitions)
+            output = &synth;
+
+        /** [TEE_BUILDER]
+         *  ADD
+         *   - -a, -B: 한 번의 parse로 복사, 통계, BBox 계산을 함께 수행.
+         *     TeeBuilder가 각 호출을 creator, stats, layoutBuilder에 전달.
+         *     통계는 oasis-analysis의 OasisStatisticsBuilder로 모은다.
+         *   - -j: 각 builder가 자신의 thread에서 bounded queue로 호출을 받음.
+         *     Repetition은 tee가 parser thread에서 batch(call-batch.h)의
+         *     cache에 intern해서 보낸다.  parser의 RepetitionCache는 parser thread만 쓰므로
+         *     stats, layoutBuilder와 공유하지 않는다.  -p도 마찬가지.
+         */
+        TeeBuilder  tee(wantThreads);
+        std::unique_ptr<OasisStatistics>  statistics;
+        std::unique_ptr<CSVWriter>  statsWriter;
+        std::unique_ptr<OasisStatisticsBuilder>  stats;
+        DiscardBuilder  discard;
+        JLayoutBuilder  layoutBuilder(discard);
+        OasisBuilder*  target = output;
+        if (wantStats || wantBBoxes) {
+            tee.addBuilder(output);
+            if (wantStats) {
+                statistics.reset(new OasisStatistics(infilename));
+                statsWriter.reset(new CSVWriter(statsFilename != Null
+                                                ? statsFilename : ""));
+                stats.reset(new OasisStatisticsBuilder(*statistics,
+                                                       *statsWriter));
+                if (!wantThreads  &&  !wantPipeline)
+                    stats->setRepetitionCache(parser.getRepetitionCache());
+                tee.addBuilder(stats.get());
+            }
+            if (wantBBoxes) {
+                if (!wantThreads  &&  !wantPipeline)
+                    layoutBuilder.setRepetitionCache(
+                        parser.getRepetitionCache());
+                tee.addBuilder(&layoutBuilder);
+            }
+            target = &tee;
+        }
+
+        /** [PIPELINE_BUILDER]
+         *  ADD
+         *   - -p: parser thread는 호출을 CallBatch에 기록하고
+         *     builder thread가 target에 replay.  parser가 pipe보다 먼저
+         *     생성되므로 name pointer는 endFile()까지 유효.  Repetition은
+         *     batch의 cache에 intern되고 batch와 함께 비워진다.
+         *   - -c, -w에서도 parser는 output이 아니라 target을 호출한다.
+         */
+        std::unique_ptr<PipelineBuilder>  pipe;
+        if (wantPipeline) {
+            pipe.reset(new PipelineBuilder(target));
+            target = pipe.get();
+        }
+
+        /** [PARALLEL_VALIDATE]
+         *  UPDATE
+         *   - -b: parseFile() 동안 FileValidator가 다른 thread에서 검사
+         *
+         *  [LAYER_FILTER]
+         *  ADD
+         *   - -L: parser 대신 OasisCursor가 layer filter를 적용하며 읽고
+         *     CursorFeeder가 target을 호출.  cursor와 feeder는 target의
+         *     endFile()이 끝날 때까지 유지된다.
+         */
+        if (haveLayerFilter) {
+            OasisCursor  cursor(infilename);
+            cursor.setLayerFilter(layerFilter);
+            CursorFeeder  feeder(cursor, target);
+            if (!parserOptions.wantText)
+                feeder.ignoreText();
+            if (!parserOptions.wantExtensions)
+                feeder.ignoreExtensions();
+            feeder.feedFile(parser.parseValidation().scheme);
+        } else if (!isCellNames  &&  parserOptions.validateInBackground
+                &&  parserOptions.wantValidation) {
+            Validation  val = parser.parseValidation();
+            FileValidator  validator(infilename);
+            validator.start(val.scheme);
+            parser.parseFile(target);
+            validator.check(val);
+        } else if (!isCellNames) {  // 셀 이름이 지정되지 않은 경우
+            parser.parseFile(target);
+        } else if (haveWindow) {    // [WINDOW_PARSE]
+            if (!parser.parseWindow(enteredCellNames[0].c_str(), window,
+                                    target))
+                FatalError("file '%s' has no cell '%s'", infilename,
+                           enteredCellNames[0].c_str());
+        } else if (!parser.JCreateLayoutDataBase(enteredCellNames, target)) {
             FatalError("file '%s' has no cell name you entered.", infilename);
         }
 
+        if (wantModalOrder)             // [MODAL_ORDER]
+            fprintf(stderr, "element order: about %llu bytes of modal "
+                    "fields before, %llu after\n",
+                    modalOrder.getBytesBefore(), modalOrder.getBytesAfter());
+        if (wantStats) {                // [TEE_BUILDER]
+            OasisStructureAnalyzer(*statistics).analyze(infilename);
+            stats->finalizeStatistics();
+        }
+        if (wantBBoxes) {
+            layoutBuilder.calculateAllCellBBoxes();
+            layoutBuilder.printLayoutInfo();
+        }
+
+        /** [PRUNED_EXTRACT]
+         *  ADD
+         */
+        if (isCellNames  &&  wantReport) {
+            const OasisExtractStats&  stats = parser.getExtractStats();
+            if (stats.pruned)
+                fprintf(stderr, "parsed %llu of %llu cells: "
+                        "%llu bytes, %llu records parsed; "
+                        "%llu bytes, %llu records skipped\n",
+                        stats.cellsParsed, stats.cellsInFile,
+                        stats.bytesParsed, stats.recordsParsed,
+                        stats.bytesSkipped, stats.recordsSkipped);
+            else
+                fprintf(stderr, "cell index unavailable; "
+                        "hierarchy was walked while parsing\n");
+        }
+
         if (fclose(stdout) == EOF)
             FatalError("cannot close standard output: %s", strerror(errno));
     }
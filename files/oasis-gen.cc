@@ -0,0 +1,730 @@
+// oasis/oasis-gen.cc -- generate synthetic OASIS files for benchmarking
+//
+// last modified:   2026/10/17
+//
+// usage:  oasis-gen [-d depth] [-f fanout] [-e elements] [-S size] ...
+//                   output-oasis-file
+//
+// oasis-gen writes a layout made up from a seed, so that the same
+// command line always gives the same file, byte for byte.  It drives
+// OasisCreator just as oasis-copy does, so every option of the writer
+// (CBLOCKs, strict tables, immediate names, validation) can be tested
+// against files of any size and shape.
+//
+// The hierarchy is built bottom-up.  Level 0 holds the leaf cells;
+// without -S there are -w of them, with -S leaf cells are added until
+// the output file reaches the requested size.  Each cell at level L
+// places -f cells of level L-1, taken round-robin so that every cell
+// below is placed at least once, and level `depth' is the single cell
+// TOP.  Each level has about 1/fanout as many cells as the one below.
+//
+// Leaf cells hold -e elements chosen by the weights of -M; the other
+// cells hold an eighth as many besides their placements.  -r percent
+// of elements and placements get a repetition, of a type chosen from
+// all eleven that OASIS defines.  Polygons and paths get 3 to -p
+// points; half are Manhattan, the rest all-angle.  Trapezoids are
+// sometimes 45-degree, so that OasisCreator writes them as CTRAPEZOID.
+//
+// The pseudo-random numbers come from our own generator rather than
+// from <random>, whose distributions differ between libraries.
+
+#include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "misc/utils.h"
+#include "creator.h"
+
+
+using namespace std;
+using namespace Anuvad::SoftJin;
+using namespace Anuvad::Oasis;
+
+
+const char  UsageMessage[] =
+"usage:  %s [-d depth] [-f fanout] [-w leaves] [-e elements] [-p points]\n"
+"            [-r percent] [-M mix] [-S size] [-g seed] [-V scheme] [-izs]\n"
+"            output-oasis-file\n"
+"Options:\n"
+"    -d depth     Levels of placements above the leaf cells.  Default 3.\n"
+"    -f fanout    Placements in each non-leaf cell.  Default 4.\n"
+"    -w leaves    Number of leaf cells when -S is not given.  Default 16.\n"
+"    -e elements  Elements in each leaf cell.  Default 1000.\n"
+"    -p points    Most points in a polygon or path.  Default 8.\n"
+"    -r percent   Percentage of elements and placements that have a\n"
+"                 repetition.  Default 10.\n"
+"\n"
+"    -M mix\n"
+"        Relative weights of the element kinds, as a comma-separated\n"
+"        list of kind=weight.  The kinds are rect, poly, path, trap,\n"
+"        circle and text.  Kinds not listed keep their default weight;\n"
+"        give 0 to omit one.  The default is\n"
+"            rect=60,poly=10,path=10,trap=5,circle=5,text=10\n"
+"\n"
+"    -S size\n"
+"        Add leaf cells until the file is at least this big.  The size\n"
+"        may end in K, M or G.  The file will be a little bigger, by the\n"
+"        last leaf cell, the cells above, and the name tables.\n"
+"\n"
+"    -g seed      Seed for the pseudo-random numbers.  Default 1.\n"
+"\n"
+"    -V scheme    Validation scheme: none, crc32 or checksum32.\n"
+"                 Default crc32.\n"
+"\n"
+"    -i  Write name records immediately to the file.\n"
+"\n"
+"    -z  Do not compress cells and name tables in CBLOCKs.\n"
+"\n"
+"    -s  Do not write strict name tables.\n"
+"\n";
+
+
+static void
+UsageError() {
+    fprintf(stderr, UsageMessage, GetProgramName());
+    exit(1);
+}
+
+
+
+//----------------------------------------------------------------------
+// Random -- deterministic pseudo-random numbers (SplitMix64)
+
+class Random {
+    Ullong      state;
+public:
+    explicit    Random (Ullong seed) : state(seed) { }
+
+    Ullong
+    next() {
+        Ullong  z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return (z ^ (z >> 31));
+    }
+
+    // below -- uniform in [0, n).  n must be positive.
+    Ulong       below (Ulong n)         { return Ulong(next() % n); }
+
+    // between -- uniform in [lo, hi]
+    long        between (long lo, long hi) {
+                    return lo + long(below(Ulong(hi - lo) + 1));
+                }
+
+    bool        chance (Uint percent)   { return (below(100) < percent); }
+};
+
+
+
+//----------------------------------------------------------------------
+// Corpus description
+
+enum ShapeKind {
+    SK_Rectangle, SK_Polygon, SK_Path, SK_Trapezoid, SK_Circle, SK_Text,
+    NumShapeKinds
+};
+
+const char*  ShapeKindNames[NumShapeKinds] = {
+    "rect", "poly", "path", "trap", "circle", "text"
+};
+
+
+struct CorpusOptions {
+    Uint        depth;
+    Uint        fanout;
+    Ulong       numLeaves;
+    Ulong       elementsPerLeaf;
+    Ulong       maxPoints;
+    Uint        repPercent;
+    Uint        weights[NumShapeKinds];
+    Ullong      targetSize;             // 0 => use numLeaves
+    Ullong      seed;
+    Validation::Scheme  valScheme;
+
+    CorpusOptions() {
+        depth = 3;
+        fanout = 4;
+        numLeaves = 16;
+        elementsPerLeaf = 1000;
+        maxPoints = 8;
+        repPercent = 10;
+        weights[SK_Rectangle] = 60;
+        weights[SK_Polygon]   = 10;
+        weights[SK_Path]      = 10;
+        weights[SK_Trapezoid] = 5;
+        weights[SK_Circle]    = 5;
+        weights[SK_Text]      = 10;
+        targetSize = 0;
+        seed = 1;
+        valScheme = Validation::CRC32;
+    }
+};
+
+
+// Extent in database units of the area a leaf cell's elements occupy.
+// Each level above doubles it.
+
+const long  LeafExtent     = 100000;
+const Ulong NumLayers      = 8;
+const Ulong NumDatatypes   = 4;
+const Ulong NumTextStrings = 64;
+const Ulong MaxRepDimen    = 8;
+
+
+
+//----------------------------------------------------------------------
+// CorpusGenerator -- writes one corpus through an OasisCreator
+
+class CorpusGenerator {
+    const CorpusOptions&  options;
+    const char*         fname;
+    OasisCreator&       creator;
+    Random              random;
+    Uint                totalWeight;
+
+    // OasisCreator does not take over names; they must live until
+    // endFile() returns.
+    vector<unique_ptr<CellName> >   cellNames;
+    vector<unique_ptr<TextString> > textStrings;
+
+    PointList           ptlist;         // scratch
+    Repetition          rep;            // scratch
+
+public:
+                CorpusGenerator (const CorpusOptions& options,
+                                 const char* fname, OasisCreator& creator);
+    void        generate();
+
+private:
+    CellName*   newCellName (Uint level, Ulong index);
+    void        makeCell (CellName* cellName, Uint level,
+                          const vector<CellName*>& children,
+                          Ulong firstChild);
+    void        makeElement (long extent);
+    const Repetition*  maybeRepetition();
+    void        makeRepetition();
+    void        makeManhattanPoints (Ulong npoints, bool closed);
+    void        makeAnyAnglePoints (Ulong npoints, bool closed);
+    Ullong      currentFileSize() const;
+
+private:
+                CorpusGenerator (const CorpusGenerator&);   // forbidden
+    void        operator= (const CorpusGenerator&);         // forbidden
+};
+
+
+CorpusGenerator::CorpusGenerator (const CorpusOptions& options,
+                                  const char* fname, OasisCreator& creator)
+  : options(options),
+    fname(fname),
+    creator(creator),
+    random(options.seed)
+{
+    totalWeight = 0;
+    for (int j = 0;  j < NumShapeKinds;  ++j)
+        totalWeight += options.weights[j];
+}
+
+
+// generate -- write the whole file
+// Leaf cells come first so that, with -S, the number of leaves need
+// not be known in advance.  Each level up is then sized from the one
+// below.
+
+void
+CorpusGenerator::generate()
+{
+    creator.beginFile("1.0", Oreal(1000), options.valScheme);
+
+    for (Ulong j = 0;  j < NumTextStrings;  ++j)
+        textStrings.emplace_back(new TextString("T" + to_string(j)));
+
+    vector<CellName*>  below, level;
+    vector<CellName*>  noChildren;
+    for (Ulong j = 0;  ;  ++j) {
+        if (options.targetSize == 0) {
+            if (j == options.numLeaves)
+                break;
+        } else if (j > 0  &&  currentFileSize() >= options.targetSize)
+            break;
+        CellName*  cellName = newCellName(0, j);
+        makeCell(cellName, 0, noChildren, 0);
+        below.push_back(cellName);
+    }
+
+    for (Uint lev = 1;  lev <= options.depth;  ++lev) {
+        Ulong  count = (lev == options.depth)
+                            ? 1
+                            : (below.size() + options.fanout - 1)
+                                  / options.fanout;
+        level.clear();
+        for (Ulong j = 0;  j < count;  ++j) {
+            CellName*  cellName = newCellName(lev, j);
+            // The top cell places every cell of the level below.
+            if (lev == options.depth) {
+                creator.beginCell(cellName);
+                for (Ulong k = 0;  k < below.size();  ++k) {
+                    long  x = long(k % 64) * (LeafExtent << lev);
+                    long  y = long(k / 64) * (LeafExtent << lev);
+                    creator.beginPlacement(below[k], x, y, Oreal(1),
+                                           Oreal(0), false, Null);
+                }
+                creator.endCell();
+            } else
+                makeCell(cellName, lev, below, j * options.fanout);
+            level.push_back(cellName);
+        }
+        below.swap(level);
+    }
+
+    creator.endFile();
+}
+
+
+CellName*
+CorpusGenerator::newCellName (Uint level, Ulong index)
+{
+    string  name = (level == options.depth && level > 0)
+                       ? string("TOP")
+                       : "L" + to_string(level) + "_" + to_string(index);
+    cellNames.emplace_back(new CellName(name));
+    return cellNames.back().get();
+}
+
+
+// makeCell -- write one cell
+// A non-leaf cell places options.fanout cells of children, starting
+// at firstChild and wrapping around.
+
+void
+CorpusGenerator::makeCell (CellName* cellName, Uint level,
+                           const vector<CellName*>& children,
+                           Ulong firstChild)
+{
+    long  extent = LeafExtent << level;
+
+    creator.beginCell(cellName);
+    if (! children.empty()) {
+        for (Uint j = 0;  j < options.fanout;  ++j) {
+            CellName*  child = children[(firstChild + j) % children.size()];
+            long  x = random.between(0, extent - 1);
+            long  y = random.between(0, extent - 1);
+            Oreal  angle(double(90 * random.below(4)));
+            bool  flip = (random.below(8) == 0);
+            creator.beginPlacement(child, x, y, Oreal(1), angle, flip,
+                                   maybeRepetition());
+        }
+    }
+
+    Ulong  nelems = (level == 0) ? options.elementsPerLeaf
+                                 : options.elementsPerLeaf / 8;
+    for (Ulong j = 0;  j < nelems;  ++j)
+        makeElement(extent);
+    creator.endCell();
+}
+
+
+// makeElement -- write one element of a kind chosen by the weights
+
+void
+CorpusGenerator::makeElement (long extent)
+{
+    if (totalWeight == 0)
+        return;
+
+    Uint  pick = random.below(totalWeight);
+    int  kind = 0;
+    while (pick >= options.weights[kind]) {
+        pick -= options.weights[kind];
+        ++kind;
+    }
+
+    Ulong  layer    = random.below(NumLayers);
+    Ulong  datatype = random.below(NumDatatypes);
+    long   x = random.between(0, extent - 1);
+    long   y = random.between(0, extent - 1);
+
+    switch (kind) {
+        case SK_Rectangle: {
+            long  width = random.between(10, 2000);
+            // One in four is square so that the S bit gets used.
+            long  height = random.chance(25) ? width
+                                             : random.between(10, 2000);
+            creator.beginRectangle(layer, datatype, x, y, width, height,
+                                   maybeRepetition());
+            break;
+        }
+
+        case SK_Polygon: {
+            Ulong  npoints = random.between(3, long(options.maxPoints));
+            if (random.chance(50))
+                makeManhattanPoints(npoints, true);
+            else
+                makeAnyAnglePoints(npoints, true);
+            creator.beginPolygon(layer, datatype, x, y, ptlist,
+                                 maybeRepetition());
+            break;
+        }
+
+        case SK_Path: {
+            Ulong  npoints = random.between(2, long(options.maxPoints));
+            if (random.chance(50))
+                makeManhattanPoints(npoints, false);
+            else
+                makeAnyAnglePoints(npoints, false);
+            long  halfwidth = random.between(5, 100);
+            long  extn = random.chance(50) ? 0 : halfwidth;
+            creator.beginPath(layer, datatype, x, y, halfwidth, extn, extn,
+                              ptlist, maybeRepetition());
+            break;
+        }
+
+        case SK_Trapezoid: {
+            // Keep the short side positive.  A 45-degree trapezoid with
+            // one slanted side fits a CTRAPEZOID type.
+            bool  vertical = random.chance(50);
+            long  width  = random.between(100, 2000);
+            long  height = random.between(100, 2000);
+            long  length = vertical ? height : width;
+            long  across = vertical ? width : height;
+            long  deltaA, deltaB;
+            if (across <= length/2  &&  random.chance(50)) {
+                deltaA = across;
+                deltaB = 0;
+            } else {
+                deltaA = random.between(0, length/3);
+                deltaB = -random.between(0, length/3);
+            }
+            Trapezoid  trap(vertical ? Trapezoid::Vertical
+                                     : Trapezoid::Horizontal,
+                            width, height, deltaA, deltaB);
+            creator.beginTrapezoid(layer, datatype, x, y, trap,
+                                   maybeRepetition());
+            break;
+        }
+
+        case SK_Circle:
+            creator.beginCircle(layer, datatype, x, y,
+                                random.between(5, 500), maybeRepetition());
+            break;
+
+        case SK_Text:
+            creator.beginText(layer, datatype, x, y,
+                              textStrings[random.below(NumTextStrings)].get(),
+                              maybeRepetition());
+            break;
+    }
+}
+
+
+// maybeRepetition -- a repetition for options.repPercent of the calls
+// Returns Null for the others.  The Repetition is overwritten by the
+// next call.
+
+const Repetition*
+CorpusGenerator::maybeRepetition()
+{
+    if (! random.chance(options.repPercent))
+        return Null;
+    makeRepetition();
+    return &rep;
+}
+
+
+// makeRepetition -- fill rep with a repetition of a random type
+// Every type in the spec except reuse-previous, which OasisCreator
+// writes by itself when a repetition is repeated.
+
+void
+CorpusGenerator::makeRepetition()
+{
+    static const RepetitionType  types[] = {
+        Rep_Matrix, Rep_UniformX, Rep_UniformY, Rep_VaryingX,
+        Rep_GridVaryingX, Rep_VaryingY, Rep_GridVaryingY,
+        Rep_TiltedMatrix, Rep_Diagonal, Rep_Arbitrary, Rep_GridArbitrary
+    };
+    const Ulong  numTypes = sizeof(types) / sizeof(types[0]);
+
+    Ulong  dimen = random.between(2, MaxRepDimen);
+    Ulong  grid  = random.between(2, 10);
+    long   space = random.between(100, 5000);
+
+    RepetitionType  type = types[random.below(numTypes)];
+    switch (type) {
+        case Rep_Matrix:
+            rep.makeMatrix(dimen, random.between(2, MaxRepDimen),
+                           space, random.between(100, 5000));
+            break;
+
+        case Rep_UniformX:
+            rep.makeUniformX(dimen, space);
+            break;
+
+        case Rep_UniformY:
+            rep.makeUniformY(dimen, space);
+            break;
+
+        case Rep_VaryingX:
+        case Rep_VaryingY:
+        case Rep_GridVaryingX:
+        case Rep_GridVaryingY: {
+            switch (type) {
+                case Rep_VaryingX:      rep.makeVaryingX(dimen);            break;
+                case Rep_GridVaryingX:  rep.makeGridVaryingX(dimen, grid);  break;
+                case Rep_VaryingY:      rep.makeVaryingY(dimen);            break;
+                default:                rep.makeGridVaryingY(dimen, grid);  break;
+            }
+            // Offsets are cumulative and, for the grid types, multiples
+            // of the grid.
+            Ulong  unit = (type == Rep_GridVaryingX
+                           ||  type == Rep_GridVaryingY) ? grid : 1;
+            long  offset = 0;
+            rep.addOffset(0);
+            for (Ulong j = 1;  j < dimen;  ++j) {
+                offset += random.between(1, 500) * long(unit);
+                rep.addOffset(offset);
+            }
+            break;
+        }
+
+        case Rep_TiltedMatrix:
+            rep.makeTiltedMatrix(dimen, random.between(2, MaxRepDimen),
+                                 Delta(space, random.between(-500, 500)),
+                                 Delta(random.between(-500, 500), space));
+            break;
+
+        case Rep_Diagonal:
+            rep.makeDiagonal(dimen, Delta(space, space));
+            break;
+
+        case Rep_Arbitrary:
+        case Rep_GridArbitrary: {
+            bool  gridded = (type == Rep_GridArbitrary);
+            if (gridded)
+                rep.makeGridArbitrary(dimen, grid);
+            else
+                rep.makeArbitrary(dimen);
+            long  unit = gridded ? long(grid) : 1;
+            Delta  pos(0, 0);
+            rep.addDelta(pos);
+            for (Ulong j = 1;  j < dimen;  ++j) {
+                pos.x += random.between(-500, 500) * unit;
+                pos.y += random.between(-500, 500) * unit;
+                rep.addDelta(pos);
+            }
+            break;
+        }
+
+        default:
+            assert (false);
+    }
+}
+
+
+// makeManhattanPoints -- fill ptlist with a staircase
+// For a polygon (closed true) the staircase is closed back along the
+// axes, which keeps it simple.  The first point is always (0,0).
+
+void
+CorpusGenerator::makeManhattanPoints (Ulong npoints, bool closed)
+{
+    ptlist.clear();
+    ptlist.push_back(Delta(0, 0));
+
+    long  x = 0, y = 0;
+    Ulong  steps = closed ? (npoints > 3 ? npoints - 2 : 2) : npoints - 1;
+    for (Ulong j = 0;  j < steps;  ++j) {
+        if (j % 2 == 0)
+            x += random.between(10, 500);
+        else
+            y += random.between(10, 500);
+        ptlist.push_back(Delta(x, y));
+    }
+    if (closed) {
+        if (steps % 2 != 0)             // last step was along x
+            ptlist.push_back(Delta(x, y += random.between(10, 500)));
+        ptlist.push_back(Delta(0, y));
+    }
+}
+
+
+// makeAnyAnglePoints -- fill ptlist with points around a circle
+// Sorted angles give a star-shaped, hence simple, polygon.  For a path
+// the points are a random walk.
+
+void
+CorpusGenerator::makeAnyAnglePoints (Ulong npoints, bool closed)
+{
+    ptlist.clear();
+    ptlist.push_back(Delta(0, 0));
+
+    if (! closed) {
+        long  x = 0, y = 0;
+        for (Ulong j = 1;  j < npoints;  ++j) {
+            x += random.between(-500, 500);
+            y += random.between(-500, 500);
+            ptlist.push_back(Delta(x, y));
+        }
+        return;
+    }
+
+    // Angles increase by at least a step and less than 2*pi in all.
+    double  step = 2 * M_PI / npoints;
+    long  x0 = 0, y0 = 0;
+    for (Ulong j = 0;  j < npoints;  ++j) {
+        double  angle = step * (j + random.below(1000) / 1000.0 * 0.9);
+        double  radius = double(random.between(50, 1000));
+        long  x = lround(radius * cos(angle));
+        long  y = lround(radius * sin(angle));
+        if (j == 0) {
+            x0 = x;
+            y0 = y;
+        } else
+            ptlist.push_back(Delta(x - x0, y - y0));
+    }
+}
+
+
+// currentFileSize -- bytes written to fname so far
+// OasisCreator buffers its output, so this lags behind by at most a
+// buffer, which does not matter for the sizes -S is meant for.
+
+Ullong
+CorpusGenerator::currentFileSize() const
+{
+    struct stat  st;
+    if (stat(fname, &st) != 0)
+        throw runtime_error(string("cannot stat '") + fname + "': "
+                            + strerror(errno));
+    return Ullong(st.st_size);
+}
+
+
+
+//----------------------------------------------------------------------
+// Option parsing
+
+
+// ParseCount -- parse a decimal number of at least minval
+static Ulong
+ParseCount (const char* arg, Ulong minval)
+{
+    char*  end;
+    errno = 0;
+    Ulong  val = strtoul(arg, &end, 10);
+    if (errno != 0  ||  end == arg  ||  *end != '\0'  ||  val < minval)
+        UsageError();
+    return val;
+}
+
+
+// ParseSize -- parse a size with an optional K, M or G suffix
+static Ullong
+ParseSize (const char* arg)
+{
+    char*  end;
+    errno = 0;
+    Ullong  val = strtoull(arg, &end, 10);
+    if (errno != 0  ||  end == arg  ||  val == 0)
+        UsageError();
+    switch (*end) {
+        case '\0':                      break;
+        case 'k': case 'K':  val <<= 10;  ++end;  break;
+        case 'm': case 'M':  val <<= 20;  ++end;  break;
+        case 'g': case 'G':  val <<= 30;  ++end;  break;
+        default:  UsageError();
+    }
+    if (*end != '\0')
+        UsageError();
+    return val;
+}
+
+
+// ParseMix -- parse the -M argument into weights
+static void
+ParseMix (const char* arg, /*inout*/ Uint* weights)
+{
+    string  spec(arg);
+    size_t  pos = 0;
+    while (pos <= spec.size()) {
+        size_t  comma = spec.find(',', pos);
+        if (comma == string::npos)
+            comma = spec.size();
+        string  item = spec.substr(pos, comma - pos);
+        size_t  eq = item.find('=');
+        if (eq == string::npos)
+            UsageError();
+
+        string  kind = item.substr(0, eq);
+        int  j = 0;
+        while (j < NumShapeKinds  &&  kind != ShapeKindNames[j])
+            ++j;
+        if (j == NumShapeKinds)
+            UsageError();
+        weights[j] = ParseCount(item.c_str() + eq + 1, 0);
+        pos = comma + 1;
+    }
+}
+
+
+int
+main (int argc, char* argv[])
+{
+    SetProgramName(argv[0]);
+
+    CorpusOptions  options;
+    OasisCreatorOptions  creatorOptions(false, true, false, true);
+
+    int  opt;
+    opterr = 0;
+    while ((opt = getopt(argc, argv, "d:e:f:g:iM:p:r:sS:V:w:z")) != EOF) {
+        switch (opt) {
+            case 'd':  options.depth = ParseCount(optarg, 0);             break;
+            case 'e':  options.elementsPerLeaf = ParseCount(optarg, 0);   break;
+            case 'f':  options.fanout = ParseCount(optarg, 1);            break;
+            case 'g':  options.seed = ParseCount(optarg, 0);              break;
+            case 'M':  ParseMix(optarg, options.weights);                 break;
+            case 'p':  options.maxPoints = ParseCount(optarg, 3);         break;
+            case 'r':  options.repPercent = ParseCount(optarg, 0);        break;
+            case 'S':  options.targetSize = ParseSize(optarg);            break;
+            case 'w':  options.numLeaves = ParseCount(optarg, 1);         break;
+            case 'V':
+                if (strcmp(optarg, "none") == 0)
+                    options.valScheme = Validation::None;
+                else if (strcmp(optarg, "crc32") == 0)
+                    options.valScheme = Validation::CRC32;
+                else if (strcmp(optarg, "checksum32") == 0)
+                    options.valScheme = Validation::Checksum32;
+                else
+                    UsageError();
+                break;
+            case 'i':  creatorOptions.immediateNames = true;    break;
+            case 'z':  creatorOptions.mustCompressed = false;   break;
+            case 's':  creatorOptions._strict        = false;   break;
+            default:   UsageError();
+        }
+    }
+    if (optind != argc-1  ||  options.repPercent > 100)
+        UsageError();
+
+    const char*  outfilename = argv[optind];
+
+    try {
+        OasisCreator  creator(outfilename, creatorOptions);
+        CorpusGenerator  generator(options, outfilename, creator);
+        generator.generate();
+    }
+    catch (const std::exception& exc) {
+        FatalError("%s", exc.what());
+    }
+    return 0;
+}
@@ -8,6 +8,8 @@
 #include "creator.h"
 #include "parser.h"
 #include "layoutbuilder.h"
+#include "rep-synth.h"
+#include "modal-order.h"
 
 #include "iostream"
 
@@ -16,17 +18,20 @@ using namespace SoftJin;
 using namespace Oasis;
 
 const char  UsageMessage[] =
-    "usage:  %s [-c cellname] [-ilntvxzs] input-oasis-file output-oasis-file\n"
+    "usage:  %s [-c cellname] [-Z threads] [-ilnORtvxzs] input-oasis-file output-oasis-file\n"
     "Options:\n"
     "    -c cellname   Select cell(s). Specify the name(s) of the cell(s) to process.\n"
     "    -i            Write name records immediately to the file.\n"
     "    -l            Ignore LAYERNAME records.\n"
     "    -n            Do not insist on strict conformance to the OASIS specification.\n"
+    "    -O            Reorder elements to share modal variables.\n"
+    "    -R            Fold identical elements into records with repetitions.\n"
     "    -t            Ignore TEXT and TEXTSTRING records.\n"
     "    -v            Ignore the validation scheme and signature in the END record.\n"
     "    -x            Ignore XNAME, XELEMENT, and XGEOMETRY records.\n"
     "    -z            Disable compression for the output file.\n"
     "    -s            Disable strict mode.\n"
+    "    -Z threads    Compress the output cells on this many background threads.\n"
     "Notes:\n"
     "    - The input and output files must have the '.oas' extension.\n";
 
@@ -84,10 +89,12 @@ int main(int argc, char* argv[]) {
     OasisParserOptions parserOptions;
     OasisCreatorOptions creatorOptions(false, true, false, true);
     bool isCellNames = false;
+    bool wantRepetitions = false;   // [REP_SYNTH]
+    bool wantModalOrder = false;    // [MODAL_ORDER]
 
     int opt;
     opterr = 0;
-    while ((opt = getopt(argc, argv, "c:lntvxizs")) != EOF) {
+    while ((opt = getopt(argc, argv, "c:lnORtvxizsZ:")) != EOF) {
         switch (opt) {
             case 'c': {
                 // 첫 번째 셀 이름 추가
@@ -101,12 +108,19 @@ int main(int argc, char* argv[]) {
             }
             case 'l':  parserOptions.wantLayerName     = false;   break;
             case 'n':  parserOptions.strictConformance = false;   break;
+            case 'O':  wantModalOrder                  = true;    break;
+            case 'R':  wantRepetitions                 = true;    break;
             case 't':  parserOptions.wantText          = false;   break;
             case 'v':  parserOptions.wantValidation    = false;   break;
             case 'x':  parserOptions.wantExtensions    = false;   break;
             case 'i':  creatorOptions.immediateNames   = true;    break;
             case 'z':  creatorOptions._mustCompressed  = false;   break;
             case 's':  creatorOptions._mustStrict      = false;   break;
+            case 'Z':  // [PARALLEL_CBLOCK]
+                creatorOptions.compressThreads = strtoul(optarg, nullptr, 10);
+                if (creatorOptions.compressThreads == 0)
+                    UsageError();
+                break;
             default:   UsageError();
         }
     }
@@ -125,9 +139,25 @@ int main(int argc, char* argv[]) {
     try {
         OasisParser parser(infilename, DisplayWarning, parserOptions);
         OasisCreator creator(outfilename, creatorOptions);
-        JLayoutBuilder layoutBuilder(creator);
+        // [REP_SYNTH] generateBinary() expands every repetition; -R
+        // folds the expanded elements back into repetitions.
+        // [MODAL_ORDER] It also writes them in unordered_map order; -O
+        // sorts them for the modal variables.
+        ModalOrderBuilder modalOrder(&creator);
+        OasisBuilder* output = &creator;
+        if (wantModalOrder)
+            output = &modalOrder;
+        RepetitionSynthesizer synth(output);
+        if (wantRepetitions)
+            output = &synth;
+        JLayoutBuilder layoutBuilder(*output);
+        layoutBuilder.setRepetitionCache(parser.getRepetitionCache());  // [REP_INTERN]
 
         parser.parseFile(&layoutBuilder);
+        if (wantModalOrder)
+            fprintf(stderr, "element order: about %llu bytes of modal "
+                    "fields before, %llu after\n",
+                    modalOrder.getBytesBefore(), modalOrder.getBytesAfter());
 
         layoutBuilder.calculateAllCellBBoxes();
 
@@ -1,57 +1,63 @@
 
 #include <map>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "mapped-file.h"
+#include "raw-cell.h"
+#include "cell-graph.h"
+#include "cell-index.h"
+#include "validator.h"
+#include "window-filter.h"
 
 /** _______________________________________________________________________________
  *
  *  [CELL_HIERARCHY]
  *  CREATE
  *  - TreeNode, HierarchyTree
+ *
+ *  [CELL_GRAPH]
+ *  UPDATE
+ *  - JTreeNode 삭제.  JCellHierarchy는 CellName에 발견 순서대로 node 번호를
+ *    붙이고 parse 여부만 기록한다.  PLACEMENT마다 string map 검색과 new를
+ *    하던 것을 pointer hash 한 번으로 바꾸었다.  edge는 기록하지 않는다:
+ *    index가 없을 때의 hierarchy는 parse하면서 발견되므로 JBeginAllCell()은
+ *    node 번호 순으로 훑으면 되고, 순서와 pruning이 필요한 곳은 cell index의
+ *    CellGraph(getCellGraph())를 쓴다.
  */
 
-class JTreeNode {
-    CellName* _cellName;
-    std::vector<JTreeNode*> _children;
-    bool _visited;
-
-public:
-    JTreeNode(CellName* name) : _cellName(name), _visited(false){}
-
-    void addChild(JTreeNode* child) {
-        _children.push_back(child);
-    }
-public:
-    bool getVisited() const { return _visited; }
-    void setVisited(bool newVisited) { _visited = newVisited; }
-
-    const std::vector<JTreeNode *> &getChildren() const {
-        return _children;
-    }
-
-    CellName *getCellName() const { return _cellName; }
-    void setCellName(CellName *newCellName) {
-        _cellName = newCellName;
-    }
-};
-
 class JCellHierarchy {
-public:
-    std::map<std::string, TreeNode*> _cellTreeMap;
+    std::unordered_map<const CellName*, Uint>  _nodes;
+    std::vector<CellName*>  _cellNames;     // by node
+    std::vector<bool>       _visited;       // by node
 
+public:
     // 노드를 찾거나 없으면 새로 생성하는 함수
-    JTreeNode* findOrCreateNode(CellName* cellName){
-        std::string name = cellName->getName();
-        if (_cellTreeMap.find(name) == _cellTreeMap.end()){
-            _cellTreeMap[name] = new JTreeNode(cellName);
+    Uint findOrCreateNode(CellName* cellName) {
+        std::pair<std::unordered_map<const CellName*, Uint>::iterator, bool>
+            ins = _nodes.insert(std::make_pair(cellName, Uint(_cellNames.size())));
+        if (ins.second) {
+            _cellNames.push_back(cellName);
+            _visited.push_back(false);
         }
-        return _cellTreeMap[name];
+        return ins.first->second;
     }
 
-    ~JCellHierarchy() {
-        for (auto& pair : _cellTreeMap){
-            delete pair.second;
-        }
+    // parent is the cell being parsed, which BeginCell() has added.
+    void addPlacement(const CellName* /*parent*/, CellName* child) {
+        (void) findOrCreateNode(child);
     }
+
+    Uint size() const { return _cellNames.size(); }
+    bool getVisited(Uint node) const { return _visited[node]; }
+    void setVisited(Uint node) { _visited[node] = true; }
+    CellName* getCellName(Uint node) const { return _cellNames[node]; }
 };
 
 /**  _______________________________________________________________________________*/
@@ -66,13 +72,33 @@ class ParserImpl {
     ModalVars           modvars;        // store all modal variables
 
     // Dictionaries for cells and the six types of names.
-    CellDict            cellDict;       // map from CellName* to Cell*
-    CellNameDict        cellNameDict;
-    PropNameDict        propNameDict;
-    PropStringDict      propStringDict;
-    TextStringDict      textStringDict;
-    XNameDict           xnameDict;
-    LayerNameDict       layerNameDict;
+
+    /** [PARALLEL_PARSE]
+     *  UPDATE
+     *   - The dictionaries now live in a NameDicts object that the
+     *     per-cell worker parsers of parseFileParallel() share with the
+     *     master parser.  The reference members keep the old names, so
+     *     the rest of ParserImpl is unchanged.  Workers only look names
+     *     up; all names and cell offsets exist before they start.
+     */
+    struct NameDicts {
+        CellDict            cellDict;       // map from CellName* to Cell*
+        CellNameDict        cellNameDict;
+        PropNameDict        propNameDict;
+        PropStringDict      propStringDict;
+        TextStringDict      textStringDict;
+        XNameDict           xnameDict;
+        LayerNameDict       layerNameDict;
+    };
+    std::shared_ptr<NameDicts>  dicts;
+
+    CellDict&           cellDict;
+    CellNameDict&       cellNameDict;
+    PropNameDict&       propNameDict;
+    PropStringDict&     propStringDict;
+    TextStringDict&     textStringDict;
+    XNameDict&          xnameDict;
+    LayerNameDict&      layerNameDict;
 
     // unregistered PropNames and TextStrings
     PointerVector<PropName>     unregPropNames;
@@ -102,6 +128,72 @@ class ParserImpl {
      */
     JCellHierarchy       _cellHierarchy;
 
+    /**
+     *  [MAPPED_INPUT]
+     *  ADD
+     *  - mappedFile : Null unless parserOptions.useMappedInput.  Used for
+     *    cell prefetching, raw cells and the cell index; the records
+     *    themselves are read by scanner.
+     */
+    std::unique_ptr<MappedFile>  mappedFile;
+
+    /**
+     *  [CELL_INDEX]
+     *  ADD
+     *  - cellIndex        : Null until applyCellIndex() loads or builds it
+     *  - cellIndexApplied : offsets from cellIndex are in cellDict
+     */
+    std::unique_ptr<CellOffsetIndex>  cellIndex;
+    bool                cellIndexApplied;
+
+    /**
+     *  [CELL_GRAPH]
+     *  ADD
+     *  - indexGraph : the placements in cellIndex as a CellGraph; node n
+     *                 is cell n of the index.  Null until getCellGraph().
+     */
+    std::unique_ptr<CellGraph>  indexGraph;
+
+    /**
+     *  [PRUNED_EXTRACT]
+     *  ADD
+     *  - extractStats : filled in by JCreateLDB()
+     */
+    OasisExtractStats   extractStats;
+
+    /**
+     *  [CELL_ARENA]
+     *  ADD
+     *  - cellArena : arena offered to an OasisArenaBuilder for each cell
+     *                parsed by parseCellAt(); Null until first needed or
+     *                after the builder adopted it
+     */
+    std::unique_ptr<MonotonicArena>  cellArena;
+
+    /**
+     *  [REP_INTERN]
+     *  ADD
+     *  - repCache : interned copies of the repetitions passed to the
+     *               builder; one per parser, so workers do not share it
+     */
+    std::shared_ptr<RepetitionCache>  repCache;
+
+    /**
+     *  [PARALLEL_VALIDATE]
+     *  ADD
+     *  - validator : computes the signature on other threads while the
+     *                file is parsed; Null unless validateInBackground
+     */
+    std::unique_ptr<FileValidator>  validator;
+
+    /**
+     *  [WINDOW_PARSE]
+     *  ADD
+     *  - bboxIndex : cell bounding boxes for parseWindow(); built on
+     *                first use and kept for later windows
+     */
+    std::unique_ptr<CellBBoxIndex>  bboxIndex;
+
 
 public:
                 ParserImpl (const char* fname, WarningHandler warner,
@@ -120,7 +212,86 @@ public:
     bool        JCreateLDB (const std::vector<std::string>& cellnames, OasisBuilder* builder);
     bool        JBeginCell (CellName* cellName);
     void        JBeginAllCell();
-    void        JBeginCellRecursive (JTreeNode* node);
+
+    /** [MAPPED_INPUT]
+     *  CREATE
+     *   - prefetchCell
+     */
+    void        prefetchCell (const Cell* cell);
+
+    /** [CELL_INDEX]
+     *  CREATE
+     *   - ensureCellIndex, applyCellIndex
+     */
+    bool        ensureCellIndex();
+    bool        applyCellIndex();
+
+    /** [PRUNED_EXTRACT]
+     *  CREATE
+     *   - getReachableCells, getExtractStats
+     */
+    bool        getReachableCells (const vector<CellName*>& roots,
+                                   /*out*/ vector<Uint>* order);
+    const OasisExtractStats&  getExtractStats() const {
+                    return extractStats;
+                }
+
+    /** [CELL_GRAPH]
+     *  CREATE
+     *   - getCellGraph, getCellGraphName
+     */
+    const CellGraph*  getCellGraph();
+    const string&     getCellGraphName (Uint node) const {
+                    return cellIndex->getCell(node).name;
+                }
+
+    /** [REP_INTERN]
+     *  CREATE
+     *   - internRepetition, getRepetitionCache
+     */
+    const Repetition*  internRepetition (const Repetition* rep) {
+                    return repCache->intern(rep);
+                }
+    const std::shared_ptr<RepetitionCache>&  getRepetitionCache() const {
+                    return repCache;
+                }
+
+    /** [PARALLEL_PARSE]
+     *  CREATE
+     *   - parseFileParallel, worker constructor, beginWorkerFile,
+     *     parseCellAt
+     */
+    void        parseFileParallel (OasisBuilderFactory* factory,
+                                   unsigned nthreads);
+
+    /** [PARALLEL_VALIDATE]
+     *  CREATE
+     *   - validateFileParallel, startValidation, finishValidation
+     */
+    void        validateFileParallel (unsigned nthreads);
+    void        startValidation();
+    void        finishValidation();
+
+    /** [WINDOW_PARSE]
+     *  CREATE
+     *   - parseWindow
+     */
+    bool        parseWindow (const char* topCell, const BoundingBox& window,
+                             OasisBuilder* builder);
+
+    /** [RAW_CELL]
+     *  CREATE
+     *   - passRawCell : offer a cell to an OasisRawCellBuilder before
+     *     parseCellAt() parses it
+     */
+    bool        passRawCell (Ullong cellOffset,
+                             OasisRawCellBuilder* rawBuilder);
+
+private:
+                ParserImpl (const ParserImpl& master, OasisBuilder* builder);
+    void        beginWorkerFile();
+    bool        parseCellAt (const Cell* cell);
+public:
 
 
 ParserImpl::ParserImpl (const char* fname, WarningHandler warner,
@@ -129,6 +300,15 @@ ParserImpl::ParserImpl (const char* fname, WarningHandler warner,
     recReader(scanner),
     parserOptions(options),
     warnHandler(warner),
+    /** [PARALLEL_PARSE] */
+    dicts(new NameDicts),
+    cellDict(dicts->cellDict),
+    cellNameDict(dicts->cellNameDict),
+    propNameDict(dicts->propNameDict),
+    propStringDict(dicts->propStringDict),
+    textStringDict(dicts->textStringDict),
+    xnameDict(dicts->xnameDict),
+    layerNameDict(dicts->layerNameDict),
     filename(fname),
     /**
      *  [CELL_HIERARCHY]
@@ -148,9 +328,121 @@ ParserImpl::ParserImpl (const char* fname, WarningHandler warner,
     recordsSeen = 0;
     fileSize = scanner.getFileSize();
     fileValidation.scheme = Validation::None;
+    cellIndexApplied = false;   // [CELL_INDEX]
+    repCache.reset(new RepetitionCache);        // [REP_INTERN]
 
     separatorPropName = makePropName("*");      // the name is arbitrary
-    recReader.setValidationWanted(parserOptions.wantValidation);
+    // [PARALLEL_VALIDATE] a FileValidator checks the file instead
+    recReader.setValidationWanted(parserOptions.wantValidation
+                                  &&  ! parserOptions.validateInBackground);
+
+    /** [MAPPED_INPUT]
+     *  ADD
+     *   - No access advice: madvise() on the mapping does not reach the
+     *     read()s of scanner.  Only prefetchCell() uses the mapping.
+     */
+    if (parserOptions.useMappedInput)
+        mappedFile.reset(new MappedFile(fname));
+}
+
+
+/** [MAPPED_INPUT]
+ *  CREATE
+ *   - Ask the kernel to read a window starting at the cell's offset
+ *     into the page cache before seekTo(), so that the scanner's
+ *     read()s find it there.  The cell's extent is not known here;
+ *     CellPrefetchWindow covers all but the largest cells.
+ */
+static const Ullong  CellPrefetchWindow = 4 << 20;
+
+void
+ParserImpl::prefetchCell (const Cell* cell)
+{
+    if (mappedFile.get() == Null)
+        return;
+
+    // [CELL_INDEX] the index knows exactly where the cell ends
+    Ullong  length = CellPrefetchWindow;
+    if (cellIndex.get() != Null) {
+        const CellOffsetIndex::CellEntry*
+            entry = cellIndex->findCellAt(cell->getOffset());
+        if (entry != Null)
+            length = entry->endOffset - entry->offset;
+    }
+    mappedFile->willNeed(cell->getOffset(), length);
+}
+
+
+/** [CELL_INDEX]
+ *  CREATE
+ *   - Load the sidecar index, or build it with a structural pass over
+ *     the file.  The pass is much cheaper than getAllCellOffsets(),
+ *     which parses every record.  The index is saved only if the user
+ *     asked for it with useCellIndex; JCreateLDB() also uses it for
+ *     the cell hierarchy, and then just keeps it in memory.
+ *   - Returns false if the index could not be built; the caller then
+ *     falls back to parsing the file.
+ */
+bool
+ParserImpl::ensureCellIndex()
+{
+    if (cellIndex.get() != Null)
+        return true;
+
+    std::unique_ptr<CellOffsetIndex>  index(new CellOffsetIndex);
+    if (! parserOptions.useCellIndex  ||  ! index->load(filename)) {
+        try {
+            std::unique_ptr<MappedFile>  tmpFile;
+            const MappedFile*  mfile = mappedFile.get();
+            if (mfile == Null) {
+                tmpFile.reset(new MappedFile(filename.c_str()));
+                mfile = tmpFile.get();
+            }
+            index->build(*mfile, std::thread::hardware_concurrency());
+        } catch (const std::exception&) {
+            // Let the parser's own pass report a malformed file.
+            return false;
+        }
+        if (parserOptions.useCellIndex  &&  ! index->save(filename)
+                &&  warnHandler != Null) {
+            string  msg = "cannot write cell index '"
+                          + CellOffsetIndex::IndexFilename(filename) + "'";
+            warnHandler(msg.c_str());
+        }
+    }
+    cellIndex = std::move(index);
+    return true;
+}
+
+
+/** [CELL_INDEX]
+ *  CREATE
+ *   - Give every cell without an offset the offset recorded in the
+ *     index.  Offsets from S_CELL_OFFSET take precedence.  Cells whose
+ *     CELL record is inside a CBLOCK cannot be sought to and are left
+ *     for getAllCellOffsets().
+ */
+bool
+ParserImpl::applyCellIndex()
+{
+    if (cellIndexApplied)
+        return true;
+    if (! ensureCellIndex())
+        return false;
+
+    for (CellOffsetIndex::const_iterator iter = cellIndex->begin();
+            iter != cellIndex->end();  ++iter) {
+        if (iter->inCblock)
+            continue;
+        CellName*  cellName = cellNameDict.lookupName(iter->name, false);
+        if (cellName == Null)
+            continue;
+        Cell*  cell = cellDict.lookup(cellName, true);
+        if (! cell->haveOffset())
+            cell->setOffset(iter->offset);
+    }
+    cellIndexApplied = true;
+    return true;
 }
 
 
@@ -165,64 +457,489 @@ ParserImpl::BeginCell (CellName* cellName)
      *  ADD
      *   - Find or create a CellNode for the given cellName in the CellhierarchyTree.
      */
-    JTreeNode* cellNode = _cellHierarchy.findOrCreateNode(cellName);
-    cellNode->setVisited(true);
+    _cellHierarchy.setVisited(_cellHierarchy.findOrCreateNode(cellName));
 
 
+    /** [CELL_INDEX]
+     *  UPDATE
+     *   - Try the sidecar index before reading the whole file.
+     */
     Cell*  cell = cellDict.lookup(cellName, false);
+    if ((cell == Null  ||  ! cell->haveOffset())
+            &&  parserOptions.useCellIndex  &&  applyCellIndex())
+        cell = cellDict.lookup(cellName, false);
     if (cell == Null  ||  ! cell->haveOffset())
         getAllCellOffsets();
     if ((cell = cellDict.lookup(cellName, false)) == Null
             ||  ! cell->haveOffset())
         return false;
 
+    /** [PARALLEL_PARSE]
+     *  UPDATE
+     *   - seek and parse moved to parseCellAt() so that the parallel
+     *     workers can share it.
+     */
+    return parseCellAt(cell);
+}
+
+
+/** [PARALLEL_PARSE]
+ *  CREATE
+ *   - Parse the single cell that begins at cell->getOffset().
+ */
+bool
+ParserImpl::parseCellAt (const Cell* cell)
+{
     off_t  cellOffset = cell->getOffset();
     if (cellOffset == 0)
         return false;
 
+    // [RAW_CELL]
+    OasisRawCellBuilder*  rawBuilder = dynamic_cast<OasisRawCellBuilder*>(builder);
+    if (rawBuilder != Null  &&  passRawCell(cellOffset, rawBuilder))
+        return true;
+
+    // [MAPPED_INPUT]
+    prefetchCell(cell);
+
     seekTo(cellOffset);
     OasisRecord*  orecp = readNextRecord();
     if (orecp->recID != RID_CELL_NAMED  &&  orecp->recID != RID_CELL_REF)
-        abortParser("cell %s does not begin with CELL record", cellName->getName().c_str());
+        abortParser("cell at offset %llu does not begin with CELL record",
+                    Ullong(cellOffset));
 
+    /** [CELL_ARENA]
+     *  UPDATE
+     *   - Hand the builder a per-cell arena around parseCell().  The
+     *     arena is reset for the next cell unless the builder adopted it.
+     */
+    OasisArenaBuilder*  arenaBuilder = dynamic_cast<OasisArenaBuilder*>(builder);
+    if (arenaBuilder == Null) {
+        parseCell(static_cast<CellRecord*>(orecp));
+        return true;
+    }
+
+    if (cellArena.get() == Null)
+        cellArena.reset(new MonotonicArena);
+    arenaBuilder->beginCellArena(cellArena.get());
     parseCell(static_cast<CellRecord*>(orecp));
+    arenaBuilder->endCellArena(cellArena);
+    if (cellArena.get() != Null)
+        cellArena->reset();
 
     return true;
 }
 
 
-/** [CELL_HIERARCHY]
- *  [INPUT_CELLNAMES]
+/** [RAW_CELL]
  *  CREATE
- *   - 모든 노드에 대해 BeginCell 호출
+ *   - ResolveRefs : the distinct reference-numbers in refnums with the
+ *     names they denote.  False if one is undefined.
  */
-void
-ParserImpl::JBeginAllCell()
+template <typename DictT, typename NameT>
+static bool
+ResolveRefs (vector<Ullong>* refnums, DictT& dict,
+             /*out*/ vector< NameRef<NameT> >* refs)
 {
-    for (auto& pair : _cellHierarchy._cellTreeMap) {
-        if (pair.second){
-            JBeginCellRecursive(pair.second);
-        }
+    std::sort(refnums->begin(), refnums->end());
+    refnums->erase(std::unique(refnums->begin(), refnums->end()),
+                   refnums->end());
+    refs->clear();
+    for (Ullong refnum : *refnums) {
+        NameT*  name = dict.lookupRefnum(refnum, false);
+        if (name == Null)
+            return false;
+        refs->push_back(NameRef<NameT>{ refnum, name });
     }
+    return true;
 }
 
-/** [CELL_HIERARCHY]
- *  [INPUT_CELLNAMES]
+
+/** [RAW_CELL]
+ *  CREATE
+ *   - Offer the cell at cellOffset to rawBuilder as it is stored.  See
+ *     raw-cell.h for when this is possible.  The placements in a copied
+ *     cell still go into the hierarchy, from which JBeginAllCell() finds
+ *     the cells still to extract.
+ */
+bool
+ParserImpl::passRawCell (Ullong cellOffset, OasisRawCellBuilder* rawBuilder)
+{
+    if (mappedFile.get() == Null
+            ||  ! parserOptions.wantText  ||  ! parserOptions.wantExtensions)
+        return false;
+
+    CellKey   key;
+    Ullong    begin, end;
+    NameRefs  refs;
+    RawCell   raw;
+    if (! FindRawCell(*mappedFile, cellOffset, &key, &begin, &end,
+                      &raw.compressed, &refs)
+            ||  ! ResolveRefs(&refs.cellRefnums, cellNameDict, &raw.cellRefs)
+            ||  ! ResolveRefs(&refs.textRefnums, textStringDict, &raw.textRefs)
+            ||  ! ResolveRefs(&refs.propNameRefnums, propNameDict,
+                              &raw.propNameRefs)
+            ||  ! ResolveRefs(&refs.propStringRefnums, propStringDict,
+                              &raw.propStringRefs))
+        return false;
+
+    CellName*  cellName = key.byRefnum
+                              ? cellNameDict.lookupRefnum(key.refnum, false)
+                              : cellNameDict.lookupName(key.name, false);
+    if (cellName == Null)
+        return false;
+
+    vector<CellName*>  children;
+    for (const NameRef<CellName>& ref : raw.cellRefs)
+        children.push_back(ref.name);
+    for (const string& name : refs.cellNames) {
+        CellName*  child = cellNameDict.lookupName(name, false);
+        if (child == Null)
+            return false;
+        children.push_back(child);
+    }
+
+    raw.data = mappedFile->getData() + begin;
+    raw.size = end - begin;
+    raw.cellNameStrings = ! refs.cellNames.empty();
+    raw.textStrings = refs.textStrings;
+    raw.propNameStrings = refs.propNameStrings;
+    if (! rawBuilder->copyRawCell(cellName, raw))
+        return false;
+
+    for (CellName* child : children)
+        _cellHierarchy.addPlacement(cellName, child);
+    return true;
+}
+
+
+/** [PARALLEL_PARSE]
+ *  CREATE
+ *   - Worker parser for parseFileParallel().  It has its own scanner,
+ *     record reader, modal variables and builder, and borrows the
+ *     master's dictionaries.  The master has already parsed the START
+ *     and END records, all names, and all cell offsets, so the worker
+ *     never needs to make a pass of its own.
+ */
+ParserImpl::ParserImpl (const ParserImpl& master, OasisBuilder* builder)
+  : scanner(master.filename.c_str(), master.warnHandler),
+    recReader(scanner),
+    parserOptions(master.parserOptions),
+    warnHandler(master.warnHandler),
+    dicts(master.dicts),
+    cellDict(dicts->cellDict),
+    cellNameDict(dicts->cellNameDict),
+    propNameDict(dicts->propNameDict),
+    propStringDict(dicts->propStringDict),
+    textStringDict(dicts->textStringDict),
+    xnameDict(dicts->xnameDict),
+    layerNameDict(dicts->layerNameDict),
+    fileVersion(master.fileVersion),
+    fileUnit(master.fileUnit),
+    fileValidation(master.fileValidation),
+    filename(master.filename),
+    _cellHierarchy()
+{
+    this->builder = builder;
+    currRecord = Null;
+    rereadCurrRecord = false;
+    allNamesParsed = true;
+    haveAllCellOffsets = true;
+    haveTableOffsets = master.haveTableOffsets;
+    haveValidation = master.haveValidation;
+    cellIndexApplied = false;
+    recordsSeen = 0;
+    fileSize = master.fileSize;
+    repCache.reset(new RepetitionCache);        // [REP_INTERN] not shared
+
+    separatorPropName = makePropName("*");
+    recReader.setValidationWanted(false);       // the master validates
+
+    if (parserOptions.useMappedInput)
+        mappedFile.reset(new MappedFile(filename.c_str()));
+}
+
+
+/** [PARALLEL_PARSE]
  *  CREATE
- *   - 재귀적으로 셀을 방문하여 beginCell 호출
+ *   - Give the worker's builder the same file prologue parseFile()
+ *     would: beginFile(), all names, and the file properties.
  */
 void
-ParserImpl::JBeginCellRecursive(TreeNode* node)
+ParserImpl::beginWorkerFile()
+{
+    seekTo(StartRecordOffset);
+    (void) readNextRecord();
+
+    builder->beginFile(fileVersion, fileUnit, fileValidation.scheme);
+    registerAllNamesWithBuilder();
+    parsePropertiesForBuilder(PC_File);
+}
+
+
+/** [PARALLEL_PARSE]
+ *  CREATE
+ *   - Cells are independent: the modal variables are reset at every
+ *     CELL record, so each one can be parsed by any worker.  The cells
+ *     are handed out largest first (size = distance to the next cell)
+ *     to keep the workers evenly loaded.  The first exception thrown by
+ *     a worker stops the others after their current cell and is
+ *     rethrown here.
+ */
+void
+ParserImpl::parseFileParallel (OasisBuilderFactory* factory, unsigned nthreads)
+{
+    if (nthreads <= 1) {
+        if (parserOptions.validateInBackground)
+            (void) parseValidation();   // for startValidation()
+        startValidation();
+        parseFile(factory->makeBuilder(0));
+        finishValidation();
+        return;
+    }
+
+    parseStartAndEndRecords();
+    startValidation();          // [PARALLEL_VALIDATE]
+    parseAllNames();
+    getAllCellOffsets();
+
+    vector<const Cell*>  cells;
+    for (CellDict::const_iterator iter = cellDict.begin();
+            iter != cellDict.end();  ++iter) {
+        const Cell*  cell = iter->second;
+        if (cell->haveOffset()  &&  cell->getOffset() != 0)
+            cells.push_back(cell);
+    }
+    std::sort(cells.begin(), cells.end(),
+              [](const Cell* a, const Cell* b) {
+                  return (a->getOffset() < b->getOffset());
+              });
+
+    vector< std::pair<Ullong, const Cell*> >  work;
+    for (size_t j = 0;  j < cells.size();  ++j) {
+        Ullong  end = (j+1 < cells.size()) ? Ullong(cells[j+1]->getOffset())
+                                           : fileSize;
+        work.push_back(std::make_pair(end - cells[j]->getOffset(), cells[j]));
+    }
+    std::sort(work.begin(), work.end(),
+              [](const std::pair<Ullong, const Cell*>& a,
+                 const std::pair<Ullong, const Cell*>& b) {
+                  return (a.first > b.first);
+              });
+
+    if (nthreads > work.size())
+        nthreads = std::max<size_t>(work.size(), 1);
+
+    PointerVector<ParserImpl>  workers;
+    for (unsigned j = 0;  j < nthreads;  ++j)
+        workers.push_back(new ParserImpl(*this, factory->makeBuilder(j)));
+    for (unsigned j = 0;  j < nthreads;  ++j)
+        workers[j]->beginWorkerFile();
+
+    std::atomic<size_t>  nextCell(0);
+    std::atomic<bool>    failed(false);
+    std::exception_ptr   firstError;
+    std::mutex           errorMutex;
+
+    vector<std::thread>  threads;
+    for (unsigned j = 0;  j < nthreads;  ++j) {
+        ParserImpl*  worker = workers[j];
+        threads.push_back(std::thread([&, worker]() {
+            try {
+                size_t  k;
+                while (! failed  &&  (k = nextCell++) < work.size())
+                    worker->parseCellAt(work[k].second);
+            } catch (...) {
+                std::lock_guard<std::mutex>  lock(errorMutex);
+                if (! failed.exchange(true))
+                    firstError = std::current_exception();
+            }
+        }));
+    }
+    for (size_t j = 0;  j < threads.size();  ++j)
+        threads[j].join();
+
+    if (firstError)
+        std::rethrow_exception(firstError);
+
+    for (unsigned j = 0;  j < nthreads;  ++j)
+        workers[j]->builder->endFile();
+    finishValidation();         // [PARALLEL_VALIDATE]
+}
+
+
+void
+OasisParser::parseFileParallel (OasisBuilderFactory* factory, unsigned nthreads)
 {
-    if (!node || node->getVisited()) return;
+    impl->parseFileParallel(factory, nthreads);
+}
 
-    JBeginCell(node->getCellName());
-    node->setVisited(true);
 
-    // 자식 노드에 대해 재귀적으로 BeginCell 호출
-    for (JTreeNode* child : node->getChildren()) {
-        JBeginCellRecursive(child);
+/** [PRUNED_EXTRACT]
+ *  CREATE
+ *   - Post-order walk of the index's child lists from the requested
+ *     cells, so each cell comes after every cell it places.  The walk
+ *     uses an explicit stack because real hierarchies can be deeper
+ *     than the call stack allows.  A cycle (invalid OASIS) is cut at
+ *     the back edge; parsing will not loop on it.
+ *   - Returns false if there is no index.
+ *
+ *  [CELL_GRAPH]
+ *  UPDATE
+ *   - The walk is CellGraph::getReachable() on the index's graph.
+ *   - Also returns false if a root is not in the index (a CELLNAME
+ *     with no CELL record, or an index that does not match the file),
+ *     so that the caller does not silently parse less than was asked.
+ */
+bool
+ParserImpl::getReachableCells (const vector<CellName*>& roots,
+                               /*out*/ vector<Uint>* order)
+{
+    const CellGraph*  graph = getCellGraph();
+    if (graph == Null)
+        return false;
+
+    vector<Uint>  rootNodes;
+    for (size_t j = 0;  j < roots.size();  ++j) {
+        int  root = cellIndex->findCellIndex(roots[j]->getName());
+        if (root < 0)
+            return false;
+        rootNodes.push_back(Uint(root));
     }
+    graph->getReachable(rootNodes, order);
+    return true;
+}
+
+
+/** [CELL_GRAPH]
+ *  CREATE
+ *   - The cell index's child lists as a CellGraph, built on first use.
+ *     Returns Null if there is no index.
+ */
+const CellGraph*
+ParserImpl::getCellGraph()
+{
+    if (indexGraph.get() != Null)
+        return indexGraph.get();
+    if (! ensureCellIndex())
+        return Null;
+
+    std::unique_ptr<CellGraph>  graph(new CellGraph);
+    graph->reserveNodes(cellIndex->size());
+    for (Uint j = 0;  j < cellIndex->size();  ++j) {
+        const vector<Uint>&  children = cellIndex->getCell(j).children;
+        for (size_t k = 0;  k < children.size();  ++k)
+            graph->addEdge(j, children[k]);
+    }
+    graph->finalize();
+    indexGraph = std::move(graph);
+    return indexGraph.get();
+}
+
+
+const CellGraph*
+OasisParser::getCellGraph()
+{
+    return impl->getCellGraph();
+}
+
+
+const string&
+OasisParser::getCellGraphName (Uint node) const
+{
+    return impl->getCellGraphName(node);
+}
+
+
+/** [PARALLEL_VALIDATE]
+ *  CREATE
+ *   - Same check as validateFile(), but the file is cut into chunks
+ *     whose CRCs or sums are computed on nthreads threads and combined.
+ */
+void
+ParserImpl::validateFileParallel (unsigned nthreads)
+{
+    Validation  val = parseValidation();
+    FileValidator  fileValidator(filename.c_str());
+    fileValidator.start(val.scheme, nthreads);
+    fileValidator.check(val);
+}
+
+
+void
+OasisParser::validateFileParallel (unsigned nthreads)
+{
+    impl->validateFileParallel(nthreads);
+}
+
+
+/** [PARALLEL_VALIDATE]
+ *  CREATE
+ *   - Called once the END record has been parsed.  The validator's
+ *     threads read their own mapping of the file, so they need nothing
+ *     from the parser while it goes on parsing.
+ */
+void
+ParserImpl::startValidation()
+{
+    if (! parserOptions.validateInBackground  ||  ! haveValidation
+            ||  fileValidation.scheme == Validation::None)
+        return;
+    validator.reset(new FileValidator(filename.c_str()));
+    validator->start(fileValidation.scheme);
+}
+
+
+/** [PARALLEL_VALIDATE]
+ *  CREATE
+ *   - Wait for the validator and throw if the signature is wrong.  If
+ *     parsing throws first, the validator is stopped when the parser is
+ *     destroyed.
+ */
+void
+ParserImpl::finishValidation()
+{
+    if (validator.get() == Null)
+        return;
+    std::unique_ptr<FileValidator>  fileValidator(std::move(validator));
+    fileValidator->check(fileValidation);
+}
+
+
+const OasisExtractStats&
+OasisParser::getExtractStats() const
+{
+    return impl->getExtractStats();
+}
+
+
+std::shared_ptr<RepetitionCache>
+OasisParser::getRepetitionCache() const
+{
+    return impl->getRepetitionCache();
+}
+
+
+/** [CELL_HIERARCHY]
+ *  [INPUT_CELLNAMES]
+ *  CREATE
+ *   - 모든 노드에 대해 BeginCell 호출
+ *
+ *  [CELL_GRAPH]
+ *  UPDATE
+ *   - 재귀 대신 반복.  셀을 parse하면 그 셀의 새 child가 node 번호 끝에
+ *     추가되므로, node 번호 순으로 한 번 훑으며 parse되지 않은 셀을 parse한다.
+ *     JBeginCellRecursive 삭제.
+ */
+void
+ParserImpl::JBeginAllCell()
+{
+    // Every node is a parsed cell or a child of one, and JBeginCell()
+    // appends the new children of the cell it parses.  So one pass in
+    // node order reaches the whole hierarchy.
+    for (Uint node = 0;  node < _cellHierarchy.size();  ++node)
+        if (! _cellHierarchy.getVisited(node))
+            JBeginCell(_cellHierarchy.getCellName(node));
 }
 
 
@@ -245,22 +962,155 @@ ParserImpl::JCreateLDB (const std::vector<std::string>& cellnames, OasisBuilder*
     registerAllNamesWithBuilder();
     parsePropertiesForBuilder(PC_File);
 
+    /** [PRUNED_EXTRACT]
+     *  UPDATE
+     *   - Check all names before parsing anything, then parse only the
+     *     cells reachable from them, children before parents.  Without
+     *     an index, or if a requested cell is not in it, fall back to
+     *     discovering the hierarchy while parsing.
+     */
+    vector<CellName*>  roots;
     for (const std::string& name : cellnames) {
         CellName*  cellName = cellNameDict.lookupName(name, false);
         if (cellName == Null){
             std::cerr << "File has no cell '" << name << "'" << std::endl;
             return false;
         }
-        JBeginCell(cellName);
+        roots.push_back(cellName);
     }
 
-    JBeginAllCell();
+    startValidation();          // [PARALLEL_VALIDATE]
+
+    extractStats.clear();
+    vector<Uint>  order;
+    if (getReachableCells(roots, &order)) {
+        (void) applyCellIndex();
+
+        vector<bool>  parsed(cellIndex->size(), false);
+        for (size_t j = 0;  j < order.size();  ++j) {
+            const string&  name = cellIndex->getCell(order[j]).name;
+            CellName*  cellName = cellNameDict.lookupName(name, false);
+            if (cellName != Null  &&  JBeginCell(cellName))
+                parsed[order[j]] = true;
+        }
+
+        extractStats.pruned = true;
+        extractStats.cellsInFile = cellIndex->size();
+        for (Uint j = 0;  j < cellIndex->size();  ++j) {
+            const CellOffsetIndex::CellEntry&  entry = cellIndex->getCell(j);
+            Ullong  bytes = entry.endOffset - entry.offset;
+            if (parsed[j]) {
+                ++extractStats.cellsParsed;
+                extractStats.bytesParsed += bytes;
+                extractStats.recordsParsed += entry.numRecords;
+            } else {
+                extractStats.bytesSkipped += bytes;
+                extractStats.recordsSkipped += entry.numRecords;
+            }
+        }
+    } else {
+        for (size_t j = 0;  j < roots.size();  ++j) {
+            if (! JBeginCell(roots[j]))
+                abortParser("file has no CELL record for cell '%s'",
+                            roots[j]->getName().c_str());
+        }
+        JBeginAllCell();
+    }
 
     builder->endFile();
+    finishValidation();         // [PARALLEL_VALIDATE]
 
     return true;
 }
 
+/** [WINDOW_PARSE]
+ *  CREATE
+ *   - Parse topCell and the cells below it, passing the builder only
+ *     the elements and placements that can meet window.  Cells are
+ *     parsed parents first, so that by the time a cell is reached the
+ *     WindowFilterBuilder knows which part of it the forwarded
+ *     placements can show.  Cells with no such part are not read.
+ */
+bool
+ParserImpl::parseWindow (const char* topCell, const BoundingBox& window,
+                         OasisBuilder* builder)
+{
+    this->builder = builder;
+
+    parseStartAndEndRecords();
+    parseAllNames();
+
+    CellName*  top = cellNameDict.lookupName(topCell, false);
+    if (top == Null) {
+        std::cerr << "File has no cell '" << topCell << "'" << std::endl;
+        return false;
+    }
+    vector<Uint>  order;
+    if (! getReachableCells(vector<CellName*>(1, top), &order))
+        abortParser("cannot find cell '%s' in the cell index of the file",
+                    topCell);
+    (void) applyCellIndex();
+
+    if (bboxIndex.get() == Null) {
+        bboxIndex.reset(new CellBBoxIndex);
+        bboxIndex->build(filename.c_str());
+    }
+
+    seekTo(StartRecordOffset);
+    (void) readNextRecord();
+    builder->beginFile(fileVersion, fileUnit, fileValidation.scheme);
+    registerAllNamesWithBuilder();
+    parsePropertiesForBuilder(PC_File);
+    startValidation();          // [PARALLEL_VALIDATE]
+
+    // getReachableCells() lists children first; go the other way.
+    WindowFilterBuilder  filter(builder, *bboxIndex);
+    filter.addRegion(top->getName(), window);
+    this->builder = &filter;
+
+    extractStats.clear();
+    vector<bool>  parsed(cellIndex->size(), false);
+    for (size_t j = order.size();  j-- > 0; ) {
+        const string&  name = cellIndex->getCell(order[j]).name;
+        BoundingBox  region;
+        if (! filter.getRegion(name, &region))
+            continue;
+        CellName*  cellName = cellNameDict.lookupName(name, false);
+        filter.setWindow(region);
+        if (cellName != Null  &&  JBeginCell(cellName))
+            parsed[order[j]] = true;
+    }
+    this->builder = builder;
+
+    extractStats.pruned = true;
+    extractStats.cellsInFile = cellIndex->size();
+    for (Uint j = 0;  j < cellIndex->size();  ++j) {
+        const CellOffsetIndex::CellEntry&  entry = cellIndex->getCell(j);
+        Ullong  bytes = entry.endOffset - entry.offset;
+        if (parsed[j]) {
+            ++extractStats.cellsParsed;
+            extractStats.bytesParsed += bytes;
+            extractStats.recordsParsed += entry.numRecords;
+        } else {
+            extractStats.bytesSkipped += bytes;
+            extractStats.recordsSkipped += entry.numRecords;
+        }
+    }
+
+    builder->endFile();
+    finishValidation();         // [PARALLEL_VALIDATE]
+    return true;
+}
+
+
+bool
+OasisParser::parseWindow (const char* topCell, const BoundingBox& window,
+                          OasisBuilder* builder)
+{
+    return impl->parseWindow(topCell, window, builder);
+}
+
+
 void
 ParserImpl::parsePlacement (const CellName* parentCell,
                             const PlacementRecord* recp)
@@ -308,7 +1158,9 @@ ParserImpl::parsePlacement (const CellName* parentCell,
 
     long  x = getPlacementX(infoByte & XBit, recp->x);
     long  y = getPlacementY(infoByte & YBit, recp->y);
-    const Repetition*  rep = getRepetition(infoByte & RepBit, recp->rawrep);
+    // [REP_INTERN] builder gets a stable pointer, not the modal repetition
+    const Repetition*  rep = internRepetition(
+                                 getRepetition(infoByte & RepBit, recp->rawrep));
 
     builder->beginPlacement(cellName, x, y, mag, angle, (infoByte & FlipBit),
                             rep);
@@ -319,10 +1171,12 @@ ParserImpl::parsePlacement (const CellName* parentCell,
     /** [CELL_HIERARCHY]
      *  ADD
      *   - Find or create a CellNode for the given cellName in the CellhierarchyTree.
+     *
+     *  [CELL_GRAPH]
+     *  UPDATE
+     *   - 중복 edge는 CellGraph가 합친다.
      */
-    JTreeNode* parent = _cellHierarchy.findOrCreateNode(const_cast<CellName*>(parentCell));
-    JTreeNode*  child = _cellHierarchy.findOrCreateNode(cellName);
-    parent->addChild(child);
+    _cellHierarchy.addPlacement(parentCell, cellName);
 
 }
 
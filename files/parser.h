@@ -9,13 +9,19 @@
 #ifndef OASIS_PARSER_H_INCLUDED
 #define OASIS_PARSER_H_INCLUDED
 
+#include <memory>
 #include "misc/utils.h"         // for WarningHandler
 #include "builder.h"
+#include "arena.h"
+#include "rep-intern.h"
+#include "bbox-index.h"
+#include "cell-graph.h"
 
 namespace Anuvad {
 namespace Oasis {
 
 using Anuvad::SoftJin::WarningHandler;
+using Anuvad::SoftJin::Ullong;
 
 
 // OasisParserOptions -- options for OasisParser
@@ -148,6 +154,52 @@ using Anuvad::SoftJin::WarningHandler;
 // 불필요한 레코드에 대한 검사 비용을 줄이기 위해 특정 플래그를 사용하지만,
 // 중요한 파일 파싱 오류는 여전히 확인하여 파일의 나머지 부분을 제대로 파싱할 수 있도록 보장한다는 점을 설명합니다.
 
+//
+// The flag useMappedInput makes the parser also map the whole input
+// file with mmap() (see MappedFile in mapped-file.h).  The records are
+// still read through OasisScanner and its read() buffers; the mapping
+// does not replace them.  What it adds is:
+//
+//   - cell prefetching: before seeking to a cell, the parser asks the
+//     kernel to read the cell's pages into the page cache, so that the
+//     reads that follow find them there.  The parser gives no
+//     sequential or random advice, which would apply to the mapping
+//     and not to OasisScanner's reads.
+//
+//   - raw-cell copying: cells are offered to an OasisRawCellBuilder
+//     (see below) only when the file is mapped
+//
+//   - the cell index (useCellIndex) is built from this mapping instead
+//     of a second one
+//
+// For decoding straight from the mapping, with no copy, use OasisCursor
+// (cursor.h) or MappedScanner.  Mapping requires a 64-bit host for
+// files of 4 GB or more; the constructor throws runtime_error if the
+// file cannot be mapped.
+//
+// The flag useCellIndex lets CreateLayoutDataBase() find cells without
+// reading the whole file.  The first time a cell
+// without an S_CELL_OFFSET property is wanted, the parser looks for a
+// cell-offset index next to the input (<file>.idx, see cell-index.h).
+// If there is none, or it was made for a different version of the
+// file, the parser builds one with a quick structural pass and tries
+// to save it for the next run.  A directory that cannot be written
+// just means the index is rebuilt every time.
+//
+// The flag validateInBackground makes parseFileParallel() and
+// CreateLayoutDataBase() check the CRC or checksum in the END record
+// on other threads while they parse (see FileValidator in validator.h).
+// If the signature is wrong they throw runtime_error after the builder's
+// endFile().  The flag has no effect if wantValidation is false or the
+// file has no validation signature.  It also stops parseFile() from
+// validating as it reads, so that the file is not checked twice; a
+// caller of parseFile() runs its own FileValidator, as oasis-copy -b
+// does.
+//
+// There is no option to select elements by layer.  For that, read the
+// file with OasisCursor::setLayerFilter() and feed the builder with
+// CursorFeeder (cursor-feed.h).
+
 
 struct OasisParserOptions {
     bool  strictConformance;    // false => allow minor deviations from spec
@@ -155,6 +207,9 @@ struct OasisParserOptions {
     bool  wantText;             // false => ignore TEXT and TEXTSTRING
     bool  wantLayerName;        // false => ignore LAYERNAME
     bool  wantExtensions;       // false => ignore XNAME, XELEMENT, XGEOMETRY
+    bool  useMappedInput;       // true => also mmap() the file; see above
+    bool  useCellIndex;         // true => keep cell offsets in <file>.idx
+    bool  validateInBackground; // true => check validation while parsing
 
 public:
     OasisParserOptions() {
@@ -163,6 +218,9 @@ public:
         wantText = true;
         wantLayerName = true;
         wantExtensions = true;
+        useMappedInput = false;
+        useCellIndex = false;
+        validateInBackground = false;
     }
 
     void
@@ -172,6 +230,9 @@ public:
         wantText = false;
         wantLayerName = false;
         wantExtensions = false;
+        useMappedInput = false;
+        useCellIndex = false;
+        validateInBackground = false;
     }
 };
 
@@ -224,6 +285,106 @@ public:
 // parseFile() and parseCell().  validateFile() checks the CRC/checksum
 // in the file, if any, and throws a runtime_error if it's wrong.
 
+// OasisBuilderFactory -- supplies the builders for parseFileParallel()
+//
+// parseFileParallel() parses the cells of a file on several threads.
+// Each thread needs its own builder, so instead of a builder the
+// caller passes a factory.  makeBuilder(worker) is called once for
+// each worker, 0 <= worker < nthreads, on the calling thread before any
+// worker starts.  The factory keeps ownership of the builders.
+//
+// Every builder sees a complete file: beginFile(), the registerFooName()
+// calls for all names, the file properties, then beginCell()..endCell()
+// for the cells assigned to its worker, and finally endFile().  Cells
+// are assigned dynamically, so which builder gets which cell varies
+// from run to run, and a builder does not see its cells in file order.
+// The name objects passed to the builders are shared by all workers
+// and must be treated as read-only.
+
+class OasisBuilderFactory {
+public:
+    virtual     ~OasisBuilderFactory() { }
+    virtual OasisBuilder*  makeBuilder (unsigned worker) = 0;
+};
+
+
+// OasisArenaBuilder -- optional interface for builders that use a cell arena
+//
+// A builder that also derives from OasisArenaBuilder is given a
+// MonotonicArena (arena.h) for each cell the parser parses on its own,
+// i.e. by parseCell(), CreateLayoutDataBase() and the workers of
+// parseFileParallel().  beginCellArena() is called just before
+// beginCell() with an empty arena.  The builder may allocate from it
+// whatever it keeps for the cell -- element objects, copies of point
+// lists, expanded repetitions -- instead of calling new for each
+// element.
+//
+// endCellArena() is called just after endCell().  By default the parser
+// then resets the arena and reuses it for the next cell, so nothing
+// allocated from it may be used after endCellArena() returns.  A
+// builder that keeps the cell's data for longer adopts the arena by
+// moving it out of the unique_ptr; the parser then starts the next cell
+// with a new arena.  Adopting costs nothing, whereas copying the data
+// out would cost the allocations the arena saves.
+//
+// The PointList and Property objects the parser passes to the
+// callbacks are its own modal state, not arena memory, and as before
+// are valid only during the callback.  Repetitions are interned; see
+// getRepetitionCache() below.
+
+class OasisArenaBuilder {
+public:
+    virtual     ~OasisArenaBuilder() { }
+    virtual void  beginCellArena (MonotonicArena* arena) = 0;
+    virtual void  endCellArena (std::unique_ptr<MonotonicArena>& arena) = 0;
+};
+
+
+// The parser delivers rectangles one at a time even to an
+// OasisBatchBuilder (batch-builder.h); runs come from CursorFeeder
+// (cursor-feed.h) and from callers of beginRectangles().
+//
+// A builder that also derives from OasisRawCellBuilder (raw-cell.h) is
+// offered the stored bytes of each cell the parser would parse on its
+// own, and may copy them instead of having the cell parsed.  This needs
+// useMappedInput.
+
+
+// OasisExtractStats -- what CreateLayoutDataBase() parsed and skipped
+//
+// CreateLayoutDataBase() parses only the requested cells and the cells
+// they place, directly or indirectly.  It finds that set with the cell
+// index (see useCellIndex above), which it builds in memory if it is
+// not kept in a file.  pruned is false if it could not, in which case
+// it walked the hierarchy as it parsed and the counts are zero.
+// parseWindow() fills in the same counts; it also skips reachable
+// cells that the window cannot see.
+//
+// Byte counts are cell extents: from a CELL record to the record that
+// ends the cell.  Cells that share a CBLOCK are counted approximately.
+
+struct OasisExtractStats {
+    bool    pruned;             // true => only reachable cells were parsed
+    Ullong  cellsInFile;
+    Ullong  cellsParsed;
+    Ullong  bytesParsed;
+    Ullong  bytesSkipped;
+    Ullong  recordsParsed;
+    Ullong  recordsSkipped;
+
+public:
+    OasisExtractStats() { clear(); }
+
+    void
+    clear() {
+        pruned = false;
+        cellsInFile = cellsParsed = 0;
+        bytesParsed = bytesSkipped = 0;
+        recordsParsed = recordsSkipped = 0;
+    }
+};
+
+
 class ParserImpl;
 
 class OasisParser {
@@ -249,6 +410,59 @@ public:
      */
     bool        CreateLayoutDataBase (const std::vector<std::string>& cellnames, OasisBuilder* builder);
 
+    /** [PARALLEL_PARSE]
+     *  CREATE
+     *   - nthreads <= 1 이면 parseFile()과 동일
+     */
+    void        parseFileParallel (OasisBuilderFactory* factory,
+                                   unsigned nthreads);
+
+    /** [PARALLEL_VALIDATE]
+     *  CREATE
+     *   - validateFile()과 같지만 파일을 나누어 nthreads개의 thread에서
+     *     CRC/checksum을 계산한다.  nthreads == 0 이면 CPU 수만큼.
+     */
+    void        validateFileParallel (unsigned nthreads = 0);
+
+    /** [WINDOW_PARSE]
+     *  CREATE
+     *   - topCell과 그 하위 셀 중 window(topCell 좌표계)와 겹칠 수 있는
+     *     element와 placement만 builder에 넘긴다.  셀의 bounding box는
+     *     CELLNAME의 S_BOUNDING_BOX property에서, 없으면 파일을 한 번 더
+     *     읽어 계산한다 (bbox-index.h).  window와 겹치지 않는 셀은 읽지
+     *     않는다.
+     *   - topCell이 없으면 false
+     */
+    bool        parseWindow (const char* topCell, const BoundingBox& window,
+                             OasisBuilder* builder);
+
+    /** [PRUNED_EXTRACT]
+     *  CREATE
+     *   - CreateLayoutDataBase(), parseWindow() 이후에 유효
+     */
+    const OasisExtractStats&  getExtractStats() const;
+
+    /** [CELL_GRAPH]
+     *  CREATE
+     *   - 파일의 셀 계층을 CellGraph(cell-graph.h)로 돌려준다.  node n은 셀
+     *     index의 n번째 셀이고, 이름은 getCellGraphName(n).  topological
+     *     order, level, top cell을 graph에서 바로 얻을 수 있다.
+     *   - 셀 index를 만들 수 없으면 Null.  graph는 파서가 소유한다.
+     */
+    const CellGraph*  getCellGraph();
+    const std::string&  getCellGraphName (Uint node) const;
+
+    /** [REP_INTERN]
+     *  CREATE
+     *   - builder에 넘기는 Repetition은 이 cache에 intern된 것이다.
+     *     같은 내용이면 같은 포인터이고, cache가 살아 있는 동안 유효하다.
+     *   - builder가 이 cache를 공유하면 intern()/getOffsets()가 해시 없이
+     *     포인터로 찾는다.  shared_ptr를 잡고 있으면 파서가 소멸된 뒤에도
+     *     repetition이 유효하다.
+     *   - parseFileParallel()의 worker는 각자 cache를 가지므로 해당 없음.
+     */
+    std::shared_ptr<RepetitionCache>  getRepetitionCache() const;
+
     // OasisBuilder는 파싱된 데이터를 수신하고 처리하는 역할을 하며,
     // Pimpl 패턴을 통해 구현 세부 사항을 감추고 인터페이스를 깔끔하게 유지할 수 있습니다.
 
@@ -0,0 +1,384 @@
+// oasis/pipeline-builder.cc -- run a builder on its own thread behind the parser
+//
+// last modified:   2026/10/17
+
+#include <cassert>
+
+#include "pipeline-builder.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+
+PipelineBuilder::PipelineBuilder (OasisBuilder* target,
+                                  size_t numBuffers,
+                                  size_t batchBytes)
+  : target(target),
+    batchBytes(batchBytes),
+    fullRing(numBuffers == 0 ? 1 : numBuffers),
+    freeRing(numBuffers == 0 ? 1 : numBuffers),
+    current(Null),
+    closed(false),
+    abandoned(false),
+    failed(false),
+    numBatches(0),
+    producerWaits(0)
+{
+    assert (target != Null);
+
+    // Leave room past batchBytes for the call that crosses it.
+    size_t  n = (numBuffers == 0 ? 1 : numBuffers);
+    for (size_t j = 0;  j < n;  ++j) {
+        buffers.emplace_back(new CallBatch(batchBytes + batchBytes/8));
+        bool  ok = freeRing.tryPush(buffers.back().get());
+        assert (ok);
+        (void) ok;
+    }
+    thread = std::thread(&PipelineBuilder::run, this);
+}
+
+
+PipelineBuilder::~PipelineBuilder()
+{
+    // Without endFile() the parse failed, and nobody wants the rest.
+    shutdown(true);
+}
+
+
+//----------------------------------------------------------------------
+// Parser side
+
+
+// packet -- the buffer to record the next call into
+// Waits for a free buffer if there is none.
+
+CallBatch&
+PipelineBuilder::packet()
+{
+    if (current == Null) {
+        if (! freeRing.tryPop(&current)) {
+            ++producerWaits;
+            Backoff  backoff;
+            do {
+                backoff.wait();
+            } while (! freeRing.tryPop(&current));
+        }
+    }
+    return *current;
+}
+
+
+// endPacket -- hand the buffer over once it holds a batch
+
+void
+PipelineBuilder::endPacket()
+{
+    if (current->byteSize() >= batchBytes) {
+        sendCurrent();
+        checkError();
+    }
+}
+
+
+void
+PipelineBuilder::sendCurrent()
+{
+    if (current == Null)
+        return;
+    // There are only as many buffers as the ring has slots.
+    bool  ok = fullRing.tryPush(current);
+    assert (ok);
+    (void) ok;
+    current = Null;
+    ++numBatches;
+}
+
+
+void
+PipelineBuilder::checkError()
+{
+    if (failed.load(std::memory_order_acquire))
+        std::rethrow_exception(error);
+}
+
+
+// shutdown -- stop the builder thread
+// With abandon, the buffers not yet replayed are dropped.
+
+void
+PipelineBuilder::shutdown (bool abandon)
+{
+    if (! thread.joinable())
+        return;
+    if (abandon)
+        abandoned.store(true, std::memory_order_release);
+    else
+        sendCurrent();
+    closed.store(true, std::memory_order_release);
+    thread.join();
+}
+
+
+//----------------------------------------------------------------------
+// Builder thread
+
+
+void
+PipelineBuilder::run()
+{
+    PointList  ptlist;          // reused for every point list
+    Backoff    backoff;
+
+    for (;;) {
+        CallBatch*  buf;
+        if (! fullRing.tryPop(&buf)) {
+            if (! closed.load(std::memory_order_acquire)) {
+                backoff.wait();
+                continue;
+            }
+            // The last buffer is pushed before closed is set.
+            if (! fullRing.tryPop(&buf))
+                break;
+        }
+        backoff.reset();
+
+        if (! failed.load(std::memory_order_relaxed)
+                &&  ! abandoned.load(std::memory_order_acquire)) {
+            try {
+                buf->replay(target, &ptlist);
+            }
+            catch (...) {
+                error = std::current_exception();
+                failed.store(true, std::memory_order_release);
+            }
+        }
+        buf->clear();
+        bool  ok = freeRing.tryPush(buf);
+        assert (ok);
+        (void) ok;
+    }
+}
+
+
+//----------------------------------------------------------------------
+// OasisBuilder methods
+
+
+void
+PipelineBuilder::beginFile (const string& version,
+                            const Oreal& unit,
+                            Validation::Scheme valScheme)
+{
+    packet().beginFile(version, unit, valScheme);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::endFile()
+{
+    packet().endFile();
+    shutdown(false);
+    checkError();
+}
+
+
+void
+PipelineBuilder::beginCell (CellName* cellName)
+{
+    packet().beginCell(cellName);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::endCell()
+{
+    packet().endCell();
+    endPacket();
+}
+
+
+void
+PipelineBuilder::beginPlacement (CellName* cellName,
+                                 long x, long y,
+                                 const Oreal&  mag,
+                                 const Oreal&  angle,
+                                 bool flip,
+                                 const Repetition*  rep)
+{
+    packet().beginPlacement(cellName, x, y, mag, angle, flip, rep);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::beginText (Ulong textlayer, Ulong texttype,
+                            long x, long y,
+                            TextString* text,
+                            const Repetition* rep)
+{
+    packet().beginText(textlayer, texttype, x, y, text, rep);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::beginRectangle (Ulong layer, Ulong datatype,
+                                 long x, long y,
+                                 long width, long height,
+                                 const Repetition*  rep)
+{
+    packet().beginRectangle(layer, datatype, x, y, width, height, rep);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::beginPolygon (Ulong layer, Ulong datatype,
+                               long x, long y,
+                               const PointList&  ptlist,
+                               const Repetition*  rep)
+{
+    packet().beginPolygon(layer, datatype, x, y, ptlist, rep);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::beginPath (Ulong layer, Ulong datatype,
+                            long x, long  y,
+                            long halfwidth,
+                            long startExtn, long endExtn,
+                            const PointList&  ptlist,
+                            const Repetition*  rep)
+{
+    packet().beginPath(layer, datatype, x, y, halfwidth,
+                       startExtn, endExtn, ptlist, rep);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::beginTrapezoid (Ulong layer, Ulong datatype,
+                                 long x, long  y,
+                                 const Trapezoid& trap,
+                                 const Repetition*  rep)
+{
+    packet().beginTrapezoid(layer, datatype, x, y, trap, rep);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::beginCircle (Ulong layer, Ulong datatype,
+                              long x, long y,
+                              long radius,
+                              const Repetition*  rep)
+{
+    packet().beginCircle(layer, datatype, x, y, radius, rep);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::beginXElement (Ulong attribute, const string& data)
+{
+    packet().beginXElement(attribute, data);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::beginXGeometry (Ulong layer, Ulong datatype,
+                                 long x, long y,
+                                 Ulong attribute,
+                                 const string& data,
+                                 const Repetition*  rep)
+{
+    packet().beginXGeometry(layer, datatype, x, y, attribute, data, rep);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::endElement()
+{
+    packet().endElement();
+    endPacket();
+}
+
+
+void
+PipelineBuilder::addCellProperty (Property* prop)
+{
+    packet().addCellProperty(prop);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::addFileProperty (Property* prop)
+{
+    packet().addFileProperty(prop);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::addElementProperty (Property* prop)
+{
+    packet().addElementProperty(prop);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::registerCellName (CellName* cellName)
+{
+    packet().registerCellName(cellName);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::registerTextString (TextString* textString)
+{
+    packet().registerTextString(textString);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::registerPropName (PropName* propName)
+{
+    packet().registerPropName(propName);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::registerPropString (PropString* propString)
+{
+    packet().registerPropString(propString);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::registerLayerName (LayerName* layerName)
+{
+    packet().registerLayerName(layerName);
+    endPacket();
+}
+
+
+void
+PipelineBuilder::registerXName (XName* xname)
+{
+    packet().registerXName(xname);
+    endPacket();
+}
+
+}  // namespace Oasis
+}  // namespace Anuvad
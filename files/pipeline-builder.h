@@ -0,0 +1,180 @@
+// oasis/pipeline-builder.h -- run a builder on its own thread behind the parser
+//
+// last modified:   2026/10/17
+//
+// Normally the parser calls its builder synchronously: decoding stops
+// while OasisCreator encodes a rectangle or JLayoutBuilder stores one.
+// PipelineBuilder overlaps the two on two cores.  Pass it to the parser
+// in place of the real builder:
+//
+//     OasisCreator     creator(outfile, options);
+//     PipelineBuilder  pipe(&creator);
+//     parser.parseFile(&pipe);
+//
+// The parser's thread records the calls into a buffer, a CallBatch
+// (call-batch.h), until it holds about batchBytes bytes.  A full buffer
+// is handed to the builder thread through a lock-free
+// single-producer/single-consumer ring (spsc-ring.h), and the builder
+// thread replays the calls on the target in order.  Used buffers are
+// cleared and return to the parser through a second ring for reuse.
+//
+// Backpressure.  There are numBuffers buffers in all.  When every one
+// is filled or being replayed, the parser waits for the builder thread
+// to return one.  So memory stays bounded however far the builder
+// falls behind.
+//
+// Pointer validity.  Each buffer holds copies of what the parser passes
+// and interns the repetitions in a cache of its own, which is emptied
+// with the buffer; see call-batch.h.  Name pointers are sent as they
+// are, so the parser must outlive endFile().  The ring's
+// release/acquire ordering makes everything the parser's thread wrote
+// into a buffer or a name before passing it visible to the builder
+// thread.  As with TeeBuilder, the parser and the target must not both
+// modify a name object.
+//
+// Errors.  If the target throws, the builder thread keeps returning
+// buffers without replaying them, and the exception is rethrown in the
+// parser's thread when it next hands over a buffer, or at endFile().
+// endFile() returns after the target's endFile() has returned.
+
+#ifndef OASIS_PIPELINE_BUILDER_H_INCLUDED
+#define OASIS_PIPELINE_BUILDER_H_INCLUDED
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "misc/utils.h"
+#include "oasis.h"
+#include "builder.h"
+#include "call-batch.h"
+#include "spsc-ring.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+using std::vector;
+using SoftJin::Ulong;
+using SoftJin::Ullong;
+
+
+class PipelineBuilder : public OasisBuilder {
+    OasisBuilder*       target;
+    size_t              batchBytes;
+
+    vector< std::unique_ptr<CallBatch> >  buffers;      // owns all
+    SpscRing<CallBatch*>  fullRing;         // parser -> builder thread
+    SpscRing<CallBatch*>  freeRing;         // builder thread -> parser
+    CallBatch*          current;            // being filled; Null if none
+
+    std::thread         thread;
+    std::atomic<bool>   closed;             // no more buffers will come
+    std::atomic<bool>   abandoned;          // do not replay what is left
+    std::atomic<bool>   failed;
+    std::exception_ptr  error;              // set before failed
+
+    // Statistics, for tuning numBuffers and batchBytes.
+    Ullong              numBatches;
+    Ullong              producerWaits;      // parser found no free buffer
+
+public:
+    explicit    PipelineBuilder (OasisBuilder* target,
+                                 size_t numBuffers = 8,
+                                 size_t batchBytes = 64*1024);
+    virtual     ~PipelineBuilder();
+
+    Ullong      getNumBatches() const       { return numBatches; }
+    Ullong      getProducerWaits() const    { return producerWaits; }
+
+    // OasisBuilder virtual methods.
+
+    virtual void  beginFile (const string& version,
+                             const Oreal& unit,
+                             Validation::Scheme valScheme);
+    virtual void  endFile();
+
+    virtual void  beginCell (CellName* cellName);
+    virtual void  endCell();
+
+    virtual void  beginPlacement (CellName* cellName,
+                                  long x, long y,
+                                  const Oreal&  mag,
+                                  const Oreal&  angle,
+                                  bool flip,
+                                  const Repetition*  rep);
+
+    virtual void  beginText (Ulong textlayer, Ulong texttype,
+                             long x, long y,
+                             TextString* text,
+                             const Repetition* rep);
+
+    virtual void  beginRectangle (Ulong layer, Ulong datatype,
+                                  long x, long y,
+                                  long width, long height,
+                                  const Repetition*  rep);
+
+    virtual void  beginPolygon (Ulong layer, Ulong datatype,
+                                long x, long y,
+                                const PointList&  ptlist,
+                                const Repetition*  rep);
+
+    virtual void  beginPath (Ulong layer, Ulong datatype,
+                             long x, long  y,
+                             long halfwidth,
+                             long startExtn, long endExtn,
+                             const PointList&  ptlist,
+                             const Repetition*  rep);
+
+    virtual void  beginTrapezoid (Ulong layer, Ulong datatype,
+                                  long x, long  y,
+                                  const Trapezoid& trap,
+                                  const Repetition*  rep);
+
+    virtual void  beginCircle (Ulong layer, Ulong datatype,
+                               long x, long y,
+                               long radius,
+                               const Repetition*  rep);
+
+    virtual void  beginXElement (Ulong attribute, const string& data);
+
+    virtual void  beginXGeometry (Ulong layer, Ulong datatype,
+                                  long x, long y,
+                                  Ulong attribute,
+                                  const string& data,
+                                  const Repetition*  rep);
+
+    virtual void  endElement();
+
+    virtual void  addCellProperty (Property* prop);
+    virtual void  addFileProperty (Property* prop);
+    virtual void  addElementProperty (Property* prop);
+
+    virtual void  registerCellName   (CellName*   cellName);
+    virtual void  registerTextString (TextString* textString);
+    virtual void  registerPropName   (PropName*   propName);
+    virtual void  registerPropString (PropString* propString);
+    virtual void  registerLayerName  (LayerName*  layerName);
+    virtual void  registerXName      (XName*      xname);
+
+private:
+    CallBatch&  packet();
+    void        endPacket();
+    void        sendCurrent();
+    void        shutdown (bool abandon);
+    void        checkError();
+    void        run();
+
+private:
+                PipelineBuilder (const PipelineBuilder&);       // forbidden
+    void        operator= (const PipelineBuilder&);             // forbidden
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_PIPELINE_BUILDER_H_INCLUDED
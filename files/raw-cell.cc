@@ -0,0 +1,69 @@
+// oasis/raw-cell.cc -- copying cells without decoding them
+//
+// last modified:   2026/10/17
+
+#include <exception>
+
+#include "rectypes.h"
+#include "mapped-scanner.h"
+#include "raw-cell.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+
+// FindRawCell
+// The contents end at the first record that is not part of the cell:
+// the next CELL, a name record, or END.  If that record is inside a
+// CBLOCK it must be the first one there, or the CBLOCK straddles the
+// end of the cell.  The tokenizer inflates the CBLOCKs in the cell to
+// see the references in them, but nothing is decoded.
+//
+// Malformed contents make this return false too.  The parser then
+// meets them itself and reports the error properly.
+
+bool
+FindRawCell (const MappedFile& mfile, Ullong cellOffset,
+             /*out*/ CellKey* cell,
+             /*out*/ Ullong* begin, /*out*/ Ullong* end,
+             /*out*/ bool* compressed, /*out*/ NameRefs* refs)
+{
+    MappedScanner  scanner(mfile);
+    OasisRecordTokenizer  tokenizer(scanner);
+    const RecordCursor&  curs = tokenizer.cursor();
+
+    try {
+        tokenizer.seekTo(cellOffset);
+        if (! tokenizer.next()  ||  curs.inCblock
+                ||  (curs.recID != RID_CELL_REF
+                     &&  curs.recID != RID_CELL_NAMED))
+            return false;
+
+        // next() has read all of the CELL record.
+        *cell = curs.ref;
+        *begin = scanner.currFileOffset();
+        *compressed = false;
+        refs->clear();
+        tokenizer.collectNameRefs(refs);
+
+        while (tokenizer.next()) {
+            if (! curs.inCell  ||  curs.cellOffset != cellOffset) {
+                if (curs.inCblock  &&  curs.blockOffset != 0)
+                    return false;
+                *end = curs.offset;
+                return true;
+            }
+            if (curs.recID == RID_CBLOCK)
+                *compressed = true;
+        }
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+    *end = mfile.getSize();
+    return true;
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
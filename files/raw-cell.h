@@ -0,0 +1,106 @@
+// oasis/raw-cell.h -- copying cells without decoding them
+//
+// last modified:   2026/10/17
+//
+// When a cell is copied unchanged, decoding it into builder calls only
+// for OasisCreator to encode and deflate it again wastes nearly all the
+// time of the copy.  The records of a cell depend on nothing outside
+// it except the names they refer to: the modal variables are reset at
+// every CELL record (Section 10.1).  So the bytes that follow the CELL
+// record in the input, CBLOCKs and all, can go into the output as they
+// are, provided every reference-number in them denotes the same name
+// in the output as in the input.
+//
+// A builder that also derives from OasisRawCellBuilder is offered each
+// cell before the parser parses it.  The parser finds out with
+// dynamic_cast, as for OasisArenaBuilder.  copyRawCell() gets the
+// cell's name and a RawCell that holds
+//
+//   - the contents: the bytes from the end of the CELL record to the
+//     end of the cell, in the mapped input file
+//   - every distinct reference-number in the contents, with the name it
+//     denotes in the input
+//   - whether names also appear as strings
+//
+// If the builder takes the cell it returns true, and the parser makes
+// no beginCell() ... endCell() calls for it.  If it returns false it
+// must not have written anything, and the parser parses the cell as
+// usual.  A builder renumbers names by taking the second path.
+//
+// The parser offers only cells whose contents can be cut out of the
+// file: the CELL record is not compressed and no CBLOCK holds records
+// of this cell and of what follows it.  It offers none when it would
+// otherwise change the contents (text or extensions not wanted), and
+// none unless the input is mapped.  Only the cells it parses on its
+// own are offered, i.e. those of parseCell(),
+// CreateLayoutDataBase() and the workers of parseFileParallel();
+// parseFile() reads the file straight through.
+
+#ifndef OASIS_RAW_CELL_H_INCLUDED
+#define OASIS_RAW_CELL_H_INCLUDED
+
+#include <cstddef>
+#include <vector>
+
+#include "misc/utils.h"
+#include "names.h"
+#include "mapped-file.h"
+#include "rec-tokenizer.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::vector;
+using SoftJin::Uchar;
+using SoftJin::Ullong;
+
+
+// NameRef -- a reference-number in the input and the name it denotes
+
+template <typename NameT>
+struct NameRef {
+    Ullong      refnum;
+    NameT*      name;
+};
+
+
+struct RawCell {
+    const Uchar*    data;               // contents of the cell
+    size_t          size;
+    bool            compressed;         // contents include CBLOCKs
+
+    vector< NameRef<CellName> >    cellRefs;
+    vector< NameRef<TextString> >  textRefs;
+    vector< NameRef<PropName> >    propNameRefs;
+    vector< NameRef<PropString> >  propStringRefs;
+
+    bool            cellNameStrings;    // PLACEMENT with cellname-string
+    bool            textStrings;        // TEXT with text-string
+    bool            propNameStrings;    // PROPERTY with propname-string
+};
+
+
+class OasisRawCellBuilder {
+public:
+    virtual     ~OasisRawCellBuilder() { }
+
+    // copyRawCell -- copy the cell from raw, or return false
+    virtual bool  copyRawCell (CellName* cellName, const RawCell& raw) = 0;
+};
+
+
+// FindRawCell -- where the contents of the cell at cellOffset lie
+// Sets *cell to the cell as the CELL record names it, [*begin, *end) to
+// the contents, and collects the names they refer to in refs.  Returns
+// false if the contents cannot be cut out of the file as they are.
+
+bool    FindRawCell (const MappedFile& mfile, Ullong cellOffset,
+                     /*out*/ CellKey* cell,
+                     /*out*/ Ullong* begin, /*out*/ Ullong* end,
+                     /*out*/ bool* compressed, /*out*/ NameRefs* refs);
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_RAW_CELL_H_INCLUDED
@@ -0,0 +1,518 @@
+// oasis/rec-tokenizer.cc -- record boundaries without record contents
+//
+// last modified:   2026/10/17
+
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+#include "oasis.h"
+#include "rectypes.h"
+#include "rec-tokenizer.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+
+// Bits of the info-bytes that say which optional fields are present.
+// Only the bits needed to step over a record are named here.
+
+namespace {
+
+const Uint  PlaceCellBit      = 0x80;   // PLACEMENT: CNXYRAAF, CNXYRMAF
+const Uint  PlaceRefnumBit    = 0x40;
+const Uint  PlaceXBit         = 0x20;
+const Uint  PlaceYBit         = 0x10;
+const Uint  PlaceRepBit       = 0x08;
+const Uint  PlaceMagBit       = 0x04;   // PLACEMENT_TRANSFORM only
+const Uint  PlaceAngleBit     = 0x02;
+
+const Uint  ElemXBit          = 0x10;   // TEXT and all geometry records
+const Uint  ElemYBit          = 0x08;
+const Uint  ElemRepBit        = 0x04;
+const Uint  ElemDatatypeBit   = 0x02;   // TEXT: texttype
+const Uint  ElemLayerBit      = 0x01;   // TEXT: textlayer
+
+const Uint  TextStringBit     = 0x40;   // TEXT: 0CNXYRTL
+const Uint  TextRefnumBit     = 0x20;
+
+const Uint  RectSquareBit     = 0x80;   // RECTANGLE: SWHXYRDL
+const Uint  WidthBit          = 0x40;   // also PATH, TRAPEZOID, CTRAPEZOID
+const Uint  HeightBit         = 0x20;   // RECTANGLE, (C)TRAPEZOID
+const Uint  PointListBit      = 0x20;   // POLYGON, PATH
+const Uint  PathExtensionBit  = 0x80;
+const Uint  CtrapTypeBit      = 0x80;
+const Uint  RadiusBit         = 0x20;
+
+const Uint  PropNameBit       = 0x04;   // PROPERTY: UUUUVCNS
+const Uint  PropRefnumBit     = 0x02;
+const Uint  PropReuseBit      = 0x08;
+
+
+inline bool
+HasInfoByte (Ulong recID)
+{
+    return ((recID >= RID_PLACEMENT  &&  recID <= RID_PROPERTY)
+            ||  recID == RID_XGEOMETRY);
+}
+
+
+// EndsCell -- true for the records that may not appear inside a cell
+// A cell's contents run from its CELL record up to the next CELL
+// record, name record or END.
+
+inline bool
+EndsCell (Ulong recID)
+{
+    return (recID == RID_END
+            ||  (recID >= RID_CELLNAME_IMPLICIT
+                 &&  recID <= RID_LAYERNAME_TEXT)
+            ||  recID == RID_XNAME_IMPLICIT  ||  recID == RID_XNAME);
+}
+
+}  // unnamed namespace
+
+
+void
+NameRefs::clear()
+{
+    cellRefnums.clear();
+    cellNames.clear();
+    textRefnums.clear();
+    propNameRefnums.clear();
+    propStringRefnums.clear();
+    textStrings = false;
+    propNameStrings = false;
+}
+
+
+OasisRecordTokenizer::OasisRecordTokenizer (MappedScanner& scanner)
+  : scanner(scanner)
+{
+    nameRefs = Null;
+    rewind();
+}
+
+
+// rewind -- position the tokenizer before the START record
+
+void
+OasisRecordTokenizer::rewind()
+{
+    seekTo(OasisMagicLength);
+    recordCount = 0;
+}
+
+
+// seekTo -- position the tokenizer before the record at offset
+// offset must be where a record begins outside any CBLOCK, for example
+// the offset of a CELL record or of the CBLOCK that contains it.  The
+// modal placement-cell becomes undefined, as it is at a CELL record.
+
+void
+OasisRecordTokenizer::seekTo (Ullong offset)
+{
+    scanner.seekTo(offset);
+    pending = false;
+    finished = false;
+    haveModalCell = false;
+
+    curs.recID = RID_PAD;
+    curs.offset = curs.blockEnd = offset;
+    curs.blockOffset = 0;
+    curs.inCblock = false;
+    curs.haveInfoByte = false;
+    curs.infoByte = 0;
+    curs.inCell = false;
+    curs.cellOffset = 0;
+    curs.haveRef = false;
+}
+
+
+// next -- advance to the next record
+// Returns false after the END record, or at the end of the file if
+// there is no END record.  Errors in the parts of the records that it
+// reads or skips make the scanner throw runtime_error.
+
+bool
+OasisRecordTokenizer::next()
+{
+    if (finished)
+        return false;
+    if (pending)
+        skipRest();
+    if (scanner.atEnd()) {
+        finished = true;
+        return false;
+    }
+
+    curs.offset = scanner.currFileOffset();
+    curs.blockOffset = scanner.currBlockOffset();
+    curs.blockEnd = scanner.cblockEndOffset();
+    curs.inCblock = scanner.inCompressedBlock();
+
+    curs.recID = scanner.readUInt();
+    curs.haveInfoByte = HasInfoByte(curs.recID);
+    curs.infoByte = (curs.haveInfoByte ? scanner.readByte() : 0);
+    curs.haveRef = false;
+    pending = true;
+    ++recordCount;
+
+    switch (curs.recID) {
+        case RID_CELL_REF:
+        case RID_CELL_NAMED:
+            readCellKey(curs.recID == RID_CELL_REF, &curs.ref);
+            curs.haveRef = true;
+            curs.inCell = true;
+            curs.cell = curs.ref;
+            curs.cellOffset = curs.offset;
+            haveModalCell = false;      // modal variables reset by CELL
+            break;
+
+        case RID_PLACEMENT:
+        case RID_PLACEMENT_TRANSFORM:
+            if (curs.infoByte & PlaceCellBit) {
+                readCellKey(curs.infoByte & PlaceRefnumBit, &modalCell);
+                haveModalCell = true;
+                if (nameRefs != Null) {
+                    if (modalCell.byRefnum)
+                        nameRefs->cellRefnums.push_back(modalCell.refnum);
+                    else
+                        nameRefs->cellNames.push_back(modalCell.name);
+                }
+            }
+            if (haveModalCell) {
+                curs.ref = modalCell;
+                curs.haveRef = true;
+            }
+            break;
+
+        case RID_END:
+            finished = true;
+            pending = false;
+            curs.inCell = false;
+            break;
+
+        default:
+            if (EndsCell(curs.recID))
+                curs.inCell = false;
+            break;
+    }
+    return true;
+}
+
+
+// skipCblock -- step over the current CBLOCK record without inflating it
+// Only valid when the cursor is at a CBLOCK record that has not been
+// claimed.  The next record is the one after the compressed data.
+
+void
+OasisRecordTokenizer::skipCblock()
+{
+    assert (curs.recID == RID_CBLOCK  &&  pending);
+    scanner.skipCblock();
+    pending = false;
+}
+
+
+void
+OasisRecordTokenizer::readCellKey (bool byRefnum, /*out*/ CellKey* key)
+{
+    key->byRefnum = byRefnum;
+    if (byRefnum) {
+        key->refnum = scanner.readUInt64();
+        key->name.clear();
+    } else {
+        key->refnum = 0;
+        StringView  sv = scanner.readString();
+        key->name.assign(sv.data, sv.size);
+    }
+}
+
+
+// skipRest -- step over what remains of the current record
+// next() has already read the record-ID, the info-byte, and the cell
+// reference of CELL and PLACEMENT records.
+
+void
+OasisRecordTokenizer::skipRest()
+{
+    pending = false;
+    switch (curs.recID) {
+        case RID_PAD:
+        case RID_XYABSOLUTE:
+        case RID_XYRELATIVE:
+        case RID_PROPERTY_REPEAT:
+        case RID_CELL_REF:
+        case RID_CELL_NAMED:
+            break;
+
+        case RID_START:
+            skipStart();
+            break;
+
+        case RID_CELLNAME_IMPLICIT:
+        case RID_TEXTSTRING_IMPLICIT:
+        case RID_PROPNAME_IMPLICIT:
+        case RID_PROPSTRING_IMPLICIT:
+            (void) scanner.readString();
+            break;
+
+        case RID_CELLNAME:
+        case RID_TEXTSTRING:
+        case RID_PROPNAME:
+        case RID_PROPSTRING:
+            (void) scanner.readString();
+            scanner.skipUInt();
+            break;
+
+        case RID_LAYERNAME_GEOMETRY:
+        case RID_LAYERNAME_TEXT:
+            (void) scanner.readString();
+            scanner.skipInterval();
+            scanner.skipInterval();
+            break;
+
+        case RID_PLACEMENT:
+        case RID_PLACEMENT_TRANSFORM:
+            skipPlacement();
+            break;
+
+        case RID_TEXT:
+            skipText();
+            break;
+
+        case RID_RECTANGLE:
+        case RID_POLYGON:
+        case RID_PATH:
+        case RID_TRAPEZOID:
+        case RID_TRAPEZOID_A:
+        case RID_TRAPEZOID_B:
+        case RID_CTRAPEZOID:
+        case RID_CIRCLE:
+            skipGeometry();
+            break;
+
+        case RID_PROPERTY:
+            skipProperty();
+            break;
+
+        case RID_XNAME_IMPLICIT:
+        case RID_XNAME:
+            scanner.skipUInt();
+            (void) scanner.readString();
+            if (curs.recID == RID_XNAME)
+                scanner.skipUInt();
+            break;
+
+        case RID_XELEMENT:
+            scanner.skipUInt();
+            (void) scanner.readString();
+            break;
+
+        case RID_XGEOMETRY:
+            scanner.skipUInt();
+            if (curs.infoByte & ElemLayerBit)     scanner.skipUInt();
+            if (curs.infoByte & ElemDatatypeBit)  scanner.skipUInt();
+            (void) scanner.readString();
+            skipPosition(curs.infoByte);
+            break;
+
+        case RID_CBLOCK:
+            scanner.enterCblock();
+            break;
+
+        default:
+            throw std::runtime_error(
+                    scanner.getMappedFile().getFilename()
+                    + ": invalid record type "
+                    + std::to_string(curs.recID) + " at offset "
+                    + std::to_string(curs.offset));
+    }
+}
+
+
+// skipStart -- Section 13
+// `1' version-string unit offset-flag [table-offsets]
+
+void
+OasisRecordTokenizer::skipStart()
+{
+    (void) scanner.readString();
+    (void) scanner.readReal();
+    if (scanner.readUInt() == 0) {
+        for (int j = 0;  j < 12;  ++j)
+            scanner.skipUInt();
+    }
+}
+
+
+// skipPlacement -- Section 22
+// The cell reference has been read by next().
+
+void
+OasisRecordTokenizer::skipPlacement()
+{
+    Uint  info = curs.infoByte;
+    if (curs.recID == RID_PLACEMENT_TRANSFORM) {
+        if (info & PlaceMagBit)    (void) scanner.readReal();
+        if (info & PlaceAngleBit)  (void) scanner.readReal();
+    }
+    if (info & PlaceXBit)    scanner.skipUInt();
+    if (info & PlaceYBit)    scanner.skipUInt();
+    if (info & PlaceRepBit)  scanner.skipRepetition();
+}
+
+
+// skipText -- Section 23
+// `19' text-info-byte [reference-number | text-string]
+//      [textlayer] [texttype] [x] [y] [repetition]
+
+void
+OasisRecordTokenizer::skipText()
+{
+    Uint  info = curs.infoByte;
+    if (info & TextStringBit) {
+        if (! (info & TextRefnumBit)) {
+            (void) scanner.readString();
+            if (nameRefs != Null)
+                nameRefs->textStrings = true;
+        } else if (nameRefs != Null)
+            nameRefs->textRefnums.push_back(scanner.readUInt64());
+        else
+            scanner.skipUInt();
+    }
+    if (info & ElemLayerBit)     scanner.skipUInt();
+    if (info & ElemDatatypeBit)  scanner.skipUInt();
+    skipPosition(info);
+}
+
+
+// skipGeometry -- Sections 24-29
+// All geometry records begin with info-byte, layer and datatype and end
+// with x, y and repetition.  Only the fields in between differ.
+
+void
+OasisRecordTokenizer::skipGeometry()
+{
+    Uint  info = curs.infoByte;
+    if (info & ElemLayerBit)     scanner.skipUInt();
+    if (info & ElemDatatypeBit)  scanner.skipUInt();
+
+    switch (curs.recID) {
+        case RID_RECTANGLE:
+            if (info & WidthBit)  scanner.skipUInt();
+            if ((info & HeightBit)  &&  !(info & RectSquareBit))
+                scanner.skipUInt();
+            break;
+
+        case RID_POLYGON:
+            if (info & PointListBit)  (void) scanner.readPointListView();
+            break;
+
+        case RID_PATH:
+            if (info & WidthBit)  scanner.skipUInt();
+            if (info & PathExtensionBit) {
+                Ulong  scheme = scanner.readUInt();
+                if (((scheme >> 2) & 3) == 3)  scanner.skipUInt();
+                if ((scheme & 3) == 3)         scanner.skipUInt();
+            }
+            if (info & PointListBit)  (void) scanner.readPointListView();
+            break;
+
+        case RID_TRAPEZOID:
+        case RID_TRAPEZOID_A:
+        case RID_TRAPEZOID_B:
+            if (info & WidthBit)   scanner.skipUInt();
+            if (info & HeightBit)  scanner.skipUInt();
+            scanner.skipUInt();
+            if (curs.recID == RID_TRAPEZOID)
+                scanner.skipUInt();
+            break;
+
+        case RID_CTRAPEZOID:
+            if (info & CtrapTypeBit)  scanner.skipUInt();
+            if (info & WidthBit)      scanner.skipUInt();
+            if (info & HeightBit)     scanner.skipUInt();
+            break;
+
+        case RID_CIRCLE:
+            if (info & RadiusBit)  scanner.skipUInt();
+            break;
+    }
+    skipPosition(info);
+}
+
+
+// skipProperty -- Section 31
+// `28' prop-info-byte [reference-number | propname-string]
+//      [prop-value-count] [<property-value>*]
+// prop-info-byte ::= UUUUVCNS
+
+void
+OasisRecordTokenizer::skipProperty()
+{
+    Uint  info = curs.infoByte;
+    if (info & PropNameBit) {
+        if (! (info & PropRefnumBit)) {
+            (void) scanner.readString();
+            if (nameRefs != Null)
+                nameRefs->propNameStrings = true;
+        } else if (nameRefs != Null)
+            nameRefs->propNameRefnums.push_back(scanner.readUInt64());
+        else
+            scanner.skipUInt();
+    }
+    if (info & PropReuseBit)
+        return;
+
+    Ullong  count = info >> 4;
+    if (count == 15)
+        count = scanner.readUInt64();
+    if (nameRefs != Null)
+        skipPropValues(count);
+    else {
+        while (count-- != 0)
+            scanner.skipPropValue();
+    }
+}
+
+
+// skipPropValues -- MappedScanner::skipPropValue() noting PROPSTRING refs
+
+void
+OasisRecordTokenizer::skipPropValues (Ullong count)
+{
+    for ( ;  count != 0;  --count) {
+        Ulong  type = scanner.readUInt();
+        if (type <= 7)
+            (void) scanner.readRealBody(type);
+        else if (type == 8  ||  type == 9)
+            scanner.skipUInt();
+        else if (type <= 12)
+            (void) scanner.readString();
+        else if (type <= 15)
+            nameRefs->propStringRefnums.push_back(scanner.readUInt64());
+        else
+            throw std::runtime_error(
+                    scanner.getMappedFile().getFilename()
+                    + ": invalid property value type "
+                    + std::to_string(type) + " at offset "
+                    + std::to_string(curs.offset));
+    }
+}
+
+
+// skipPosition -- the x, y and repetition that end element records
+
+void
+OasisRecordTokenizer::skipPosition (Uint info)
+{
+    if (info & ElemXBit)    scanner.skipUInt();
+    if (info & ElemYBit)    scanner.skipUInt();
+    if (info & ElemRepBit)  scanner.skipRepetition();
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
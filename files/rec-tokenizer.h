@@ -0,0 +1,181 @@
+// oasis/rec-tokenizer.h -- record boundaries without record contents
+//
+// last modified:   2026/10/17
+//
+// Many passes over an OASIS file only need its structure: where each
+// record starts, what type it is, which cell it belongs to and which
+// cells it places.  Cell-offset indexing, hierarchy discovery and the
+// structural statistics of the analyzer are examples.  Running them
+// through OasisRecordReader decodes every point list, repetition and
+// property only to throw them away.
+//
+// OasisRecordTokenizer walks the records of a mapped file (see
+// mapped-scanner.h) and stops at each one with a cursor describing it.
+// It decodes only the record-ID, the info-byte and, for CELL and
+// PLACEMENT records, the cell reference.  When the caller asks for the
+// next record, the rest of the current one is skipped by reading just
+// the integers that give the lengths of the variable parts; strings
+// and point lists are stepped over, not decoded.
+//
+// A caller that wants a particular record in full decodes the rest of
+// it with the primitives of getScanner(), which is positioned just
+// after the fields the tokenizer decoded, and then calls claimRecord()
+// so that the tokenizer does not try to skip it again.
+//
+// CBLOCKs are transparent by default: the tokenizer stops at the
+// CBLOCK record itself, and if the caller does nothing the next
+// records come from the inflated block.  skipCblock() instead steps
+// over the compressed bytes without inflating them.
+//
+// A caller that must know which names the records refer to, e.g. to
+// decide whether a cell can be copied without renumbering, passes a
+// NameRefs to collectNameRefs().  The tokenizer then notes the
+// reference-numbers and name strings in the records it skips.
+
+#ifndef OASIS_REC_TOKENIZER_H_INCLUDED
+#define OASIS_REC_TOKENIZER_H_INCLUDED
+
+#include <string>
+#include <vector>
+#include "misc/utils.h"
+#include "mapped-scanner.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+using std::vector;
+using SoftJin::Uint;
+using SoftJin::Ulong;
+using SoftJin::Ullong;
+
+
+// CellKey -- a cell as a CELL or PLACEMENT record names it
+// Only one of refnum and name is meaningful, depending on byRefnum.
+// The tokenizer does not resolve reference-numbers; the CELLNAME
+// records that define them may come at the end of the file.
+
+struct CellKey {
+    bool        byRefnum;
+    Ullong      refnum;
+    string      name;
+
+    CellKey() : byRefnum(false), refnum(0) { }
+
+    bool        sameAs (const CellKey& k) const {
+                    return (byRefnum == k.byRefnum
+                            &&  (byRefnum ? refnum == k.refnum
+                                          : name == k.name));
+                }
+};
+
+
+// RecordCursor -- what the tokenizer knows about the current record
+//
+// recID            record type
+// offset           file offset of the record, or of the CBLOCK that
+//                  contains it
+// blockOffset      offset of the record in the inflated CBLOCK; 0
+//                  outside CBLOCKs
+// blockEnd         file offset just past the CBLOCK containing the
+//                  record; equal to offset outside CBLOCKs
+// inCblock         the record is inside a CBLOCK
+// haveInfoByte     infoByte is valid; true for PLACEMENT, TEXT, the
+//                  geometry records, PROPERTY and XGEOMETRY
+// infoByte         the record's info-byte
+// inCell           the record is part of a cell's contents (a CELL
+//                  record counts as part of its own cell)
+// cellOffset       if inCell, the offset of the cell's CELL record, as
+//                  in offset
+// cell             if inCell, the cell
+// haveRef          ref is valid.  True for CELL records and for
+//                  PLACEMENT records once the modal placement-cell is
+//                  defined.
+// ref              the cell a CELL record begins or a PLACEMENT places;
+//                  for a PLACEMENT without an explicit cell this is
+//                  the modal placement-cell
+
+struct RecordCursor {
+    Ulong       recID;
+    Ullong      offset;
+    Ullong      blockOffset;
+    Ullong      blockEnd;
+    bool        inCblock;
+    bool        haveInfoByte;
+    Uint        infoByte;
+    bool        inCell;
+    Ullong      cellOffset;
+    CellKey     cell;
+    bool        haveRef;
+    CellKey     ref;
+};
+
+
+// NameRefs -- the names referred to by the records skipped
+// Reference-numbers are listed in order of appearance, with
+// duplicates.  Names given as strings are noted only for cells, which
+// callers need for the hierarchy; for the others a flag says whether
+// any appeared.
+
+struct NameRefs {
+    vector<Ullong>  cellRefnums;        // PLACEMENT
+    vector<string>  cellNames;          // PLACEMENT with cellname-string
+    vector<Ullong>  textRefnums;        // TEXT
+    vector<Ullong>  propNameRefnums;    // PROPERTY
+    vector<Ullong>  propStringRefnums;  // property values of types 13-15
+    bool            textStrings;        // some TEXT has a text-string
+    bool            propNameStrings;    // some PROPERTY has a propname-string
+
+    NameRefs() : textStrings(false), propNameStrings(false) { }
+    void        clear();
+};
+
+
+class OasisRecordTokenizer {
+    MappedScanner&  scanner;
+    RecordCursor    curs;
+    bool            pending;        // rest of current record not yet read
+    bool            finished;       // END record or end of file seen
+    bool            haveModalCell;
+    CellKey         modalCell;      // modal placement-cell
+    Ullong          recordCount;
+    NameRefs*       nameRefs;       // Null unless collecting
+
+public:
+    explicit    OasisRecordTokenizer (MappedScanner& scanner);
+
+    void        rewind();
+    void        seekTo (Ullong offset);
+    bool        next();
+    const RecordCursor&  cursor() const     { return curs; }
+    Ullong      getRecordCount() const      { return recordCount; }
+
+    // Opting in to decoding the current record.
+    MappedScanner&  getScanner()            { return scanner; }
+    void        claimRecord()               { pending = false; }
+    void        skipCblock();
+
+    // Collecting name references; Null stops.
+    void        collectNameRefs (NameRefs* refs)  { nameRefs = refs; }
+
+private:
+    void        skipRest();
+    void        skipStart();
+    void        skipPlacement();
+    void        skipText();
+    void        skipGeometry();
+    void        skipProperty();
+    void        skipPropValues (Ullong count);
+    void        skipPosition (Uint info);
+    void        readCellKey (bool byRefnum, /*out*/ CellKey* key);
+
+private:
+                OasisRecordTokenizer (const OasisRecordTokenizer&);
+    void        operator= (const OasisRecordTokenizer&);
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_REC_TOKENIZER_H_INCLUDED
@@ -0,0 +1,489 @@
+// oasis/rep-intern.cc -- interning table for Repetition objects
+//
+// last modified:   2026/10/17
+
+#include <algorithm>
+
+#include "varint.h"
+#include "rep-intern.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+
+namespace {
+
+// Mix -- fold one value into an FNV-1a style hash
+
+inline size_t
+Mix (size_t hash, long long value)
+{
+    return ((hash ^ static_cast<size_t>(value)) * size_t(1099511628211ULL));
+}
+
+
+inline Ullong
+Magnitude (long val) {
+    return (val < 0 ? Ullong(0) - Ullong(val) : Ullong(val));
+}
+
+
+// GDeltaSize -- Section 7.5: the 1-integer form for the eight
+// octangular directions, else the 2-integer form.
+
+size_t
+GDeltaSize (const Delta& d)
+{
+    Ullong  ax = Magnitude(d.x);
+    Ullong  ay = Magnitude(d.y);
+    if (ax == 0  ||  ay == 0  ||  ax == ay)
+        return UIntSize(std::max(ax, ay) << 4);
+    return UIntSize((ax << 2) | 3) + UIntSize((ay << 1) | 1);
+}
+
+}  // unnamed namespace
+
+
+RepetitionCache::RepetitionCache()
+{
+    lookups = 0;
+    hits = 0;
+}
+
+
+// intern -- return the cache's copy of rep, adding one if needed
+// Returns Null if rep is Null.
+
+const Repetition*
+RepetitionCache::intern (const Repetition* rep)
+{
+    if (rep == Null)
+        return Null;
+    return &lookup(rep)->rep;
+}
+
+
+// clear -- forget all interned repetitions
+// Invalidates every pointer intern() has returned.  The statistics are
+// kept.
+
+void
+RepetitionCache::clear()
+{
+    entriesByRep.clear();
+    entriesByHash.clear();
+    entries.clear();
+}
+
+
+// getPositionCount -- number of positions rep expands to
+// 1 for Null.
+
+Ullong
+RepetitionCache::getPositionCount (const Repetition* rep)
+{
+    if (rep == Null)
+        return 1;
+    return lookup(rep)->numPositions;
+}
+
+
+// getOffsets -- offsets of the positions rep expands to
+// The offsets are relative to the element's own position, in the order
+// the repetition lists them.  Null yields the single offset (0,0).  The
+// vector is owned by the cache and lives as long as it does.
+
+const vector<Delta>&
+RepetitionCache::getOffsets (const Repetition* rep)
+{
+    static const vector<Delta>  NoRepetition(1, Delta(0, 0));
+    if (rep == Null)
+        return NoRepetition;
+
+    Entry*  entry = lookup(rep);
+    if (! entry->haveOffsets) {
+        ExpandOffsets(entry->rep, &entry->offsets);
+        entry->haveOffsets = true;
+    }
+    return entry->offsets;
+}
+
+
+// lookup -- find or add the entry for rep
+// Pointers handed out by intern() are found without hashing.
+
+RepetitionCache::Entry*
+RepetitionCache::lookup (const Repetition* rep)
+{
+    ++lookups;
+    std::unordered_map<const Repetition*, Entry*>::const_iterator
+        riter = entriesByRep.find(rep);
+    if (riter != entriesByRep.end()) {
+        ++hits;
+        return riter->second;
+    }
+
+    size_t  hash = Hash(*rep);
+    typedef std::unordered_multimap<size_t, Entry*>::const_iterator  HashIter;
+    std::pair<HashIter, HashIter>  range = entriesByHash.equal_range(hash);
+    for (HashIter iter = range.first;  iter != range.second;  ++iter) {
+        if (Equal(iter->second->rep, *rep)) {
+            ++hits;
+            return iter->second;
+        }
+    }
+
+    entries.push_back(Entry(*rep, hash));
+    Entry*  entry = &entries.back();
+    entriesByHash.insert(std::make_pair(hash, entry));
+    entriesByRep[&entry->rep] = entry;
+    return entry;
+}
+
+
+//----------------------------------------------------------------------
+// Content operations.  These look at a repetition only through its
+// accessors, and only at the fields that its type uses.
+
+
+/*static*/ size_t
+RepetitionCache::Hash (const Repetition& rep)
+{
+    size_t  hash = Mix(size_t(14695981039346656037ULL), rep.getType());
+
+    switch (rep.getType()) {
+        case Rep_Matrix:
+            hash = Mix(hash, rep.getMatrixXdimen());
+            hash = Mix(hash, rep.getMatrixYdimen());
+            hash = Mix(hash, rep.getMatrixXspace());
+            hash = Mix(hash, rep.getMatrixYspace());
+            break;
+
+        case Rep_UniformX:
+            hash = Mix(hash, rep.getDimen());
+            hash = Mix(hash, rep.getUniformXspace());
+            break;
+
+        case Rep_UniformY:
+            hash = Mix(hash, rep.getDimen());
+            hash = Mix(hash, rep.getUniformYspace());
+            break;
+
+        case Rep_VaryingX:
+        case Rep_GridVaryingX:
+            hash = Mix(hash, rep.getDimen());
+            if (rep.getType() == Rep_GridVaryingX)
+                hash = Mix(hash, rep.getGrid());
+            for (Ulong j = 0;  j < rep.getDimen();  ++j)
+                hash = Mix(hash, rep.getVaryingXoffset(j));
+            break;
+
+        case Rep_VaryingY:
+        case Rep_GridVaryingY:
+            hash = Mix(hash, rep.getDimen());
+            if (rep.getType() == Rep_GridVaryingY)
+                hash = Mix(hash, rep.getGrid());
+            for (Ulong j = 0;  j < rep.getDimen();  ++j)
+                hash = Mix(hash, rep.getVaryingYoffset(j));
+            break;
+
+        case Rep_TiltedMatrix: {
+            Delta  ndelta = rep.getMatrixNdelta();
+            Delta  mdelta = rep.getMatrixMdelta();
+            hash = Mix(hash, rep.getMatrixNdimen());
+            hash = Mix(hash, rep.getMatrixMdimen());
+            hash = Mix(hash, ndelta.x);
+            hash = Mix(hash, ndelta.y);
+            hash = Mix(hash, mdelta.x);
+            hash = Mix(hash, mdelta.y);
+            break;
+        }
+
+        case Rep_Diagonal: {
+            Delta  delta = rep.getDiagonalDelta();
+            hash = Mix(hash, rep.getDimen());
+            hash = Mix(hash, delta.x);
+            hash = Mix(hash, delta.y);
+            break;
+        }
+
+        case Rep_Arbitrary:
+        case Rep_GridArbitrary:
+            hash = Mix(hash, rep.getDimen());
+            if (rep.getType() == Rep_GridArbitrary)
+                hash = Mix(hash, rep.getGrid());
+            for (Ulong j = 0;  j < rep.getDimen();  ++j) {
+                Delta  delta = rep.getDelta(j);
+                hash = Mix(hash, delta.x);
+                hash = Mix(hash, delta.y);
+            }
+            break;
+
+        default:
+            break;
+    }
+    return hash;
+}
+
+
+/*static*/ bool
+RepetitionCache::Equal (const Repetition& a, const Repetition& b)
+{
+    if (a.getType() != b.getType())
+        return false;
+
+    switch (a.getType()) {
+        case Rep_Matrix:
+            return (a.getMatrixXdimen() == b.getMatrixXdimen()
+                    &&  a.getMatrixYdimen() == b.getMatrixYdimen()
+                    &&  a.getMatrixXspace() == b.getMatrixXspace()
+                    &&  a.getMatrixYspace() == b.getMatrixYspace());
+
+        case Rep_UniformX:
+            return (a.getDimen() == b.getDimen()
+                    &&  a.getUniformXspace() == b.getUniformXspace());
+
+        case Rep_UniformY:
+            return (a.getDimen() == b.getDimen()
+                    &&  a.getUniformYspace() == b.getUniformYspace());
+
+        case Rep_VaryingX:
+        case Rep_GridVaryingX:
+            if (a.getDimen() != b.getDimen())
+                return false;
+            if (a.getType() == Rep_GridVaryingX  &&  a.getGrid() != b.getGrid())
+                return false;
+            for (Ulong j = 0;  j < a.getDimen();  ++j) {
+                if (a.getVaryingXoffset(j) != b.getVaryingXoffset(j))
+                    return false;
+            }
+            return true;
+
+        case Rep_VaryingY:
+        case Rep_GridVaryingY:
+            if (a.getDimen() != b.getDimen())
+                return false;
+            if (a.getType() == Rep_GridVaryingY  &&  a.getGrid() != b.getGrid())
+                return false;
+            for (Ulong j = 0;  j < a.getDimen();  ++j) {
+                if (a.getVaryingYoffset(j) != b.getVaryingYoffset(j))
+                    return false;
+            }
+            return true;
+
+        case Rep_TiltedMatrix:
+            return (a.getMatrixNdimen() == b.getMatrixNdimen()
+                    &&  a.getMatrixMdimen() == b.getMatrixMdimen()
+                    &&  a.getMatrixNdelta() == b.getMatrixNdelta()
+                    &&  a.getMatrixMdelta() == b.getMatrixMdelta());
+
+        case Rep_Diagonal:
+            return (a.getDimen() == b.getDimen()
+                    &&  a.getDiagonalDelta() == b.getDiagonalDelta());
+
+        case Rep_Arbitrary:
+        case Rep_GridArbitrary:
+            if (a.getDimen() != b.getDimen())
+                return false;
+            if (a.getType() == Rep_GridArbitrary  &&  a.getGrid() != b.getGrid())
+                return false;
+            for (Ulong j = 0;  j < a.getDimen();  ++j) {
+                if (! (a.getDelta(j) == b.getDelta(j)))
+                    return false;
+            }
+            return true;
+
+        default:
+            return true;
+    }
+}
+
+
+/*static*/ Ullong
+RepetitionCache::PositionCount (const Repetition& rep)
+{
+    switch (rep.getType()) {
+        case Rep_Matrix:
+            return Ullong(rep.getMatrixXdimen()) * rep.getMatrixYdimen();
+        case Rep_TiltedMatrix:
+            return Ullong(rep.getMatrixNdimen()) * rep.getMatrixMdimen();
+        case Rep_UniformX:
+        case Rep_UniformY:
+        case Rep_VaryingX:
+        case Rep_GridVaryingX:
+        case Rep_VaryingY:
+        case Rep_GridVaryingY:
+        case Rep_Diagonal:
+        case Rep_Arbitrary:
+        case Rep_GridArbitrary:
+            return rep.getDimen();
+        default:
+            return 1;
+    }
+}
+
+
+// ExpandOffsets -- list the offsets of all positions of rep
+// Matrices are listed column by column (x outer), the order in which
+// JLayout::unpackRepetition() has always listed them.
+
+/*static*/ void
+RepetitionCache::ExpandOffsets (const Repetition& rep,
+                                /*out*/ vector<Delta>* offsets)
+{
+    offsets->clear();
+    offsets->reserve(PositionCount(rep));
+
+    switch (rep.getType()) {
+        case Rep_Matrix: {
+            Ulong  xdimen = rep.getMatrixXdimen();
+            Ulong  ydimen = rep.getMatrixYdimen();
+            long   xspace = rep.getMatrixXspace();
+            long   yspace = rep.getMatrixYspace();
+            for (Ulong i = 0;  i < xdimen;  ++i)
+                for (Ulong j = 0;  j < ydimen;  ++j)
+                    offsets->push_back(Delta(long(i)*xspace, long(j)*yspace));
+            break;
+        }
+
+        case Rep_UniformX:
+            for (Ulong i = 0;  i < rep.getDimen();  ++i)
+                offsets->push_back(Delta(long(i)*rep.getUniformXspace(), 0));
+            break;
+
+        case Rep_UniformY:
+            for (Ulong i = 0;  i < rep.getDimen();  ++i)
+                offsets->push_back(Delta(0, long(i)*rep.getUniformYspace()));
+            break;
+
+        case Rep_VaryingX:
+        case Rep_GridVaryingX:
+            for (Ulong i = 0;  i < rep.getDimen();  ++i)
+                offsets->push_back(Delta(rep.getVaryingXoffset(i), 0));
+            break;
+
+        case Rep_VaryingY:
+        case Rep_GridVaryingY:
+            for (Ulong i = 0;  i < rep.getDimen();  ++i)
+                offsets->push_back(Delta(0, rep.getVaryingYoffset(i)));
+            break;
+
+        case Rep_TiltedMatrix: {
+            Ulong  ndimen = rep.getMatrixNdimen();
+            Ulong  mdimen = rep.getMatrixMdimen();
+            Delta  ndelta = rep.getMatrixNdelta();
+            Delta  mdelta = rep.getMatrixMdelta();
+            for (Ulong i = 0;  i < ndimen;  ++i)
+                for (Ulong j = 0;  j < mdimen;  ++j)
+                    offsets->push_back(Delta(long(i)*ndelta.x + long(j)*mdelta.x,
+                                             long(i)*ndelta.y + long(j)*mdelta.y));
+            break;
+        }
+
+        case Rep_Diagonal: {
+            Delta  delta = rep.getDiagonalDelta();
+            for (Ulong i = 0;  i < rep.getDimen();  ++i)
+                offsets->push_back(Delta(long(i)*delta.x, long(i)*delta.y));
+            break;
+        }
+
+        case Rep_Arbitrary:
+        case Rep_GridArbitrary:
+            for (Ulong i = 0;  i < rep.getDimen();  ++i)
+                offsets->push_back(rep.getDelta(i));
+            break;
+
+        default:
+            offsets->push_back(Delta(0, 0));
+            break;
+    }
+}
+
+
+// EncodedSize -- bytes OasisCreator needs to write rep (Section 7.6)
+// The size of the repetition itself, not of a Rep_ReusePrevious that
+// may stand for it.
+
+/*static*/ size_t
+RepetitionCache::EncodedSize (const Repetition& rep)
+{
+    size_t  size = 1;
+    switch (rep.getType()) {
+        case Rep_Matrix:
+            size += UIntSize(rep.getMatrixXdimen() - 2)
+                  + UIntSize(rep.getMatrixYdimen() - 2)
+                  + UIntSize(rep.getMatrixXspace())
+                  + UIntSize(rep.getMatrixYspace());
+            break;
+
+        case Rep_UniformX:
+            size += UIntSize(rep.getDimen() - 2)
+                  + UIntSize(rep.getUniformXspace());
+            break;
+
+        case Rep_UniformY:
+            size += UIntSize(rep.getDimen() - 2)
+                  + UIntSize(rep.getUniformYspace());
+            break;
+
+        case Rep_VaryingX:
+        case Rep_GridVaryingX:
+        case Rep_VaryingY:
+        case Rep_GridVaryingY: {
+            bool  isX = (rep.getType() == Rep_VaryingX
+                         ||  rep.getType() == Rep_GridVaryingX);
+            Ullong  grid = 1;
+            size += UIntSize(rep.getDimen() - 2);
+            if (rep.getType() == Rep_GridVaryingX
+                    ||  rep.getType() == Rep_GridVaryingY) {
+                grid = rep.getGrid();
+                size += UIntSize(grid);
+            }
+            for (Ulong j = 1;  j < rep.getDimen();  ++j) {
+                long  diff = isX ? rep.getVaryingXoffset(j)
+                                   - rep.getVaryingXoffset(j-1)
+                                 : rep.getVaryingYoffset(j)
+                                   - rep.getVaryingYoffset(j-1);
+                size += UIntSize(Magnitude(diff) / grid);
+            }
+            break;
+        }
+
+        case Rep_TiltedMatrix:
+            size += UIntSize(rep.getMatrixNdimen() - 2)
+                  + UIntSize(rep.getMatrixMdimen() - 2)
+                  + GDeltaSize(rep.getMatrixNdelta())
+                  + GDeltaSize(rep.getMatrixMdelta());
+            break;
+
+        case Rep_Diagonal:
+            size += UIntSize(rep.getDimen() - 2)
+                  + GDeltaSize(rep.getDiagonalDelta());
+            break;
+
+        case Rep_Arbitrary:
+        case Rep_GridArbitrary: {
+            long  grid = 1;
+            size += UIntSize(rep.getDimen() - 2);
+            if (rep.getType() == Rep_GridArbitrary) {
+                grid = long(rep.getGrid());
+                size += UIntSize(grid);
+            }
+            for (Ulong j = 1;  j < rep.getDimen();  ++j) {
+                Delta  prev = rep.getDelta(j-1);
+                Delta  curr = rep.getDelta(j);
+                size += GDeltaSize(Delta((curr.x - prev.x) / grid,
+                                         (curr.y - prev.y) / grid));
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+    return size;
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
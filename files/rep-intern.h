@@ -0,0 +1,103 @@
+// oasis/rep-intern.h -- interning table for Repetition objects
+//
+// last modified:   2026/10/17
+//
+// OASIS files repeat the same repetitions over and over: a standard-cell
+// row uses the same Rep_Arbitrary delta list in every cell that has the
+// row, and arrays of vias share a handful of Rep_Matrix pitches.  The
+// parser decodes each occurrence into its modal Repetition object, so a
+// builder that keeps repetitions must copy them, and one that expands
+// them expands the same repetition again for every element.
+//
+// RepetitionCache keeps one copy of each distinct repetition.  intern()
+// hashes the contents of a Repetition and returns the cache's copy,
+// adding one if needed.  The pointer it returns is stable: equal
+// repetitions always yield the same pointer, and it stays valid for the
+// lifetime of the cache, or until clear().  Consumers can therefore memoize results per
+// repetition by pointer.  The cache itself memoizes the two results
+// everyone wants: the number of positions and the expanded offsets.
+//
+// The parser interns the repetitions of the placements it passes to
+// the builder (see OasisParser::getRepetitionCache()); for geometry and
+// TEXT it passes its modal Repetition, which the next record
+// overwrites.  A builder that shares the parser's cache finds the
+// interned pointers without hashing; given any other Repetition,
+// intern() falls back to hashing.  A builder that keeps a repetition
+// beyond the call, or hands it to another thread, must intern it
+// first.
+//
+// RepetitionCache is not thread-safe.  Each parser, including each
+// worker of parseFileParallel(), has its own.
+
+#ifndef OASIS_REP_INTERN_H_INCLUDED
+#define OASIS_REP_INTERN_H_INCLUDED
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include "misc/utils.h"
+#include "oasis.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::vector;
+using SoftJin::Ullong;
+
+
+class RepetitionCache {
+    struct Entry {
+        Repetition      rep;            // interned copy
+        size_t          hash;
+        Ullong          numPositions;
+        bool            haveOffsets;
+        vector<Delta>   offsets;        // filled on first getOffsets()
+
+        Entry (const Repetition& r, size_t h)
+          : rep(r), hash(h), numPositions(RepetitionCache::PositionCount(r)),
+            haveOffsets(false) { }
+    };
+
+    std::deque<Entry>   entries;        // deque: push_back keeps addresses
+    std::unordered_multimap<size_t, Entry*>  entriesByHash;
+    std::unordered_map<const Repetition*, Entry*>  entriesByRep;
+    Ullong              lookups;
+    Ullong              hits;
+
+public:
+                RepetitionCache();
+
+    const Repetition*  intern (const Repetition* rep);
+    bool        isInterned (const Repetition* rep) const {
+                    return (entriesByRep.find(rep) != entriesByRep.end());
+                }
+
+    void        clear();
+
+    Ullong      getPositionCount (const Repetition* rep);
+    const vector<Delta>&  getOffsets (const Repetition* rep);
+
+    size_t      size() const            { return entries.size(); }
+    Ullong      getLookups() const      { return lookups; }
+    Ullong      getHits() const         { return hits; }
+
+    static size_t  Hash (const Repetition& rep);
+    static bool    Equal (const Repetition& a, const Repetition& b);
+    static Ullong  PositionCount (const Repetition& rep);
+    static size_t  EncodedSize (const Repetition& rep);
+    static void    ExpandOffsets (const Repetition& rep,
+                                  /*out*/ vector<Delta>* offsets);
+
+private:
+    Entry*      lookup (const Repetition* rep);
+
+private:
+                RepetitionCache (const RepetitionCache&);   // forbidden
+    void        operator= (const RepetitionCache&);         // forbidden
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_REP_INTERN_H_INCLUDED
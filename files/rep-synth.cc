@@ -0,0 +1,865 @@
+// oasis/rep-synth.cc -- builder proxy that folds identical elements
+//                       into repetitions
+//
+// last modified:   2026/10/17
+
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_set>
+
+#include "varint.h"
+#include "rep-synth.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+
+namespace {
+
+// Positions held before a cell's groups are written out early.
+const size_t  MaxBufferedPositions = 1 << 20;
+
+// Shortest uniform run in a row that gets a record of its own.  Two
+// positions cost about as much as a record as they do in an arbitrary
+// repetition.
+const size_t  MinRowRun = 3;
+
+// Number of positions nearest the corner tried as tilted-matrix edges.
+const size_t  NumTiltCandidates = 8;
+
+
+template <typename T>
+inline void
+AppendBytes (/*inout*/ string* buf, const T& val) {
+    buf->append(reinterpret_cast<const char*>(&val), sizeof val);
+}
+
+
+// DeltaLess -- order by y, then x: rows from the bottom up
+
+struct DeltaLess {
+    bool operator() (const Delta& a, const Delta& b) const {
+        return (a.y < b.y  ||  (a.y == b.y  &&  a.x < b.x));
+    }
+};
+
+struct DeltaHash {
+    size_t operator() (const Delta& d) const {
+        return (size_t(d.x) * size_t(1099511628211ULL)) ^ size_t(d.y);
+    }
+};
+
+typedef std::unordered_set<Delta, DeltaHash>  DeltaSet;
+
+
+inline Delta
+Transpose (const Delta& d) {
+    return Delta(d.y, d.x);
+}
+
+
+inline Ullong
+Magnitude (long val) {
+    return (val < 0 ? Ullong(0) - Ullong(val) : Ullong(val));
+}
+
+
+Ullong
+Gcd (Ullong a, Ullong b)
+{
+    while (b != 0) {
+        Ullong  r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+
+// PlanSize -- bytes for the records of a plan, apart from the fields
+// that the modal variables supply after the first record
+
+size_t
+PlanSize (const vector<RepCover>& covers, size_t begin)
+{
+    size_t  size = 0;
+    for (size_t j = begin;  j < covers.size();  ++j) {
+        const RepCover&  cover = covers[j];
+        size += 2 + SIntSize(cover.origin.x) + SIntSize(cover.origin.y);
+        if (cover.repeated)
+            size += RepetitionCache::EncodedSize(cover.rep);
+    }
+    return size;
+}
+
+
+// TransposeRepetition -- the repetition with X and Y swapped
+
+void
+TransposeRepetition (const Repetition& rep, /*out*/ Repetition* trep)
+{
+    Ulong  dimen = rep.getDimen();
+    switch (rep.getType()) {
+        case Rep_Matrix:
+            trep->makeMatrix(rep.getMatrixYdimen(), rep.getMatrixXdimen(),
+                             rep.getMatrixYspace(), rep.getMatrixXspace());
+            break;
+
+        case Rep_UniformX:
+            trep->makeUniformY(dimen, rep.getUniformXspace());
+            break;
+
+        case Rep_UniformY:
+            trep->makeUniformX(dimen, rep.getUniformYspace());
+            break;
+
+        case Rep_VaryingX:
+        case Rep_GridVaryingX:
+            if (rep.getType() == Rep_GridVaryingX)
+                trep->makeGridVaryingY(dimen, rep.getGrid());
+            else
+                trep->makeVaryingY(dimen);
+            for (Ulong j = 0;  j < dimen;  ++j)
+                trep->addOffset(rep.getVaryingXoffset(j));
+            break;
+
+        case Rep_VaryingY:
+        case Rep_GridVaryingY:
+            if (rep.getType() == Rep_GridVaryingY)
+                trep->makeGridVaryingX(dimen, rep.getGrid());
+            else
+                trep->makeVaryingX(dimen);
+            for (Ulong j = 0;  j < dimen;  ++j)
+                trep->addOffset(rep.getVaryingYoffset(j));
+            break;
+
+        case Rep_TiltedMatrix:
+            trep->makeTiltedMatrix(rep.getMatrixNdimen(),
+                                   rep.getMatrixMdimen(),
+                                   Transpose(rep.getMatrixNdelta()),
+                                   Transpose(rep.getMatrixMdelta()));
+            break;
+
+        case Rep_Diagonal:
+            trep->makeDiagonal(dimen, Transpose(rep.getDiagonalDelta()));
+            break;
+
+        case Rep_Arbitrary:
+        case Rep_GridArbitrary:
+            if (rep.getType() == Rep_GridArbitrary)
+                trep->makeGridArbitrary(dimen, rep.getGrid());
+            else
+                trep->makeArbitrary(dimen);
+            for (Ulong j = 0;  j < dimen;  ++j)
+                trep->addDelta(Transpose(rep.getDelta(j)));
+            break;
+
+        default:
+            *trep = rep;
+            break;
+    }
+}
+
+
+//----------------------------------------------------------------------
+// Planning.  Except where noted, the positions passed around are
+// distinct and sorted by DeltaLess.
+
+
+RepCover
+SingleCover (const Delta& pos)
+{
+    RepCover  cover;
+    cover.origin = pos;
+    cover.repeated = false;
+    return cover;
+}
+
+
+// CountAlong -- number of positions origin, origin+step, ... in set
+
+Ulong
+CountAlong (const DeltaSet& set, const Delta& origin, const Delta& step)
+{
+    Ulong  count = 1;
+    while (set.count(Delta(origin.x + long(count)*step.x,
+                           origin.y + long(count)*step.y)) != 0)
+        ++count;
+    return count;
+}
+
+
+// FitTilted -- try a tilted matrix over all of pts
+// The first position is a corner of any parallelogram the positions
+// fill, and the edge vectors from it are tried among the differences
+// to the positions nearest it.
+
+bool
+FitTilted (const vector<Delta>& pts, /*out*/ RepCover* cover)
+{
+    size_t  n = pts.size();
+    if (n < 4)
+        return false;
+
+    const Delta&  p0 = pts[0];
+    vector<std::pair<double, Delta> >  nearest;
+    nearest.reserve(n - 1);
+    for (size_t j = 1;  j < n;  ++j) {
+        double  dx = double(pts[j].x - p0.x);
+        double  dy = double(pts[j].y - p0.y);
+        nearest.push_back(std::make_pair(dx*dx + dy*dy,
+                                         Delta(pts[j].x - p0.x,
+                                               pts[j].y - p0.y)));
+    }
+    size_t  k = std::min(NumTiltCandidates, nearest.size());
+    std::partial_sort(nearest.begin(), nearest.begin() + k, nearest.end(),
+        [](const std::pair<double, Delta>& a,
+           const std::pair<double, Delta>& b) { return a.first < b.first; });
+
+    DeltaSet  set(pts.begin(), pts.end());
+    for (size_t a = 0;  a < k;  ++a) {
+        const Delta&  ndelta = nearest[a].second;
+        Ulong  ndimen = CountAlong(set, p0, ndelta);
+        if (ndimen < 2)
+            continue;
+        for (size_t b = a + 1;  b < k;  ++b) {
+            const Delta&  mdelta = nearest[b].second;
+            if (double(ndelta.x)*mdelta.y == double(ndelta.y)*mdelta.x)
+                continue;               // parallel
+            Ulong  mdimen = CountAlong(set, p0, mdelta);
+            if (mdimen < 2  ||  Ullong(ndimen)*mdimen != n)
+                continue;
+
+            bool  filled = true;
+            for (Ulong i = 0;  i < ndimen  &&  filled;  ++i) {
+                for (Ulong j = 0;  j < mdimen  &&  filled;  ++j) {
+                    Delta  pos(p0.x + long(i)*ndelta.x + long(j)*mdelta.x,
+                               p0.y + long(i)*ndelta.y + long(j)*mdelta.y);
+                    filled = (set.count(pos) != 0);
+                }
+            }
+            if (filled) {
+                cover->origin = p0;
+                cover->rep.makeTiltedMatrix(ndimen, mdimen, ndelta, mdelta);
+                cover->repeated = true;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+bool
+IsUniform (const vector<long>& vals)
+{
+    for (size_t j = 2;  j < vals.size();  ++j) {
+        if (vals[j] - vals[j-1] != vals[1] - vals[0])
+            return false;
+    }
+    return true;
+}
+
+
+// FitRegular -- try one repetition of fixed size over all of pts
+// pts has at least two positions.
+
+bool
+FitRegular (const vector<Delta>& pts, /*out*/ RepCover* cover)
+{
+    size_t  n = pts.size();
+    const Delta&  p0 = pts[0];
+    cover->origin = p0;
+    cover->repeated = true;
+
+    // A line with a constant step.  Sorting keeps the steps in order.
+    Delta  step(pts[1].x - p0.x, pts[1].y - p0.y);
+    bool  line = true;
+    for (size_t j = 2;  j < n  &&  line;  ++j)
+        line = (pts[j].x - pts[j-1].x == step.x
+                &&  pts[j].y - pts[j-1].y == step.y);
+    if (line) {
+        if (step.y == 0)
+            cover->rep.makeUniformX(n, step.x);
+        else if (step.x == 0)
+            cover->rep.makeUniformY(n, step.y);
+        else
+            cover->rep.makeDiagonal(n, step);
+        return true;
+    }
+
+    // An axis-aligned grid: as many distinct positions as the product of
+    // the distinct coordinates means every combination is there.
+    vector<long>  xs, ys;
+    xs.reserve(n);
+    ys.reserve(n);
+    for (size_t j = 0;  j < n;  ++j) {
+        xs.push_back(pts[j].x);
+        ys.push_back(pts[j].y);
+    }
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+    if (xs.size() >= 2  &&  ys.size() >= 2
+            &&  Ullong(xs.size())*ys.size() == n
+            &&  IsUniform(xs)  &&  IsUniform(ys)) {
+        cover->rep.makeMatrix(xs.size(), ys.size(),
+                              xs[1] - xs[0], ys[1] - ys[0]);
+        return true;
+    }
+
+    return FitTilted(pts, cover);
+}
+
+
+// FitScattered -- one varying or arbitrary repetition over all of pts
+// pts has at least two positions.  The offsets are listed in order, so
+// the displacements between them are short.
+
+void
+FitScattered (const vector<Delta>& pts, /*out*/ RepCover* cover)
+{
+    size_t  n = pts.size();
+    const Delta&  p0 = pts[0];
+    bool  sameX = true, sameY = true;
+    Ullong  grid = 0;
+    for (size_t j = 1;  j < n;  ++j) {
+        sameX = sameX  &&  (pts[j].x == p0.x);
+        sameY = sameY  &&  (pts[j].y == p0.y);
+        grid = Gcd(grid, Magnitude(pts[j].x - pts[j-1].x));
+        grid = Gcd(grid, Magnitude(pts[j].y - pts[j-1].y));
+    }
+
+    Repetition&  rep = cover->rep;
+    cover->origin = p0;
+    cover->repeated = true;
+    if (sameY  ||  sameX) {
+        if (sameY  &&  grid > 1)
+            rep.makeGridVaryingX(n, grid);
+        else if (sameY)
+            rep.makeVaryingX(n);
+        else if (grid > 1)
+            rep.makeGridVaryingY(n, grid);
+        else
+            rep.makeVaryingY(n);
+        for (size_t j = 0;  j < n;  ++j)
+            rep.addOffset(sameY ? pts[j].x - p0.x : pts[j].y - p0.y);
+    } else {
+        if (grid > 1)
+            rep.makeGridArbitrary(n, grid);
+        else
+            rep.makeArbitrary(n);
+        for (size_t j = 0;  j < n;  ++j)
+            rep.addDelta(Delta(pts[j].x - p0.x, pts[j].y - p0.y));
+    }
+}
+
+
+// PlanLeftover -- cover pts, which need not be large or regular
+
+void
+PlanLeftover (const vector<Delta>& pts, /*out*/ vector<RepCover>* covers)
+{
+    if (pts.empty())
+        return;
+    if (pts.size() == 1) {
+        covers->push_back(SingleCover(pts[0]));
+        return;
+    }
+    RepCover  cover;
+    if (! FitRegular(pts, &cover))
+        FitScattered(pts, &cover);
+    covers->push_back(cover);
+}
+
+
+// PlanRows -- cover pts with uniform runs along X, stacked into
+// matrices where runs of the same start, length and pitch are evenly
+// spaced in Y.  What is not in a run goes to PlanLeftover().
+
+struct RowRun {
+    long        x0;
+    Ulong       count;
+    long        pitch;
+    long        y;
+
+    bool operator< (const RowRun& r) const {
+        if (x0 != r.x0)         return (x0 < r.x0);
+        if (count != r.count)   return (count < r.count);
+        if (pitch != r.pitch)   return (pitch < r.pitch);
+        return (y < r.y);
+    }
+    bool sameRow (const RowRun& r) const {
+        return (x0 == r.x0  &&  count == r.count  &&  pitch == r.pitch);
+    }
+};
+
+
+void
+PlanRows (const vector<Delta>& pts, /*out*/ vector<RepCover>* covers)
+{
+    vector<RowRun>  runs;
+    vector<Delta>   leftover;
+    size_t  n = pts.size();
+
+    for (size_t row = 0;  row < n;  ) {
+        size_t  rowEnd = row;
+        while (rowEnd < n  &&  pts[rowEnd].y == pts[row].y)
+            ++rowEnd;
+
+        size_t  j = row;
+        while (j < rowEnd) {
+            size_t  k = j + 1;
+            if (k < rowEnd) {
+                long  pitch = pts[k].x - pts[j].x;
+                while (k + 1 < rowEnd  &&  pts[k+1].x - pts[k].x == pitch)
+                    ++k;
+                if (k - j + 1 >= MinRowRun) {
+                    RowRun  run = { pts[j].x, Ulong(k - j + 1), pitch,
+                                    pts[j].y };
+                    runs.push_back(run);
+                    j = k + 1;
+                    continue;
+                }
+            }
+            leftover.push_back(pts[j]);
+            ++j;
+        }
+        row = rowEnd;
+    }
+
+    std::sort(runs.begin(), runs.end());
+    for (size_t j = 0;  j < runs.size();  ) {
+        size_t  k = j + 1;
+        if (k < runs.size()  &&  runs[k].sameRow(runs[j])) {
+            long  ypitch = runs[k].y - runs[j].y;
+            while (k + 1 < runs.size()  &&  runs[k+1].sameRow(runs[j])
+                    &&  runs[k+1].y - runs[k].y == ypitch)
+                ++k;
+            ++k;
+        }
+
+        RepCover  cover;
+        cover.origin = Delta(runs[j].x0, runs[j].y);
+        cover.repeated = true;
+        if (k - j >= 2)
+            cover.rep.makeMatrix(runs[j].count, k - j, runs[j].pitch,
+                                 runs[j+1].y - runs[j].y);
+        else
+            cover.rep.makeUniformX(runs[j].count, runs[j].pitch);
+        covers->push_back(cover);
+        j = k;
+    }
+
+    PlanLeftover(leftover, covers);
+}
+
+
+// PlanDistinct -- cover pts, which has at least two positions
+
+void
+PlanDistinct (const vector<Delta>& pts, /*out*/ vector<RepCover>* covers)
+{
+    RepCover  cover;
+    if (FitRegular(pts, &cover)) {
+        covers->push_back(cover);
+        return;
+    }
+
+    size_t  begin = covers->size();
+    FitScattered(pts, &cover);
+    covers->push_back(cover);
+    size_t  bestSize = PlanSize(*covers, begin);
+
+    vector<RepCover>  rows;
+    PlanRows(pts, &rows);
+    size_t  rowsSize = PlanSize(rows, 0);
+    if (rowsSize < bestSize) {
+        covers->resize(begin);
+        covers->insert(covers->end(), rows.begin(), rows.end());
+        bestSize = rowsSize;
+    }
+
+    // The same along Y: plan the transposed positions and transpose
+    // the plan back.
+    vector<Delta>  tpts;
+    tpts.reserve(pts.size());
+    for (size_t j = 0;  j < pts.size();  ++j)
+        tpts.push_back(Transpose(pts[j]));
+    std::sort(tpts.begin(), tpts.end(), DeltaLess());
+
+    vector<RepCover>  columns;
+    PlanRows(tpts, &columns);
+    for (size_t j = 0;  j < columns.size();  ++j) {
+        RepCover&  col = columns[j];
+        col.origin = Transpose(col.origin);
+        if (col.repeated) {
+            Repetition  trep;
+            TransposeRepetition(col.rep, &trep);
+            col.rep = trep;
+        }
+    }
+    if (PlanSize(columns, 0) < bestSize) {
+        covers->resize(begin);
+        covers->insert(covers->end(), columns.begin(), columns.end());
+    }
+}
+
+}  // unnamed namespace
+
+
+// PlanRepetitions -- cover positions with as few bytes of records as
+// can be found
+// Appends to covers one RepCover per record.  positions may be in any
+// order and may repeat; it is left sorted.
+
+/*static*/ void
+RepetitionSynthesizer::PlanRepetitions (/*inout*/ vector<Delta>* positions,
+                                        /*out*/ vector<RepCover>* covers)
+{
+    if (positions->empty())
+        return;
+    if (positions->size() == 1) {
+        covers->push_back(SingleCover(positions->front()));
+        return;
+    }
+
+    std::sort(positions->begin(), positions->end(), DeltaLess());
+    vector<Delta>  distinct, repeats;
+    distinct.reserve(positions->size());
+    for (size_t j = 0;  j < positions->size();  ++j) {
+        const Delta&  pos = (*positions)[j];
+        if (! distinct.empty()  &&  distinct.back() == pos)
+            repeats.push_back(pos);
+        else
+            distinct.push_back(pos);
+    }
+
+    if (distinct.size() == 1)
+        covers->push_back(SingleCover(distinct[0]));
+    else
+        PlanDistinct(distinct, covers);
+    PlanRepetitions(&repeats, covers);
+}
+
+
+//----------------------------------------------------------------------
+
+
+RepetitionSynthesizer::RepetitionSynthesizer (OasisBuilder* target)
+  : ElementProxy(target)
+{
+    numBuffered = 0;
+    pendingX = pendingY = 0;
+    elementsIn = recordsOut = 0;
+}
+
+
+RepetitionSynthesizer::~RepetitionSynthesizer() { }
+
+
+// beginElement -- start holding a new element at (x,y)
+// Returns the element, cleared but for its kind, for the caller to fill.
+
+RepetitionSynthesizer::Element&
+RepetitionSynthesizer::beginElement (ElementKind kind, long x, long y)
+{
+    beginHeld();
+    pendingX = x;
+    pendingY = y;
+    ++elementsIn;
+
+    Element&  elem = pending;
+    elem.kind = kind;
+    elem.layer = elem.datatype = 0;
+    elem.width = elem.height = 0;
+    elem.startExtn = elem.endExtn = 0;
+    elem.ptlist.clear();
+    elem.cellName = Null;
+    elem.text = Null;
+    elem.mag = Oreal(1);
+    elem.angle = Oreal(0);
+    elem.flip = false;
+    return elem;
+}
+
+
+// settleLast -- add the held element to its group
+
+void
+RepetitionSynthesizer::settleLast()
+{
+    std::pair<std::unordered_map<string, size_t>::iterator, bool>
+        ins = groupIndex.insert(std::make_pair(key(pending), groups.size()));
+    if (ins.second) {
+        groups.push_back(Group());
+        groups.back().proto = pending;
+    }
+    groups[ins.first->second].positions.push_back(Delta(pendingX, pendingY));
+    if (++numBuffered >= MaxBufferedPositions)
+        flushHeld();
+}
+
+
+// flushHeld -- write out every group held
+
+void
+RepetitionSynthesizer::flushHeld()
+{
+    for (size_t j = 0;  j < groups.size();  ++j) {
+        Group&  group = groups[j];
+        covers.clear();
+        PlanRepetitions(&group.positions, &covers);
+        for (size_t k = 0;  k < covers.size();  ++k) {
+            const RepCover&  cover = covers[k];
+            emit(group.proto, cover.origin.x, cover.origin.y,
+                 cover.repeated ? repCache.intern(&cover.rep) : Null);
+            target->endElement();
+            ++recordsOut;
+        }
+    }
+    groups.clear();
+    groupIndex.clear();
+    numBuffered = 0;
+}
+
+
+// passThrough -- the element about to be forwarded is not held
+
+void
+RepetitionSynthesizer::passThrough()
+{
+    beginForwarded();
+    ++elementsIn;
+    ++recordsOut;
+}
+
+
+// key -- what identifies an element's group: all of it but the position
+
+const string&
+RepetitionSynthesizer::key (const Element& elem)
+{
+    keyBuf.clear();
+    AppendBytes(&keyBuf, elem.kind);
+    AppendBytes(&keyBuf, elem.layer);
+    AppendBytes(&keyBuf, elem.datatype);
+    AppendBytes(&keyBuf, elem.width);
+    AppendBytes(&keyBuf, elem.height);
+    AppendBytes(&keyBuf, elem.startExtn);
+    AppendBytes(&keyBuf, elem.endExtn);
+    AppendBytes(&keyBuf, elem.cellName);
+    AppendBytes(&keyBuf, elem.text);
+    AppendBytes(&keyBuf, elem.mag.getValue());
+    AppendBytes(&keyBuf, elem.angle.getValue());
+    AppendBytes(&keyBuf, elem.flip);
+    for (PointList::const_iterator iter = elem.ptlist.begin();
+            iter != elem.ptlist.end();  ++iter) {
+        AppendBytes(&keyBuf, iter->x);
+        AppendBytes(&keyBuf, iter->y);
+    }
+    return keyBuf;
+}
+
+
+// emit -- pass elem at (x,y) with rep to the target, without endElement()
+
+void
+RepetitionSynthesizer::emit (const Element& elem, long x, long y,
+                             const Repetition* rep)
+{
+    switch (elem.kind) {
+        case PlacementElem:
+            target->beginPlacement(elem.cellName, x, y, elem.mag, elem.angle,
+                                   elem.flip, rep);
+            break;
+        case TextElem:
+            target->beginText(elem.layer, elem.datatype, x, y, elem.text, rep);
+            break;
+        case RectangleElem:
+            target->beginRectangle(elem.layer, elem.datatype, x, y,
+                                   elem.width, elem.height, rep);
+            break;
+        case PolygonElem:
+            target->beginPolygon(elem.layer, elem.datatype, x, y,
+                                 elem.ptlist, rep);
+            break;
+        case PathElem:
+            target->beginPath(elem.layer, elem.datatype, x, y, elem.width,
+                              elem.startExtn, elem.endExtn, elem.ptlist, rep);
+            break;
+        case CircleElem:
+            target->beginCircle(elem.layer, elem.datatype, x, y,
+                                elem.width, rep);
+            break;
+    }
+}
+
+
+// releaseLast -- an element with properties is not folded into a
+// repetition: the held element goes out as it is, and its properties
+// after it.
+
+void
+RepetitionSynthesizer::releaseLast()
+{
+    emit(pending, pendingX, pendingY, Null);
+    ++recordsOut;
+}
+
+
+//----------------------------------------------------------------------
+// Elements.  Those with a repetition go through; the rest are held.
+
+
+void
+RepetitionSynthesizer::beginPlacement (CellName* cellName,
+                                       long x, long y,
+                                       const Oreal&  mag,
+                                       const Oreal&  angle,
+                                       bool flip,
+                                       const Repetition*  rep)
+{
+    if (rep != Null) {
+        passThrough();
+        target->beginPlacement(cellName, x, y, mag, angle, flip, rep);
+        return;
+    }
+    Element&  elem = beginElement(PlacementElem, x, y);
+    elem.cellName = cellName;
+    elem.mag = mag;
+    elem.angle = angle;
+    elem.flip = flip;
+}
+
+
+void
+RepetitionSynthesizer::beginText (Ulong textlayer, Ulong texttype,
+                                  long x, long y,
+                                  TextString* text,
+                                  const Repetition* rep)
+{
+    if (rep != Null) {
+        passThrough();
+        target->beginText(textlayer, texttype, x, y, text, rep);
+        return;
+    }
+    Element&  elem = beginElement(TextElem, x, y);
+    elem.layer = textlayer;
+    elem.datatype = texttype;
+    elem.text = text;
+}
+
+
+void
+RepetitionSynthesizer::beginRectangle (Ulong layer, Ulong datatype,
+                                       long x, long y,
+                                       long width, long height,
+                                       const Repetition*  rep)
+{
+    if (rep != Null) {
+        passThrough();
+        target->beginRectangle(layer, datatype, x, y, width, height, rep);
+        return;
+    }
+    Element&  elem = beginElement(RectangleElem, x, y);
+    elem.layer = layer;
+    elem.datatype = datatype;
+    elem.width = width;
+    elem.height = height;
+}
+
+
+void
+RepetitionSynthesizer::beginPolygon (Ulong layer, Ulong datatype,
+                                     long x, long y,
+                                     const PointList&  ptlist,
+                                     const Repetition*  rep)
+{
+    if (rep != Null) {
+        passThrough();
+        target->beginPolygon(layer, datatype, x, y, ptlist, rep);
+        return;
+    }
+    Element&  elem = beginElement(PolygonElem, x, y);
+    elem.layer = layer;
+    elem.datatype = datatype;
+    elem.ptlist = ptlist;
+}
+
+
+void
+RepetitionSynthesizer::beginPath (Ulong layer, Ulong datatype,
+                                  long x, long  y,
+                                  long halfwidth,
+                                  long startExtn, long endExtn,
+                                  const PointList&  ptlist,
+                                  const Repetition*  rep)
+{
+    if (rep != Null) {
+        passThrough();
+        target->beginPath(layer, datatype, x, y, halfwidth,
+                          startExtn, endExtn, ptlist, rep);
+        return;
+    }
+    Element&  elem = beginElement(PathElem, x, y);
+    elem.layer = layer;
+    elem.datatype = datatype;
+    elem.width = halfwidth;
+    elem.startExtn = startExtn;
+    elem.endExtn = endExtn;
+    elem.ptlist = ptlist;
+}
+
+
+void
+RepetitionSynthesizer::beginCircle (Ulong layer, Ulong datatype,
+                                    long x, long y,
+                                    long radius,
+                                    const Repetition*  rep)
+{
+    if (rep != Null) {
+        passThrough();
+        target->beginCircle(layer, datatype, x, y, radius, rep);
+        return;
+    }
+    Element&  elem = beginElement(CircleElem, x, y);
+    elem.layer = layer;
+    elem.datatype = datatype;
+    elem.width = radius;
+}
+
+
+void
+RepetitionSynthesizer::beginTrapezoid (Ulong layer, Ulong datatype,
+                                       long x, long  y,
+                                       const Trapezoid& trap,
+                                       const Repetition*  rep)
+{
+    passThrough();
+    target->beginTrapezoid(layer, datatype, x, y, trap, rep);
+}
+
+
+void
+RepetitionSynthesizer::beginXElement (Ulong attribute, const string& data)
+{
+    passThrough();
+    target->beginXElement(attribute, data);
+}
+
+
+void
+RepetitionSynthesizer::beginXGeometry (Ulong layer, Ulong datatype,
+                                       long x, long y,
+                                       Ulong attribute,
+                                       const string& data,
+                                       const Repetition*  rep)
+{
+    passThrough();
+    target->beginXGeometry(layer, datatype, x, y, attribute, data, rep);
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
@@ -0,0 +1,187 @@
+// oasis/rep-synth.h -- builder proxy that folds identical elements
+//                      into repetitions
+//
+// last modified:   2026/10/17
+//
+// Many flows write flat rows of identical rectangles and placements
+// with no OASIS repetitions, and JLayoutBuilder::generateBinary()
+// expands every repetition it stored.  Each instance then costs a
+// record.  RepetitionSynthesizer sits in front of the OasisCreator and
+// writes such elements back as a few records with repetitions.
+//
+// Within a cell, an element without a repetition or properties is not
+// forwarded at once.  It joins the group of elements that differ from
+// it only in position: same kind, layer and datatype (or textlayer and
+// texttype), same dimensions or point list, same cell or text string,
+// same magnification, angle and flip.  At endCell() each group is
+// written as what PlanRepetitions() makes of its positions:
+//
+//   - one Rep_UniformX, Rep_UniformY, Rep_Diagonal, Rep_Matrix or
+//     Rep_TiltedMatrix, if that covers the positions exactly
+//   - otherwise whichever costs fewest bytes of: one varying or
+//     arbitrary repetition (with a grid if the offsets share a factor),
+//     or uniform rows stacked into matrices where they line up, with
+//     the odd positions left over in one varying or arbitrary
+//     repetition; rows are tried both along X and along Y
+//
+// Positions that occur more than once are planned again on their own,
+// so nothing is lost or merged.  Byte counts are estimates from the
+// encodings in Section 7.6 and ignore the modal variables.
+//
+// Elements that already have a repetition or that have properties are
+// forwarded at once, unchanged.  So are trapezoids and XGEOMETRY
+// records, which are rarely flat arrays.  What the proxy does with
+// everything else, and why reordering is allowed, is described in
+// element-proxy.h.  A cell with very many elements is written in
+// several parts to bound the memory held.
+
+#ifndef OASIS_REP_SYNTH_H_INCLUDED
+#define OASIS_REP_SYNTH_H_INCLUDED
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "misc/utils.h"
+#include "oasis.h"
+#include "builder.h"
+#include "element-proxy.h"
+#include "rep-intern.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+using std::vector;
+using SoftJin::Ulong;
+using SoftJin::Ullong;
+
+
+// RepCover -- one record of a plan: an element at origin with rep,
+// or a single element if repeated is false.
+
+struct RepCover {
+    Delta       origin;
+    Repetition  rep;
+    bool        repeated;
+};
+
+
+class RepetitionSynthesizer : public ElementProxy {
+    enum ElementKind {
+        PlacementElem, TextElem, RectangleElem, PolygonElem,
+        PathElem, CircleElem
+    };
+
+    // Element -- everything about an element except its position
+    struct Element {
+        ElementKind     kind;
+        Ulong           layer, datatype;        // textlayer, texttype
+        long            width, height;          // radius, halfwidth
+        long            startExtn, endExtn;
+        PointList       ptlist;
+        CellName*       cellName;
+        TextString*     text;
+        Oreal           mag, angle;
+        bool            flip;
+    };
+
+    struct Group {
+        Element         proto;
+        vector<Delta>   positions;
+    };
+
+    vector<Group>       groups;         // in order of first appearance
+    std::unordered_map<string, size_t>  groupIndex;     // by key()
+    size_t              numBuffered;    // positions in groups
+
+    Element             pending;        // the last element, if held
+    long                pendingX, pendingY;
+
+    string              keyBuf;         // scratch
+    vector<RepCover>    covers;         // scratch
+
+    Ullong      elementsIn, recordsOut;
+
+public:
+    explicit    RepetitionSynthesizer (OasisBuilder* target);
+    virtual     ~RepetitionSynthesizer();
+
+    Ullong      getElementsIn() const   { return elementsIn; }
+    Ullong      getRecordsOut() const   { return recordsOut; }
+
+    static void PlanRepetitions (/*inout*/ vector<Delta>* positions,
+                                 /*out*/ vector<RepCover>* covers);
+
+    // OasisBuilder virtual methods for the elements.  ElementProxy
+    // provides the rest.
+
+    virtual void  beginPlacement (CellName* cellName,
+                                  long x, long y,
+                                  const Oreal&  mag,
+                                  const Oreal&  angle,
+                                  bool flip,
+                                  const Repetition*  rep);
+
+    virtual void  beginText (Ulong textlayer, Ulong texttype,
+                             long x, long y,
+                             TextString* text,
+                             const Repetition* rep);
+
+    virtual void  beginRectangle (Ulong layer, Ulong datatype,
+                                  long x, long y,
+                                  long width, long height,
+                                  const Repetition*  rep);
+
+    virtual void  beginPolygon (Ulong layer, Ulong datatype,
+                                long x, long y,
+                                const PointList&  ptlist,
+                                const Repetition*  rep);
+
+    virtual void  beginPath (Ulong layer, Ulong datatype,
+                             long x, long  y,
+                             long halfwidth,
+                             long startExtn, long endExtn,
+                             const PointList&  ptlist,
+                             const Repetition*  rep);
+
+    virtual void  beginTrapezoid (Ulong layer, Ulong datatype,
+                                  long x, long  y,
+                                  const Trapezoid& trap,
+                                  const Repetition*  rep);
+
+    virtual void  beginCircle (Ulong layer, Ulong datatype,
+                               long x, long y,
+                               long radius,
+                               const Repetition*  rep);
+
+    virtual void  beginXElement (Ulong attribute, const string& data);
+
+    virtual void  beginXGeometry (Ulong layer, Ulong datatype,
+                                  long x, long y,
+                                  Ulong attribute,
+                                  const string& data,
+                                  const Repetition*  rep);
+
+private:
+    virtual void  flushHeld();
+    virtual void  releaseLast();
+    virtual void  settleLast();
+
+private:
+    Element&    beginElement (ElementKind kind, long x, long y);
+    void        passThrough();
+    void        emit (const Element& elem, long x, long y,
+                      const Repetition* rep);
+    const string&  key (const Element& elem);
+
+private:
+                RepetitionSynthesizer (const RepetitionSynthesizer&);  // forbidden
+    void        operator= (const RepetitionSynthesizer&);              // forbidden
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_REP_SYNTH_H_INCLUDED
@@ -0,0 +1,426 @@
+// oasis/shape-encode.cc -- choose the cheapest encoding of an element's
+//                          geometry
+//
+// last modified:   2026/10/17
+
+#include <algorithm>
+#include <cassert>
+
+#include "varint.h"
+#include "shape-encode.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using SoftJin::llong;
+using SoftJin::Ullong;
+
+
+namespace {
+
+// Edge coordinates below MaxEdgeCoord fit every point-list type.  The
+// tightest is a form-1 g-delta (magnitude shifted left 4 bits) of the
+// difference of two edges in type 5.
+
+const Ullong  MaxEdgeCoord = Ullong(1) << 59;
+
+
+inline Ullong
+Magnitude (llong val) {
+    return (val < 0 ? Ullong(0) - Ullong(val) : Ullong(val));
+}
+
+
+// OctDirection -- direction code and magnitude of an octangular delta
+// The codes are those of 3-deltas and form-1 g-deltas (Section 7.5):
+// E N W S NE NW SW SE.  2-deltas use the first four.  (0,0) is east
+// with magnitude 0.  Returns false if the delta is not horizontal,
+// vertical or diagonal.
+
+inline bool
+OctDirection (llong dx, llong dy, /*out*/ Uint* dir, /*out*/ Ullong* mag)
+{
+    Ullong  ax = Magnitude(dx);
+    Ullong  ay = Magnitude(dy);
+    if (dy == 0) {
+        *dir = (dx < 0) ? 2 : 0;
+        *mag = ax;
+    } else if (dx == 0) {
+        *dir = (dy < 0) ? 3 : 1;
+        *mag = ay;
+    } else if (ax == ay) {
+        if (dx > 0)
+            *dir = (dy > 0) ? 4 : 7;
+        else
+            *dir = (dy > 0) ? 5 : 6;
+        *mag = ax;
+    } else
+        return false;
+    return true;
+}
+
+
+// GDeltaSize, EncodeGDelta -- the 1-integer form for the eight
+// octangular directions, else the 2-integer form
+
+inline size_t
+GDeltaSize (llong dx, llong dy)
+{
+    Uint    dir;
+    Ullong  mag;
+    if (OctDirection(dx, dy, &dir, &mag))
+        return UIntSize((mag << 4) | (dir << 1));
+    return (UIntSize((Magnitude(dx) << 2) | 1) + SIntSize(dy));
+}
+
+
+inline size_t
+EncodeGDelta (llong dx, llong dy, /*out*/ Uchar* buf)
+{
+    Uint    dir;
+    Ullong  mag;
+    if (OctDirection(dx, dy, &dir, &mag))
+        return EncodeUInt((mag << 4) | (dir << 1), buf);
+    size_t  nbytes = EncodeUInt((Magnitude(dx) << 2) | (dx < 0 ? 2 : 0) | 1,
+                                buf);
+    return (nbytes + EncodeSInt(dy, buf + nbytes));
+}
+
+}  // unnamed namespace
+
+
+//----------------------------------------------------------------------
+// Point-lists
+
+
+// ChoosePointListCode -- the valid point-list type with fewest bytes
+// A single pass over the edges keeps, for each type, whether it can
+// still hold the list and the bytes of its deltas so far.  For
+// polygons the closing edge is only checked, and 1-deltas also skip
+// the edge into the last vertex, which the reader infers.
+
+bool
+ChoosePointListCode (const PointList& ptlist, bool isPolygon,
+                     /*out*/ PointListCode* code)
+{
+    assert (! ptlist.empty()  &&  ptlist[0].x == 0  &&  ptlist[0].y == 0);
+
+    size_t  numVertices = ptlist.size();
+    size_t  numEdges = isPolygon ? numVertices : numVertices - 1;
+    size_t  numStored = numVertices - 1;        // types 2-5
+    size_t  numStored1 = numStored;             // types 0 and 1
+
+    bool    valid[6] = { true, true, true, true, true, true };
+    size_t  bytes[6] = { 0, 0, 0, 0, 0, 0 };
+    if (isPolygon) {
+        if (numVertices < 4  ||  numVertices % 2 != 0) {
+            valid[0] = valid[1] = false;
+            numStored1 = 0;
+        } else
+            --numStored1;
+    }
+
+    llong  prevDx = 0, prevDy = 0;
+    for (size_t k = 0;  k < numEdges;  ++k) {
+        const Delta&  from = ptlist[k];
+        const Delta&  to = (k + 1 == numVertices) ? ptlist[0] : ptlist[k+1];
+        llong  dx = llong(to.x) - llong(from.x);
+        llong  dy = llong(to.y) - llong(from.y);
+        if (Magnitude(dx) >= MaxEdgeCoord  ||  Magnitude(dy) >= MaxEdgeCoord)
+            return false;
+
+        // Type 0 wants the even edges horizontal and the odd ones
+        // vertical, type 1 the reverse.
+        bool  even = (k % 2 == 0);
+        if (even ? (dy != 0) : (dx != 0))  valid[0] = false;
+        if (even ? (dx != 0) : (dy != 0))  valid[1] = false;
+        if (k < numStored1) {
+            bytes[0] += SIntSize(even ? dx : dy);
+            bytes[1] += SIntSize(even ? dy : dx);
+        }
+
+        Uint    dir;
+        Ullong  mag;
+        bool  octangular = OctDirection(dx, dy, &dir, &mag);
+        if (! octangular)
+            valid[2] = valid[3] = false;
+        else if (dir >= 4)
+            valid[2] = false;
+
+        if (k >= numStored)
+            continue;
+        if (octangular) {
+            bytes[2] += UIntSize((mag << 2) | (dir & 3));
+            bytes[3] += UIntSize((mag << 3) | dir);
+            bytes[4] += UIntSize((mag << 4) | (dir << 1));
+        } else
+            bytes[4] += UIntSize((Magnitude(dx) << 2) | 1) + SIntSize(dy);
+        bytes[5] += GDeltaSize(dx - prevDx, dy - prevDy);
+        prevDx = dx;
+        prevDy = dy;
+    }
+
+    code->bytes = 0;
+    for (Uint type = 0;  type < 6;  ++type) {
+        if (! valid[type])
+            continue;
+        Ulong   count = (type <= 1) ? numStored1 : numStored;
+        size_t  total = 1 + UIntSize(count) + bytes[type];
+        if (code->bytes == 0  ||  total < code->bytes) {
+            code->type = type;
+            code->count = count;
+            code->bytes = total;
+        }
+    }
+    return true;
+}
+
+
+// EncodePointList -- append ptlist to buf in the type chosen by
+// ChoosePointListCode()
+// code must have come from ChoosePointListCode() for the same list;
+// it also says how many deltas to write, which depends on isPolygon.
+
+void
+EncodePointList (const PointList& ptlist, const PointListCode& code,
+                 /*inout*/ vector<Uchar>* buf)
+{
+    // The encoders may store a whole word past the last byte they
+    // write, so leave them room and trim it afterwards.
+    size_t  start = buf->size();
+    buf->resize(start + code.bytes + MaxVarintBytes);
+    Uchar*  p = &(*buf)[start];
+
+    p += EncodeUInt(code.type, p);
+    p += EncodeUInt(code.count, p);
+
+    llong  prevDx = 0, prevDy = 0;
+    for (Ulong k = 0;  k < code.count;  ++k) {
+        llong  dx = llong(ptlist[k+1].x) - llong(ptlist[k].x);
+        llong  dy = llong(ptlist[k+1].y) - llong(ptlist[k].y);
+        Uint    dir = 0;
+        Ullong  mag = 0;
+        switch (code.type) {
+            case 0:
+            case 1: {
+                bool  horiz = ((k % 2 == 0) == (code.type == 0));
+                p += EncodeSInt(horiz ? dx : dy, p);
+                break;
+            }
+            case 2:
+                OctDirection(dx, dy, &dir, &mag);
+                p += EncodeUInt((mag << 2) | dir, p);
+                break;
+            case 3:
+                OctDirection(dx, dy, &dir, &mag);
+                p += EncodeUInt((mag << 3) | dir, p);
+                break;
+            case 4:
+                p += EncodeGDelta(dx, dy, p);
+                break;
+            default:
+                p += EncodeGDelta(dx - prevDx, dy - prevDy, p);
+                prevDx = dx;
+                prevDy = dy;
+                break;
+        }
+    }
+
+    assert (p == &(*buf)[start] + code.bytes);
+    buf->resize(start + code.bytes);
+}
+
+
+//----------------------------------------------------------------------
+// Trapezoids
+
+
+namespace {
+
+// CtrapVertices -- the vertices of each CTRAPEZOID type (Section 26)
+// Each coordinate is xw*w + xh*h or yw*w + yh*h.  The triangles repeat
+// their last vertex.
+
+struct CtrapVertex {
+    signed char  xw, xh, yw, yh;
+};
+
+const CtrapVertex  CtrapVertices[26][4] = {
+    { {0,0,0,0}, {0,0,0,1}, {1,-1,0,1}, {1,0,0,0} },        //  0
+    { {0,0,0,0}, {0,0,0,1}, {1,0,0,1},  {1,-1,0,0} },       //  1
+    { {0,0,0,0}, {0,1,0,1}, {1,0,0,1},  {1,0,0,0} },        //  2
+    { {0,1,0,0}, {0,0,0,1}, {1,0,0,1},  {1,0,0,0} },        //  3
+    { {0,0,0,0}, {0,1,0,1}, {1,-1,0,1}, {1,0,0,0} },        //  4
+    { {0,1,0,0}, {0,0,0,1}, {1,0,0,1},  {1,-1,0,0} },       //  5
+    { {0,0,0,0}, {0,1,0,1}, {1,0,0,1},  {1,-1,0,0} },       //  6
+    { {0,1,0,0}, {0,0,0,1}, {1,-1,0,1}, {1,0,0,0} },        //  7
+    { {0,0,0,0}, {0,0,0,1}, {1,0,-1,1}, {1,0,0,0} },        //  8
+    { {0,0,0,0}, {0,0,-1,1}, {1,0,0,1}, {1,0,0,0} },        //  9
+    { {0,0,0,0}, {0,0,0,1}, {1,0,0,1},  {1,0,1,0} },        // 10
+    { {0,0,1,0}, {0,0,0,1}, {1,0,0,1},  {1,0,0,0} },        // 11
+    { {0,0,0,0}, {0,0,0,1}, {1,0,-1,1}, {1,0,1,0} },        // 12
+    { {0,0,1,0}, {0,0,-1,1}, {1,0,0,1}, {1,0,0,0} },        // 13
+    { {0,0,0,0}, {0,0,-1,1}, {1,0,0,1}, {1,0,1,0} },        // 14
+    { {0,0,1,0}, {0,0,0,1}, {1,0,-1,1}, {1,0,0,0} },        // 15
+    { {0,0,0,0}, {0,0,1,0}, {1,0,0,0},  {1,0,0,0} },        // 16
+    { {0,0,0,0}, {0,0,1,0}, {1,0,1,0},  {1,0,1,0} },        // 17
+    { {0,0,0,0}, {1,0,1,0}, {1,0,0,0},  {1,0,0,0} },        // 18
+    { {0,0,1,0}, {1,0,1,0}, {1,0,0,0},  {1,0,0,0} },        // 19
+    { {0,0,0,0}, {0,1,0,1}, {0,2,0,0},  {0,2,0,0} },        // 20
+    { {0,0,0,1}, {0,2,0,1}, {0,1,0,0},  {0,1,0,0} },        // 21
+    { {0,0,0,0}, {0,0,2,0}, {1,0,1,0},  {1,0,1,0} },        // 22
+    { {1,0,0,0}, {0,0,1,0}, {1,0,2,0},  {1,0,2,0} },        // 23
+    { {0,0,0,0}, {0,0,0,1}, {1,0,0,1},  {1,0,0,0} },        // 24
+    { {0,0,0,0}, {0,0,1,0}, {1,0,1,0},  {1,0,0,0} },        // 25
+};
+
+
+// The order in which the types are tried: those that need only one of
+// width and height first, then the rectangle, then the rest.
+
+const Uint  CtrapPreference[26] = {
+    25, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+};
+
+
+// FitsCTrapezoid -- whether type may have width w and height h
+
+bool
+FitsCTrapezoid (Uint type, llong w, llong h)
+{
+    switch (type) {
+        case 0:   case 1:   case 2:   case 3:   case 6:   case 7:
+            return (w >= h);
+        case 4:   case 5:
+            return (w >= 2*h);
+        case 8:   case 9:   case 10:  case 11:  case 14:  case 15:
+            return (h >= w);
+        case 12:  case 13:
+            return (h >= 2*w);
+        case 16:  case 17:  case 18:  case 19:  case 25:
+            return (h == w);
+        case 20:  case 21:
+            return (w == 2*h);
+        case 22:  case 23:
+            return (h == 2*w);
+        default:
+            return true;
+    }
+}
+
+
+bool
+VertexLess (const Delta& a, const Delta& b) {
+    return (a.x < b.x  ||  (a.x == b.x  &&  a.y < b.y));
+}
+
+
+// SortVertices -- sort the four vertices and drop duplicates
+// Two convex shapes are the same if their vertex sets are.  Returns the
+// number of distinct vertices.
+
+size_t
+SortVertices (/*inout*/ Delta* vertices)
+{
+    std::sort(vertices, vertices + 4, VertexLess);
+    return (std::unique(vertices, vertices + 4) - vertices);
+}
+
+}  // unnamed namespace
+
+
+// FindCTrapezoidType -- the CTRAPEZOID type with the vertices of trap
+// Returns false if there is none.  The vertices of the TRAPEZOID are
+// those of Section 25: delta-a and delta-b move the ends of the top
+// and bottom edges (horizontal) or of the left and right edges
+// (vertical).  Every side of a CTRAPEZOID is at 0, 45 or 90 degrees,
+// so most trapezoids are rejected by the first test.
+
+bool
+FindCTrapezoidType (const Trapezoid& trap, /*out*/ Uint* ctrapType)
+{
+    llong  w = trap.getWidth();
+    llong  h = trap.getHeight();
+    llong  da = trap.getDelta_a();
+    llong  db = trap.getDelta_b();
+    bool   vertical = (trap.getOrientation() == Trapezoid::Vertical);
+
+    llong  slant = vertical ? w : h;
+    if ((da != 0  &&  da != slant  &&  da != -slant)
+            ||  (db != 0  &&  db != slant  &&  db != -slant))
+        return false;
+
+    Delta  shape[4];
+    if (vertical) {
+        shape[0] = Delta(0, std::max(da, llong(0)));
+        shape[1] = Delta(0, h + std::min(db, llong(0)));
+        shape[2] = Delta(w, h - std::max(db, llong(0)));
+        shape[3] = Delta(w, -std::min(da, llong(0)));
+    } else {
+        shape[0] = Delta(std::max(da, llong(0)), h);
+        shape[1] = Delta(w + std::min(db, llong(0)), h);
+        shape[2] = Delta(w - std::max(db, llong(0)), 0);
+        shape[3] = Delta(-std::min(da, llong(0)), 0);
+    }
+    size_t  numShape = SortVertices(shape);
+
+    for (Uint j = 0;  j < 26;  ++j) {
+        Uint  type = CtrapPreference[j];
+        if (! FitsCTrapezoid(type, w, h))
+            continue;
+        Delta  ctrap[4];
+        for (int k = 0;  k < 4;  ++k) {
+            const CtrapVertex&  v = CtrapVertices[type][k];
+            ctrap[k] = Delta(v.xw*w + v.xh*h, v.yw*w + v.yh*h);
+        }
+        if (SortVertices(ctrap) == numShape
+                &&  std::equal(shape, shape + numShape, ctrap)) {
+            *ctrapType = type;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// CTrapezoidFields -- which dimensions a CTRAPEZOID of type needs
+// Types 20 and 21 derive the width from the height; 16-19, 22, 23 and
+// 25 derive the height from the width.
+
+void
+CTrapezoidFields (Uint ctrapType, /*out*/ bool* needWidth,
+                  /*out*/ bool* needHeight)
+{
+    *needWidth = (ctrapType != 20  &&  ctrapType != 21);
+    *needHeight = ! ((ctrapType >= 16  &&  ctrapType <= 19)
+                     ||  ctrapType == 22  ||  ctrapType == 23
+                     ||  ctrapType == 25);
+}
+
+
+//----------------------------------------------------------------------
+// Path extensions
+
+
+// ChooseExtnScheme -- the cheapest scheme for one end of a path
+// modalExtn points to the value of path-start-extension or
+// path-end-extension, or is Null if the modal variable is undefined.
+// Scheme 0 reuses the modal variable, 1 is flush, 2 is half the width
+// and 3 is an explicit signed-integer.
+
+Uint
+ChooseExtnScheme (long extn, long halfwidth, const long* modalExtn)
+{
+    if (modalExtn != Null  &&  *modalExtn == extn)
+        return 0;
+    if (extn == 0)
+        return 1;
+    if (extn == halfwidth)
+        return 2;
+    return 3;
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
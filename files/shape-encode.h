@@ -0,0 +1,96 @@
+// oasis/shape-encode.h -- choose the cheapest encoding of an element's
+//                         geometry
+//
+// last modified:   2026/10/17
+//
+// OASIS can write the same shape in several ways, and the ways differ
+// in size.  These functions decide, for one element at a time, which
+// valid form is shortest.  They only choose and encode; the record
+// itself is written by OasisCreator.
+//
+// Point-lists (Section 7.7)
+//
+//   ChoosePointListCode() makes one pass over the edges and works out
+//   at the same time which of the six point-list types can hold the
+//   list and how many bytes each would take:
+//
+//     0, 1   1-deltas: edges alternately horizontal and vertical,
+//            starting horizontal (0) or vertical (1).  For polygons the
+//            closing edge must continue the alternation, and the last
+//            vertex is left out because the reader can infer it.
+//     2      2-deltas: every edge horizontal or vertical
+//     3      3-deltas: every edge horizontal, vertical or at 45 degrees
+//     4      g-deltas: any edge
+//     5      g-deltas of the difference from the previous edge, which
+//            is short when edges repeat, as in staircases and
+//            approximated arcs
+//
+//   For polygons of types 2 and 3 the implicit closing edge must also be
+//   Manhattan or octangular.  The choice is the valid type with fewest
+//   bytes, the lower type on a tie.  EncodePointList() then writes the
+//   list in that type.
+//
+//   The first vertex of the list must be (0,0), as the encoding
+//   implies it.  ChoosePointListCode() returns false if an edge has a
+//   coordinate of 2^59 or more, which no type is sure to hold.
+//
+// Trapezoids (Section 26)
+//
+//   FindCTrapezoidType() finds the CTRAPEZOID type, if any, that has the
+//   same vertices as a TRAPEZOID, and CTrapezoidFields() says which of
+//   width and height that type still needs.  A type that derives one
+//   dimension from the other is preferred, then the rectangle, so a
+//   square comes out as type 25.  (A square RECTANGLE needs no help:
+//   the S bit applies whenever width equals height.)
+//
+// Path extensions (Section 24)
+//
+//   ChooseExtnScheme() picks the 2-bit scheme for one end of a path.
+//   Schemes 0-2 cost nothing beyond the extension-scheme byte, and if
+//   both ends use scheme 0 (reuse the modal variable) the byte itself
+//   can be left out.  So scheme 0 is preferred whenever the modal
+//   variable already has the value.
+
+#ifndef OASIS_SHAPE_ENCODE_H_INCLUDED
+#define OASIS_SHAPE_ENCODE_H_INCLUDED
+
+#include <cstddef>
+#include <vector>
+
+#include "misc/utils.h"
+#include "oasis.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::vector;
+using SoftJin::Uchar;
+using SoftJin::Uint;
+using SoftJin::Ulong;
+
+
+// PointListCode -- how a point-list is to be written
+
+struct PointListCode {
+    Uint        type;           // point-list type 0-5
+    Ulong       count;          // number of deltas written
+    size_t      bytes;          // of the type, the count and the deltas
+};
+
+
+bool    ChoosePointListCode (const PointList& ptlist, bool isPolygon,
+                             /*out*/ PointListCode* code);
+void    EncodePointList (const PointList& ptlist, const PointListCode& code,
+                         /*inout*/ vector<Uchar>* buf);
+
+bool    FindCTrapezoidType (const Trapezoid& trap, /*out*/ Uint* ctrapType);
+void    CTrapezoidFields (Uint ctrapType, /*out*/ bool* needWidth,
+                          /*out*/ bool* needHeight);
+
+Uint    ChooseExtnScheme (long extn, long halfwidth, const long* modalExtn);
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_SHAPE_ENCODE_H_INCLUDED
@@ -0,0 +1,123 @@
+// oasis/spsc-ring.h -- bounded lock-free single-producer/single-consumer ring
+//
+// last modified:   2026/10/17
+//
+// SpscRing<T> is a fixed-size circular queue for exactly one producer
+// thread and one consumer thread.  Neither side takes a lock: the
+// producer owns tail, the consumer owns head, and each reads the
+// other's index with acquire ordering.  A successful tryPush()
+// happens-before the tryPop() that returns the item, so everything the
+// producer wrote before pushing is visible to the consumer after
+// popping.  Keep T small (a pointer, say); it is copied in and out.
+//
+// The capacity is rounded up to a power of two.  The indexes grow
+// without wrapping and are masked on use, so a full ring holds all
+// capacity() slots.
+//
+// Backoff is the waiting policy for a side that finds the ring full or
+// empty.  It spins briefly, then yields, then sleeps for short
+// periods, so that a stalled partner does not cost a whole core.
+
+#ifndef OASIS_SPSC_RING_H_INCLUDED
+#define OASIS_SPSC_RING_H_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace Anuvad {
+namespace Oasis {
+
+
+template <typename T>
+class SpscRing {
+    enum { CacheLine = 64 };
+
+    std::vector<T>      slots;
+    size_t              mask;
+
+    // Each index on its own cache line, so that the two threads do not
+    // take turns owning one line.
+    char                pad0[CacheLine];
+    std::atomic<size_t> head;           // next slot to pop; consumer's
+    char                pad1[CacheLine - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> tail;           // next slot to push; producer's
+    char                pad2[CacheLine - sizeof(std::atomic<size_t>)];
+
+public:
+    explicit    SpscRing (size_t capacity)
+                  : head(0), tail(0)
+                {
+                    size_t  n = 1;
+                    while (n < capacity)
+                        n <<= 1;
+                    slots.resize(n);
+                    mask = n - 1;
+                }
+
+    size_t      capacity() const        { return slots.size(); }
+
+    // tryPush -- append item; false if the ring is full
+    // Producer only.
+    bool        tryPush (const T& item) {
+                    size_t  t = tail.load(std::memory_order_relaxed);
+                    if (t - head.load(std::memory_order_acquire) == slots.size())
+                        return false;
+                    slots[t & mask] = item;
+                    tail.store(t + 1, std::memory_order_release);
+                    return true;
+                }
+
+    // tryPop -- remove the oldest item into *item; false if empty
+    // Consumer only.
+    bool        tryPop (/*out*/ T* item) {
+                    size_t  h = head.load(std::memory_order_relaxed);
+                    if (h == tail.load(std::memory_order_acquire))
+                        return false;
+                    *item = slots[h & mask];
+                    head.store(h + 1, std::memory_order_release);
+                    return true;
+                }
+
+    // empty -- a snapshot; exact only when the other side is idle
+    bool        empty() const {
+                    return (head.load(std::memory_order_acquire)
+                            == tail.load(std::memory_order_acquire));
+                }
+
+private:
+                SpscRing (const SpscRing&);             // forbidden
+    void        operator= (const SpscRing&);            // forbidden
+};
+
+
+// Backoff -- spin, then yield, then sleep
+// Call wait() each time the ring is found full or empty, and reset()
+// after making progress.
+
+class Backoff {
+    unsigned    rounds;
+
+public:
+                Backoff() : rounds(0) { }
+    void        reset()                 { rounds = 0; }
+
+    void        wait() {
+                    if (rounds < 64)
+                        ;                       // spin
+                    else if (rounds < 128)
+                        std::this_thread::yield();
+                    else
+                        std::this_thread::sleep_for(
+                            std::chrono::microseconds(50));
+                    ++rounds;
+                }
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_SPSC_RING_H_INCLUDED
@@ -0,0 +1,28 @@
+// oasis/stream-builder.cc -- optional chunked delivery of large point lists
+//
+// last modified:   2026/10/17
+
+#include "stream-builder.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+
+void
+StreamPointList (OasisPointStreamBuilder* builder,
+                 const PointListView& view, bool isPolygon)
+{
+    // 16 KB of vertices: small enough to stay in L1/L2 between the
+    // decoder and the builder.
+    const size_t  ChunkSize = 1024;
+    Delta  chunk[ChunkSize];
+
+    PointListDecoder  decoder(view, isPolygon);
+    size_t  n;
+    while ((n = decoder.next(chunk, ChunkSize)) != 0)
+        builder->addPoints(DeltaSpan(chunk, n));
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
@@ -0,0 +1,84 @@
+// oasis/stream-builder.h -- optional chunked delivery of large point lists
+//
+// last modified:   2026/10/17
+//
+// Some polygons and paths -- curvilinear OPC output, for instance --
+// have hundreds of thousands of vertices.  Passing one as a PointList
+// means holding all of it decoded at once, and a builder that stores it
+// copies it again.  A builder that only needs a bounding box, a vertex
+// count, or a place to put the vertices can instead take them in fixed
+// chunks, so that peak memory does not depend on the size of the list.
+//
+// A builder that also derives from OasisPointStreamBuilder may be given
+// a polygon or path in three steps instead of one beginPolygon() or
+// beginPath():
+//
+//     beginPolygonStream() or beginPathStream()
+//         the element's other fields and numPoints, the number of
+//         vertices that will follow
+//     addPoints(), one or more times
+//         the vertices in order, exactly numPoints in all.  They are
+//         what the PointList would have held: relative to (x,y),
+//         cumulative, beginning with (0,0), with the closing edge of a
+//         polygon implied.  The span is valid only during the call.
+//     the element's properties and endElement() as usual.
+//
+// Callers find out with dynamic_cast, as for OasisArenaBuilder, and
+// stream only lists of at least PointStreamThreshold vertices; shorter
+// lists still come through beginPolygon() and beginPath().
+// StreamPointList() does the addPoints() part for a caller that has the
+// list as an undecoded PointListView.
+
+#ifndef OASIS_STREAM_BUILDER_H_INCLUDED
+#define OASIS_STREAM_BUILDER_H_INCLUDED
+
+#include "misc/utils.h"
+#include "oasis.h"
+#include "batch-builder.h"
+#include "mapped-scanner.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using SoftJin::Ulong;
+
+
+typedef ElemSpan<Delta>  DeltaSpan;
+
+// Below this many vertices the list is small enough to pass whole.
+const Ulong  PointStreamThreshold = 4096;
+
+
+class OasisPointStreamBuilder {
+public:
+    virtual     ~OasisPointStreamBuilder() { }
+
+    virtual void  beginPolygonStream (Ulong layer, Ulong datatype,
+                                      long x, long y,
+                                      Ulong numPoints,
+                                      const Repetition*  rep) = 0;
+
+    virtual void  beginPathStream (Ulong layer, Ulong datatype,
+                                   long x, long y,
+                                   long halfwidth,
+                                   long startExtn, long endExtn,
+                                   Ulong numPoints,
+                                   const Repetition*  rep) = 0;
+
+    virtual void  addPoints (const DeltaSpan& points) = 0;
+};
+
+
+// StreamPointList -- decode view in chunks and pass them to addPoints()
+// The caller has already called beginPolygonStream() or
+// beginPathStream() with PointListDecoder::NumVertices(view, isPolygon)
+// as numPoints.
+
+void    StreamPointList (OasisPointStreamBuilder* builder,
+                         const PointListView& view, bool isPolygon);
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_STREAM_BUILDER_H_INCLUDED
@@ -0,0 +1,599 @@
+// oasis/tee-builder.cc -- builder that forwards each call to several builders
+//
+// last modified:   2026/10/17
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "tee-builder.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+
+namespace {
+
+// Bytes per batch.  Large enough that the queue locking is lost in the
+// cost of the calls, small enough that the consumers start early.
+const size_t  BatchBytes = 16*1024;
+
+}  // unnamed namespace
+
+
+//----------------------------------------------------------------------
+// Consumer -- a target builder, its thread and its queue of batches
+
+
+class TeeBuilder::Consumer {
+    typedef std::shared_ptr<const CallBatch>  BatchPtr;
+
+    OasisBuilder*       builder;
+    size_t              capacity;
+    std::deque<BatchPtr>  queue;
+    std::mutex          mutex;
+    std::condition_variable  notEmpty;
+    std::condition_variable  notFull;
+    bool                closed;         // no more batches will come
+    bool                abandoned;      // drop whatever is queued
+    std::exception_ptr  error;          // set before failed
+    std::atomic<bool>   failed;
+    std::thread         thread;
+
+public:
+                Consumer (OasisBuilder* builder, size_t capacity);
+    void        start();
+    void        push (const BatchPtr& batch);
+    void        close (bool abandon);
+    void        join();
+
+    bool        hasFailed() const {
+                    return failed.load(std::memory_order_acquire);
+                }
+    // getError -- the exception the builder threw; valid once
+    // hasFailed() is true or after join()
+    std::exception_ptr  getError() const  { return error; }
+
+private:
+    void        run();
+};
+
+
+TeeBuilder::Consumer::Consumer (OasisBuilder* builder, size_t capacity)
+  : builder(builder),
+    capacity(capacity),
+    closed(false),
+    abandoned(false),
+    failed(false)
+{ }
+
+
+void
+TeeBuilder::Consumer::start() {
+    thread = std::thread(&Consumer::run, this);
+}
+
+
+// push -- queue a batch, waiting while the queue is full
+
+void
+TeeBuilder::Consumer::push (const BatchPtr& batch)
+{
+    std::unique_lock<std::mutex>  lock(mutex);
+    notFull.wait(lock, [this] {
+        return (queue.size() < capacity  ||  abandoned);
+    });
+    if (abandoned)
+        return;
+    queue.push_back(batch);
+    lock.unlock();
+    notEmpty.notify_one();
+}
+
+
+// close -- tell the thread that no more batches will come
+// With abandon, also discard the batches still queued.
+
+void
+TeeBuilder::Consumer::close (bool abandon)
+{
+    {
+        std::lock_guard<std::mutex>  lock(mutex);
+        closed = true;
+        if (abandon) {
+            abandoned = true;
+            queue.clear();
+        }
+    }
+    notEmpty.notify_one();
+    notFull.notify_one();
+}
+
+
+void
+TeeBuilder::Consumer::join()
+{
+    if (thread.joinable())
+        thread.join();
+}
+
+
+// run -- replay the queued batches on the builder until closed
+// Once the builder throws, the rest are drained without being replayed.
+
+void
+TeeBuilder::Consumer::run()
+{
+    PointList  ptlist;
+    for (;;) {
+        BatchPtr  batch;
+        {
+            std::unique_lock<std::mutex>  lock(mutex);
+            notEmpty.wait(lock, [this] {
+                return (!queue.empty()  ||  closed);
+            });
+            if (queue.empty())
+                break;
+            batch = queue.front();
+            queue.pop_front();
+        }
+        notFull.notify_one();
+
+        if (error)
+            continue;
+        try {
+            batch->replay(builder, &ptlist);
+        }
+        catch (...) {
+            error = std::current_exception();
+            failed.store(true, std::memory_order_release);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------
+// TeeBuilder
+
+
+TeeBuilder::TeeBuilder (bool threaded, size_t queueBatches)
+  : threaded(threaded),
+    queueBatches(queueBatches == 0 ? 1 : queueBatches),
+    started(false)
+{ }
+
+
+TeeBuilder::~TeeBuilder()
+{
+    // If endFile() was not reached, the parse failed.  Nothing waits
+    // for the output, so drop the queued calls.
+    stopThreads(true);
+}
+
+
+// addBuilder -- add a target
+// All targets must be added before the first call is forwarded.
+
+void
+TeeBuilder::addBuilder (OasisBuilder* builder)
+{
+    assert (builder != Null  &&  !started);
+    builders.push_back(builder);
+}
+
+
+void
+TeeBuilder::startThreads()
+{
+    assert (!started);
+    started = true;
+    batch = std::make_shared<CallBatch>();
+    consumers.reserve(builders.size());
+    for (size_t j = 0;  j < builders.size();  ++j) {
+        consumers.push_back(new Consumer(builders[j], queueBatches));
+        consumers.back()->start();
+    }
+}
+
+
+void
+TeeBuilder::stopThreads (bool abandon)
+{
+    for (size_t j = 0;  j < consumers.size();  ++j)
+        consumers[j]->close(abandon);
+    for (size_t j = 0;  j < consumers.size();  ++j) {
+        consumers[j]->join();
+        delete consumers[j];
+    }
+    consumers.clear();
+    batch.reset();
+    started = false;
+}
+
+
+// record -- the batch to record the next call into
+// Sends the current batch off first if it is full.
+
+CallBatch&
+TeeBuilder::record()
+{
+    if (!started)
+        startThreads();
+    else if (batch->byteSize() >= BatchBytes)
+        flushBatch();
+    return *batch;
+}
+
+
+// flushBatch -- give the current batch to every consumer
+// Then rethrow the error of any consumer that has failed, so that the
+// parse stops soon after a target gives up.
+
+void
+TeeBuilder::flushBatch()
+{
+    if (!batch->empty()) {
+        std::shared_ptr<const CallBatch>  full(std::move(batch));
+        batch = std::make_shared<CallBatch>(BatchBytes);
+        for (size_t j = 0;  j < consumers.size();  ++j)
+            consumers[j]->push(full);
+    }
+    checkErrors();
+}
+
+
+void
+TeeBuilder::checkErrors()
+{
+    for (size_t j = 0;  j < consumers.size();  ++j)
+        if (consumers[j]->hasFailed())
+            std::rethrow_exception(consumers[j]->getError());
+}
+
+
+// finish -- send the last batch and wait for all the targets
+// Rethrows the error of the first target that failed.
+
+void
+TeeBuilder::finish()
+{
+    flushBatch();
+    for (size_t j = 0;  j < consumers.size();  ++j)
+        consumers[j]->close(false);
+
+    std::exception_ptr  error;
+    for (size_t j = 0;  j < consumers.size();  ++j) {
+        consumers[j]->join();
+        if (!error)
+            error = consumers[j]->getError();
+    }
+    stopThreads(false);
+    if (error)
+        std::rethrow_exception(error);
+}
+
+
+//----------------------------------------------------------------------
+// OasisBuilder methods
+// Each records the call in threaded mode and makes it on every target
+// otherwise.
+
+
+void
+TeeBuilder::beginFile (const string& version,
+                       const Oreal& unit,
+                       Validation::Scheme valScheme)
+{
+    if (threaded) {
+        record().beginFile(version, unit, valScheme);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->beginFile(version, unit, valScheme);
+}
+
+
+void
+TeeBuilder::endFile()
+{
+    if (threaded) {
+        record().endFile();
+        finish();
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->endFile();
+}
+
+
+void
+TeeBuilder::beginCell (CellName* cellName)
+{
+    if (threaded) {
+        record().beginCell(cellName);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->beginCell(cellName);
+}
+
+
+void
+TeeBuilder::endCell()
+{
+    if (threaded) {
+        record().endCell();
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->endCell();
+}
+
+
+void
+TeeBuilder::beginPlacement (CellName* cellName,
+                            long x, long y,
+                            const Oreal&  mag,
+                            const Oreal&  angle,
+                            bool flip,
+                            const Repetition*  rep)
+{
+    if (threaded) {
+        record().beginPlacement(cellName, x, y, mag, angle, flip, rep);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->beginPlacement(cellName, x, y, mag, angle, flip, rep);
+}
+
+
+void
+TeeBuilder::beginText (Ulong textlayer, Ulong texttype,
+                       long x, long y,
+                       TextString* text,
+                       const Repetition* rep)
+{
+    if (threaded) {
+        record().beginText(textlayer, texttype, x, y, text, rep);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->beginText(textlayer, texttype, x, y, text, rep);
+}
+
+
+void
+TeeBuilder::beginRectangle (Ulong layer, Ulong datatype,
+                            long x, long y,
+                            long width, long height,
+                            const Repetition*  rep)
+{
+    if (threaded) {
+        record().beginRectangle(layer, datatype, x, y, width, height, rep);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->beginRectangle(layer, datatype, x, y,
+                                    width, height, rep);
+}
+
+
+void
+TeeBuilder::beginPolygon (Ulong layer, Ulong datatype,
+                          long x, long y,
+                          const PointList&  ptlist,
+                          const Repetition*  rep)
+{
+    if (threaded) {
+        record().beginPolygon(layer, datatype, x, y, ptlist, rep);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->beginPolygon(layer, datatype, x, y, ptlist, rep);
+}
+
+
+void
+TeeBuilder::beginPath (Ulong layer, Ulong datatype,
+                       long x, long  y,
+                       long halfwidth,
+                       long startExtn, long endExtn,
+                       const PointList&  ptlist,
+                       const Repetition*  rep)
+{
+    if (threaded) {
+        record().beginPath(layer, datatype, x, y, halfwidth,
+                           startExtn, endExtn, ptlist, rep);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->beginPath(layer, datatype, x, y, halfwidth,
+                               startExtn, endExtn, ptlist, rep);
+}
+
+
+void
+TeeBuilder::beginTrapezoid (Ulong layer, Ulong datatype,
+                            long x, long  y,
+                            const Trapezoid& trap,
+                            const Repetition*  rep)
+{
+    if (threaded) {
+        record().beginTrapezoid(layer, datatype, x, y, trap, rep);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->beginTrapezoid(layer, datatype, x, y, trap, rep);
+}
+
+
+void
+TeeBuilder::beginCircle (Ulong layer, Ulong datatype,
+                         long x, long y,
+                         long radius,
+                         const Repetition*  rep)
+{
+    if (threaded) {
+        record().beginCircle(layer, datatype, x, y, radius, rep);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->beginCircle(layer, datatype, x, y, radius, rep);
+}
+
+
+void
+TeeBuilder::beginXElement (Ulong attribute, const string& data)
+{
+    if (threaded) {
+        record().beginXElement(attribute, data);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->beginXElement(attribute, data);
+}
+
+
+void
+TeeBuilder::beginXGeometry (Ulong layer, Ulong datatype,
+                            long x, long y,
+                            Ulong attribute,
+                            const string& data,
+                            const Repetition*  rep)
+{
+    if (threaded) {
+        record().beginXGeometry(layer, datatype, x, y, attribute, data, rep);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->beginXGeometry(layer, datatype, x, y,
+                                    attribute, data, rep);
+}
+
+
+void
+TeeBuilder::endElement()
+{
+    if (threaded) {
+        record().endElement();
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->endElement();
+}
+
+
+void
+TeeBuilder::addCellProperty (Property* prop)
+{
+    if (threaded) {
+        record().addCellProperty(prop);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->addCellProperty(prop);
+}
+
+
+void
+TeeBuilder::addFileProperty (Property* prop)
+{
+    if (threaded) {
+        record().addFileProperty(prop);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->addFileProperty(prop);
+}
+
+
+void
+TeeBuilder::addElementProperty (Property* prop)
+{
+    if (threaded) {
+        record().addElementProperty(prop);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->addElementProperty(prop);
+}
+
+
+void
+TeeBuilder::registerCellName (CellName* cellName)
+{
+    if (threaded) {
+        record().registerCellName(cellName);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->registerCellName(cellName);
+}
+
+
+void
+TeeBuilder::registerTextString (TextString* textString)
+{
+    if (threaded) {
+        record().registerTextString(textString);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->registerTextString(textString);
+}
+
+
+void
+TeeBuilder::registerPropName (PropName* propName)
+{
+    if (threaded) {
+        record().registerPropName(propName);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->registerPropName(propName);
+}
+
+
+void
+TeeBuilder::registerPropString (PropString* propString)
+{
+    if (threaded) {
+        record().registerPropString(propString);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->registerPropString(propString);
+}
+
+
+void
+TeeBuilder::registerLayerName (LayerName* layerName)
+{
+    if (threaded) {
+        record().registerLayerName(layerName);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->registerLayerName(layerName);
+}
+
+
+void
+TeeBuilder::registerXName (XName* xname)
+{
+    if (threaded) {
+        record().registerXName(xname);
+        return;
+    }
+    for (size_t j = 0;  j < builders.size();  ++j)
+        builders[j]->registerXName(xname);
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
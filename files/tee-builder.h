@@ -0,0 +1,171 @@
+// oasis/tee-builder.h -- builder that forwards each call to several builders
+//
+// last modified:   2026/10/17
+//
+// TeeBuilder lets one parse feed several consumers, e.g. an OasisCreator
+// copying the file, an OasisStatisticsBuilder (Servers/analyzer.h)
+// counting it and a JLayoutBuilder computing bounding boxes.  Add the targets with addBuilder() before
+// passing the TeeBuilder to the parser.  Each OasisBuilder call is then
+// forwarded to the targets in the order they were added.
+//
+// Synchronous mode
+//
+//   The default.  Each call is made on every target before the next is
+//   made on any.  An exception from a target propagates to the parser
+//   at once; the targets after it do not see that call.
+//
+// Threaded mode
+//
+//   TeeBuilder(true) gives each target its own thread, so that a slow
+//   consumer does not hold up the others or the parser.  The parser's
+//   thread records the calls into batches, and each batch is put on a
+//   bounded queue for every target.  A target's thread replays the
+//   calls in order.  When a queue is full the parser waits; that is
+//   the backpressure that bounds memory to queueBatches batches per
+//   target.
+//
+//   The batches are CallBatch objects (call-batch.h), which copy what
+//   the parser passes and intern its repetitions in a cache of their
+//   own; a batch is freed when the last target has replayed it.  The
+//   parser must outlive endFile(), since the name pointers are passed
+//   through as they are, and at most one of the targets may modify the
+//   name objects (OasisCreator does, when it assigns reference
+//   numbers).  A batch is written only by the parser's thread and read
+//   by the others only after it has crossed the queue's mutex.
+//
+//   If a target throws, its thread stops calling it and keeps draining
+//   its queue, so the others are not affected.  The exception is
+//   rethrown in the parser's thread at the next batch or at endFile(),
+//   whichever comes first.  endFile() returns only after every target
+//   has finished its own endFile().
+
+#ifndef OASIS_TEE_BUILDER_H_INCLUDED
+#define OASIS_TEE_BUILDER_H_INCLUDED
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "misc/utils.h"
+#include "oasis.h"
+#include "builder.h"
+#include "call-batch.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+using std::vector;
+using SoftJin::Ulong;
+
+
+class TeeBuilder : public OasisBuilder {
+public:
+    class  Consumer;
+
+private:
+    vector<OasisBuilder*>   builders;
+    bool                    threaded;
+    size_t                  queueBatches;   // queue capacity, in batches
+
+    // Threaded mode only.
+    vector<Consumer*>       consumers;      // one per builder
+    std::shared_ptr<CallBatch>  batch;      // being filled
+    bool                    started;
+
+public:
+    explicit    TeeBuilder (bool threaded = false, size_t queueBatches = 64);
+    virtual     ~TeeBuilder();
+
+    void        addBuilder (OasisBuilder* builder);
+    size_t      size() const            { return builders.size(); }
+    bool        isThreaded() const      { return threaded; }
+
+    // OasisBuilder virtual methods.
+
+    virtual void  beginFile (const string& version,
+                             const Oreal& unit,
+                             Validation::Scheme valScheme);
+    virtual void  endFile();
+
+    virtual void  beginCell (CellName* cellName);
+    virtual void  endCell();
+
+    virtual void  beginPlacement (CellName* cellName,
+                                  long x, long y,
+                                  const Oreal&  mag,
+                                  const Oreal&  angle,
+                                  bool flip,
+                                  const Repetition*  rep);
+
+    virtual void  beginText (Ulong textlayer, Ulong texttype,
+                             long x, long y,
+                             TextString* text,
+                             const Repetition* rep);
+
+    virtual void  beginRectangle (Ulong layer, Ulong datatype,
+                                  long x, long y,
+                                  long width, long height,
+                                  const Repetition*  rep);
+
+    virtual void  beginPolygon (Ulong layer, Ulong datatype,
+                                long x, long y,
+                                const PointList&  ptlist,
+                                const Repetition*  rep);
+
+    virtual void  beginPath (Ulong layer, Ulong datatype,
+                             long x, long  y,
+                             long halfwidth,
+                             long startExtn, long endExtn,
+                             const PointList&  ptlist,
+                             const Repetition*  rep);
+
+    virtual void  beginTrapezoid (Ulong layer, Ulong datatype,
+                                  long x, long  y,
+                                  const Trapezoid& trap,
+                                  const Repetition*  rep);
+
+    virtual void  beginCircle (Ulong layer, Ulong datatype,
+                               long x, long y,
+                               long radius,
+                               const Repetition*  rep);
+
+    virtual void  beginXElement (Ulong attribute, const string& data);
+
+    virtual void  beginXGeometry (Ulong layer, Ulong datatype,
+                                  long x, long y,
+                                  Ulong attribute,
+                                  const string& data,
+                                  const Repetition*  rep);
+
+    virtual void  endElement();
+
+    virtual void  addCellProperty (Property* prop);
+    virtual void  addFileProperty (Property* prop);
+    virtual void  addElementProperty (Property* prop);
+
+    virtual void  registerCellName   (CellName*   cellName);
+    virtual void  registerTextString (TextString* textString);
+    virtual void  registerPropName   (PropName*   propName);
+    virtual void  registerPropString (PropString* propString);
+    virtual void  registerLayerName  (LayerName*  layerName);
+    virtual void  registerXName      (XName*      xname);
+
+private:
+    CallBatch&  record();
+    void        startThreads();
+    void        flushBatch();
+    void        finish();
+    void        stopThreads (bool abandon);
+    void        checkErrors();
+
+private:
+                TeeBuilder (const TeeBuilder&);         // forbidden
+    void        operator= (const TeeBuilder&);          // forbidden
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_TEE_BUILDER_H_INCLUDED
@@ -0,0 +1,325 @@
+// oasis/validator.cc -- CRC32 and checksum32 validation on several threads
+//
+// last modified:   2026/10/17
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <zlib.h>
+
+#if defined(__x86_64__)  ||  defined(__i386__)
+#  include <immintrin.h>
+#  define HAVE_CLMUL_CRC32  1
+#endif
+
+#include "validator.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::runtime_error;
+
+
+namespace {
+
+#ifdef HAVE_CLMUL_CRC32
+
+// Crc32Clmul -- CRC-32 of data by folding with carry-less multiplication
+// This is the method of Gopal et al., "Fast CRC Computation for Generic
+// Polynomials Using PCLMULQDQ Instruction" (Intel, 2009), for the
+// bit-reflected polynomial 0xEDB88320.  crc is the raw register value,
+// i.e. without the pre- and post-inversion that zlib's interface does.
+// len must be at least 64 and a multiple of 16.  The constants are
+// x^(4*128+32), x^(4*128-32), x^(128+32), x^(128-32) and x^64 mod P,
+// each bit-reflected and shifted left by 1, then P' and mu for the
+// Barrett reduction.
+
+__attribute__((target("pclmul,sse4.1")))
+Uint
+Crc32Clmul (Uint crc, const Uchar* data, size_t len)
+{
+    const __m128i  k1k2 = _mm_set_epi64x(0x1c6e41596LL, 0x154442bd4LL);
+    const __m128i  k3k4 = _mm_set_epi64x(0x0ccaa009eLL, 0x1751997d0LL);
+    const __m128i  k5   = _mm_set_epi64x(0, 0x163cd6124LL);
+    const __m128i  poly = _mm_set_epi64x(0x1f7011641LL, 0x1db710641LL);
+    const __m128i  mask32 = _mm_set_epi32(0, 0, 0, -1);
+
+    const __m128i*  p = reinterpret_cast<const __m128i*>(data);
+    __m128i  x1 = _mm_loadu_si128(p);
+    __m128i  x2 = _mm_loadu_si128(p + 1);
+    __m128i  x3 = _mm_loadu_si128(p + 2);
+    __m128i  x4 = _mm_loadu_si128(p + 3);
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(int(crc)));
+    p += 4;
+    len -= 64;
+
+    // Fold four blocks at a time into four accumulators.
+    while (len >= 64) {
+        __m128i  t1 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+        __m128i  t2 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+        __m128i  t3 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+        __m128i  t4 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, t1), _mm_loadu_si128(p));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, t2), _mm_loadu_si128(p + 1));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, t3), _mm_loadu_si128(p + 2));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, t4), _mm_loadu_si128(p + 3));
+        p += 4;
+        len -= 64;
+    }
+
+    // Fold the four accumulators into one, then the remaining blocks.
+    __m128i  next[3] = { x2, x3, x4 };
+    for (int j = 0;  j < 3;  ++j) {
+        __m128i  t = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, t), next[j]);
+    }
+    while (len >= 16) {
+        __m128i  t = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, t), _mm_loadu_si128(p));
+        ++p;
+        len -= 16;
+    }
+
+    // Reduce 128 bits to 64, 64 to 32, and then to the CRC.
+    x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k5, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x2 = x1;
+    x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), poly, 0x10);
+    x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), poly, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return Uint(_mm_extract_epi32(x1, 1));
+}
+
+
+bool
+DetectClmul()
+{
+    __builtin_cpu_init();
+    return (__builtin_cpu_supports("pclmul")
+            &&  __builtin_cpu_supports("sse4.1"));
+}
+
+const bool  HaveClmul = DetectClmul();
+
+#else
+
+const bool  HaveClmul = false;
+
+#endif  // HAVE_CLMUL_CRC32
+
+
+// ZlibCrc32 -- zlib's crc32() for lengths that may not fit in uInt
+
+Uint
+ZlibCrc32 (Uint crc, const Uchar* data, size_t len)
+{
+    const size_t  MaxPiece = size_t(1) << 30;
+    while (len != 0) {
+        size_t  n = std::min(len, MaxPiece);
+        crc = crc32(crc, data, uInt(n));
+        data += n;
+        len -= n;
+    }
+    return crc;
+}
+
+}  // unnamed namespace
+
+
+// Crc32 -- update crc with len bytes of data
+// Same interface and result as zlib's crc32(): start with 0.
+
+/*static*/ Uint
+FileValidator::Crc32 (Uint crc, const Uchar* data, size_t len)
+{
+#ifdef HAVE_CLMUL_CRC32
+    if (HaveClmul  &&  len >= 64) {
+        size_t  n = len & ~size_t(15);
+        crc = ~Crc32Clmul(~crc, data, n);
+        data += n;
+        len -= n;
+    }
+#endif
+    return ZlibCrc32(crc, data, len);
+}
+
+
+// Crc32Combine -- CRC of A followed by B, given the CRCs of A and B
+// len2 is the length of B.
+
+/*static*/ Uint
+FileValidator::Crc32Combine (Uint crc1, Uint crc2, Ullong len2)
+{
+    return Uint(crc32_combine(crc1, crc2, z_off_t(len2)));
+}
+
+
+// Checksum32 -- add len bytes of data to sum, modulo 2^32
+
+/*static*/ Uint
+FileValidator::Checksum32 (Uint sum, const Uchar* data, size_t len)
+{
+#if defined(__SSE2__)  &&  defined(__x86_64__)
+    // psadbw against zero adds each half of a 16-byte block into a
+    // 64-bit lane, which cannot overflow for any file.
+    const __m128i  zero = _mm_setzero_si128();
+    __m128i  acc = zero;
+    const __m128i*  p = reinterpret_cast<const __m128i*>(data);
+    for ( ;  len >= 16;  len -= 16, ++p)
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128(p), zero));
+    sum += Uint(_mm_cvtsi128_si64(acc))
+         + Uint(_mm_cvtsi128_si64(_mm_unpackhi_epi64(acc, acc)));
+    data = reinterpret_cast<const Uchar*>(p);
+#endif
+    for ( ;  len != 0;  --len)
+        sum += *data++;
+    return sum;
+}
+
+
+/*static*/ bool
+FileValidator::HaveHardwareCrc32()
+{
+    return HaveClmul;
+}
+
+
+FileValidator::FileValidator (const char* fname)
+  : mfile(fname)
+{
+    scheme = Validation::None;
+    length = 0;
+    nextChunk = 0;
+    stopping = false;
+    started = false;
+}
+
+
+FileValidator::~FileValidator()
+{
+    stopWorkers();
+}
+
+
+// start -- begin computing the signature for scheme on nthreads threads
+// nthreads == 0 means one per processor.  Returns at once.  The
+// signature covers the whole file except its last four bytes, which in
+// a file with a validation signature are the signature.
+
+void
+FileValidator::start (Validation::Scheme scheme, unsigned nthreads)
+{
+    stopWorkers();
+    this->scheme = scheme;
+    started = true;
+    if (scheme == Validation::None)
+        return;
+
+    if (mfile.getSize() < 4)
+        throw runtime_error(mfile.getFilename()
+                            + ": file too short to have a validation"
+                              " signature");
+    length = mfile.getSize() - 4;
+    partials.assign((length + ChunkSize - 1) / ChunkSize, 0);
+    nextChunk = 0;
+    stopping = false;
+
+    if (nthreads == 0)
+        nthreads = std::max(std::thread::hardware_concurrency(), 1u);
+    nthreads = std::min<size_t>(nthreads, partials.size());
+    mfile.advise(MappedFile::Sequential);
+    for (unsigned j = 0;  j < nthreads;  ++j)
+        threads.push_back(std::thread(&FileValidator::runWorker, this));
+}
+
+
+// wait -- wait for the threads and return the computed signature
+
+Uint
+FileValidator::wait()
+{
+    for (size_t j = 0;  j < threads.size();  ++j)
+        threads[j].join();
+    threads.clear();
+
+    Uint  result = 0;
+    for (size_t k = 0;  k < partials.size();  ++k) {
+        if (scheme == Validation::CRC32) {
+            Ullong  n = std::min<Ullong>(ChunkSize, length - k*ChunkSize);
+            result = (k == 0) ? partials[k]
+                              : Crc32Combine(result, partials[k], n);
+        } else
+            result += partials[k];
+    }
+    return result;
+}
+
+
+// check -- wait for the threads and compare with the END record's signature
+// Throws runtime_error if they differ.  Does nothing for Validation::None.
+
+void
+FileValidator::check (const Validation& val)
+{
+    if (! started)
+        start(val.scheme);
+    if (val.scheme == Validation::None)
+        return;
+
+    Uint  computed = wait();
+    if (computed != Uint(val.signature)) {
+        char  msg[128];
+        snprintf(msg, sizeof msg,
+                 ": validation failed: %s in END record is %08x,"
+                 " but file has %08x",
+                 (val.scheme == Validation::CRC32 ? "CRC32" : "checksum32"),
+                 Uint(val.signature), computed);
+        throw runtime_error(mfile.getFilename() + msg);
+    }
+}
+
+
+void
+FileValidator::runWorker()
+{
+    const Uchar*  base = mfile.getData();
+    for (;;) {
+        size_t  k = nextChunk++;
+        if (stopping  ||  k >= partials.size())
+            break;
+        Ullong  offset = Ullong(k) * ChunkSize;
+        size_t  n = size_t(std::min<Ullong>(ChunkSize, length - offset));
+        partials[k] = (scheme == Validation::CRC32)
+                          ? Crc32(0, base + offset, n)
+                          : Checksum32(0, base + offset, n);
+    }
+}
+
+
+// stopWorkers -- abandon a computation in progress
+// Called when the validator is destroyed or restarted before wait(),
+// e.g. because the parser threw an exception.
+
+void
+FileValidator::stopWorkers()
+{
+    stopping = true;
+    for (size_t j = 0;  j < threads.size();  ++j)
+        threads[j].join();
+    threads.clear();
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
@@ -0,0 +1,91 @@
+// oasis/validator.h -- CRC32 and checksum32 validation on several threads
+//
+// last modified:   2026/10/17
+//
+// The validation signature in the END record covers every byte of the
+// file except the signature itself.  Computing it a byte at a time
+// takes longer than parsing many files, so operators turn validation
+// off.  FileValidator makes it cheap enough to leave on.
+//
+//   - The file is cut into chunks that are checked on separate threads.
+//     Each chunk yields a partial CRC or sum; the partial CRCs are
+//     combined in file order with Crc32Combine().
+//
+//   - On x86 processors with PCLMULQDQ, Crc32() folds 64 bytes per
+//     iteration with carry-less multiplication.  Elsewhere it uses
+//     zlib's crc32().  The choice is made at run time, so one binary
+//     serves every host.  Note that the SSE4.2 CRC32 instruction does
+//     not help: it computes CRC-32C, and OASIS uses the CRC-32 of ISO
+//     3309, the same as zlib and gzip.
+//
+//   - Checksum32() adds bytes sixteen at a time with SSE2 where it is
+//     available.
+//
+//   - start() returns at once and the threads run in the background, so
+//     the parser can validate while it parses.  check() waits for them
+//     and compares the result with the signature in the END record.
+//
+// FileValidator maps the file itself (see mapped-file.h), so it does
+// not care how the parser reads it.
+
+#ifndef OASIS_VALIDATOR_H_INCLUDED
+#define OASIS_VALIDATOR_H_INCLUDED
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "misc/utils.h"
+#include "oasis.h"
+#include "mapped-file.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+using std::vector;
+using SoftJin::Uchar;
+using SoftJin::Uint;
+using SoftJin::Ullong;
+
+
+class FileValidator {
+    MappedFile          mfile;
+    Validation::Scheme  scheme;
+    Ullong              length;         // bytes covered by the signature
+    vector<Uint>        partials;       // one per chunk
+    std::atomic<size_t> nextChunk;
+    std::atomic<bool>   stopping;       // set by the destructor
+    vector<std::thread> threads;
+    bool                started;
+
+public:
+    static const size_t  ChunkSize = 4*1024*1024;
+
+    explicit    FileValidator (const char* fname);
+                ~FileValidator();
+
+    void        start (Validation::Scheme scheme, unsigned nthreads = 0);
+    Uint        wait();
+    void        check (const Validation& val);
+
+    static Uint Crc32 (Uint crc, const Uchar* data, size_t len);
+    static Uint Crc32Combine (Uint crc1, Uint crc2, Ullong len2);
+    static Uint Checksum32 (Uint sum, const Uchar* data, size_t len);
+    static bool HaveHardwareCrc32();
+
+private:
+    void        runWorker();
+    void        stopWorkers();
+
+private:
+                FileValidator (const FileValidator&);   // forbidden
+    void        operator= (const FileValidator&);       // forbidden
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_VALIDATOR_H_INCLUDED
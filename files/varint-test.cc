@@ -0,0 +1,287 @@
+// oasis/varint-test.cc -- check the integer encoders and decoders
+//
+// last modified:   2026/10/17
+//
+// usage:  varint-test
+//
+// varint-test checks varint.h against its own reference, DecodeUInt(),
+// and against the OASIS encoding of Section 7.2:
+//
+//   - every encoder round-trips through DecodeUInt(), DecodeUIntFast()
+//     and their signed forms, at each length boundary and on
+//     pseudo-random values, and writes as many bytes as UIntSize() or
+//     SIntSize() says
+//   - overlong encodings are accepted, and truncated integers and
+//     integers of more than 64 bits are rejected without moving the
+//     pointer
+//   - every VarintImpl supported by this processor agrees with
+//     DecodeUInt() on the values, the end position and the validity
+//     of runs of every length from every offset of a buffer that
+//     mixes good integers with junk
+//
+// Each mismatch is printed on stderr.  The exit status is 0 if there
+// were none and 1 otherwise, so that a build script can run it after
+// changing varint.h or varint.cc.  It needs only varint.cc.
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "misc/utils.h"
+#include "varint.h"
+
+
+using namespace std;
+using namespace Anuvad::SoftJin;
+using namespace Anuvad::Oasis;
+
+
+static int  NumFailures = 0;
+
+
+static void
+Fail (const string& what)
+{
+    fprintf(stderr, "varint-test: %s\n", what.c_str());
+    ++NumFailures;
+}
+
+
+// Random -- our own generator, so that the values are the same
+// everywhere
+
+static Ullong
+Random (/*inout*/ Ullong* state)
+{
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *state;
+}
+
+
+// CheckUInt -- val must round-trip through every unsigned decoder
+
+static void
+CheckUInt (Ullong val)
+{
+    Uchar  buf[MaxVarintBytes + 8];
+    memset(buf, 0xff, sizeof buf);
+    size_t  nbytes = EncodeUInt(val, buf);
+    if (nbytes != UIntSize(val))
+        Fail("EncodeUInt(" + to_string(val) + ") wrote "
+             + to_string(nbytes) + " bytes, UIntSize() says "
+             + to_string(UIntSize(val)));
+
+    // Once with the encoding alone, once with bytes after it, so that
+    // DecodeUIntFast() takes both of its paths.
+    for (size_t avail = nbytes;  avail <= nbytes + 8;  avail += 8) {
+        const Uchar*  p = buf;
+        Ullong  got;
+        if (! DecodeUInt(&p, buf + avail, &got)  ||  got != val
+                ||  p != buf + nbytes)
+            Fail("DecodeUInt() does not return " + to_string(val));
+
+        p = buf;
+        if (! DecodeUIntFast(&p, buf + avail, &got)  ||  got != val
+                ||  p != buf + nbytes)
+            Fail("DecodeUIntFast() does not return " + to_string(val));
+    }
+}
+
+
+// CheckSInt -- val must round-trip through every signed decoder
+
+static void
+CheckSInt (llong val)
+{
+    Uchar  buf[MaxVarintBytes + 8];
+    memset(buf, 0xff, sizeof buf);
+    size_t  nbytes = EncodeSInt(val, buf);
+    if (nbytes != SIntSize(val))
+        Fail("EncodeSInt(" + to_string(val) + ") wrote "
+             + to_string(nbytes) + " bytes, SIntSize() says "
+             + to_string(SIntSize(val)));
+
+    for (size_t avail = nbytes;  avail <= nbytes + 8;  avail += 8) {
+        const Uchar*  p = buf;
+        llong  got;
+        if (! DecodeSInt(&p, buf + avail, &got)  ||  got != val
+                ||  p != buf + nbytes)
+            Fail("DecodeSInt() does not return " + to_string(val));
+
+        p = buf;
+        if (! DecodeSIntFast(&p, buf + avail, &got)  ||  got != val
+                ||  p != buf + nbytes)
+            Fail("DecodeSIntFast() does not return " + to_string(val));
+    }
+}
+
+
+static void
+CheckRoundTrips()
+{
+    CheckUInt(0);
+    CheckUInt(ULLONG_MAX);
+    for (Uint shift = 1;  shift < 64;  ++shift) {
+        Ullong  pow = Ullong(1) << shift;
+        CheckUInt(pow - 1);
+        CheckUInt(pow);
+        CheckUInt(pow + 1);
+    }
+
+    CheckSInt(0);
+    CheckSInt(LLONG_MAX);
+    CheckSInt(LLONG_MIN + 1);          // LLONG_MIN has no encoding
+    for (Uint shift = 1;  shift < 63;  ++shift) {
+        llong  pow = llong(1) << shift;
+        CheckSInt(pow - 1);
+        CheckSInt(pow);
+        CheckSInt(-pow + 1);
+        CheckSInt(-pow);
+    }
+
+    Ullong  state = 12345;
+    for (int j = 0;  j < 100000;  ++j) {
+        Ullong  val = Random(&state) >> (Random(&state) % 64);
+        CheckUInt(val);
+        if (val != Ullong(LLONG_MIN))
+            CheckSInt(llong(val));
+    }
+}
+
+
+// CheckDecode -- DecodeUInt() and DecodeUIntFast() on bytes
+// If ok, they must return val and consume all of the bytes; if not,
+// they must fail and leave the pointer alone.
+
+static void
+CheckDecode (const char* what, const vector<Uchar>& bytes, bool ok,
+             Ullong val)
+{
+    vector<Uchar>  buf(bytes);
+    buf.resize(bytes.size() + 8, 0x80);     // junk for DecodeUIntFast()
+    for (int fast = 0;  fast < 2;  ++fast) {
+        for (size_t avail = bytes.size();  avail <= buf.size();
+                avail += 8) {
+            const Uchar*  p = buf.data();
+            Ullong  got;
+            bool  gok = fast ? DecodeUIntFast(&p, buf.data() + avail, &got)
+                             : DecodeUInt(&p, buf.data() + avail, &got);
+            if (gok != ok
+                    ||  (ok  &&  (got != val
+                                  ||  p != buf.data() + bytes.size()))
+                    ||  (! ok  &&  p != buf.data()))
+                Fail(string(fast ? "DecodeUIntFast()" : "DecodeUInt()")
+                     + " is wrong on " + what);
+        }
+    }
+}
+
+
+static void
+CheckEdgeCases()
+{
+    CheckDecode("an overlong 0", { 0x80, 0x00 }, true, 0);
+    CheckDecode("an overlong 1", { 0x81, 0x80, 0x80, 0x00 }, true, 1);
+    CheckDecode("2^64-1",
+                { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01 },
+                true, ULLONG_MAX);
+    CheckDecode("2^64",
+                { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x02 },
+                false, 0);
+    CheckDecode("an 11-byte integer",
+                { 0x81, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                  0x80, 0x00 },
+                false, 0);
+
+    // Truncated: the end comes before the last byte.  The buffer is
+    // longer than the range so that no decoder reads past it.
+    Uchar  buf[16] = { 0x80, 0x80, 0x01 };
+    for (size_t avail = 0;  avail < 3;  ++avail) {
+        const Uchar*  p = buf;
+        Ullong  got;
+        if (DecodeUInt(&p, buf + avail, &got)  ||  p != buf
+                ||  DecodeUIntFast(&p, buf + avail, &got)  ||  p != buf)
+            Fail("a truncated integer is accepted");
+    }
+}
+
+
+// CheckRuns -- every VarintImpl against DecodeUInt()
+// This is the check that oasis-bench makes before timing varint-run.
+
+static void
+CheckRuns()
+{
+    vector<Uchar>  buf;
+    Ullong  state = 54321;
+    while (buf.size() < 2048) {
+        Uchar  tmp[MaxVarintBytes];
+        Ullong  val = Random(&state) >> (Random(&state) % 64);
+        buf.insert(buf.end(), tmp, tmp + EncodeUInt(val, tmp));
+    }
+    for (size_t j = 0;  j < 2048;  ++j) {
+        Uint  byte = Random(&state) >> 56;
+        // Mostly continuation bytes, so that long integers are common.
+        buf.push_back(Uchar((j % 3 == 0) ? byte : (byte | 0x80)));
+    }
+
+    const size_t  MaxRun = 40;
+    const Uchar*  begin = buf.data();
+    const Uchar*  end = begin + buf.size();
+    Ullong  expect[MaxRun], got[MaxRun];
+
+    VarintImpl  saved = GetVarintImpl();
+    for (int impl = 0;  impl < Varint_NumImpls;  ++impl) {
+        if (! SetVarintImpl(VarintImpl(impl)))
+            continue;
+        for (const Uchar* start = begin;  start != end;  ++start) {
+            for (size_t n = 0;  n <= MaxRun;  ++n) {
+                const Uchar*  ep = start;
+                bool  eok = true;
+                for (size_t k = 0;  k < n  &&  eok;  ++k)
+                    eok = DecodeUInt(&ep, end, &expect[k]);
+                if (! eok)
+                    ep = start;
+                const Uchar*  gp = start;
+                bool  gok = DecodeUIntRun(&gp, end, got, n);
+                const Uchar*  sp = start;
+                bool  sok = SkipUIntRun(&sp, end, n);
+                if (gok != eok  ||  gp != ep
+                        ||  (eok  &&  ! std::equal(expect, expect + n, got))
+                        ||  (eok  &&  (! sok  ||  sp != ep))) {
+                    Fail(string(VarintImplName(VarintImpl(impl)))
+                         + " disagrees with DecodeUInt() at offset "
+                         + to_string(start - begin) + ", run of "
+                         + to_string(n));
+                    break;
+                }
+            }
+        }
+    }
+    SetVarintImpl(saved);
+}
+
+
+int
+main (int argc, char* argv[])
+{
+    SetProgramName(argv[0]);
+    if (argc != 1) {
+        fprintf(stderr, "usage:  %s\n", GetProgramName());
+        return 1;
+    }
+
+    CheckRoundTrips();
+    CheckEdgeCases();
+    CheckRuns();
+
+    if (NumFailures != 0) {
+        fprintf(stderr, "varint-test: %d failures\n", NumFailures);
+        return 1;
+    }
+    printf("varint-test: all passed (run decoder %s)\n",
+           VarintImplName(GetVarintImpl()));
+    return 0;
+}
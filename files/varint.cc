@@ -0,0 +1,352 @@
+// oasis/varint.cc -- fast encoding and decoding of OASIS integers
+//
+// last modified:   2026/10/17
+
+#if defined(__x86_64__)  &&  defined(__SSE2__)
+#  include <immintrin.h>
+#  define HAVE_SSE2_VARINT  1
+#endif
+
+#include "varint.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+
+namespace {
+
+typedef bool  DecodeRunFunc (const Uchar** pp, const Uchar* end,
+                             Ullong* vals, size_t n);
+typedef bool  SkipRunFunc (const Uchar** pp, const Uchar* end, size_t n);
+
+
+//----------------------------------------------------------------------
+// Portable implementations
+
+
+bool
+DecodeRunScalar (const Uchar** pp, const Uchar* end, Ullong* vals, size_t n)
+{
+    const Uchar*  p = *pp;
+    for (size_t j = 0;  j < n;  ++j) {
+        if (! DecodeUInt(&p, end, &vals[j]))
+            return false;
+    }
+    *pp = p;
+    return true;
+}
+
+
+bool
+DecodeRunWord (const Uchar** pp, const Uchar* end, Ullong* vals, size_t n)
+{
+    const Uchar*  p = *pp;
+    for (size_t j = 0;  j < n;  ++j) {
+        if (! DecodeUIntFast(&p, end, &vals[j]))
+            return false;
+    }
+    *pp = p;
+    return true;
+}
+
+
+bool
+SkipRunScalar (const Uchar** pp, const Uchar* end, size_t n)
+{
+    const Uchar*  p = *pp;
+    for ( ;  n != 0;  --n) {
+        while (p != end  &&  (*p & 0x80))
+            ++p;
+        if (p == end)
+            return false;
+        ++p;
+    }
+    *pp = p;
+    return true;
+}
+
+
+//----------------------------------------------------------------------
+// SSE2 implementations
+//
+// Each step loads a 16-byte block and takes the movemask of the
+// continuation bits; its complement, stops, has a bit for the last byte
+// of each integer.  The integers that end in the block are then
+// extracted one by one with an eight-byte load, so the loop runs only
+// while 24 bytes remain and leaves the tail to DecodeUInt().
+
+#ifdef HAVE_SSE2_VARINT
+
+struct PackShifts {
+    Ullong  operator() (Ullong word) const  { return PackVarintWord(word); }
+};
+
+struct PackPext {
+    __attribute__((target("bmi2")))
+    Ullong  operator() (Ullong word) const {
+                return _pext_u64(word, 0x7f7f7f7f7f7f7f7fULL);
+            }
+};
+
+
+// StoreSixteenBytes -- zero-extend the 16 bytes of block into vals
+
+inline void
+StoreSixteenBytes (__m128i block, Ullong* vals)
+{
+    const __m128i  zero = _mm_setzero_si128();
+    __m128i*  out = reinterpret_cast<__m128i*>(vals);
+    __m128i  half[2] = { _mm_unpacklo_epi8(block, zero),
+                         _mm_unpackhi_epi8(block, zero) };
+    for (int h = 0;  h < 2;  ++h) {
+        __m128i  lo = _mm_unpacklo_epi16(half[h], zero);
+        __m128i  hi = _mm_unpackhi_epi16(half[h], zero);
+        _mm_storeu_si128(out++, _mm_unpacklo_epi32(lo, zero));
+        _mm_storeu_si128(out++, _mm_unpackhi_epi32(lo, zero));
+        _mm_storeu_si128(out++, _mm_unpacklo_epi32(hi, zero));
+        _mm_storeu_si128(out++, _mm_unpackhi_epi32(hi, zero));
+    }
+}
+
+
+template <typename Pack>
+inline __attribute__((always_inline)) bool
+DecodeRunBlocks (const Uchar** pp, const Uchar* end, Ullong* vals, size_t n)
+{
+    Pack  pack;
+    const Uchar*  p = *pp;
+    size_t  j = 0;
+
+    while (j < n  &&  end - p >= 24) {
+        __m128i  block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        Uint  stops = ~_mm_movemask_epi8(block) & 0xffff;
+        if (stops == 0xffff  &&  n - j >= 16) {
+            StoreSixteenBytes(block, vals + j);
+            p += 16;
+            j += 16;
+            continue;
+        }
+        if (stops == 0)                 // too long; DecodeUInt() rejects it
+            break;
+
+        Uint  pos = 0;
+        do {
+            Uint  last = __builtin_ctz(stops);
+            Uint  len = last + 1 - pos;
+            if (len <= 8) {
+                Ullong  word = LoadVarintWord(p + pos);
+                vals[j] = pack(word & (~Ullong(0) >> (64 - 8*len)));
+            } else {
+                const Uchar*  q = p + pos;
+                if (! DecodeUInt(&q, end, &vals[j]))
+                    return false;
+            }
+            ++j;
+            pos = last + 1;
+            stops &= stops - 1;
+        } while (stops != 0  &&  j < n);
+        p += pos;
+    }
+
+    for ( ;  j < n;  ++j) {
+        if (! DecodeUInt(&p, end, &vals[j]))
+            return false;
+    }
+    *pp = p;
+    return true;
+}
+
+
+bool
+DecodeRunSse2 (const Uchar** pp, const Uchar* end, Ullong* vals, size_t n)
+{
+    return DecodeRunBlocks<PackShifts>(pp, end, vals, n);
+}
+
+
+__attribute__((target("bmi2")))
+bool
+DecodeRunBmi2 (const Uchar** pp, const Uchar* end, Ullong* vals, size_t n)
+{
+    return DecodeRunBlocks<PackPext>(pp, end, vals, n);
+}
+
+
+// SkipRunSse2 -- count the stops in each block until the n-th
+// Bytes after the last stop in a block belong to an integer that ends
+// in a later block, so whole blocks can be skipped.
+
+bool
+SkipRunSse2 (const Uchar** pp, const Uchar* end, size_t n)
+{
+    const Uchar*  p = *pp;
+    while (n != 0  &&  end - p >= 16) {
+        __m128i  block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        Uint  stops = ~_mm_movemask_epi8(block) & 0xffff;
+        size_t  count = __builtin_popcount(stops);
+        if (count < n) {
+            n -= count;
+            p += 16;
+            continue;
+        }
+        for ( ;  n > 1;  --n)
+            stops &= stops - 1;
+        p += __builtin_ctz(stops) + 1;
+        n = 0;
+    }
+    if (! SkipRunScalar(&p, end, n))
+        return false;
+    *pp = p;
+    return true;
+}
+
+
+// PextIsFast -- whether PEXT is worth using
+// AMD processors before Zen 3 implement PEXT in microcode, taking
+// hundreds of cycles, although they report BMI2.
+
+bool
+PextIsFast()
+{
+    __builtin_cpu_init();
+    if (! __builtin_cpu_supports("bmi2"))
+        return false;
+    return ! (__builtin_cpu_is("amdfam15h")
+              ||  __builtin_cpu_is("znver1")
+              ||  __builtin_cpu_is("znver2"));
+}
+
+#endif  // HAVE_SSE2_VARINT
+
+
+//----------------------------------------------------------------------
+// Dispatch
+
+
+struct VarintOps {
+    const char*     name;
+    DecodeRunFunc*  decodeRun;          // Null if not supported here
+    SkipRunFunc*    skipRun;
+};
+
+const VarintOps  AllVarintOps[Varint_NumImpls] = {
+    { "scalar", DecodeRunScalar, SkipRunScalar },
+#ifdef OASIS_VARINT_WORDS
+    { "word",   DecodeRunWord,   SkipRunScalar },
+#else
+    { "word",   Null,            Null },
+#endif
+#ifdef HAVE_SSE2_VARINT
+    { "sse2",   DecodeRunSse2,   SkipRunSse2 },
+    { "bmi2",   DecodeRunBmi2,   SkipRunSse2 },
+#else
+    { "sse2",   Null,            Null },
+    { "bmi2",   Null,            Null },
+#endif
+};
+
+
+VarintImpl
+DetectVarintImpl()
+{
+#if defined(HAVE_SSE2_VARINT)
+    return (PextIsFast() ? Varint_Bmi2 : Varint_Sse2);
+#elif defined(OASIS_VARINT_WORDS)
+    return Varint_Word;
+#else
+    return Varint_Scalar;
+#endif
+}
+
+// Both are constant-initialized, so that the run functions work even
+// from static constructors that run before SelectedImpl is set.
+VarintImpl  CurrentImpl = Varint_Scalar;
+const VarintOps*  CurrentOps = &AllVarintOps[Varint_Scalar];
+
+}  // unnamed namespace
+
+
+bool
+DecodeUIntRun (const Uchar** pp, const Uchar* end,
+               /*out*/ Ullong* vals, size_t n)
+{
+    return CurrentOps->decodeRun(pp, end, vals, n);
+}
+
+
+bool
+DecodeSIntRun (const Uchar** pp, const Uchar* end,
+               /*out*/ llong* vals, size_t n)
+{
+    // Signed and unsigned types may alias, so the conversion can be
+    // done in place.
+    Ullong*  uvals = reinterpret_cast<Ullong*>(vals);
+    if (! CurrentOps->decodeRun(pp, end, uvals, n))
+        return false;
+    for (size_t j = 0;  j < n;  ++j)
+        vals[j] = UIntToSInt(uvals[j]);
+    return true;
+}
+
+
+bool
+SkipUIntRun (const Uchar** pp, const Uchar* end, size_t n)
+{
+    return CurrentOps->skipRun(pp, end, n);
+}
+
+
+VarintImpl
+GetVarintImpl()
+{
+    return CurrentImpl;
+}
+
+
+// VarintImplSupported -- whether impl can run on this processor
+// Varint_Bmi2 is supported wherever BMI2 is, even if it is slow there.
+
+bool
+VarintImplSupported (VarintImpl impl)
+{
+    if (impl < 0  ||  impl >= Varint_NumImpls
+            ||  AllVarintOps[impl].decodeRun == Null)
+        return false;
+#ifdef HAVE_SSE2_VARINT
+    if (impl == Varint_Bmi2)
+        return __builtin_cpu_supports("bmi2");
+#endif
+    return true;
+}
+
+
+// SetVarintImpl -- use impl for the run functions from now on
+// Returns false, changing nothing, if impl is not supported.  Not
+// thread-safe: call it before any decoding starts.
+
+bool
+SetVarintImpl (VarintImpl impl)
+{
+    if (! VarintImplSupported(impl))
+        return false;
+    CurrentImpl = impl;
+    CurrentOps = &AllVarintOps[impl];
+    return true;
+}
+
+namespace {
+const bool  SelectedImpl = SetVarintImpl(DetectVarintImpl());
+}
+
+
+const char*
+VarintImplName (VarintImpl impl)
+{
+    if (impl < 0  ||  impl >= Varint_NumImpls)
+        return "unknown";
+    return AllVarintOps[impl].name;
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
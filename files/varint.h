@@ -0,0 +1,290 @@
+// oasis/varint.h -- fast encoding and decoding of OASIS integers
+//
+// last modified:   2026/10/17
+//
+// Unsigned-integers and signed-integers (Section 7.2 of the spec) are
+// little-endian base-128 numbers: seven bits per byte, with bit 7 set
+// in every byte but the last.  A signed-integer keeps its sign in
+// bit 0.  Geometry-dense files are mostly such integers, so decoding
+// them a byte at a time is the scanner's hottest loop.
+//
+// DecodeUInt() and DecodeSInt() are the reference decoders.  The rest
+// of this file computes the same thing faster:
+//
+//   DecodeUIntFast(), DecodeSIntFast()
+//       one integer.  Eight bytes are loaded at once, the last byte of
+//       the integer is found with a bit scan, and the 7-bit groups are
+//       packed together with shifts and masks.  Near the end of the
+//       range, and for integers longer than eight bytes, these fall
+//       back to DecodeUInt().
+//
+//   DecodeUIntRun(), DecodeSIntRun(), SkipUIntRun()
+//       n consecutive integers, as in point lists and repetitions.
+//       These go through an implementation chosen at startup from the
+//       processor's features.  On x86-64 the SSE2 one finds all the
+//       integer boundaries in 16 bytes with one movemask and converts
+//       a block of sixteen one-byte integers without looking at them
+//       singly.  Where BMI2 is fast it packs the groups with PEXT.
+//       Elsewhere the word-at-a-time method of DecodeUIntFast() is used.
+//
+//   EncodeUInt(), EncodeSInt()
+//       the inverse.  The value is spread into eight bytes with shifts
+//       and masks instead of a loop, for integers below 2^56.
+//
+// Every decoder accepts exactly what DecodeUInt() accepts, including
+// overlong encodings, and rejects integers that do not fit in 64 bits.
+// SetVarintImpl() forces one implementation; oasis-bench uses it to
+// time them and to check them against each other.
+
+#ifndef OASIS_VARINT_H_INCLUDED
+#define OASIS_VARINT_H_INCLUDED
+
+#include <cassert>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include "misc/utils.h"
+
+#if defined(__GNUC__)  &&  defined(__BYTE_ORDER__)  \
+        &&  __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#  define OASIS_VARINT_WORDS  1
+#endif
+
+namespace Anuvad {
+namespace Oasis {
+
+using SoftJin::Uchar;
+using SoftJin::Uint;
+using SoftJin::Ullong;
+using SoftJin::llong;
+
+
+// The longest encoding of a 64-bit integer.  Buffers passed to the
+// encoders must have this much room, although fewer bytes are used.
+const size_t  MaxVarintBytes = 10;
+
+
+// UIntToSInt -- the signed-integer whose encoding is that of uval
+
+inline llong
+UIntToSInt (Ullong uval)
+{
+    llong  mag = uval >> 1;
+    return ((uval & 1) ? -mag : mag);
+}
+
+
+// DecodeUInt, DecodeSInt -- decode one integer from raw bytes
+// They advance *pp past the integer.  They return false, leaving *pp
+// unchanged, if the integer runs off the end of the range or does not
+// fit in 64 bits.
+
+inline bool
+DecodeUInt (const Uchar** pp, const Uchar* end, Ullong* valp)
+{
+    const Uchar*  p = *pp;
+    Ullong  val = 0;
+    for (Uint shift = 0;  p != end;  shift += 7) {
+        Uint  byte = *p++;
+        if (shift == 63  &&  byte > 1)
+            return false;
+        val |= Ullong(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *pp = p;
+            *valp = val;
+            return true;
+        }
+        if (shift == 63)
+            return false;
+    }
+    return false;
+}
+
+
+inline bool
+DecodeSInt (const Uchar** pp, const Uchar* end, llong* valp)
+{
+    Ullong  uval;
+    if (! DecodeUInt(pp, end, &uval))
+        return false;
+    *valp = UIntToSInt(uval);
+    return true;
+}
+
+
+#ifdef OASIS_VARINT_WORDS
+
+// LoadVarintWord -- the eight bytes at p as a little-endian integer
+
+inline Ullong
+LoadVarintWord (const Uchar* p)
+{
+    Ullong  word;
+    memcpy(&word, p, sizeof word);
+    return word;
+}
+
+
+// PackVarintWord -- concatenate the low seven bits of each byte
+// Bytes that are not part of the integer must already be cleared.
+
+inline Ullong
+PackVarintWord (Ullong word)
+{
+    word &= 0x7f7f7f7f7f7f7f7fULL;
+    word = (word & 0x007f007f007f007fULL) | ((word & 0x7f007f007f007f00ULL) >> 1);
+    word = (word & 0x00003fff00003fffULL) | ((word & 0x3fff00003fff0000ULL) >> 2);
+    word = (word & 0x000000000fffffffULL) | ((word & 0x0fffffff00000000ULL) >> 4);
+    return word;
+}
+
+
+// SpreadVarintWord -- the inverse of PackVarintWord() for val < 2^56
+
+inline Ullong
+SpreadVarintWord (Ullong val)
+{
+    Ullong  word = (val & 0x000000000fffffffULL)
+                 | ((val & 0x00fffffff0000000ULL) << 4);
+    word = (word & 0x00003fff00003fffULL) | ((word & 0x0fffc0000fffc000ULL) << 2);
+    word = (word & 0x007f007f007f007fULL) | ((word & 0x3f803f803f803f80ULL) << 1);
+    return word;
+}
+
+#endif  // OASIS_VARINT_WORDS
+
+
+// DecodeUIntFast, DecodeSIntFast -- DecodeUInt() and DecodeSInt() for
+// a single integer in the middle of a record
+
+inline bool
+DecodeUIntFast (const Uchar** pp, const Uchar* end, Ullong* valp)
+{
+#ifdef OASIS_VARINT_WORDS
+    const Uchar*  p = *pp;
+    if (end - p >= 8) {
+        Ullong  word = LoadVarintWord(p);
+        Ullong  stops = ~word & 0x8080808080808080ULL;
+        if (stops != 0) {
+            // stops ^ (stops - 1) covers the bytes up to and including
+            // the last byte of the integer.
+            *valp = PackVarintWord(word & (stops ^ (stops - 1)));
+            *pp = p + (__builtin_ctzll(stops) >> 3) + 1;
+            return true;
+        }
+    }
+#endif
+    return DecodeUInt(pp, end, valp);
+}
+
+
+inline bool
+DecodeSIntFast (const Uchar** pp, const Uchar* end, llong* valp)
+{
+    Ullong  uval;
+    if (! DecodeUIntFast(pp, end, &uval))
+        return false;
+    *valp = UIntToSInt(uval);
+    return true;
+}
+
+
+// EncodeUInt, EncodeSInt -- encode val into buf
+// buf must have room for MaxVarintBytes bytes.  Returns the number of
+// bytes in the encoding, which is the shortest one.  EncodeSInt() does
+// not take LLONG_MIN: its magnitude, 2^63, shifted left for the sign
+// bit needs 65 bits, which no decoder here accepts.
+
+inline size_t
+EncodeUInt (Ullong val, /*out*/ Uchar* buf)
+{
+#ifdef OASIS_VARINT_WORDS
+    if (val < (Ullong(1) << 56)) {
+        size_t  nbytes = (64 - __builtin_clzll(val | 1) + 6) / 7;
+        Ullong  word = SpreadVarintWord(val)
+                     | (0x8080808080808080ULL
+                        & ((Ullong(1) << (8 * (nbytes - 1))) - 1));
+        memcpy(buf, &word, sizeof word);
+        return nbytes;
+    }
+#endif
+    size_t  nbytes = 0;
+    while (val >= 0x80) {
+        buf[nbytes++] = Uchar(val | 0x80);
+        val >>= 7;
+    }
+    buf[nbytes++] = Uchar(val);
+    return nbytes;
+}
+
+
+inline size_t
+EncodeSInt (llong val, /*out*/ Uchar* buf)
+{
+    assert(val != LLONG_MIN);
+    Ullong  mag = (val < 0) ? Ullong(-(val + 1)) + 1 : Ullong(val);
+    return EncodeUInt((mag << 1) | (val < 0 ? 1 : 0), buf);
+}
+
+
+// UIntSize, SIntSize -- number of bytes EncodeUInt() or EncodeSInt()
+// would write for val
+
+inline size_t
+UIntSize (Ullong val)
+{
+    size_t  nbytes = 1;
+    while (val >= 0x80) {
+        val >>= 7;
+        ++nbytes;
+    }
+    return nbytes;
+}
+
+
+inline size_t
+SIntSize (llong val)
+{
+    assert(val != LLONG_MIN);
+    Ullong  mag = (val < 0) ? Ullong(-(val + 1)) + 1 : Ullong(val);
+    return UIntSize(mag << 1);
+}
+
+
+// DecodeUIntRun -- decode n consecutive unsigned-integers into vals
+// DecodeSIntRun -- the same for signed-integers
+// SkipUIntRun   -- step over n consecutive integers of either kind
+//
+// Like DecodeUInt(), these advance *pp past what they read, and return
+// false, leaving *pp unchanged, if any integer runs off the end or
+// does not fit in 64 bits.  The contents of vals are then unspecified.
+// SkipUIntRun() does not check the size of the integers, only that
+// they end before end, as MappedScanner::skipUInt() does.
+
+bool    DecodeUIntRun (const Uchar** pp, const Uchar* end,
+                       /*out*/ Ullong* vals, size_t n);
+bool    DecodeSIntRun (const Uchar** pp, const Uchar* end,
+                       /*out*/ llong* vals, size_t n);
+bool    SkipUIntRun (const Uchar** pp, const Uchar* end, size_t n);
+
+
+// VarintImpl -- the implementations behind the run functions
+
+enum VarintImpl {
+    Varint_Scalar,      // DecodeUInt() in a loop
+    Varint_Word,        // DecodeUIntFast() in a loop
+    Varint_Sse2,        // x86-64: movemask boundaries, shift-mask packing
+    Varint_Bmi2,        // x86-64: movemask boundaries, PEXT packing
+    Varint_NumImpls
+};
+
+VarintImpl   GetVarintImpl();
+bool         VarintImplSupported (VarintImpl impl);
+bool         SetVarintImpl (VarintImpl impl);
+const char*  VarintImplName (VarintImpl impl);
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_VARINT_H_INCLUDED
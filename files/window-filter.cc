@@ -0,0 +1,342 @@
+// oasis/window-filter.cc -- builder proxy that drops what misses a window
+//
+// last modified:   2026/10/17
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "window-filter.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+
+WindowFilterBuilder::WindowFilterBuilder (OasisBuilder* target,
+                                          const CellBBoxIndex& bboxes)
+  : target(target),
+    bboxes(bboxes),
+    window(BoundingBox::Everything())
+{
+    dropping = false;
+    elementsKept = elementsDropped = 0;
+    placementsKept = placementsDropped = 0;
+}
+
+
+WindowFilterBuilder::~WindowFilterBuilder() { }
+
+
+// setWindow -- set the window for the cell about to be parsed
+// window is in the cell's coordinates.
+
+void
+WindowFilterBuilder::setWindow (const BoundingBox& window)
+{
+    this->window = window;
+    dropping = false;
+}
+
+
+// addRegion -- add region to the part of cellName that must be parsed
+
+void
+WindowFilterBuilder::addRegion (const string& cellName,
+                                const BoundingBox& region)
+{
+    std::unordered_map<string, BoundingBox>::iterator
+        iter = regions.find(cellName);
+    if (iter == regions.end())
+        regions.insert(std::make_pair(cellName, region));
+    else
+        iter->second.merge(region);
+}
+
+
+// getRegion -- part of cellName that forwarded placements can show
+// Returns false if no forwarded placement has placed the cell.
+
+bool
+WindowFilterBuilder::getRegion (const string& cellName,
+                                /*out*/ BoundingBox* region) const
+{
+    std::unordered_map<string, BoundingBox>::const_iterator
+        iter = regions.find(cellName);
+    if (iter == regions.end())
+        return false;
+    *region = iter->second;
+    return true;
+}
+
+
+// keep -- decide whether to forward an element with extent box
+// box is for the element's first position; the repetition sweeps it.
+
+bool
+WindowFilterBuilder::keep (BoundingBox box, const Repetition* rep)
+{
+    box.sweep(BoundingBox::OfRepetition(rep));
+    dropping = ! box.intersects(window);
+    if (dropping)
+        ++elementsDropped;
+    else
+        ++elementsKept;
+    return (! dropping);
+}
+
+
+//----------------------------------------------------------------------
+// Names, properties and structure go straight through.
+
+
+void
+WindowFilterBuilder::beginFile (const string& version, const Oreal& unit,
+                                Validation::Scheme valScheme)
+{
+    target->beginFile(version, unit, valScheme);
+}
+
+
+void
+WindowFilterBuilder::endFile()
+{
+    target->endFile();
+}
+
+
+void
+WindowFilterBuilder::beginCell (CellName* cellName)
+{
+    dropping = false;
+    target->beginCell(cellName);
+}
+
+
+void
+WindowFilterBuilder::endCell()
+{
+    dropping = false;
+    target->endCell();
+}
+
+
+void
+WindowFilterBuilder::beginXElement (Ulong attribute, const string& data)
+{
+    dropping = false;
+    target->beginXElement(attribute, data);
+}
+
+
+void
+WindowFilterBuilder::endElement()
+{
+    if (! dropping)
+        target->endElement();
+    dropping = false;
+}
+
+
+void
+WindowFilterBuilder::addCellProperty (Property* prop)
+{
+    target->addCellProperty(prop);
+}
+
+
+void
+WindowFilterBuilder::addFileProperty (Property* prop)
+{
+    target->addFileProperty(prop);
+}
+
+
+void
+WindowFilterBuilder::addElementProperty (Property* prop)
+{
+    if (! dropping)
+        target->addElementProperty(prop);
+}
+
+
+void
+WindowFilterBuilder::registerCellName (CellName* cellName) {
+    target->registerCellName(cellName);
+}
+
+void
+WindowFilterBuilder::registerTextString (TextString* textString) {
+    target->registerTextString(textString);
+}
+
+void
+WindowFilterBuilder::registerPropName (PropName* propName) {
+    target->registerPropName(propName);
+}
+
+void
+WindowFilterBuilder::registerPropString (PropString* propString) {
+    target->registerPropString(propString);
+}
+
+void
+WindowFilterBuilder::registerLayerName (LayerName* layerName) {
+    target->registerLayerName(layerName);
+}
+
+void
+WindowFilterBuilder::registerXName (XName* xname) {
+    target->registerXName(xname);
+}
+
+
+//----------------------------------------------------------------------
+// Elements are forwarded only if they meet the window.
+
+
+// beginPlacement
+// The instances of a repeated placement are not tested one by one: if
+// the box swept by all of them meets the window, the placement is
+// forwarded whole, and the placed cell's region covers every instance.
+
+void
+WindowFilterBuilder::beginPlacement (CellName* cellName,
+                                     long x, long y,
+                                     const Oreal&  mag,
+                                     const Oreal&  angle,
+                                     bool flip,
+                                     const Repetition*  rep)
+{
+    const string&  name = cellName->getName();
+    double  m = mag.getValue();
+    double  a = angle.getValue();
+    BoundingBox  offsets = BoundingBox::OfRepetition(rep);
+
+    BoundingBox  cellBox;
+    BoundingBox  region;
+    if (! bboxes.lookup(name, &cellBox)) {
+        cellBox = BoundingBox::Everything();
+        region = BoundingBox::Everything();
+    } else if (window.isUnbounded()) {
+        region = BoundingBox::Everything();
+    } else {
+        // The window as seen from the first instance, widened to cover
+        // the other instances.
+        BoundingBox  shifted(window.xmin - offsets.xmax,
+                             window.ymin - offsets.ymax,
+                             window.xmax - offsets.xmin,
+                             window.ymax - offsets.ymin);
+        region = shifted.inverseTransform(m, a, flip, x, y);
+    }
+
+    BoundingBox  placed = cellBox.transform(m, a, flip, x, y);
+    placed.sweep(offsets);
+    dropping = ! placed.intersects(window);
+    if (dropping) {
+        ++placementsDropped;
+        return;
+    }
+    ++placementsKept;
+    addRegion(name, region);
+    target->beginPlacement(cellName, x, y, mag, angle, flip, rep);
+}
+
+
+// beginText
+// OASIS gives text no extent, so only its position is tested.
+
+void
+WindowFilterBuilder::beginText (Ulong textlayer, Ulong texttype,
+                                long x, long y,
+                                TextString* text,
+                                const Repetition* rep)
+{
+    if (keep(BoundingBox(x, y, x, y), rep))
+        target->beginText(textlayer, texttype, x, y, text, rep);
+}
+
+
+void
+WindowFilterBuilder::beginRectangle (Ulong layer, Ulong datatype,
+                                     long x, long y,
+                                     long width, long height,
+                                     const Repetition*  rep)
+{
+    if (keep(BoundingBox(x, y, x + width, y + height), rep))
+        target->beginRectangle(layer, datatype, x, y, width, height, rep);
+}
+
+
+void
+WindowFilterBuilder::beginPolygon (Ulong layer, Ulong datatype,
+                                   long x, long y,
+                                   const PointList&  ptlist,
+                                   const Repetition*  rep)
+{
+    BoundingBox  box(x, y, x, y);
+    for (PointList::const_iterator iter = ptlist.begin();
+            iter != ptlist.end();  ++iter)
+        box.addPoint(x + iter->x, y + iter->y);
+    if (keep(box, rep))
+        target->beginPolygon(layer, datatype, x, y, ptlist, rep);
+}
+
+
+void
+WindowFilterBuilder::beginPath (Ulong layer, Ulong datatype,
+                                long x, long  y,
+                                long halfwidth,
+                                long startExtn, long endExtn,
+                                const PointList&  ptlist,
+                                const Repetition*  rep)
+{
+    BoundingBox  box(x, y, x, y);
+    for (PointList::const_iterator iter = ptlist.begin();
+            iter != ptlist.end();  ++iter)
+        box.addPoint(x + iter->x, y + iter->y);
+    long  pad = halfwidth + std::max(std::labs(startExtn), std::labs(endExtn));
+    box.grow(pad, pad);
+    if (keep(box, rep))
+        target->beginPath(layer, datatype, x, y, halfwidth,
+                          startExtn, endExtn, ptlist, rep);
+}
+
+
+void
+WindowFilterBuilder::beginTrapezoid (Ulong layer, Ulong datatype,
+                                     long x, long  y,
+                                     const Trapezoid& trap,
+                                     const Repetition*  rep)
+{
+    BoundingBox  box(x, y, x + long(trap.getWidth()),
+                           y + long(trap.getHeight()));
+    if (keep(box, rep))
+        target->beginTrapezoid(layer, datatype, x, y, trap, rep);
+}
+
+
+void
+WindowFilterBuilder::beginCircle (Ulong layer, Ulong datatype,
+                                  long x, long y,
+                                  long radius,
+                                  const Repetition*  rep)
+{
+    if (keep(BoundingBox(x - radius, y - radius, x + radius, y + radius),
+             rep))
+        target->beginCircle(layer, datatype, x, y, radius, rep);
+}
+
+
+void
+WindowFilterBuilder::beginXGeometry (Ulong layer, Ulong datatype,
+                                     long x, long y,
+                                     Ulong attribute,
+                                     const string& data,
+                                     const Repetition*  rep)
+{
+    if (keep(BoundingBox(x, y, x, y), rep))
+        target->beginXGeometry(layer, datatype, x, y, attribute, data, rep);
+}
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
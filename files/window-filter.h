@@ -0,0 +1,149 @@
+// oasis/window-filter.h -- builder proxy that drops what misses a window
+//
+// last modified:   2026/10/17
+//
+// WindowFilterBuilder sits between the parser and the real builder
+// during OasisParser::parseWindow().  Before the parser reads a cell,
+// parseWindow() calls setWindow() with the part of the cell that can
+// show through the caller's window, in the cell's own coordinates.
+// The proxy forwards each element whose extent, repetitions included,
+// meets that window and drops the rest, together with their properties
+// and endElement() calls.
+//
+// A placement is forwarded if the placed cell's box, from the
+// CellBBoxIndex, meets the window.  The proxy then maps the window into
+// the placed cell's coordinates and adds it to that cell's region;
+// parseWindow() parses a cell only if some forwarded placement gave it
+// a region, with the union of the regions as its window.  Placements
+// of cells without a box are always forwarded and make the whole of the
+// cell visible.
+//
+// Everything that is not an element goes through unchanged.
+
+#ifndef OASIS_WINDOW_FILTER_H_INCLUDED
+#define OASIS_WINDOW_FILTER_H_INCLUDED
+
+#include <string>
+#include <unordered_map>
+
+#include "misc/utils.h"
+#include "oasis.h"
+#include "builder.h"
+#include "bbox-index.h"
+
+namespace Anuvad {
+namespace Oasis {
+
+using std::string;
+using SoftJin::Ulong;
+using SoftJin::Ullong;
+
+
+class WindowFilterBuilder : public OasisBuilder {
+    OasisBuilder*           target;
+    const CellBBoxIndex&    bboxes;
+    BoundingBox             window;         // of the current cell
+    bool                    dropping;       // the current element was dropped
+    std::unordered_map<string, BoundingBox>  regions;   // by cell name
+
+    Ullong      elementsKept, elementsDropped;
+    Ullong      placementsKept, placementsDropped;
+
+public:
+                WindowFilterBuilder (OasisBuilder* target,
+                                     const CellBBoxIndex& bboxes);
+    virtual     ~WindowFilterBuilder();
+
+    void        setWindow (const BoundingBox& window);
+    void        addRegion (const string& cellName, const BoundingBox& region);
+    bool        getRegion (const string& cellName,
+                           /*out*/ BoundingBox* region) const;
+
+    Ullong      getElementsKept() const         { return elementsKept; }
+    Ullong      getElementsDropped() const      { return elementsDropped; }
+    Ullong      getPlacementsKept() const       { return placementsKept; }
+    Ullong      getPlacementsDropped() const    { return placementsDropped; }
+
+    // OasisBuilder virtual methods.
+
+    virtual void  beginFile (const string& version,
+                             const Oreal& unit,
+                             Validation::Scheme valScheme);
+    virtual void  endFile();
+
+    virtual void  beginCell (CellName* cellName);
+    virtual void  endCell();
+
+    virtual void  beginPlacement (CellName* cellName,
+                                  long x, long y,
+                                  const Oreal&  mag,
+                                  const Oreal&  angle,
+                                  bool flip,
+                                  const Repetition*  rep);
+
+    virtual void  beginText (Ulong textlayer, Ulong texttype,
+                             long x, long y,
+                             TextString* text,
+                             const Repetition* rep);
+
+    virtual void  beginRectangle (Ulong layer, Ulong datatype,
+                                  long x, long y,
+                                  long width, long height,
+                                  const Repetition*  rep);
+
+    virtual void  beginPolygon (Ulong layer, Ulong datatype,
+                                long x, long y,
+                                const PointList&  ptlist,
+                                const Repetition*  rep);
+
+    virtual void  beginPath (Ulong layer, Ulong datatype,
+                             long x, long  y,
+                             long halfwidth,
+                             long startExtn, long endExtn,
+                             const PointList&  ptlist,
+                             const Repetition*  rep);
+
+    virtual void  beginTrapezoid (Ulong layer, Ulong datatype,
+                                  long x, long  y,
+                                  const Trapezoid& trap,
+                                  const Repetition*  rep);
+
+    virtual void  beginCircle (Ulong layer, Ulong datatype,
+                               long x, long y,
+                               long radius,
+                               const Repetition*  rep);
+
+    virtual void  beginXElement (Ulong attribute, const string& data);
+
+    virtual void  beginXGeometry (Ulong layer, Ulong datatype,
+                                  long x, long y,
+                                  Ulong attribute,
+                                  const string& data,
+                                  const Repetition*  rep);
+
+    virtual void  endElement();
+
+    virtual void  addCellProperty (Property* prop);
+    virtual void  addFileProperty (Property* prop);
+    virtual void  addElementProperty (Property* prop);
+
+    virtual void  registerCellName   (CellName*   cellName);
+    virtual void  registerTextString (TextString* textString);
+    virtual void  registerPropName   (PropName*   propName);
+    virtual void  registerPropString (PropString* propString);
+    virtual void  registerLayerName  (LayerName*  layerName);
+    virtual void  registerXName      (XName*      xname);
+
+private:
+    bool        keep (BoundingBox box, const Repetition* rep);
+
+private:
+                WindowFilterBuilder (const WindowFilterBuilder&);  // forbidden
+    void        operator= (const WindowFilterBuilder&);            // forbidden
+};
+
+
+}  // namespace Oasis
+}  // namespace Anuvad
+
+#endif  // OASIS_WINDOW_FILTER_H_INCLUDED